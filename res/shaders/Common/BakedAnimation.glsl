@@ -0,0 +1,44 @@
+// Needs Skinning.glsl. Mirrors BakedClip in BakedAnimation.h
+struct BakedClip
+{
+	uint firstFrame;
+	uint frameCount;
+	float duration;
+	float padding;
+};
+
+layout (std430, binding = 7) readonly buffer BakedClips
+{
+	BakedClip bakedClips[];
+};
+
+// One row per frame, three texels per bone holding the rows of its matrix
+uniform sampler2D bakedBones;
+// Seconds since the crowd started
+uniform float bakedTime;
+
+// Clips loop, the two frames around the time are blended linearly
+void SkinBakedVertex(uint clip, float timeOffset, ivec4 indices, vec4 weights, inout vec3 position, inout vec3 normal)
+{
+	const BakedClip baked = bakedClips[clip];
+	// Clips of a single key are baked with no duration and hold their first frame
+	const float frame = baked.duration > 0.0f ? fract((bakedTime + timeOffset) / baked.duration) * float(baked.frameCount - 1u) : 0.0f;
+	const int frame0 = int(baked.firstFrame) + int(frame);
+	const int frame1 = min(frame0 + 1, int(baked.firstFrame + baked.frameCount) - 1);
+	const float blend = fract(frame);
+
+	vec4 rows[3] = vec4[3](vec4(0.0f), vec4(0.0f), vec4(0.0f));
+	for (int i = 0; i < 4; ++i)
+	{
+		if (weights[i] > 0.0f && indices[i] >= 0)
+		{
+			for (int row = 0; row < 3; ++row)
+			{
+				const int texel = indices[i] * 3 + row;
+				const vec4 value = mix(texelFetch(bakedBones, ivec2(texel, frame0), 0), texelFetch(bakedBones, ivec2(texel, frame1), 0), blend);
+				rows[row] += value * weights[i];
+			}
+		}
+	}
+	ApplySkin(rows[0], rows[1], rows[2], position, normal);
+}
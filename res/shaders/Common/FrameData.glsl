@@ -0,0 +1,36 @@
+// Mirrors FrameConstants, ObjectData and PackedBone in FrameRingBuffer.h
+layout (std140) uniform Matrixes
+{
+	mat4 view;
+	mat4 projection;
+	mat4 viewProjection;
+	mat4 lightSpace;
+	vec4 cameraPosition;
+};
+
+struct ObjectData
+{
+	mat4 model;
+	mat4 normalMatrix;
+	uint flags;
+	uint boneOffset;
+};
+
+layout (std430, binding = 3) readonly buffer Objects
+{
+	ObjectData objects[];
+};
+
+// Rows of the bone matrix, the fourth one is always 0 0 0 1
+struct PackedBone
+{
+	vec4 rows[3];
+};
+
+layout (std430, binding = 4) readonly buffer Bones
+{
+	PackedBone bones[];
+};
+
+const uint OBJECT_SELECTED = 1u;
+const uint OBJECT_REFRACT = 2u;
@@ -0,0 +1,41 @@
+// Mirrors InstanceFormat
+const int INSTANCE_MATRIX = 0;
+const int INSTANCE_AFFINE = 1;
+const int INSTANCE_QUAT_SCALE = 2;
+
+// vec4s per instance, InstanceBuilder::GetStride in vec4s
+uint GetInstanceStride(int format)
+{
+	return format == INSTANCE_AFFINE ? 3u : (format == INSTANCE_QUAT_SCALE ? 2u : 4u);
+}
+
+// Matrix of an instance from the first GetInstanceStride vec4s of its data
+mat4 DecodeInstance(int format, vec4 instance0, vec4 instance1, vec4 instance2, vec4 instance3)
+{
+	if (format == INSTANCE_AFFINE)
+	{
+		// Rows of the matrix
+		return transpose(mat4(instance0, instance1, instance2, vec4(0.0f, 0.0f, 0.0f, 1.0f)));
+	}
+	if (format == INSTANCE_QUAT_SCALE)
+	{
+		// Position and scale, then the quaternion as x, y, z, w
+		const vec4 q = instance1;
+		const float s = instance0.w;
+		const float xx = q.x * q.x;
+		const float yy = q.y * q.y;
+		const float zz = q.z * q.z;
+		const float xy = q.x * q.y;
+		const float xz = q.x * q.z;
+		const float yz = q.y * q.z;
+		const float wx = q.w * q.x;
+		const float wy = q.w * q.y;
+		const float wz = q.w * q.z;
+		return mat4(
+			vec4(1.0f - 2.0f * (yy + zz), 2.0f * (xy + wz), 2.0f * (xz - wy), 0.0f) * s,
+			vec4(2.0f * (xy - wz), 1.0f - 2.0f * (xx + zz), 2.0f * (yz + wx), 0.0f) * s,
+			vec4(2.0f * (xz + wy), 2.0f * (yz - wx), 1.0f - 2.0f * (xx + yy), 0.0f) * s,
+			vec4(instance0.xyz, 1.0f));
+	}
+	return mat4(instance0, instance1, instance2, instance3);
+}
@@ -0,0 +1,28 @@
+// Transforms by the weighted bone rows of a vertex, summed first so the vertex is transformed once
+void ApplySkin(vec4 row0, vec4 row1, vec4 row2, inout vec3 position, inout vec3 normal)
+{
+	const vec4 pos = vec4(position, 1.0f);
+	const vec3 norm = normal;
+	position = vec3(dot(row0, pos), dot(row1, pos), dot(row2, pos));
+	normal = vec3(dot(row0.xyz, norm), dot(row1.xyz, norm), dot(row2.xyz, norm));
+}
+
+// Needs FrameData.glsl. Blends up to four bones of the palette at boneOffset,
+// zero weights and negative indices are skipped
+void SkinVertex(uint boneOffset, ivec4 indices, vec4 weights, inout vec3 position, inout vec3 normal)
+{
+	vec4 row0 = vec4(0.0f);
+	vec4 row1 = vec4(0.0f);
+	vec4 row2 = vec4(0.0f);
+	for (int i = 0; i < 4; ++i)
+	{
+		if (weights[i] > 0.0f && indices[i] >= 0)
+		{
+			const PackedBone bone = bones[boneOffset + uint(indices[i])];
+			row0 += bone.rows[0] * weights[i];
+			row1 += bone.rows[1] * weights[i];
+			row2 += bone.rows[2] * weights[i];
+		}
+	}
+	ApplySkin(row0, row1, row2, position, normal);
+}
@@ -1,8 +1,14 @@
 #version 430 core
+#include "Common/Instance.glsl"
+
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoords;
-layout (location = 3) in mat4 instanceModel;
+// One instance in InstancedModel's format, formats shorter than a matrix leave the last attributes unused
+layout (location = 3) in vec4 instance0;
+layout (location = 4) in vec4 instance1;
+layout (location = 5) in vec4 instance2;
+layout (location = 6) in vec4 instance3;
 
 layout (std140) uniform Matrixes
 {
@@ -10,6 +16,8 @@ layout (std140) uniform Matrixes
 	uniform mat4 projection;	//64
 };
 uniform mat4 model;
+// InstanceFormat
+uniform int instanceFormat;
 
 layout (location = 0) out VSOut
 {
@@ -18,6 +26,6 @@ layout (location = 0) out VSOut
 
 void main()
 {
-	gl_Position = projection * view * model * instanceModel * vec4(aPos, 1.0f);
+	gl_Position = projection * view * model * DecodeInstance(instanceFormat, instance0, instance1, instance2, instance3) * vec4(aPos, 1.0f);
 	vsOut.TexCoords = aTexCoords;
 }
\ No newline at end of file
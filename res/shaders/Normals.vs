@@ -1,13 +1,8 @@
-#version 430 core
+#version 460 core
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 
-layout (std140) uniform Matrixes
-{
-	uniform mat4 view;			//64
-	uniform mat4 projection;	//64
-};
-uniform mat4 model;
+#include "Common/FrameData.glsl"
 
 out VSOut
 {
@@ -16,8 +11,10 @@ out VSOut
 
 void main()
 {
-	gl_Position = projection * view * model * vec4(aPos, 1.0);
+	ObjectData object = objects[gl_BaseInstance];
+	gl_Position = viewProjection * object.model * vec4(aPos, 1.0);
 	
-	mat3 normalMatrix = mat3(transpose(inverse(view * model)));
+	// The view matrix is orthonormal, its inverse transpose is itself
+	mat3 normalMatrix = mat3(view) * mat3(object.normalMatrix);
 	vsOut.Normal = normalize(vec3(projection * vec4(normalMatrix * aNormal, 0.0)));
 }
\ No newline at end of file
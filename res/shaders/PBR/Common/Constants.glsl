@@ -0,0 +1 @@
+const float PI = 3.14159265359;
@@ -0,0 +1,103 @@
+// Light structures and their direct lighting, only lights that are on are uploaded
+#include "BRDF.glsl"
+
+struct DirLight
+{
+	vec3 direction;
+	vec3 color;
+};
+
+struct PointLight
+{    
+	vec3 position;
+	vec3 color;
+	
+	float constant;
+	float linear;
+	float quadratic;  
+};
+
+struct SpotLight
+{
+	vec3 position;
+	vec3 direction;
+	vec3 color;
+	
+	float cutOff;
+	float outerCutOff;
+
+	float constant;
+	float linear;
+	float quadratic;  
+};  
+
+// ----------------------------------------------------------------------------
+// Outgoing radiance for unit light radiance coming from lightDir
+vec3 CookTorrance(vec3 normal, vec3 viewDir, vec3 lightDir, vec3 F0, float roughness, float metalness, vec3 albedo)
+{
+	vec3 halfwayDir = normalize(lightDir + viewDir);
+
+	// Cook-Torrance BRDF
+	float NDF = DistributionGGX(normal, halfwayDir, roughness);   
+	float G   = GeometrySmith(normal, viewDir, lightDir, roughness);    
+	vec3  F   = fresnelSchlick(max(dot(halfwayDir, viewDir), 0.0), F0);        
+	
+	// scale light by NdotL
+	float NdotL = max(dot(normal, lightDir), 0.0);    
+	
+	vec3 numerator    = NDF * G * F;
+	float denominator = 4.0 * max(dot(normal, viewDir), 0.0) * NdotL + 0.0001; // + 0.0001 to prevent divide by zero
+	vec3 specular = numerator / denominator;
+	
+	 // kS is equal to Fresnel
+	vec3 kS = F;
+	// for energy conservation, the diffuse and specular light can't
+	// be above 1.0 (unless the surface emits light); to preserve this
+	// relationship the diffuse component (kD) should equal 1.0 - kS.
+	vec3 kD = vec3(1.0) - kS;
+	// multiply kD by the inverse metalness such that only non-metals 
+	// have diffuse lighting, or a linear blend if partly metal (pure metals
+	// have no diffuse light).
+	kD *= 1.0 - metalness;
+	
+	// note that we already multiplied the BRDF by the Fresnel (kS) so we won't multiply by kS again
+	return (kD * albedo / PI + specular) * NdotL;
+}
+
+// ----------------------------------------------------------------------------
+vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir, vec3 F0, float roughness, float metalness, vec3 albedo, float shadow)
+{
+	vec3 lightDir = normalize(-light.direction);
+	return CookTorrance(normal, viewDir, lightDir, F0, roughness, metalness, albedo) * (1.0f - shadow) * light.color;
+}
+
+// ----------------------------------------------------------------------------
+vec3 CalcPointLight(PointLight light, vec3 normal, vec3 worldPos, vec3 viewDir, vec3 F0, float roughness, float metalness, vec3 albedo)
+{
+	vec3 lightDir = normalize(light.position - worldPos);
+	
+	// Calculate attenuation of light in distance
+	float distance = length(light.position - worldPos);
+	float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));
+	
+	vec3 radiance = light.color * attenuation;
+	return CookTorrance(normal, viewDir, lightDir, F0, roughness, metalness, albedo) * radiance;
+}
+
+// ----------------------------------------------------------------------------
+vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 worldPos, vec3 viewDir, vec3 F0, float roughness, float metalness, vec3 albedo)
+{
+	vec3 lightDir = normalize(light.position - worldPos);
+	
+	// Calculate intensity of light on egdes
+	float theta = dot(lightDir, normalize(-light.direction));
+	float epsilon = light.cutOff - light.outerCutOff;
+	float intensity = clamp((theta - light.outerCutOff) / epsilon, 0.0f, 1.0f);
+	
+	// Calculate attenuation of light in distance
+	float distance = length(light.position - worldPos);
+	float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));  
+	
+	vec3 radiance = light.color * attenuation * intensity;
+	return CookTorrance(normal, viewDir, lightDir, F0, roughness, metalness, albedo) * radiance;
+}
@@ -7,6 +7,20 @@ layout (location = 0) in FSIn
 	vec4 WorldPosLightSpace;
 } fsIn;
 
+// Light counts, SHADOWS and REFRACTION are injected by the shader permutation
+#ifndef POINT_LIGHTS_COUNT
+#define POINT_LIGHTS_COUNT 4
+#endif
+#ifndef SPOT_LIGHTS_COUNT
+#define SPOT_LIGHTS_COUNT 2
+#endif
+#ifndef DIR_LIGHTS_COUNT
+#define DIR_LIGHTS_COUNT 1
+#endif
+
+#include "Common/Lights.glsl"
+#include "../Common/FrameData.glsl"
+
 const int MAX_MATERIAL_MAPS_COUNT = 1;
 
 // material parameters
@@ -20,77 +34,36 @@ struct Material
 	sampler2D ambientocclusion[MAX_MATERIAL_MAPS_COUNT];
 };
 
-struct DirLight
-{
-	bool isOn;
-	
-	vec3 direction;
-	vec3 color;
-};
-
-struct PointLight
-{    
-	bool isOn;
-	
-	vec3 position;
-	vec3 color;
-	
-	float constant;
-	float linear;
-	float quadratic;  
-};
-
-struct SpotLight
-{
-	bool isOn;
-	
-	vec3 position;
-	vec3 direction;
-	vec3 color;
-	
-	float cutOff;
-	float outerCutOff;
-
-	float constant;
-	float linear;
-	float quadratic;  
-
-};  
-
 // IBL
 uniform samplerCube irradianceMap;
 uniform samplerCube prefilterMap;
 uniform sampler2D brdfLUT;
+#ifdef SHADOWS
 uniform sampler2D shadowMap;
+#endif
 
 // lights
-uniform PointLight pointLights[4];
-uniform SpotLight spotLights[2];
-uniform DirLight dirLights[1];
+#if POINT_LIGHTS_COUNT > 0
+uniform PointLight pointLights[POINT_LIGHTS_COUNT];
+#endif
+#if SPOT_LIGHTS_COUNT > 0
+uniform SpotLight spotLights[SPOT_LIGHTS_COUNT];
+#endif
+#if DIR_LIGHTS_COUNT > 0
+uniform DirLight dirLights[DIR_LIGHTS_COUNT];
+#endif
 
 uniform Material material;
 
-uniform bool isRefract;
-uniform vec3 camPos;
-
 layout (location = 0) out vec4 FragColor;
 layout (location = 1) out vec4 BrightColor;
 
-const float PI = 3.14159265359;
 // ----------------------------------------------------------------------------
 // Easy trick to get tangent-normals to world-space to keep PBR code simplified.
 // Don't worry if you don't get what's going on; you generally want to do normal 
 // mapping the usual way for performance anways; I do plan make a note of this 
 // technique somewhere later in the normal mapping tutorial.
 vec3 getNormalFromMap(vec3 worldPos, vec2 texCoords, vec3 normal, sampler2D normalMap);
-float DistributionGGX(vec3 N, vec3 H, float roughness);
-float GeometrySchlickGGX(float NdotV, float roughness);
-float GeometrySmith(vec3 N, vec3 V, vec3 L, float roughness);
-vec3 fresnelSchlick(float cosTheta, vec3 F0);
-vec3 fresnelSchlickRoughness(float cosTheta, vec3 F0, float roughness);
-vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir, vec3 F0, float roughness, float metalness, vec3 albedo, vec4 worldPosLightSpace);
-vec3 CalcPointLight(PointLight light, vec3 normal, vec3 worldPos, vec3 viewDir, vec3 F0, float roughness, float metalness, vec3 albedo);
-vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 worldPos, vec3 viewDir, vec3 F0, float roughness, float metalness, vec3 albedo);
 float ShadowCalculation(vec4 worldPosLightSpace, vec3 normal, vec3 lightDir);
 
 void main()
@@ -110,7 +83,7 @@ void main()
     // input lighting data
     vec3 normal = getNormalFromMap(fsIn.WorldPos, fsIn.TexCoords, fsIn.Normal, material.normal[0]);
 	// View position
-    vec3 viewDir = normalize(camPos - fsIn.WorldPos);
+    vec3 viewDir = normalize(cameraPosition.xyz - fsIn.WorldPos);
     vec3 refl = reflect(-viewDir, normal); 
 
     // calculate reflectance at normal incidence; if dia-electric (like plastic) use F0 
@@ -120,15 +93,32 @@ void main()
 
     // reflectance equation
     vec3 Lo = vec3(0.0);
-    for(int i = 0; i < 4; ++i) 
+#if POINT_LIGHTS_COUNT > 0
+    for(int i = 0; i < POINT_LIGHTS_COUNT; ++i) 
     {
 		Lo += CalcPointLight(pointLights[i], normal, fsIn.WorldPos, viewDir, F0, roughness, metalness, albedo);
     }
-    for(int i = 0; i < 2; ++i) 
+#endif
+#if SPOT_LIGHTS_COUNT > 0
+    for(int i = 0; i < SPOT_LIGHTS_COUNT; ++i) 
     {
 		Lo += CalcSpotLight(spotLights[i], normal, fsIn.WorldPos, viewDir, F0, roughness, metalness, albedo);
 	}
-    Lo += CalcDirLight(dirLights[0], normal, viewDir, F0, roughness, metalness, albedo, fsIn.WorldPosLightSpace);
+#endif
+#if DIR_LIGHTS_COUNT > 0
+    for(int i = 0; i < DIR_LIGHTS_COUNT; ++i) 
+    {
+		float shadow = 0.0f;
+#ifdef SHADOWS
+		// Only the first directional light renders a shadow map
+		if (i == 0)
+		{
+			shadow = ShadowCalculation(fsIn.WorldPosLightSpace, normal, normalize(-dirLights[i].direction));
+		}
+#endif
+		Lo += CalcDirLight(dirLights[i], normal, viewDir, F0, roughness, metalness, albedo, shadow);
+	}
+#endif
     // ambient lighting (we now use IBL as the ambient term)
     vec3 F = fresnelSchlickRoughness(max(dot(normal, viewDir), 0.0), F0, roughness);
     
@@ -149,17 +139,14 @@ void main()
     
     vec3 color = ambient + Lo + emission * 5.0f;
 	
-	if (isRefract)
-	{
-		float ratio = 1.00 / 1.52;
-		vec3 I = normalize(fsIn.WorldPos - camPos);
-		vec3 R = refract(I, normal, ratio);
-		FragColor = vec4(texture(prefilterMap, R).rgb, 1.0);
-	}
-	else
-	{
-		FragColor = vec4(color , 1.0);
-	}
+#ifdef REFRACTION
+	float ratio = 1.00 / 1.52;
+	vec3 I = normalize(fsIn.WorldPos - cameraPosition.xyz);
+	vec3 R = refract(I, normal, ratio);
+	FragColor = vec4(texture(prefilterMap, R).rgb, 1.0);
+#else
+	FragColor = vec4(color , 1.0);
+#endif
 	
     float brightness = dot(color, vec3(0.2126f, 0.7152f, 0.0722f));
     if(brightness > 1.0f)
@@ -173,146 +160,7 @@ void main()
 }
 
 
-// ----------------------------------------------------------------------------
-vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir, vec3 F0, float roughness, float metalness, vec3 albedo, vec4 worldPosLightSpace)
-{
-	if (!light.isOn)
-	{
-		return vec3(0.0f);
-	}
-	
-	vec3 lightDir = normalize(-light.direction);
-    vec3 halfwayDir = normalize(lightDir + viewDir);
-
-	// Cook-Torrance BRDF
-	float NDF = DistributionGGX(normal, halfwayDir, roughness);   
-	float G   = GeometrySmith(normal, viewDir, lightDir, roughness);    
-	vec3  F   = fresnelSchlick(max(dot(halfwayDir, viewDir), 0.0), F0);        
-	
-	// scale light by NdotL
-	float NdotL = max(dot(normal, lightDir), 0.0);    
-	
-	vec3 numerator    = NDF * G * F;
-	float denominator = 4.0 * max(dot(normal, viewDir), 0.0) * NdotL + 0.0001; // + 0.0001 to prevent divide by zero
-	vec3 specular = numerator / denominator;
-	
-	 // kS is equal to Fresnel
-	vec3 kS = F;
-	// for energy conservation, the diffuse and specular light can't
-	// be above 1.0 (unless the surface emits light); to preserve this
-	// relationship the diffuse component (kD) should equal 1.0 - kS.
-	vec3 kD = vec3(1.0) - kS;
-	// multiply kD by the inverse metalness such that only non-metals 
-	// have diffuse lighting, or a linear blend if partly metal (pure metals
-	// have no diffuse light).
-	kD *= 1.0 - metalness;
-	
-    float shadow = ShadowCalculation(worldPosLightSpace, normal,  lightDir);   
-	
-	// note that we already multiplied the BRDF by the Fresnel (kS) so we won't multiply by kS again
-	return (kD * albedo / PI + specular) * (1.0f - shadow) * light.color * NdotL;
-
-}
-
-// ----------------------------------------------------------------------------
-vec3 CalcPointLight(PointLight light, vec3 normal, vec3 worldPos, vec3 viewDir, vec3 F0, float roughness, float metalness, vec3 albedo)
-{
-	if (!light.isOn)
-	{
-		return vec3(0.0f);
-	}
-	
-	// calculate per-light radiance
-	vec3 lightDir = normalize(light.position - worldPos);
-	vec3 halfwayDir = normalize(viewDir + lightDir);
-	
-	
-	// Calculate attenuation of light in distance
-	float distance = length(light.position - worldPos);
-	float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));
-	
-	vec3 radiance = light.color * attenuation;
-
-	// Cook-Torrance BRDF
-	float NDF = DistributionGGX(normal, halfwayDir, roughness);   
-	float G   = GeometrySmith(normal, viewDir, lightDir, roughness);    
-	vec3  F   = fresnelSchlick(max(dot(halfwayDir, viewDir), 0.0), F0);        
-	
-	
-	// scale light by NdotL
-	float NdotL = max(dot(normal, lightDir), 0.0);    
-	
-	vec3 numerator    = NDF * G * F;
-	float denominator = 4.0 * max(dot(normal, viewDir), 0.0) * NdotL + 0.0001; // + 0.0001 to prevent divide by zero
-	vec3 specular = numerator / denominator;
-	
-	 // kS is equal to Fresnel
-	vec3 kS = F;
-	// for energy conservation, the diffuse and specular light can't
-	// be above 1.0 (unless the surface emits light); to preserve this
-	// relationship the diffuse component (kD) should equal 1.0 - kS.
-	vec3 kD = vec3(1.0) - kS;
-	// multiply kD by the inverse metalness such that only non-metals 
-	// have diffuse lighting, or a linear blend if partly metal (pure metals
-	// have no diffuse light).
-	kD *= 1.0 - metalness;
-	
-	// note that we already multiplied the BRDF by the Fresnel (kS) so we won't multiply by kS again
-	return (kD * albedo / PI + specular) * radiance * NdotL;
-}
-
-// ----------------------------------------------------------------------------
-vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 worldPos, vec3 viewDir, vec3 F0, float roughness, float metalness, vec3 albedo)
-{
-	if (!light.isOn)
-	{
-		return vec3(0.0f);
-	}
-	
-	vec3 lightDir = normalize(light.position - worldPos);
-	vec3 halfwayDir = normalize(lightDir + viewDir);
-	
-	// Calculate intensity of light on egdes
-	float theta = dot(lightDir, normalize(-light.direction));
-	float epsilon = light.cutOff - light.outerCutOff;
-	float intensity = clamp((theta - light.outerCutOff) / epsilon, 0.0f, 1.0f);
-	
-	
-	// Calculate attenuation of light in distance
-	float distance = length(light.position - worldPos);
-	float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));  
-	
-	
-	vec3 radiance = light.color * attenuation * intensity;
-
-	// Cook-Torrance BRDF
-	float NDF = DistributionGGX(normal, halfwayDir, roughness);   
-	float G   = GeometrySmith(normal, viewDir, lightDir, roughness);    
-	vec3  F   = fresnelSchlick(max(dot(halfwayDir, viewDir), 0.0), F0);        
-	
-	
-	// scale light by NdotL
-	float NdotL = max(dot(normal, lightDir), 0.0);    
-	
-	vec3  numerator   = NDF * G * F;
-	float denominator = 4.0 * max(dot(normal, viewDir), 0.0) * NdotL + 0.0001; // + 0.0001 to prevent divide by zero
-	vec3  specular    = numerator / denominator;
-	
-	 // kS is equal to Fresnel
-	vec3 kS = F;
-	// for energy conservation, the diffuse and specular light can't
-	// be above 1.0 (unless the surface emits light); to preserve this
-	// relationship the diffuse component (kD) should equal 1.0 - kS.
-	vec3 kD = vec3(1.0) - kS;
-	// multiply kD by the inverse metalness such that only non-metals 
-	// have diffuse lighting, or a linear blend if partly metal (pure metals
-	// have no diffuse light).
-	kD *= 1.0 - metalness;
-	
-	// note that we already multiplied the BRDF by the Fresnel (kS) so we won't multiply by kS again
-	return (kD * albedo / PI + specular) * radiance * NdotL;
-}
-
+#ifdef SHADOWS
 // ----------------------------------------------------------------------------
 float ShadowCalculation(vec4 worldPosLightSpace, vec3 normal, vec3 lightDir)
 {
@@ -346,6 +194,7 @@ float ShadowCalculation(vec4 worldPosLightSpace, vec3 normal, vec3 lightDir)
 
     return shadow;
 }
+#endif
 
 // ----------------------------------------------------------------------------
 vec3 getNormalFromMap(vec3 worldPos, vec2 texCoords, vec3 normal, sampler2D normalMap)
@@ -364,53 +213,3 @@ vec3 getNormalFromMap(vec3 worldPos, vec2 texCoords, vec3 normal, sampler2D norm
 
     return normalize(TBN * tangentNormal);
 }
-
-// ----------------------------------------------------------------------------
-float DistributionGGX(vec3 N, vec3 H, float roughness)
-{
-    float a = roughness*roughness;
-    float a2 = a*a;
-    float NdotH = max(dot(N, H), 0.0);
-    float NdotH2 = NdotH*NdotH;
-
-    float nom   = a2;
-    float denom = (NdotH2 * (a2 - 1.0) + 1.0);
-    denom = PI * denom * denom;
-
-    return nom / denom;
-}
-
-// ----------------------------------------------------------------------------
-float GeometrySchlickGGX(float NdotV, float roughness)
-{
-    float r = (roughness + 1.0);
-    float k = (r*r) / 8.0;
-
-    float nom   = NdotV;
-    float denom = NdotV * (1.0 - k) + k;
-
-    return nom / denom;
-}
-
-// ----------------------------------------------------------------------------
-float GeometrySmith(vec3 N, vec3 V, vec3 L, float roughness)
-{
-    float NdotV = max(dot(N, V), 0.0);
-    float NdotL = max(dot(N, L), 0.0);
-    float ggx2 = GeometrySchlickGGX(NdotV, roughness);
-    float ggx1 = GeometrySchlickGGX(NdotL, roughness);
-
-    return ggx1 * ggx2;
-}
-
-// ----------------------------------------------------------------------------
-vec3 fresnelSchlick(float cosTheta, vec3 F0)
-{
-    return F0 + (1.0 - F0) * pow(clamp(1.0 - cosTheta, 0.0, 1.0), 5.0);
-}
-
-// ----------------------------------------------------------------------------
-vec3 fresnelSchlickRoughness(float cosTheta, vec3 F0, float roughness)
-{
-    return F0 + (max(vec3(1.0 - roughness), F0) - F0) * pow(clamp(1.0 - cosTheta, 0.0, 1.0), 5.0);
-}   
\ No newline at end of file
@@ -1,16 +1,26 @@
-#version 430 core
+#version 460 core
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoords;
+#if defined(SKINNING) || defined(BAKED_ANIMATION)
+layout (location = 4) in ivec4 skinIndices;
+layout (location = 5) in vec4  skinWeights;
+#endif
+#ifdef BAKED_ANIMATION
+// Per instance, the matrix takes locations 6 to 9
+layout (location = 6) in mat4 instanceModel;
+layout (location = 10) in uint instanceClip;
+layout (location = 11) in float instanceTimeOffset;
+#endif
 
-layout (std140) uniform Matrixes
-{
-	uniform mat4 view;			//64
-	uniform mat4 projection;	//64
-};
-uniform mat4 model;
-uniform mat4 lightSpace;
+#include "../Common/FrameData.glsl"
 
+#if defined(SKINNING) || defined(BAKED_ANIMATION)
+#include "../Common/Skinning.glsl"
+#endif
+#ifdef BAKED_ANIMATION
+#include "../Common/BakedAnimation.glsl"
+#endif
 
 layout (location = 0) out VSOut
 {
@@ -22,10 +32,33 @@ layout (location = 0) out VSOut
 
 void main()
 {
+#ifdef BAKED_ANIMATION
+    // Instances carry their world transform, rigid or uniformly scaled so it transforms normals as well
+    const mat4 model = instanceModel;
+    const mat3 normalMatrix = mat3(instanceModel);
+#else
+    // Draws pass the index of their first object as base instance, instances follow it
+    ObjectData object = objects[gl_BaseInstance + gl_InstanceID];
+    const mat4 model = object.model;
+    const mat3 normalMatrix = mat3(object.normalMatrix);
+#endif
+
+    vec3 localPos = aPos;
+    vec3 localNormal = aNormal;
+#ifdef SKINNING
+    SkinVertex(object.boneOffset, skinIndices, skinWeights, localPos, localNormal);
+#elif defined(BAKED_ANIMATION)
+    SkinBakedVertex(instanceClip, instanceTimeOffset, skinIndices, skinWeights, localPos, localNormal);
+#endif
+
     vsOut.TexCoords = aTexCoords;
-    vsOut.WorldPos = vec3(model * vec4(aPos, 1.0f));
-    vsOut.Normal = mat3(model) * aNormal;   
+    vsOut.WorldPos = vec3(model * vec4(localPos, 1.0f));
+    vsOut.Normal = normalMatrix * localNormal;
 
-    gl_Position =  projection * view * vec4(vsOut.WorldPos, 1.0f);
+    gl_Position = viewProjection * vec4(vsOut.WorldPos, 1.0f);
+#ifdef SHADOWS
     vsOut.WorldPosLightSpace = lightSpace * vec4(vsOut.WorldPos, 1.0f);
-}
\ No newline at end of file
+#else
+    vsOut.WorldPosLightSpace = vec4(0.0f);
+#endif
+}
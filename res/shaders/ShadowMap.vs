@@ -1,10 +1,25 @@
-#version 430 core
+#version 460 core
 layout (location = 0) in vec3 aPos;
+#ifdef SKINNING
+layout (location = 4) in ivec4 skinIndices;
+layout (location = 5) in vec4  skinWeights;
+#endif
+
+#include "Common/FrameData.glsl"
+#ifdef SKINNING
+#include "Common/Skinning.glsl"
+#endif
 
 uniform mat4 lightSpaceMatrix;
-uniform mat4 model;
 
 void main()
 {
-    gl_Position = lightSpaceMatrix * model * vec4(aPos, 1.0);
-}
\ No newline at end of file
+    ObjectData object = objects[gl_BaseInstance + gl_InstanceID];
+    vec3 localPos = aPos;
+#ifdef SKINNING
+    // Unused, the depth pass only needs the position
+    vec3 localNormal = vec3(0.0f);
+    SkinVertex(object.boneOffset, skinIndices, skinWeights, localPos, localNormal);
+#endif
+    gl_Position = lightSpaceMatrix * object.model * vec4(localPos, 1.0);
+}
@@ -1,24 +1,23 @@
 #include "Public/Animation.h"
 #include "Public/SkinnedModel.h"
 #include "Public/BoneInfo.h"
+#include "Public/ClipCache.h"
 #include <assimp/scene.h>
 #include <assimp/Importer.hpp>
 #include <assimp/postprocess.h>
 #include <glm/gtx/matrix_decompose.hpp>
+#include <chrono>
+#include <cstdio>
 
-Animation::Animation(const std::string& animationPath, SkinnedModel* model)
+Animation::Animation(const std::string& animationPath, SkinnedModel* model, uint32_t clipIndex)
 {
-	Assimp::Importer importer;
-	const aiScene* scene = importer.ReadFile(animationPath, aiProcess_Triangulate);
-	assert(scene && scene->mRootNode);
-	aiAnimation* animation = scene->mAnimations[0];
-	m_Duration = animation->mDuration;
-	m_TicksPerSecond = animation->mTicksPerSecond;
-	//std::cout << animation->mDuration << " " << animation->mTicksPerSecond << std::endl;
-	//aiMatrix4x4 globalTransformation = scene->mRootNode->mTransformation;
-	//globalTransformation = globalTransformation.Inverse();
-	ReadHierarchyData(m_RootNode, scene->mRootNode);
-	ReadMissingBones(animation, *model);
+	ClipFileData data;
+	if (!ReadClipFile(animationPath, data) || clipIndex >= data.Clips.size())
+	{
+		fprintf(stderr, "ERROR::ANIMATION::No clip %u in %s\n", clipIndex, animationPath.c_str());
+		return;
+	}
+	*this = Animation(data.Clips[clipIndex], data.Root, *model);
 	//for (auto& c : m_Bones)
 	//{
 	//	std::cout << c.GetBoneName() << std::endl;
@@ -35,6 +34,72 @@ Animation::Animation(const std::string& animationPath, SkinnedModel* model)
 	//}
 }
 
+Animation::Animation(ClipData& clip, const AssimpNodeData& rootNode, SkinnedModel& model)
+	: m_Name(clip.Name)
+	, m_Duration(clip.Duration)
+	, m_TicksPerSecond(clip.TicksPerSecond)
+	, m_RootNode(rootNode)
+{
+	ReadMissingBones(clip, model);
+}
+
+std::vector<Animation> Animation::LoadAll(const std::string& animationPath, SkinnedModel* model)
+{
+	std::vector<Animation> clips;
+	ClipFileData data;
+	if (ReadClipFile(animationPath, data))
+	{
+		clips.reserve(data.Clips.size());
+		for (ClipData& clip : data.Clips)
+		{
+			clips.push_back(Animation(clip, data.Root, *model));
+		}
+	}
+	return clips;
+}
+
+bool Animation::ReadClipFile(const std::string& animationPath, ClipFileData& data)
+{
+	const uint64_t key = ClipCache::GetKey(animationPath);
+	if (ClipCache::Load(key, data))
+	{
+		return true;
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	Assimp::Importer importer;
+	const aiScene* scene = importer.ReadFile(animationPath, aiProcess_Triangulate);
+	if (!scene || !scene->mRootNode || scene->mNumAnimations == 0)
+	{
+		fprintf(stderr, "ERROR::ANIMATION::No animations in %s\n", animationPath.c_str());
+		return false;
+	}
+
+	ReadHierarchyData(data.Root, scene->mRootNode);
+	data.Clips.resize(scene->mNumAnimations);
+	for (uint32_t i = 0; i < scene->mNumAnimations; ++i)
+	{
+		const aiAnimation* animation = scene->mAnimations[i];
+		ClipData& clip = data.Clips[i];
+		clip.Name = animation->mName.C_Str();
+		clip.Duration = animation->mDuration;
+		clip.TicksPerSecond = animation->mTicksPerSecond;
+		clip.Channels.resize(animation->mNumChannels);
+		for (uint32_t j = 0; j < animation->mNumChannels; ++j)
+		{
+			// Converted by Bone so cached and imported keys are the same
+			Bone bone(animation->mChannels[j]->mNodeName.C_Str(), -1, animation->mChannels[j]);
+			clip.Channels[j].Name = bone.GetBoneName();
+			clip.Channels[j].Positions = std::move(bone.m_Positions);
+			clip.Channels[j].Rotations = std::move(bone.m_Rotations);
+		}
+	}
+	ClipCache::AddImportTime(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+
+	ClipCache::Save(key, data);
+	return true;
+}
+
 Bone* Animation::FindBone(const std::string& name)
 {
 	auto iter = std::find_if(m_Bones.begin(), m_Bones.end(),
@@ -54,29 +119,90 @@ Bone* Animation::FindBone(const std::string& name)
 	}
 }
 
-float Animation::GetTicksPerSecond()
+int32_t Animation::FindBoneIndex(const std::string& name) const
+{
+	for (int32_t i = 0; i < m_Bones.size(); ++i)
+	{
+		if (m_Bones[i].GetBoneName() == name)
+		{
+			return i;
+		}
+	}
+	return -1;
+}
+
+Bone& Animation::GetBone(int32_t index)
+{
+	return m_Bones[index];
+}
+
+const Bone& Animation::GetBone(int32_t index) const
+{
+	return m_Bones[index];
+}
+
+uint32_t Animation::GetBoneCount() const
+{
+	return m_Bones.size();
+}
+
+void Animation::Resample(float keysPerSecond)
+{
+	for (Bone& bone : m_Bones)
+	{
+		bone.Resample(keysPerSecond / m_TicksPerSecond);
+	}
+}
+
+const std::string& Animation::GetName() const
+{
+	return m_Name;
+}
+
+float Animation::GetTicksPerSecond() const
 {
 	return m_TicksPerSecond;
 }
 
-float Animation::GetDuration()
+float Animation::GetDuration() const
 {
 	return m_Duration;
 }
 
-const AssimpNodeData& Animation::GetRootNode()
+const AssimpNodeData& Animation::GetRootNode() const
 { 
 	return m_RootNode;
 }
 
-const std::unordered_map<std::string, BoneInfo>& Animation::GetBoneIDMap()
+const std::unordered_map<std::string, BoneInfo>& Animation::GetBoneIDMap() const
 { 
-	return m_BoneInfoMap;
+	static const std::unordered_map<std::string, BoneInfo> empty;
+	return m_BoneInfoMap ? *m_BoneInfoMap : empty;
+}
+
+size_t Animation::GetMemorySize() const
+{
+	size_t size = sizeof(Animation) + GetNodeMemorySize(m_RootNode) - sizeof(AssimpNodeData);
+	for (const Bone& bone : m_Bones)
+	{
+		size += bone.GetMemorySize();
+	}
+	return size + (m_Bones.capacity() - m_Bones.size()) * sizeof(Bone);
+}
+
+size_t Animation::GetNodeMemorySize(const AssimpNodeData& node)
+{
+	size_t size = sizeof(AssimpNodeData) + node.name.capacity() + (node.children.capacity() - node.children.size()) * sizeof(AssimpNodeData);
+	for (const AssimpNodeData& child : node.children)
+	{
+		size += GetNodeMemorySize(child);
+	}
+	return size;
 }
 
-void Animation::ReadMissingBones(const aiAnimation* animation, SkinnedModel& model)
+void Animation::ReadMissingBones(ClipData& clip, SkinnedModel& model)
 {
-	int32_t size = animation->mNumChannels;
+	int32_t size = clip.Channels.size();
 
 	std::unordered_map<std::string, BoneInfo>& modelBoneInfoMap = model.GetBoneInfoMap();//getting m_BoneInfoMap from Model class
 	int32_t boneCount = model.GetBoneCount(); //getting the m_BoneCounter from Model class
@@ -84,22 +210,25 @@ void Animation::ReadMissingBones(const aiAnimation* animation, SkinnedModel& mod
 	//reading channels(bones engaged in an animation and their keyframes)
 	for (int32_t i = 0; i < size; i++)
 	{
-		aiNodeAnim* channel = animation->mChannels[i];
-		std::string boneName = channel->mNodeName.data;
+		ClipChannel& channel = clip.Channels[i];
+		const std::string& boneName = channel.Name;
 
 		//if (modelBoneInfoMap.find(boneName) == modelBoneInfoMap.end())
 		//{
 		//	modelBoneInfoMap[boneName].ID = boneCount;
 		//	boneCount++;
 		//}
-		m_Bones.push_back(Bone(channel->mNodeName.data, modelBoneInfoMap[channel->mNodeName.data].ID, channel));
+		// Channels of nodes without skinned vertices get no palette slot, indexing the map would insert one with ID 0
+		auto boneInfo = modelBoneInfoMap.find(boneName);
+		int32_t boneID = boneInfo != modelBoneInfoMap.end() ? boneInfo->second.ID : -1;
+		m_Bones.push_back(Bone(boneName, boneID, std::move(channel.Positions), std::move(channel.Rotations)));
 	}
 	//for (auto& b : m_Bones)
 	//{
 	//	std::cout << b.GetBoneName() << " " << b.GetBoneID() << std::endl;
 	//}
 
-	m_BoneInfoMap = modelBoneInfoMap;
+	m_BoneInfoMap = &modelBoneInfoMap;
 }
 
 void Animation::ReadHierarchyData(AssimpNodeData& dest, const aiNode* src)
@@ -0,0 +1,157 @@
+#include "Public/AnimationLibrary.h"
+#include "Public/Animation.h"
+#include "Public/Animator.h"
+#include "Public/Skeleton.h"
+#include "Public/SkinnedModel.h"
+
+#include <cstdio>
+
+namespace
+{
+	// Node based map: a node per entry holding the key and value next to the chain pointer, plus the bucket array
+	size_t GetBoneMapMemorySize(const std::unordered_map<std::string, BoneInfo>& Map)
+	{
+		size_t size = sizeof(Map) + Map.bucket_count() * sizeof(void*);
+		for (const auto& entry : Map)
+		{
+			size += sizeof(entry) + sizeof(void*) + entry.first.capacity();
+		}
+		return size;
+	}
+}
+
+AnimationLibrary& AnimationLibrary::GetInstance()
+{
+	// Never destroyed, assets are owned by their users
+	static AnimationLibrary* instance = new AnimationLibrary();
+	return *instance;
+}
+
+std::shared_ptr<const Animation> AnimationLibrary::LoadClip(const std::string& Path, SkinnedModel& Model, uint32_t ClipIndex)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	RemoveExpired();
+
+	std::weak_ptr<const Animation>& entry = m_Clips[{ Path, &Model, ClipIndex }];
+	if (std::shared_ptr<const Animation> clip = entry.lock())
+	{
+		return clip;
+	}
+
+	std::shared_ptr<const Animation> clip = std::make_shared<const Animation>(Path, &Model, ClipIndex);
+	if (clip->GetBoneCount() == 0)
+	{
+		fprintf(stderr, "ERROR::ANIMATION_LIBRARY::Clip %s has no channels\n", Path.c_str());
+	}
+	entry = clip;
+	return clip;
+}
+
+std::vector<std::shared_ptr<const Animation>> AnimationLibrary::LoadClips(const std::string& Path, SkinnedModel& Model)
+{
+	std::vector<Animation> loaded = Animation::LoadAll(Path, &Model);
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	RemoveExpired();
+
+	std::vector<std::shared_ptr<const Animation>> clips;
+	for (uint32_t i = 0; i < loaded.size(); ++i)
+	{
+		// Clips loaded one by one earlier stay the shared instance
+		std::weak_ptr<const Animation>& entry = m_Clips[{ Path, &Model, i }];
+		std::shared_ptr<const Animation> clip = entry.lock();
+		if (!clip)
+		{
+			clip = std::make_shared<const Animation>(std::move(loaded[i]));
+			entry = clip;
+		}
+		clips.push_back(clip);
+	}
+	return clips;
+}
+
+std::shared_ptr<const Skeleton> AnimationLibrary::GetSkeleton(const std::shared_ptr<const Animation>& Clip, SkinnedModel& Model)
+{
+	if (!Clip)
+	{
+		return nullptr;
+	}
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	RemoveExpired();
+
+	std::weak_ptr<const Skeleton>& entry = m_Skeletons[Clip.get()];
+	if (std::shared_ptr<const Skeleton> skeleton = entry.lock())
+	{
+		return skeleton;
+	}
+
+	// The deleter owns a reference, joints point at channels of the clip
+	std::shared_ptr<const Skeleton> skeleton(new Skeleton(*Clip, Model), [Clip](const Skeleton* compiled) { delete compiled; });
+	entry = skeleton;
+	return skeleton;
+}
+
+uint32_t AnimationLibrary::GetClipCount()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	RemoveExpired();
+	return m_Clips.size();
+}
+
+uint32_t AnimationLibrary::GetSkeletonCount()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	RemoveExpired();
+	return m_Skeletons.size();
+}
+
+size_t AnimationLibrary::GetMemorySize()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	size_t size = 0;
+	for (const auto& entry : m_Clips)
+	{
+		if (std::shared_ptr<const Animation> clip = entry.second.lock())
+		{
+			size += clip->GetMemorySize();
+		}
+	}
+	for (const auto& entry : m_Skeletons)
+	{
+		if (std::shared_ptr<const Skeleton> skeleton = entry.second.lock())
+		{
+			size += skeleton->GetMemorySize();
+		}
+	}
+	return size;
+}
+
+void AnimationLibrary::RemoveExpired()
+{
+	std::erase_if(m_Clips, [](const auto& entry) { return entry.second.expired(); });
+	std::erase_if(m_Skeletons, [](const auto& entry) { return entry.second.expired(); });
+}
+
+CharacterMemoryReport AnimationLibrary::ReportCharacterMemory(const std::string& ModelPath, const std::string& ClipPath)
+{
+	SkinnedModel model(ModelPath.c_str());
+	std::shared_ptr<const Animation> clip = GetInstance().LoadClip(ClipPath, model);
+	std::shared_ptr<const Skeleton> skeleton = GetInstance().GetSkeleton(clip, model);
+
+	Animator animator(clip.get());
+	animator.SetSkeleton(skeleton.get());
+	animator.UpdateAnimation(0.0f);
+
+	CharacterMemoryReport report;
+	report.ClipBytes = clip->GetMemorySize();
+	report.BoneMapBytes = GetBoneMapMemorySize(clip->GetBoneIDMap());
+	report.SkeletonBytes = skeleton->GetMemorySize();
+	report.InstanceBytes = animator.GetMemorySize();
+	report.UnsharedBytes = report.ClipBytes + report.BoneMapBytes + report.SkeletonBytes + report.InstanceBytes;
+	report.SharedBytes = report.InstanceBytes;
+
+	fprintf(stdout, "Memory per character: %zu bytes unshared (clip %zu, bone map %zu, skeleton %zu, animator %zu), %zu bytes shared\n",
+		report.UnsharedBytes, report.ClipBytes, report.BoneMapBytes, report.SkeletonBytes, report.InstanceBytes, report.SharedBytes);
+	return report;
+}
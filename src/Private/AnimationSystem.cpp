@@ -0,0 +1,387 @@
+#include "Public/AnimationSystem.h"
+#include "Public/Animation.h"
+#include "Public/Animator.h"
+#include "Public/Skeleton.h"
+#include "Public/SkinnedModel.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+
+AnimationSystem::~AnimationSystem()
+{
+	// The job references this system
+	EndUpdate();
+}
+
+int32_t AnimationSystem::Add(Animator* Animator)
+{
+	if (!Animator->GetSkeleton())
+	{
+		fprintf(stderr, "ERROR::ANIMATION_SYSTEM::Animator has no skeleton\n");
+		return -1;
+	}
+
+	EndUpdate();
+	m_Entries.push_back({ Animator, 0, 0 });
+	AddPalette(m_Entries.back());
+	return m_Entries.size() - 1;
+}
+
+void AnimationSystem::Remove(Animator* Animator)
+{
+	EndUpdate();
+	auto iter = std::find_if(m_Entries.begin(), m_Entries.end(), [&](const Entry& entry) { return entry.Player == Animator; });
+	if (iter != m_Entries.end())
+	{
+		m_Entries.erase(iter);
+		for (std::vector<glm::mat4>& palettes : m_Palettes)
+		{
+			palettes.clear();
+		}
+		m_PreviousPoses.clear();
+		for (Entry& entry : m_Entries)
+		{
+			AddPalette(entry);
+		}
+		// Sources are indexes into m_Entries, the erase moved them
+		ClearCacheSources();
+	}
+}
+
+void AnimationSystem::SetFixedRate(float StepsPerSecond)
+{
+	m_FixedStep = StepsPerSecond > 0.0f ? 1.0f / StepsPerSecond : 0.0f;
+	m_Accumulator = 0.0f;
+}
+
+void AnimationSystem::SetLod(uint32_t Index, const AnimationLod& Lod)
+{
+	// The running update reads the entries
+	EndUpdate();
+	Entry& entry = m_Entries[Index];
+	entry.IsStale |= entry.Lod.Interval != Lod.Interval;
+	entry.Lod = Lod;
+}
+
+AnimationLod AnimationSystem::SelectLod(float ScreenSize, bool IsVisible, const AnimationLodSettings& Settings)
+{
+	AnimationLod lod;
+	if (!Settings.IsEnabled)
+	{
+		return lod;
+	}
+
+	lod.IsVisible = IsVisible;
+	if (ScreenSize < Settings.QuarterRateSize)
+	{
+		lod.Interval = 4;
+	}
+	else if (ScreenSize < Settings.HalfRateSize)
+	{
+		lod.Interval = 2;
+	}
+	if (ScreenSize < Settings.LeafCullingSize)
+	{
+		lod.LeafCulling = Settings.LeafCulling;
+	}
+	return lod;
+}
+
+void AnimationSystem::SetPoseCache(const PoseCacheSettings& Settings)
+{
+	m_PoseCache = Settings;
+}
+
+const PoseCacheSettings& AnimationSystem::GetPoseCache() const
+{
+	return m_PoseCache;
+}
+
+void AnimationSystem::BeginUpdate(float DeltaTime)
+{
+	EndUpdate();
+
+	float step = DeltaTime;
+	m_Steps = 1;
+	if (m_FixedStep > 0.0f)
+	{
+		step = m_FixedStep;
+		m_Accumulator += DeltaTime;
+		m_Steps = std::min(uint32_t(m_Accumulator / m_FixedStep), MAX_STEPS);
+		// Past MAX_STEPS the animation slows down rather than falling further behind every frame
+		m_Accumulator = m_Steps == MAX_STEPS ? 0.0f : m_Accumulator - m_Steps * m_FixedStep;
+	}
+	if (m_Steps == 0 || m_Entries.empty())
+	{
+		return;
+	}
+
+	// Lookups happen before the dispatch, jobs then only evaluate the poses the cache misses
+	const bool isCaching = m_PoseCache.IsEnabled && m_PoseCache.TimeStep > 0.0f;
+	if (isCaching)
+	{
+		AssignCacheSources(m_Steps, step);
+	}
+	else
+	{
+		// Sources of an earlier update would keep showing the pose at their frozen cache time
+		ClearCacheSources();
+	}
+
+	const uint32_t steps = isCaching ? 0 : m_Steps;
+	const uint32_t backIndex = 1 - m_Front;
+	glm::mat4* back = m_Palettes[backIndex].data();
+	m_Update = JobPool::GetInstance().Dispatch(m_Entries.size(), BATCH_SIZE,
+		[this, steps, step, backIndex, back](uint32_t Begin, uint32_t End)
+		{
+			for (uint32_t i = Begin; i < End; ++i)
+			{
+				Entry& entry = m_Entries[i];
+				entry.EvaluatedBones = 0;
+				entry.ReadOffset[backIndex] = entry.PaletteOffset;
+				for (uint32_t s = 0; s < steps; ++s)
+				{
+					entry.Player->AdvanceTime(step);
+				}
+				if (!entry.Lod.IsVisible)
+				{
+					// The palette is not seen, it is refreshed once the animator is visible again
+					entry.IsStale = true;
+					entry.State = EntryState::CLOCK_ONLY;
+					continue;
+				}
+
+				if (entry.CacheSource != NO_CACHE_SOURCE)
+				{
+					// Leaving the cache restarts the LOD interval from a fresh pose
+					entry.IsStale = true;
+					if (entry.CacheSource != i)
+					{
+						// The source writes its palette in this update, only its offset is needed here
+						entry.ReadOffset[backIndex] = m_Entries[entry.CacheSource].PaletteOffset;
+						entry.State = EntryState::CACHED;
+						continue;
+					}
+					entry.Player->SetLeafCulling(entry.Lod.LeafCulling);
+					entry.Player->EvaluatePoseAt(entry.CacheTime);
+					const std::vector<glm::mat4>& palette = entry.Player->GetFinalBoneMatrices();
+					std::copy_n(palette.begin(), std::min<size_t>(entry.PaletteSize, palette.size()), back + entry.PaletteOffset);
+					entry.EvaluatedBones = entry.Player->GetEvaluatedBones();
+					entry.State = EntryState::EVALUATED;
+					continue;
+				}
+
+				const std::vector<glm::mat4>& palette = entry.Player->GetFinalBoneMatrices();
+				const size_t count = std::min<size_t>(entry.PaletteSize, palette.size());
+				glm::mat4* previous = m_PreviousPoses.data() + entry.PaletteOffset;
+				const bool isDue = entry.IsStale || ++entry.Age >= entry.Lod.Interval;
+				if (isDue)
+				{
+					entry.Player->SetLeafCulling(entry.Lod.LeafCulling);
+					// A stale pose may be long gone, blending then starts from the new one
+					if (entry.Lod.Interval > 1 && !entry.IsStale)
+					{
+						std::copy_n(palette.begin(), count, previous);
+					}
+					entry.Player->EvaluatePose();
+					if (entry.Lod.Interval > 1 && entry.IsStale)
+					{
+						std::copy_n(palette.begin(), count, previous);
+					}
+					entry.EvaluatedBones = entry.Player->GetEvaluatedBones();
+					// Spreads the evaluations of animators switching interval together over the interval
+					entry.Age = entry.IsStale ? i % entry.Lod.Interval : 0;
+				}
+
+				if (entry.Lod.Interval <= 1 || entry.IsStale)
+				{
+					std::copy_n(palette.begin(), count, back + entry.PaletteOffset);
+				}
+				else
+				{
+					// Trails the evaluated pose by up to Interval - 1 frames, poses this close blend per element
+					const float alpha = std::min(float(entry.Age + 1) / entry.Lod.Interval, 1.0f);
+					for (size_t bone = 0; bone < count; ++bone)
+					{
+						back[entry.PaletteOffset + bone] = previous[bone] + (palette[bone] - previous[bone]) * alpha;
+					}
+				}
+				entry.IsStale = false;
+				entry.State = isDue ? EntryState::EVALUATED : EntryState::INTERPOLATED;
+			}
+		}
+	);
+}
+
+void AnimationSystem::EndUpdate()
+{
+	if (!m_Update)
+	{
+		return;
+	}
+	JobPool::GetInstance().Wait(m_Update);
+	m_Update.reset();
+	m_Front = 1 - m_Front;
+
+	m_Stats = AnimationSystemStats();
+	for (const Entry& entry : m_Entries)
+	{
+		m_Stats.Evaluated += entry.State == EntryState::EVALUATED ? 1 : 0;
+		m_Stats.Interpolated += entry.State == EntryState::INTERPOLATED ? 1 : 0;
+		m_Stats.ClockOnly += entry.State == EntryState::CLOCK_ONLY ? 1 : 0;
+		m_Stats.CacheHits += entry.State == EntryState::CACHED ? 1 : 0;
+		m_Stats.CacheMisses += entry.State == EntryState::EVALUATED && entry.CacheSource != NO_CACHE_SOURCE ? 1 : 0;
+		m_Stats.EvaluatedBones += entry.EvaluatedBones;
+		m_Stats.FullRateBones += entry.Player->GetSkeleton()->GetChannelCount();
+	}
+}
+
+void AnimationSystem::Update(float DeltaTime)
+{
+	BeginUpdate(DeltaTime);
+	EndUpdate();
+}
+
+const glm::mat4* AnimationSystem::GetPalette(uint32_t Index) const
+{
+	return m_Palettes[m_Front].data() + m_Entries[Index].ReadOffset[m_Front];
+}
+
+uint32_t AnimationSystem::GetPaletteSize(uint32_t Index) const
+{
+	return m_Entries[Index].PaletteSize;
+}
+
+uint32_t AnimationSystem::GetPaletteOffset(uint32_t Index) const
+{
+	return m_Entries[Index].ReadOffset[m_Front];
+}
+
+const std::vector<glm::mat4>& AnimationSystem::GetPalettes() const
+{
+	return m_Palettes[m_Front];
+}
+
+uint32_t AnimationSystem::GetAnimatorCount() const
+{
+	return m_Entries.size();
+}
+
+uint32_t AnimationSystem::GetLastSteps() const
+{
+	return m_Steps;
+}
+
+const AnimationSystemStats& AnimationSystem::GetStats() const
+{
+	return m_Stats;
+}
+
+void AnimationSystem::AddPalette(Entry& Entry)
+{
+	// Both copies start from the current palette, a swap never exposes an empty one
+	const std::vector<glm::mat4>& palette = Entry.Player->GetFinalBoneMatrices();
+	Entry.PaletteOffset = m_Palettes[0].size();
+	Entry.PaletteSize = palette.size();
+	Entry.ReadOffset[0] = Entry.PaletteOffset;
+	Entry.ReadOffset[1] = Entry.PaletteOffset;
+	for (std::vector<glm::mat4>& palettes : m_Palettes)
+	{
+		palettes.insert(palettes.end(), palette.begin(), palette.end());
+	}
+	m_PreviousPoses.insert(m_PreviousPoses.end(), palette.begin(), palette.end());
+}
+
+void AnimationSystem::ClearCacheSources()
+{
+	for (Entry& entry : m_Entries)
+	{
+		// Entries outside the cache keep their LOD interval
+		if (entry.CacheSource != NO_CACHE_SOURCE)
+		{
+			entry.CacheSource = NO_CACHE_SOURCE;
+			entry.IsStale = true;
+		}
+	}
+}
+
+void AnimationSystem::AssignCacheSources(uint32_t Steps, float Step)
+{
+	m_PoseSources.clear();
+	for (uint32_t i = 0; i < m_Entries.size(); ++i)
+	{
+		Entry& entry = m_Entries[i];
+		Animator& player = *entry.Player;
+		for (uint32_t s = 0; s < Steps; ++s)
+		{
+			player.AdvanceTime(Step);
+		}
+
+		entry.CacheSource = NO_CACHE_SOURCE;
+		const Animation* clip = player.GetCurrentAnimation();
+		if (!entry.Lod.IsVisible || !clip || player.IsFading() || clip->GetDuration() <= 0.0f)
+		{
+			continue;
+		}
+
+		// The last step before the end of the clip wraps to its start
+		const float stepTicks = m_PoseCache.TimeStep * clip->GetTicksPerSecond();
+		int64_t step = int64_t(std::floor(player.GetCurrentTime() / stepTicks + 0.5f));
+		if (step * stepTicks >= clip->GetDuration())
+		{
+			step = 0;
+		}
+		const PoseKey key(clip, player.GetSkeleton(), player.GetCompressedClip(), entry.Lod.LeafCulling, step);
+		entry.CacheSource = m_PoseSources.try_emplace(key, i).first->second;
+		entry.CacheTime = step * stepTicks;
+	}
+}
+
+AnimationSystemBenchmarkResult AnimationSystem::Benchmark(const std::string& ModelPath, const std::string& ClipPath, uint32_t Instances, int Frames)
+{
+	using Clock = std::chrono::high_resolution_clock;
+	const float deltaTime = 1.0f / 60.0f;
+
+	SkinnedModel model(ModelPath.c_str());
+	Animation clip(ClipPath, &model);
+	Skeleton skeleton(clip, model);
+
+	AnimationSystemBenchmarkResult result;
+	result.Instances = Instances;
+	result.Threads = JobPool::GetInstance().GetWorkerCount() + 1;
+	result.Frames = std::max(Frames, 1);
+
+	std::vector<std::unique_ptr<Animator>> animators;
+	animators.reserve(Instances);
+	AnimationSystem system;
+	for (uint32_t i = 0; i < Instances; ++i)
+	{
+		animators.push_back(std::make_unique<Animator>(&clip));
+		animators.back()->SetSkeleton(&skeleton);
+		// Spread the instances over the clip so they do not all sample the same keys
+		animators.back()->UpdateAnimation(deltaTime * (i % 97));
+		system.Add(animators.back().get());
+	}
+
+	Clock::time_point start = Clock::now();
+	for (int frame = 0; frame < result.Frames; ++frame)
+	{
+		for (std::unique_ptr<Animator>& animator : animators)
+		{
+			animator->UpdateAnimation(deltaTime);
+		}
+	}
+	result.SerialMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count() / result.Frames;
+
+	start = Clock::now();
+	for (int frame = 0; frame < result.Frames; ++frame)
+	{
+		system.Update(deltaTime);
+	}
+	result.ParallelMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count() / result.Frames;
+
+	return result;
+}
@@ -1,16 +1,29 @@
 #include "Public/Animator.h"
 #include "Public/Animation.h"
 #include "Public/Bone.h"
+#include "Public/Skeleton.h"
+#include "Public/CompressedClip.h"
+#include "Public/SkinnedModel.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
 #include <iostream>
 
-Animator::Animator(Animation* animation)
+namespace
+{
+	// Palette size of animators without a skeleton, bone IDs of the node tree walk stay below it
+	const int32_t MAX_BONES = 512;
+}
+
+Animator::Animator(const Animation* animation)
 {
 	m_CurrentTime = 0.0f;
 	m_CurrentAnimation = animation;
+	m_KeyCursors.assign(animation ? animation->GetBoneCount() * 2 : 0, 0);
 
-	m_FinalBoneMatrices.reserve(512);
+	m_FinalBoneMatrices.reserve(MAX_BONES);
 
-	for (int32_t i = 0; i < 512; ++i)
+	for (int32_t i = 0; i < MAX_BONES; ++i)
 	{
 		m_FinalBoneMatrices.push_back(glm::mat4(1.0f));
 	}
@@ -26,20 +39,212 @@ Animator::Animator(Animation* animation)
 }
 
 void Animator::UpdateAnimation(float dt)
+{
+	AdvanceTime(dt);
+	EvaluatePose();
+}
+
+void Animator::AdvanceTime(float dt)
 {
 	m_DeltaTime = dt;
 	if (m_CurrentAnimation)
 	{
 		m_CurrentTime += m_CurrentAnimation->GetTicksPerSecond() * dt;
 		m_CurrentTime = fmod(m_CurrentTime, m_CurrentAnimation->GetDuration());
-		CalculateBoneTransform(&m_CurrentAnimation->GetRootNode(), glm::mat4(1.0f));
+	}
+	if (m_NextAnimation)
+	{
+		m_NextTime += m_NextAnimation->GetTicksPerSecond() * dt;
+		m_NextTime = fmod(m_NextTime, m_NextAnimation->GetDuration());
+		m_FadeTime += dt;
+		if (m_FadeTime >= m_FadeDuration)
+		{
+			FinishFade();
+		}
 	}
 }
 
-void Animator::PlayAnimation(Animation* pAnimation)
+void Animator::EvaluatePose()
+{
+	if (m_CurrentAnimation)
+	{
+		if (m_NextAnimation)
+		{
+			CalculateBlendedPose();
+		}
+		else if (m_Skeleton && m_Skeleton->GetClip() == m_CurrentAnimation)
+		{
+			CalculatePose();
+		}
+		else
+		{
+			// Bone IDs of other clips may go past a palette trimmed to a skeleton
+			m_FinalBoneMatrices.resize(MAX_BONES, glm::mat4(1.0f));
+			m_KeyCursors.resize(m_CurrentAnimation->GetBoneCount() * 2, 0);
+			CalculateBoneTransform(&m_CurrentAnimation->GetRootNode(), glm::mat4(1.0f));
+		}
+	}
+}
+
+void Animator::EvaluatePoseAt(float Time)
+{
+	const float currentTime = m_CurrentTime;
+	m_CurrentTime = Time;
+	EvaluatePose();
+	m_CurrentTime = currentTime;
+}
+
+void Animator::PlayAnimation(const Animation* pAnimation)
 {
 	m_CurrentAnimation = pAnimation;
 	m_CurrentTime = 0.0f;
+	m_KeyCursors.assign(pAnimation ? pAnimation->GetBoneCount() * 2 : 0, 0);
+	// Cancels a running crossfade
+	m_NextAnimation = nullptr;
+	m_NextSkeleton = nullptr;
+}
+
+void Animator::CrossFade(const Animation* Clip, const Skeleton* ClipSkeleton, float Seconds)
+{
+	bool canFade = Seconds > 0.0f && m_CurrentAnimation && Clip && m_Skeleton && m_Skeleton->GetClip() == m_CurrentAnimation
+		&& ClipSkeleton && ClipSkeleton->GetClip() == Clip && ClipSkeleton->GetJointCount() == m_Skeleton->GetJointCount();
+	for (uint32_t i = 0; canFade && i < m_Skeleton->GetJointCount(); ++i)
+	{
+		canFade = m_Skeleton->GetJoints()[i].Parent == ClipSkeleton->GetJoints()[i].Parent;
+	}
+	if (!canFade)
+	{
+		if (Seconds > 0.0f)
+		{
+			fprintf(stderr, "ERROR::ANIMATOR::Cannot crossfade between these skeletons, switching clips instead\n");
+		}
+		PlayAnimation(Clip);
+		SetSkeleton(ClipSkeleton && ClipSkeleton->GetClip() == Clip ? ClipSkeleton : nullptr);
+		return;
+	}
+
+	m_NextAnimation = Clip;
+	m_NextSkeleton = ClipSkeleton;
+	m_NextKeyCursors.assign(Clip->GetBoneCount() * 2, 0);
+	m_NextTime = 0.0f;
+	m_FadeTime = 0.0f;
+	m_FadeDuration = Seconds;
+}
+
+bool Animator::IsFading() const
+{
+	return m_NextAnimation != nullptr;
+}
+
+float Animator::GetFadeWeight() const
+{
+	return m_NextAnimation ? std::min(m_FadeTime / m_FadeDuration, 1.0f) : 0.0f;
+}
+
+const Animation* Animator::GetCurrentAnimation() const
+{
+	return m_CurrentAnimation;
+}
+
+float Animator::GetCurrentTime() const
+{
+	return m_CurrentTime;
+}
+
+void Animator::FinishFade()
+{
+	m_CurrentAnimation = m_NextAnimation;
+	m_CurrentTime = m_NextTime;
+	m_Skeleton = m_NextSkeleton;
+	m_KeyCursors.swap(m_NextKeyCursors);
+	// The compressed copy belonged to the outgoing clip
+	m_CompressedClip = nullptr;
+	m_NextAnimation = nullptr;
+	m_NextSkeleton = nullptr;
+}
+
+void Animator::SetSkeleton(const Skeleton* skeleton)
+{
+	m_Skeleton = skeleton;
+	m_GlobalTransforms.assign(skeleton ? skeleton->GetJointCount() : 0, glm::mat4(1.0f));
+	m_KeyCursors.assign(skeleton ? skeleton->GetClip()->GetBoneCount() * 2 : 0, 0);
+	// Only the bones the skeleton writes are kept, crowds hold thousands of palettes
+	m_FinalBoneMatrices.assign(skeleton ? skeleton->GetPaletteSize() : MAX_BONES, glm::mat4(1.0f));
+}
+
+const Skeleton* Animator::GetSkeleton() const
+{
+	return m_Skeleton;
+}
+
+void Animator::SetCompressedClip(const CompressedClip* clip)
+{
+	m_CompressedClip = clip;
+}
+
+const CompressedClip* Animator::GetCompressedClip() const
+{
+	return m_CompressedClip;
+}
+
+void Animator::SetLeafCulling(uint32_t depth)
+{
+	m_LeafCulling = depth;
+}
+
+uint32_t Animator::GetLeafCulling() const
+{
+	return m_LeafCulling;
+}
+
+uint32_t Animator::GetEvaluatedBones() const
+{
+	return m_EvaluatedBones;
+}
+
+void Animator::CalculatePose()
+{
+	const std::vector<SkeletonJoint>& joints = m_Skeleton->GetJoints();
+	m_EvaluatedBones = 0;
+	for (size_t i = 0; i < joints.size(); ++i)
+	{
+		const SkeletonJoint& joint = joints[i];
+
+		// Culled joints still follow their parent, only their own motion is dropped
+		glm::mat4 localTransform = joint.BindLocal;
+		const bool isSampled = joint.Channel >= 0 && joint.LeafDistance >= m_LeafCulling;
+		if (isSampled && m_CompressedClip)
+		{
+			localTransform = m_CompressedClip->SampleLocalTransform(joint.Channel, m_CurrentTime);
+		}
+		else if (isSampled)
+		{
+			// The clip may be shared with animators on other threads, the cursors are this animator's
+			const Bone& bone = m_Skeleton->GetClip()->GetBone(joint.Channel);
+			localTransform = bone.SampleLocalTransform(m_CurrentTime, m_KeyCursors[joint.Channel * 2], m_KeyCursors[joint.Channel * 2 + 1]);
+		}
+		m_EvaluatedBones += isSampled ? 1 : 0;
+
+		// The parent was written earlier in this loop
+		m_GlobalTransforms[i] = joint.Parent >= 0 ? m_GlobalTransforms[joint.Parent] * localTransform : localTransform;
+
+		if (joint.BoneID >= 0)
+		{
+			m_FinalBoneMatrices[joint.BoneID] = m_GlobalTransforms[i] * joint.Offset;
+		}
+	}
+}
+
+void Animator::CalculateBlendedPose()
+{
+	m_EvaluatedBones = Pose::Sample(*m_Skeleton, m_CurrentTime, m_KeyCursors, m_Poses[0], m_LeafCulling, m_CompressedClip);
+	m_EvaluatedBones += Pose::Sample(*m_NextSkeleton, m_NextTime, m_NextKeyCursors, m_Poses[1], m_LeafCulling);
+
+	const Pose* poses[2] = { &m_Poses[0], &m_Poses[1] };
+	const float weight = GetFadeWeight();
+	const float weights[2] = { 1.0f - weight, weight };
+	Pose::Blend(poses, weights, 2, m_Poses[2]);
+	Pose::ToModelSpace(*m_Skeleton, m_Poses[2], m_GlobalTransforms, m_FinalBoneMatrices);
 }
 
 void Animator::CalculateBoneTransform(const AssimpNodeData* node, const glm::mat4& parentTransform)
@@ -53,12 +258,12 @@ void Animator::CalculateBoneTransform(const AssimpNodeData* node, const glm::mat
 	glm::mat4 nodeTransform = glm::translate(glm::mat4(1.0f), posDecomp);
 	nodeTransform *= glm::toMat4(rotDecomp);
 
-	Bone* Bone = m_CurrentAnimation->FindBone(nodeName);
+	const int32_t channel = m_CurrentAnimation->FindBoneIndex(nodeName);
 
-	if (Bone)
+	if (channel >= 0)
 	{
-		Bone->Update(m_CurrentTime);
-		nodeTransform = Bone->GetLocalTransform();
+		const Bone& bone = m_CurrentAnimation->GetBone(channel);
+		nodeTransform = bone.SampleLocalTransform(m_CurrentTime, m_KeyCursors[channel * 2], m_KeyCursors[channel * 2 + 1]);
 		//std::cout << nodeName << std::endl;
 		//for (int i = 0; i < 4; ++i)
 		//{
@@ -71,13 +276,14 @@ void Animator::CalculateBoneTransform(const AssimpNodeData* node, const glm::mat
 
 	glm::mat4 globalTransformation = parentTransform * nodeTransform;
 
-	std::unordered_map<std::string, BoneInfo> boneInfoMap = m_CurrentAnimation->GetBoneIDMap();
-	if (boneInfoMap.find(nodeName) != boneInfoMap.end())
+	const std::unordered_map<std::string, BoneInfo>& boneInfoMap = m_CurrentAnimation->GetBoneIDMap();
+	auto boneInfo = boneInfoMap.find(nodeName);
+	if (boneInfo != boneInfoMap.end())
 	{
-		int32_t index = boneInfoMap[nodeName].ID;
+		int32_t index = boneInfo->second.ID;
 
-		glm::mat4 offset = glm::translate(glm::mat4(1.0f), boneInfoMap[nodeName].Position);
-		offset *= glm::toMat4(boneInfoMap[nodeName].Rotation);
+		glm::mat4 offset = glm::translate(glm::mat4(1.0f), boneInfo->second.Position);
+		offset *= glm::toMat4(boneInfo->second.Rotation);
 
 		m_FinalBoneMatrices[index] = globalTransformation * offset;
 	}
@@ -88,7 +294,64 @@ void Animator::CalculateBoneTransform(const AssimpNodeData* node, const glm::mat
 	}
 }
 
-std::vector<glm::mat4> Animator::GetFinalBoneMatrices()
+const std::vector<glm::mat4>& Animator::GetFinalBoneMatrices() const
 {
 	return m_FinalBoneMatrices;
 }
+
+size_t Animator::GetMemorySize() const
+{
+	return sizeof(Animator) + (m_FinalBoneMatrices.capacity() + m_GlobalTransforms.capacity()) * sizeof(glm::mat4)
+		+ m_KeyCursors.capacity() * sizeof(int32_t);
+}
+
+AnimatorBenchmarkResult Animator::Benchmark(const std::string& ModelPath, const std::string& ClipPath, int Iterations)
+{
+	using Clock = std::chrono::high_resolution_clock;
+	const float deltaTime = 1.0f / 60.0f;
+
+	SkinnedModel model(ModelPath.c_str());
+	Animation clip(ClipPath, &model);
+	Skeleton skeleton(clip, model);
+
+	Animator legacy(&clip);
+	Animator flat(&clip);
+	flat.SetSkeleton(&skeleton);
+
+	AnimatorBenchmarkResult result;
+	result.Iterations = std::max(Iterations, 1);
+	result.Joints = skeleton.GetJointCount();
+
+	Clock::time_point start = Clock::now();
+	for (int i = 0; i < result.Iterations; ++i)
+	{
+		legacy.UpdateAnimation(deltaTime);
+	}
+	result.LegacyMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count() / result.Iterations;
+
+	start = Clock::now();
+	for (int i = 0; i < result.Iterations; ++i)
+	{
+		flat.UpdateAnimation(deltaTime);
+	}
+	result.FlatMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count() / result.Iterations;
+
+	// Both advanced by the same steps so the palettes are comparable at any point
+	for (int i = 0; i < 60; ++i)
+	{
+		legacy.UpdateAnimation(deltaTime);
+		flat.UpdateAnimation(deltaTime);
+		for (uint32_t bone = 0; bone < skeleton.GetPaletteSize(); ++bone)
+		{
+			const glm::mat4& a = legacy.m_FinalBoneMatrices[bone];
+			const glm::mat4& b = flat.m_FinalBoneMatrices[bone];
+			for (int column = 0; column < 4; ++column)
+			{
+				glm::vec4 difference = glm::abs(a[column] - b[column]);
+				result.MaxError = std::max(result.MaxError, std::max(std::max(difference.x, difference.y), std::max(difference.z, difference.w)));
+			}
+		}
+	}
+
+	return result;
+}
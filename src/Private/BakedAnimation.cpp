@@ -0,0 +1,144 @@
+#include "Public/BakedAnimation.h"
+#include "Public/Animation.h"
+#include "Public/Animator.h"
+#include "Public/GLState.h"
+#include "Public/GPUResourceTracker.h"
+#include "Public/Skeleton.h"
+#include "Public/SkinnedModel.h"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+
+namespace
+{
+	// Texels per bone, the last matrix row is always 0 0 0 1
+	const uint32_t TEXELS_PER_BONE = 3;
+}
+
+BakedAnimation::BakedAnimation(SkinnedModel& Model, const std::vector<const Animation*>& Clips, float FramesPerSecond, BakedFormat Format)
+	: m_Format(Format)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+
+	std::vector<std::unique_ptr<Skeleton>> skeletons;
+	for (const Animation* clip : Clips)
+	{
+		skeletons.push_back(std::make_unique<Skeleton>(*clip, Model));
+		m_PaletteSize = std::max(m_PaletteSize, skeletons.back()->GetPaletteSize());
+
+		BakedClip baked = {};
+		baked.FirstFrame = m_FrameCount;
+		baked.Duration = clip->GetDuration() / clip->GetTicksPerSecond();
+		baked.FrameCount = std::max(2U, uint32_t(std::round(baked.Duration * FramesPerSecond)) + 1U);
+		m_Clips.push_back(baked);
+		m_FrameCount += baked.FrameCount;
+	}
+
+	GLint maxSize = 0;
+	glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+	const uint32_t width = m_PaletteSize * TEXELS_PER_BONE;
+	if (m_Clips.empty() || width == 0 || width > uint32_t(maxSize) || m_FrameCount > uint32_t(maxSize))
+	{
+		fprintf(stderr, "ERROR::BAKED_ANIMATION::%u bones and %u frames do not fit in a texture\n", m_PaletteSize, m_FrameCount);
+		m_Clips.clear();
+		m_FrameCount = 0;
+		return;
+	}
+
+	// Bones a clip does not animate keep the identity
+	const glm::vec4 identity[TEXELS_PER_BONE] = { glm::vec4(1.0f, 0.0f, 0.0f, 0.0f), glm::vec4(0.0f, 1.0f, 0.0f, 0.0f), glm::vec4(0.0f, 0.0f, 1.0f, 0.0f) };
+	std::vector<glm::vec4> texels(size_t(width) * m_FrameCount);
+	for (size_t i = 0; i < texels.size(); ++i)
+	{
+		texels[i] = identity[i % TEXELS_PER_BONE];
+	}
+
+	for (size_t clip = 0; clip < Clips.size(); ++clip)
+	{
+		const BakedClip& baked = m_Clips[clip];
+		Animator animator(Clips[clip]);
+		animator.SetSkeleton(skeletons[clip].get());
+		const float step = baked.Duration / (baked.FrameCount - 1);
+		const float ticksPerSecond = Clips[clip]->GetTicksPerSecond();
+		const float duration = Clips[clip]->GetDuration();
+		for (uint32_t frame = 0; frame < baked.FrameCount; ++frame)
+		{
+			// Each frame sampled at its own time without wrapping, so the last one is the end of the clip and
+			// rounding does not add up over the frames
+			animator.EvaluatePoseAt(std::min(frame * step * ticksPerSecond, duration));
+			const std::vector<glm::mat4>& palette = animator.GetFinalBoneMatrices();
+			glm::vec4* row = &texels[size_t(baked.FirstFrame + frame) * width];
+			for (size_t bone = 0; bone < palette.size() && bone < m_PaletteSize; ++bone)
+			{
+				const glm::mat4 rows = glm::transpose(palette[bone]);
+				for (uint32_t i = 0; i < TEXELS_PER_BONE; ++i)
+				{
+					row[bone * TEXELS_PER_BONE + i] = rows[i];
+				}
+			}
+		}
+	}
+
+	GPUResourceTracker& tracker = GPUResourceTracker::GetInstance();
+	const GLenum internalFormat = m_Format == BakedFormat::RGBA16F ? GL_RGBA16F : GL_RGBA32F;
+	tracker.GenTextures(1, &m_Texture, GPUResourceOwner::TEXTURE);
+	GLState::BindTexture(GL_TEXTURE_2D, m_Texture);
+	glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, m_FrameCount, 0, GL_RGBA, GL_FLOAT, texels.data());
+	tracker.SetTextureSize(m_Texture, internalFormat, width, m_FrameCount);
+	// Read with texelFetch, frames are blended in the shader
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	GLState::BindTexture(GL_TEXTURE_2D, 0);
+
+	tracker.GenBuffers(1, &m_ClipBuffer, GPUResourceOwner::OTHER);
+	GLState::BindBuffer(GL_SHADER_STORAGE_BUFFER, m_ClipBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, m_Clips.size() * sizeof(BakedClip), m_Clips.data(), GL_STATIC_DRAW);
+	tracker.SetBufferSize(m_ClipBuffer, m_Clips.size() * sizeof(BakedClip));
+	GLState::BindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	m_BakeMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+BakedAnimation::~BakedAnimation()
+{
+	GPUResourceTracker& tracker = GPUResourceTracker::GetInstance();
+	tracker.DeleteTextures(1, &m_Texture);
+	tracker.DeleteBuffers(1, &m_ClipBuffer);
+}
+
+void BakedAnimation::Bind(uint32_t Unit) const
+{
+	GLState::BindTexture(Unit, GL_TEXTURE_2D, m_Texture);
+	GLState::BindBufferBase(GL_SHADER_STORAGE_BUFFER, CLIPS_BINDING, m_ClipBuffer);
+}
+
+uint32_t BakedAnimation::GetClipCount() const
+{
+	return m_Clips.size();
+}
+
+uint32_t BakedAnimation::GetFrameCount() const
+{
+	return m_FrameCount;
+}
+
+uint32_t BakedAnimation::GetPaletteSize() const
+{
+	return m_PaletteSize;
+}
+
+size_t BakedAnimation::GetMemorySize() const
+{
+	const size_t texelSize = m_Format == BakedFormat::RGBA16F ? 8 : 16;
+	return size_t(m_PaletteSize) * TEXELS_PER_BONE * m_FrameCount * texelSize;
+}
+
+double BakedAnimation::GetBakeMs() const
+{
+	return m_BakeMs;
+}
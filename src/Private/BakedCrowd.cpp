@@ -0,0 +1,111 @@
+#include "Public/BakedCrowd.h"
+#include "Public/BakedAnimation.h"
+#include "Public/GLState.h"
+#include "Public/GPUResourceTracker.h"
+#include "Public/Shader.h"
+#include "Public/SkinnedModel.h"
+
+#include <glad/glad.h>
+
+BakedCrowd::BakedCrowd(SkinnedModel& Model, const BakedAnimation& Animation, const std::vector<BakedInstance>& Instances)
+	: m_Model(Model)
+	, m_Animation(Animation)
+	, m_Count(Instances.size())
+{
+	GPUResourceTracker& tracker = GPUResourceTracker::GetInstance();
+	tracker.GenBuffers(1, &m_InstanceVBO, GPUResourceOwner::MESH);
+	GLState::BindBuffer(GL_ARRAY_BUFFER, m_InstanceVBO);
+	glBufferData(GL_ARRAY_BUFFER, Instances.size() * sizeof(BakedInstance), Instances.data(), GL_STATIC_DRAW);
+	tracker.SetBufferSize(m_InstanceVBO, Instances.size() * sizeof(BakedInstance));
+
+	// Own vertex arrays so the model's meshes keep drawing without instance attributes
+	m_VAOs.resize(m_Model.GetMeshCount());
+	tracker.GenVertexArrays(m_VAOs.size(), m_VAOs.data(), GPUResourceOwner::MESH);
+	for (uint32_t i = 0; i < m_VAOs.size(); ++i)
+	{
+		SkinnedMesh& mesh = m_Model.GetMesh(i);
+		GLState::BindVertexArray(m_VAOs[i]);
+		GLState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.GetEBO());
+
+		GLState::BindBuffer(GL_ARRAY_BUFFER, mesh.GetVBO());
+		// Position attribute
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(SkinnedVertex), (void*)0);
+		// Normal attribute
+		glEnableVertexAttribArray(1);
+		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(SkinnedVertex), (void*)offsetof(SkinnedVertex, Normal));
+		// Texture position attribute
+		glEnableVertexAttribArray(2);
+		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(SkinnedVertex), (void*)offsetof(SkinnedVertex, TexCoords));
+		// Bone IDs
+		glEnableVertexAttribArray(4);
+		glVertexAttribIPointer(4, 4, GL_INT, sizeof(SkinnedVertex), (void*)offsetof(SkinnedVertex, BoneIDs));
+		// Vertex weights
+		glEnableVertexAttribArray(5);
+		glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, sizeof(SkinnedVertex), (void*)offsetof(SkinnedVertex, Weights));
+
+		GLState::BindBuffer(GL_ARRAY_BUFFER, m_InstanceVBO);
+		// Instance transform, one column per location
+		for (GLuint column = 0; column < 4; ++column)
+		{
+			glEnableVertexAttribArray(6 + column);
+			glVertexAttribPointer(6 + column, 4, GL_FLOAT, GL_FALSE, sizeof(BakedInstance), (void*)(column * sizeof(glm::vec4)));
+			glVertexAttribDivisor(6 + column, 1);
+		}
+		// Clip index
+		glEnableVertexAttribArray(10);
+		glVertexAttribIPointer(10, 1, GL_UNSIGNED_INT, sizeof(BakedInstance), (void*)offsetof(BakedInstance, Clip));
+		glVertexAttribDivisor(10, 1);
+		// Time offset
+		glEnableVertexAttribArray(11);
+		glVertexAttribPointer(11, 1, GL_FLOAT, GL_FALSE, sizeof(BakedInstance), (void*)offsetof(BakedInstance, TimeOffset));
+		glVertexAttribDivisor(11, 1);
+	}
+
+	GLState::BindVertexArray(0);
+	GLState::BindBuffer(GL_ARRAY_BUFFER, 0);
+	GLState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+BakedCrowd::~BakedCrowd()
+{
+	GPUResourceTracker& tracker = GPUResourceTracker::GetInstance();
+	tracker.DeleteVertexArrays(m_VAOs.size(), m_VAOs.data());
+	tracker.DeleteBuffers(1, &m_InstanceVBO);
+}
+
+void BakedCrowd::Update(float DeltaTime)
+{
+	m_Time += DeltaTime;
+}
+
+void BakedCrowd::Draw(Shader& Shader)
+{
+	if (m_Count == 0 || m_Animation.GetClipCount() == 0)
+	{
+		return;
+	}
+
+	Shader.Use();
+	m_Animation.Bind(BAKED_BONES_UNIT);
+	Shader.setInt("bakedBones", BAKED_BONES_UNIT);
+	Shader.setFloat("bakedTime", m_Time);
+	for (uint32_t i = 0; i < m_VAOs.size(); ++i)
+	{
+		SkinnedMesh& mesh = m_Model.GetMesh(i);
+		mesh.BindMaterial(Shader);
+		GLState::BindVertexArray(m_VAOs[i]);
+		// Base instance stays 0, it offsets the instance attributes as well
+		glDrawElementsInstanced(GL_TRIANGLES, mesh.Indexes.size(), GL_UNSIGNED_INT, 0, m_Count);
+	}
+}
+
+uint32_t BakedCrowd::GetCount() const
+{
+	return m_Count;
+}
+
+uint32_t BakedCrowd::GetDrawCount() const
+{
+	return m_VAOs.size();
+}
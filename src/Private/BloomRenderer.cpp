@@ -1,6 +1,8 @@
 #include "Public/BloomRenderer.h"
 #include <iostream>
 #include "Public/Quad.h"
+#include "Public/GPUResourceTracker.h"
+#include "Public/GLState.h"
 
 BloomRenderer::BloomRenderer(unsigned int WindowWidth, unsigned int WindowHeight)
 	: m_Init(false)
@@ -12,10 +14,10 @@ BloomRenderer::~BloomRenderer()
 {
 	for (int i = 0; i < (int)m_MipChain.size(); i++)
 	{
-		glDeleteTextures(1, &m_MipChain[i].texture);
+		GPUResourceTracker::GetInstance().DeleteTextures(1, &m_MipChain[i].texture);
 		m_MipChain[i].texture = 0;
 	}
-	glDeleteFramebuffers(1, &m_FBO);
+	GPUResourceTracker::GetInstance().DeleteFramebuffers(1, &m_FBO);
 	m_FBO = 0;
 	delete m_DownsampleShader;
 	delete m_UpsampleShader;
@@ -27,8 +29,8 @@ bool BloomRenderer::Init(unsigned int WindowWidth, unsigned int WindowsHeight)
 
 	if (m_Init) return true;
 
-	glGenFramebuffers(1, &m_FBO);
-	glBindFramebuffer(GL_FRAMEBUFFER, m_FBO);
+	GPUResourceTracker::GetInstance().GenFramebuffers(1, &m_FBO, GPUResourceOwner::BLOOM);
+	GLState::BindFramebuffer(GL_FRAMEBUFFER, m_FBO);
 
 	glm::vec2 mipSize((float)WindowWidth, (float)WindowsHeight);
 	glm::ivec2 mipIntSize((int)WindowWidth, (int)WindowsHeight);
@@ -48,10 +50,11 @@ bool BloomRenderer::Init(unsigned int WindowWidth, unsigned int WindowsHeight)
 		mip.size = mipSize;
 		mip.intSize = mipIntSize;
 
-		glGenTextures(1, &mip.texture);
-		glBindTexture(GL_TEXTURE_2D, mip.texture);
+		GPUResourceTracker::GetInstance().GenTextures(1, &mip.texture, GPUResourceOwner::BLOOM);
+		GLState::BindTexture(GL_TEXTURE_2D, mip.texture);
 		// we are downscaling an HDR color buffer, so we need a float texture format
 		glTexImage2D(GL_TEXTURE_2D, 0, GL_R11F_G11F_B10F, (int)mipSize.x, (int)mipSize.y, 0, GL_RGB, GL_FLOAT, nullptr);
+		GPUResourceTracker::GetInstance().SetTextureSize(mip.texture, GL_R11F_G11F_B10F, mipIntSize.x, mipIntSize.y);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
@@ -72,7 +75,7 @@ bool BloomRenderer::Init(unsigned int WindowWidth, unsigned int WindowsHeight)
 	if (status != GL_FRAMEBUFFER_COMPLETE)
 	{
 		printf("gbuffer FBO error, status: 0x%x\n", status);
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		GLState::BindFramebuffer(GL_FRAMEBUFFER, 0);
 		return false;
 	}
 
@@ -93,7 +96,7 @@ bool BloomRenderer::Init(unsigned int WindowWidth, unsigned int WindowsHeight)
 	m_UpsampleShader->Use();
 	m_UpsampleShader->setInt("srcTexture", 0);
 
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	GLState::BindFramebuffer(GL_FRAMEBUFFER, 0);
 	m_Init = true;
 	return true;
 }
@@ -109,14 +112,14 @@ void BloomRenderer::RenderDownsamples(unsigned int srcTexture)
 	}
 
 	// Bind srcTexture (HDR color buffer) as initial texture input
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, srcTexture);
+	GLState::ActiveTexture(0);
+	GLState::BindTexture(GL_TEXTURE_2D, srcTexture);
 
 	// Progressively downsample through the mip chain
 	for (int i = 0; i < (int)m_MipChain.size(); i++)
 	{
 		const bloomMip& mip = m_MipChain[i];
-		glViewport(0, 0, mip.size.x, mip.size.y);
+		GLState::Viewport(0, 0, mip.size.x, mip.size.y);
 		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, mip.texture, 0);
 
 		// Render screen-filled quad of resolution of current mip
@@ -125,7 +128,7 @@ void BloomRenderer::RenderDownsamples(unsigned int srcTexture)
 		// Set current mip resolution as srcResolution for next iteration
 		m_DownsampleShader->setVec2("srcResolution", mip.size);
 		// Set current mip as texture input for next iteration
-		glBindTexture(GL_TEXTURE_2D, mip.texture);
+		GLState::BindTexture(GL_TEXTURE_2D, mip.texture);
 		// Disable Karis average for consequent downsamples
 		if (i == 0) 
 		{
@@ -139,8 +142,8 @@ void BloomRenderer::RenderUpsamples(float filterRadius)
 	m_UpsampleShader->setFloat("filterRadius", filterRadius);
 
 	// Enable additive blending
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_ONE, GL_ONE);
+	GLState::Enable(GL_BLEND);
+	GLState::BlendFunc(GL_ONE, GL_ONE);
 	glBlendEquation(GL_FUNC_ADD);
 
 	for (int i = (int)m_MipChain.size() - 1; i > 0; i--)
@@ -149,11 +152,11 @@ void BloomRenderer::RenderUpsamples(float filterRadius)
 		const bloomMip& nextMip = m_MipChain[i - 1];
 
 		// Bind viewport and texture from where to read
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, mip.texture);
+		GLState::ActiveTexture(0);
+		GLState::BindTexture(GL_TEXTURE_2D, mip.texture);
 
 		// Set framebuffer render target (we write to this texture)
-		glViewport(0, 0, nextMip.size.x, nextMip.size.y);
+		GLState::Viewport(0, 0, nextMip.size.x, nextMip.size.y);
 		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
 			GL_TEXTURE_2D, nextMip.texture, 0);
 
@@ -163,21 +166,21 @@ void BloomRenderer::RenderUpsamples(float filterRadius)
 
 	// Disable additive blending
 	//glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
-	glDisable(GL_BLEND);
+	GLState::Disable(GL_BLEND);
 
-	glUseProgram(0);
+	GLState::UseProgram(0);
 }
 
 void BloomRenderer::RenderBloomTexture(unsigned int srcTexture, float filterRadius)
 {
-	glBindFramebuffer(GL_FRAMEBUFFER, m_FBO);
+	GLState::BindFramebuffer(GL_FRAMEBUFFER, m_FBO);
 
 	this->RenderDownsamples(srcTexture);
 	this->RenderUpsamples(filterRadius);
 
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	GLState::BindFramebuffer(GL_FRAMEBUFFER, 0);
 	// Restore viewport
-	glViewport(0, 0, m_SrcViewportSize.x, m_SrcViewportSize.y);
+	GLState::Viewport(0, 0, m_SrcViewportSize.x, m_SrcViewportSize.y);
 }
 
 GLuint BloomRenderer::BloomTexture()
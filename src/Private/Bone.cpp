@@ -1,5 +1,74 @@
 #include "Public/Bone.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <iostream>
+#include <random>
+
+namespace
+{
+	// Keeps timed samples from being optimised out
+	volatile float BenchmarkSink;
+
+	template<typename Key>
+	int32_t FindKey(const std::vector<Key>& keys, int32_t cursor, float animationTime)
+	{
+		const int32_t lastSegment = int32_t(keys.size()) - 2;
+		if (lastSegment <= 0)
+		{
+			return 0;
+		}
+
+		cursor = std::clamp(cursor, 0, lastSegment);
+		if (animationTime >= keys[cursor].timeStamp)
+		{
+			if (cursor == lastSegment || animationTime < keys[cursor + 1].timeStamp)
+			{
+				return cursor;
+			}
+			if (cursor + 1 == lastSegment || animationTime < keys[cursor + 2].timeStamp)
+			{
+				return cursor + 1;
+			}
+		}
+
+		auto next = std::upper_bound(keys.begin() + 1, keys.end() - 1, animationTime,
+			[](float time, const Key& key)
+			{
+				return time < key.timeStamp;
+			}
+		);
+		return int32_t(next - keys.begin()) - 1;
+	}
+
+	// Key search used before cursors, kept as the reference of the benchmark
+	template<typename Key>
+	int32_t FindKeyLinear(const std::vector<Key>& keys, float animationTime)
+	{
+		for (int32_t index = 0; index < int32_t(keys.size()) - 1; ++index)
+		{
+			if (animationTime < keys[index + 1].timeStamp)
+			{
+				return index;
+			}
+		}
+		return std::max(int32_t(keys.size()) - 2, 0);
+	}
+
+	float GetError(const glm::vec3& a, const glm::vec3& b)
+	{
+		glm::vec3 difference = glm::abs(a - b);
+		return std::max(std::max(difference.x, difference.y), difference.z);
+	}
+
+	float GetError(const glm::quat& a, const glm::quat& b)
+	{
+		// q and -q are the same rotation
+		glm::vec4 difference = glm::min(glm::abs(glm::vec4(a.x - b.x, a.y - b.y, a.z - b.z, a.w - b.w)),
+			glm::abs(glm::vec4(a.x + b.x, a.y + b.y, a.z + b.z, a.w + b.w)));
+		return std::max(std::max(difference.x, difference.y), std::max(difference.z, difference.w));
+	}
+}
 
 Bone::Bone(const std::string& name, int32_t ID, const aiNodeAnim* channel)
 	: m_Name(name)
@@ -46,28 +115,20 @@ Bone::Bone(const std::string& name, int32_t ID, const aiNodeAnim* channel)
 	//}
 }
 
-void Bone::Update(float animationTime)
+Bone::Bone(const std::string& name, int32_t ID, std::vector<KeyPosition> positions, std::vector<KeyRotation> rotations)
+	: m_Positions(std::move(positions))
+	, m_Rotations(std::move(rotations))
+	, m_NumPositions(m_Positions.size())
+	, m_NumRotations(m_Rotations.size())
+	, m_LocalTransform(1.0f)
+	, m_Name(name)
+	, m_ID(ID)
 {
-	glm::mat4 translation = InterpolatePosition(animationTime);
-	glm::mat4 rotation = InterpolateRotation(animationTime);
-	//std::cout << m_Name << std::endl;
-	//for (int i = 0; i < 4; ++i)
-	//{
-	//	for (int j = 0; j < 4; ++j)
-	//		std::cout << translation[i][j] << " ";
-	//	std::cout << std::endl;
-	//}
-	//std::cout << std::endl;
-	//for (int i = 0; i < 4; ++i)
-	//{
-	//	for (int j = 0; j < 4; ++j)
-	//		std::cout << rotation[i][j] << " ";
-	//	std::cout << std::endl;
-	//}
-	//std::cout << std::endl;
-	//std::cout << std::endl;
+}
 
-	m_LocalTransform = translation * rotation;
+void Bone::Update(float animationTime)
+{
+	m_LocalTransform = SampleLocalTransform(animationTime, m_PositionCursor, m_RotationCursor);
 }
 
 glm::mat4 Bone::GetLocalTransform()
@@ -75,7 +136,7 @@ glm::mat4 Bone::GetLocalTransform()
 	return m_LocalTransform;
 }
 
-std::string Bone::GetBoneName() const
+const std::string& Bone::GetBoneName() const
 { 
 	return m_Name; 
 }
@@ -87,63 +148,286 @@ int32_t Bone::GetBoneID()
 
 int32_t Bone::GetPositionIndex(float animationTime)
 {
-	for (int32_t index = 0; index < m_NumPositions - 1; ++index)
-	{
-		if (animationTime < m_Positions[index + 1].timeStamp)
-		{
-			return index;
-		}
-	}
-	assert(0);
+	m_PositionCursor = FindKey(m_Positions, m_PositionCursor, animationTime);
+	return m_PositionCursor;
 }
 
 int32_t Bone::GetRotationIndex(float animationTime)
 {
-	for (int32_t index = 0; index < m_NumRotations - 1; ++index)
-	{
-		if (animationTime < m_Rotations[index + 1].timeStamp)
-		{
-			return index;
-		}
-	}
-	assert(0);
+	m_RotationCursor = FindKey(m_Rotations, m_RotationCursor, animationTime);
+	return m_RotationCursor;
 }
 
-
-float Bone::GetScaleFactor(float lastTimeStamp, float nextTimeStamp, float animationTime)
+float Bone::GetScaleFactor(float lastTimeStamp, float nextTimeStamp, float animationTime) const
 {
 	float midWayLength = animationTime - lastTimeStamp;
 	float framesDiff = nextTimeStamp - lastTimeStamp;
 	float scaleFactor = midWayLength / framesDiff;
-	return scaleFactor;
+	// Times outside the track hold the first or last key
+	return glm::clamp(scaleFactor, 0.0f, 1.0f);
+}
+
+glm::vec3 Bone::SamplePosition(float animationTime)
+{
+	return SamplePosition(animationTime, m_PositionCursor);
+}
+
+glm::quat Bone::SampleRotation(float animationTime)
+{
+	return SampleRotation(animationTime, m_RotationCursor);
 }
 
-glm::mat4 Bone::InterpolatePosition(float animationTime)
+glm::vec3 Bone::SamplePosition(float animationTime, int32_t& cursor) const
 {
 	if (m_NumPositions == 1)
 	{
-		return glm::translate(glm::mat4(1.0f), m_Positions[0].position);
+		return m_Positions[0].position;
 	}
 
-	int32_t p0Index = GetPositionIndex(animationTime);
+	cursor = FindKey(m_Positions, cursor, animationTime);
+	int32_t p0Index = cursor;
 	int32_t p1Index = p0Index + 1;
 	float scaleFactor = GetScaleFactor(m_Positions[p0Index].timeStamp, m_Positions[p1Index].timeStamp, animationTime);
-	glm::vec3 finalPosition = glm::mix(m_Positions[p0Index].position, m_Positions[p1Index].position, scaleFactor);
-	return glm::translate(glm::mat4(1.0f), finalPosition);
+	return glm::mix(m_Positions[p0Index].position, m_Positions[p1Index].position, scaleFactor);
 }
 
-glm::mat4 Bone::InterpolateRotation(float animationTime)
+glm::quat Bone::SampleRotation(float animationTime, int32_t& cursor) const
 {
 	if (m_NumRotations == 1)
 	{
-		glm::quat rotation = glm::normalize(m_Rotations[0].orientation);
-		return glm::toMat4(rotation);
+		return glm::normalize(m_Rotations[0].orientation);
 	}
 
-	int32_t p0Index = GetRotationIndex(animationTime);
+	cursor = FindKey(m_Rotations, cursor, animationTime);
+	int32_t p0Index = cursor;
 	int32_t p1Index = p0Index + 1;
 	float scaleFactor = GetScaleFactor(m_Rotations[p0Index].timeStamp, m_Rotations[p1Index].timeStamp, animationTime);
 	glm::quat finalRotation = glm::slerp(m_Rotations[p0Index].orientation, m_Rotations[p1Index].orientation, scaleFactor);
-	finalRotation = glm::normalize(finalRotation);
-	return glm::toMat4(finalRotation);
-}
\ No newline at end of file
+	return glm::normalize(finalRotation);
+}
+
+glm::mat4 Bone::SampleLocalTransform(float animationTime, int32_t& positionCursor, int32_t& rotationCursor) const
+{
+	glm::vec3 position;
+	glm::quat rotation;
+	if (IsResampled())
+	{
+		SampleResampled(animationTime, position, rotation);
+	}
+	else
+	{
+		position = SamplePosition(animationTime, positionCursor);
+		rotation = SampleRotation(animationTime, rotationCursor);
+	}
+	return glm::translate(glm::mat4(1.0f), position) * glm::toMat4(rotation);
+}
+
+void Bone::GetPositionKeys(float animationTime, int32_t& cursor, glm::vec3& from, glm::vec3& to, float& alpha) const
+{
+	if (IsResampled())
+	{
+		const size_t lastKey = m_ResampledPositions.size() - 1;
+		float key = glm::clamp((animationTime - m_ResampleStart) * m_ResampleRate, 0.0f, float(lastKey));
+		size_t index = std::min(size_t(key), lastKey == 0 ? 0 : lastKey - 1);
+		from = m_ResampledPositions[index];
+		to = m_ResampledPositions[std::min(index + 1, lastKey)];
+		alpha = key - index;
+		return;
+	}
+	if (m_NumPositions == 1)
+	{
+		from = to = m_Positions[0].position;
+		alpha = 0.0f;
+		return;
+	}
+
+	cursor = FindKey(m_Positions, cursor, animationTime);
+	from = m_Positions[cursor].position;
+	to = m_Positions[cursor + 1].position;
+	alpha = GetScaleFactor(m_Positions[cursor].timeStamp, m_Positions[cursor + 1].timeStamp, animationTime);
+}
+
+void Bone::GetRotationKeys(float animationTime, int32_t& cursor, glm::quat& from, glm::quat& to, float& alpha) const
+{
+	if (IsResampled())
+	{
+		const size_t lastKey = m_ResampledRotations.size() - 1;
+		float key = glm::clamp((animationTime - m_ResampleStart) * m_ResampleRate, 0.0f, float(lastKey));
+		size_t index = std::min(size_t(key), lastKey == 0 ? 0 : lastKey - 1);
+		from = m_ResampledRotations[index];
+		to = m_ResampledRotations[std::min(index + 1, lastKey)];
+		alpha = key - index;
+		return;
+	}
+	if (m_NumRotations == 1)
+	{
+		from = to = m_Rotations[0].orientation;
+		alpha = 0.0f;
+		return;
+	}
+
+	cursor = FindKey(m_Rotations, cursor, animationTime);
+	from = m_Rotations[cursor].orientation;
+	to = m_Rotations[cursor + 1].orientation;
+	alpha = GetScaleFactor(m_Rotations[cursor].timeStamp, m_Rotations[cursor + 1].timeStamp, animationTime);
+}
+
+void Bone::Resample(float keysPerTick)
+{
+	m_ResampledPositions.clear();
+	m_ResampledRotations.clear();
+	m_ResampleRate = 0.0f;
+	if (keysPerTick <= 0.0f)
+	{
+		return;
+	}
+
+	float start = std::min(m_Positions.front().timeStamp, m_Rotations.front().timeStamp);
+	float end = std::max(m_Positions.back().timeStamp, m_Rotations.back().timeStamp);
+	// The last key lands on or after the end of the tracks
+	size_t count = size_t(std::ceil((end - start) * keysPerTick)) + 1;
+
+	m_ResampledPositions.reserve(count);
+	m_ResampledRotations.reserve(count);
+	for (size_t i = 0; i < count; ++i)
+	{
+		float time = start + i / keysPerTick;
+		m_ResampledPositions.push_back(SamplePosition(time));
+		m_ResampledRotations.push_back(SampleRotation(time));
+	}
+	m_ResampleStart = start;
+	m_ResampleRate = keysPerTick;
+}
+
+bool Bone::IsResampled() const
+{
+	return m_ResampleRate > 0.0f;
+}
+
+size_t Bone::GetMemorySize() const
+{
+	return sizeof(Bone) + m_Name.capacity() +
+		m_Positions.capacity() * sizeof(KeyPosition) + m_Rotations.capacity() * sizeof(KeyRotation) +
+		m_ResampledPositions.capacity() * sizeof(glm::vec3) + m_ResampledRotations.capacity() * sizeof(glm::quat);
+}
+
+void Bone::SampleResampled(float animationTime, glm::vec3& position, glm::quat& rotation) const
+{
+	const size_t lastKey = m_ResampledPositions.size() - 1;
+	float key = glm::clamp((animationTime - m_ResampleStart) * m_ResampleRate, 0.0f, float(lastKey));
+	size_t index = std::min(size_t(key), lastKey == 0 ? 0 : lastKey - 1);
+	size_t next = std::min(index + 1, lastKey);
+	float alpha = key - index;
+
+	position = glm::mix(m_ResampledPositions[index], m_ResampledPositions[next], alpha);
+	rotation = glm::normalize(glm::slerp(m_ResampledRotations[index], m_ResampledRotations[next], alpha));
+}
+
+KeyframeBenchmarkResult Bone::Benchmark(int32_t keyCount, int32_t samples)
+{
+	using Clock = std::chrono::high_resolution_clock;
+
+	KeyframeBenchmarkResult result;
+	result.Keys = std::max(keyCount, 2);
+	result.Samples = std::max(samples, 1);
+
+	// Irregular key spacing like exported clips have, so the resampled track is not exact
+	std::mt19937 random(1234);
+	std::uniform_real_distribution<float> spacing(0.5f, 1.5f);
+	std::vector<KeyPosition> positions(result.Keys);
+	std::vector<KeyRotation> rotations(result.Keys);
+	float time = 0.0f;
+	for (int32_t i = 0; i < result.Keys; ++i)
+	{
+		positions[i].position = glm::vec3(std::sin(time * 0.1f), std::cos(time * 0.07f), time * 0.01f);
+		positions[i].timeStamp = time;
+		rotations[i].orientation = glm::angleAxis(time * 0.05f, glm::normalize(glm::vec3(1.0f, std::sin(time * 0.02f), 0.5f)));
+		rotations[i].timeStamp = time;
+		time += spacing(random);
+	}
+	const float duration = positions.back().timeStamp;
+
+	Bone bone("Benchmark", -1, positions, rotations);
+	Bone resampled("Benchmark", -1, positions, rotations);
+	resampled.Resample(4.0f);
+
+	std::vector<float> forwardTimes(result.Samples);
+	std::vector<float> seekTimes(result.Samples);
+	std::uniform_real_distribution<float> seek(0.0f, duration);
+	for (int32_t i = 0; i < result.Samples; ++i)
+	{
+		forwardTimes[i] = duration * i / result.Samples;
+		seekTimes[i] = seek(random);
+	}
+
+	// The linear scan is timed on every tenth sample, each lookup walks the clip from its start
+	const int32_t linearSamples = std::max(result.Samples / 10, 1);
+	Clock::time_point start = Clock::now();
+	for (int32_t i = 0; i < linearSamples; ++i)
+	{
+		int32_t index = FindKeyLinear(positions, forwardTimes[i * 10]);
+		index += FindKeyLinear(rotations, forwardTimes[i * 10]);
+		BenchmarkSink = float(index);
+	}
+	result.LinearUs = std::chrono::duration<double, std::micro>(Clock::now() - start).count() / linearSamples;
+
+	start = Clock::now();
+	for (float sampleTime : forwardTimes)
+	{
+		BenchmarkSink = float(bone.GetPositionIndex(sampleTime) + bone.GetRotationIndex(sampleTime));
+	}
+	result.CursorUs = std::chrono::duration<double, std::micro>(Clock::now() - start).count() / result.Samples;
+
+	start = Clock::now();
+	for (float sampleTime : seekTimes)
+	{
+		BenchmarkSink = float(bone.GetPositionIndex(sampleTime) + bone.GetRotationIndex(sampleTime));
+	}
+	result.SeekUs = std::chrono::duration<double, std::micro>(Clock::now() - start).count() / result.Samples;
+
+	glm::vec3 position;
+	glm::quat rotation;
+	start = Clock::now();
+	for (float sampleTime : forwardTimes)
+	{
+		resampled.SampleResampled(sampleTime, position, rotation);
+		BenchmarkSink = position.x + rotation.w;
+	}
+	result.ResampledUs = std::chrono::duration<double, std::micro>(Clock::now() - start).count() / result.Samples;
+
+	// Interpolation on the segments found by the linear scan is the reference
+	auto referencePosition = [&](float sampleTime)
+	{
+		int32_t index = FindKeyLinear(positions, sampleTime);
+		float scaleFactor = glm::clamp((sampleTime - positions[index].timeStamp) / (positions[index + 1].timeStamp - positions[index].timeStamp), 0.0f, 1.0f);
+		return glm::mix(positions[index].position, positions[index + 1].position, scaleFactor);
+	};
+	auto referenceRotation = [&](float sampleTime)
+	{
+		int32_t index = FindKeyLinear(rotations, sampleTime);
+		float scaleFactor = glm::clamp((sampleTime - rotations[index].timeStamp) / (rotations[index + 1].timeStamp - rotations[index].timeStamp), 0.0f, 1.0f);
+		return glm::normalize(glm::slerp(rotations[index].orientation, rotations[index + 1].orientation, scaleFactor));
+	};
+
+	// Checked on fewer samples for the same reason, plus both ends of the clip
+	std::vector<float> checkTimes = { 0.0f, duration, duration + 1.0f };
+	for (int32_t i = 0; i < result.Samples; i += 10)
+	{
+		checkTimes.push_back(forwardTimes[i]);
+	}
+	for (float sampleTime : checkTimes)
+	{
+		glm::vec3 expectedPosition = referencePosition(sampleTime);
+		glm::quat expectedRotation = referenceRotation(sampleTime);
+		result.CursorError = std::max({ result.CursorError, GetError(bone.SamplePosition(sampleTime), expectedPosition), GetError(bone.SampleRotation(sampleTime), expectedRotation) });
+		resampled.SampleResampled(sampleTime, position, rotation);
+		result.ResampledError = std::max({ result.ResampledError, GetError(position, expectedPosition), GetError(rotation, expectedRotation) });
+	}
+	for (int32_t i = 0; i < result.Samples; i += 10)
+	{
+		float sampleTime = seekTimes[i];
+		result.SeekError = std::max({ result.SeekError, GetError(bone.SamplePosition(sampleTime), referencePosition(sampleTime)), GetError(bone.SampleRotation(sampleTime), referenceRotation(sampleTime)) });
+	}
+
+	return result;
+}
@@ -0,0 +1,464 @@
+#include "Public/CPUSkinning.h"
+#include "Public/Animation.h"
+#include "Public/Animator.h"
+#include "Public/JobPool.h"
+#include "Public/Skeleton.h"
+#include "Public/SkinnedModel.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SKINNING_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+// The AVX2 kernel is built with its own target whatever the flags of the build, Skin picks it after a cpuid check
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define SKINNING_USE_AVX2
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define SKINNING_AVX2_TARGET
+#else
+#define SKINNING_AVX2_TARGET __attribute__((target("avx2,fma")))
+#endif
+#endif
+
+namespace
+{
+	bool IsInfluence(const SkinnedVertex& Vertex, int Influence, uint32_t PaletteSize)
+	{
+		return Vertex.Weights[Influence] > 0.0f && Vertex.BoneIDs[Influence] >= 0 && uint32_t(Vertex.BoneIDs[Influence]) < PaletteSize;
+	}
+
+	SkinnedBounds EmptyBounds()
+	{
+		return { glm::vec3(FLT_MAX), glm::vec3(-FLT_MAX) };
+	}
+
+	void Merge(SkinnedBounds& Bounds, const SkinnedBounds& Other)
+	{
+		Bounds.Min = glm::min(Bounds.Min, Other.Min);
+		Bounds.Max = glm::max(Bounds.Max, Other.Max);
+	}
+
+#ifdef SKINNING_USE_SSE2
+	// Columns of the weighted sum of a vertex's bones
+	struct BlendedColumns
+	{
+		__m128 Columns[4];
+	};
+
+	inline BlendedColumns BlendBones(const SkinnedVertex& Vertex, const glm::mat4* Palette, uint32_t PaletteSize)
+	{
+		BlendedColumns blended = { { _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps() } };
+		for (int i = 0; i < MAX_BONE_INFLUENCE; ++i)
+		{
+			if (!IsInfluence(Vertex, i, PaletteSize))
+			{
+				continue;
+			}
+			const float* bone = &Palette[Vertex.BoneIDs[i]][0][0];
+			const __m128 weight = _mm_set1_ps(Vertex.Weights[i]);
+			for (int column = 0; column < 4; ++column)
+			{
+				blended.Columns[column] = _mm_add_ps(blended.Columns[column], _mm_mul_ps(_mm_loadu_ps(bone + column * 4), weight));
+			}
+		}
+		return blended;
+	}
+
+	// Lanes x, y and z, the w lane of the store is dropped
+	inline void StoreVec3(glm::vec3& Target, __m128 Value)
+	{
+		alignas(16) float values[4];
+		_mm_store_ps(values, Value);
+		memcpy(&Target, values, sizeof(glm::vec3));
+	}
+
+	SkinnedBounds SkinSse2(const SkinnedVertex* Vertices, uint32_t Count, const glm::mat4* Palette, uint32_t PaletteSize,
+		glm::vec3* Positions, glm::vec3* Normals)
+	{
+		__m128 min = _mm_set1_ps(FLT_MAX);
+		__m128 max = _mm_set1_ps(-FLT_MAX);
+		for (uint32_t v = 0; v < Count; ++v)
+		{
+			const BlendedColumns blended = BlendBones(Vertices[v], Palette, PaletteSize);
+			const glm::vec3& p = Vertices[v].Position;
+			const glm::vec3& n = Vertices[v].Normal;
+			__m128 position = _mm_add_ps(_mm_mul_ps(blended.Columns[0], _mm_set1_ps(p.x)), _mm_mul_ps(blended.Columns[1], _mm_set1_ps(p.y)));
+			position = _mm_add_ps(_mm_add_ps(position, _mm_mul_ps(blended.Columns[2], _mm_set1_ps(p.z))), blended.Columns[3]);
+			__m128 normal = _mm_add_ps(_mm_mul_ps(blended.Columns[0], _mm_set1_ps(n.x)), _mm_mul_ps(blended.Columns[1], _mm_set1_ps(n.y)));
+			normal = _mm_add_ps(normal, _mm_mul_ps(blended.Columns[2], _mm_set1_ps(n.z)));
+			min = _mm_min_ps(min, position);
+			max = _mm_max_ps(max, position);
+			StoreVec3(Positions[v], position);
+			StoreVec3(Normals[v], normal);
+		}
+		SkinnedBounds bounds;
+		StoreVec3(bounds.Min, min);
+		StoreVec3(bounds.Max, max);
+		return bounds;
+	}
+#endif
+
+	// Remaining vertices of the wide kernels
+	SkinnedBounds SkinNarrow(const SkinnedVertex* Vertices, uint32_t Count, const glm::mat4* Palette, uint32_t PaletteSize,
+		glm::vec3* Positions, glm::vec3* Normals)
+	{
+#ifdef SKINNING_USE_SSE2
+		return SkinSse2(Vertices, Count, Palette, PaletteSize, Positions, Normals);
+#else
+		return CPUSkinning::SkinScalar(Vertices, Count, Palette, PaletteSize, Positions, Normals);
+#endif
+	}
+
+#ifdef SKINNING_USE_AVX2
+	bool DetectAvx2()
+	{
+#if defined(_MSC_VER) && !defined(__clang__)
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7)
+		{
+			return false;
+		}
+		__cpuid(info, 1);
+		const bool isFma = (info[2] & (1 << 12)) != 0;
+		const bool isOsSaved = (info[2] & (1 << 27)) != 0;
+		const bool isAvx = (info[2] & (1 << 28)) != 0;
+		// The OS has to save the YMM registers on context switches
+		if (!isFma || !isOsSaved || !isAvx || (_xgetbv(0) & 6) != 6)
+		{
+			return false;
+		}
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+#else
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+	}
+
+	// Eight vertices per iteration, lane i holding vertex i. Vertex fields and bone elements are gathered into
+	// structure of arrays registers, so every multiply works on eight vertices instead of one vector of one vertex
+	SKINNING_AVX2_TARGET
+	SkinnedBounds SkinAvx2(const SkinnedVertex* Vertices, uint32_t Count, const glm::mat4* Palette, uint32_t PaletteSize,
+		glm::vec3* Positions, glm::vec3* Normals)
+	{
+		const int vertexFloats = sizeof(SkinnedVertex) / sizeof(float);
+		const __m256i vertexOffsets = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(vertexFloats));
+		const int positionOffset = offsetof(SkinnedVertex, Position) / sizeof(float);
+		const int normalOffset = offsetof(SkinnedVertex, Normal) / sizeof(float);
+		const int boneIDsOffset = offsetof(SkinnedVertex, BoneIDs) / sizeof(float);
+		const int weightsOffset = offsetof(SkinnedVertex, Weights) / sizeof(float);
+		const float* bones = &Palette[0][0][0];
+		const __m256i paletteSize = _mm256_set1_epi32(int(PaletteSize));
+		const __m256i minusOne = _mm256_set1_epi32(-1);
+		const __m256 zero = _mm256_setzero_ps();
+
+		__m256 min[3] = { _mm256_set1_ps(FLT_MAX), _mm256_set1_ps(FLT_MAX), _mm256_set1_ps(FLT_MAX) };
+		__m256 max[3] = { _mm256_set1_ps(-FLT_MAX), _mm256_set1_ps(-FLT_MAX), _mm256_set1_ps(-FLT_MAX) };
+		uint32_t v = 0;
+		for (; v + 8 <= Count; v += 8)
+		{
+			const float* vertices = reinterpret_cast<const float*>(Vertices + v);
+			const int* vertexInts = reinterpret_cast<const int*>(Vertices + v);
+
+			// Rows 0 to 2 of each column of the blended matrix, the last row is not needed for affine bones
+			__m256 blended[4][3];
+			for (int column = 0; column < 4; ++column)
+			{
+				for (int row = 0; row < 3; ++row)
+				{
+					blended[column][row] = zero;
+				}
+			}
+			for (int i = 0; i < MAX_BONE_INFLUENCE; ++i)
+			{
+				const __m256 weight = _mm256_i32gather_ps(vertices + weightsOffset + i, vertexOffsets, 4);
+				const __m256i id = _mm256_i32gather_epi32(vertexInts + boneIDsOffset + i, vertexOffsets, 4);
+				const __m256i isValid = _mm256_and_si256(_mm256_castps_si256(_mm256_cmp_ps(weight, zero, _CMP_GT_OQ)),
+					_mm256_and_si256(_mm256_cmpgt_epi32(id, minusOne), _mm256_cmpgt_epi32(paletteSize, id)));
+				if (_mm256_testz_si256(isValid, isValid))
+				{
+					continue;
+				}
+				// Skipped lanes gather nothing and add a zero weight
+				const __m256 mask = _mm256_castsi256_ps(isValid);
+				const __m256 validWeight = _mm256_and_ps(weight, mask);
+				const __m256i boneOffsets = _mm256_slli_epi32(_mm256_and_si256(id, isValid), 4);
+				for (int column = 0; column < 4; ++column)
+				{
+					for (int row = 0; row < 3; ++row)
+					{
+						const __m256 element = _mm256_mask_i32gather_ps(zero, bones + column * 4 + row, boneOffsets, mask, 4);
+						blended[column][row] = _mm256_fmadd_ps(element, validWeight, blended[column][row]);
+					}
+				}
+			}
+
+			const __m256 px = _mm256_i32gather_ps(vertices + positionOffset, vertexOffsets, 4);
+			const __m256 py = _mm256_i32gather_ps(vertices + positionOffset + 1, vertexOffsets, 4);
+			const __m256 pz = _mm256_i32gather_ps(vertices + positionOffset + 2, vertexOffsets, 4);
+			const __m256 nx = _mm256_i32gather_ps(vertices + normalOffset, vertexOffsets, 4);
+			const __m256 ny = _mm256_i32gather_ps(vertices + normalOffset + 1, vertexOffsets, 4);
+			const __m256 nz = _mm256_i32gather_ps(vertices + normalOffset + 2, vertexOffsets, 4);
+			alignas(32) float positions[3][8];
+			alignas(32) float normals[3][8];
+			for (int row = 0; row < 3; ++row)
+			{
+				const __m256 position = _mm256_fmadd_ps(blended[0][row], px,
+					_mm256_fmadd_ps(blended[1][row], py, _mm256_fmadd_ps(blended[2][row], pz, blended[3][row])));
+				const __m256 normal = _mm256_fmadd_ps(blended[0][row], nx, _mm256_fmadd_ps(blended[1][row], ny, _mm256_mul_ps(blended[2][row], nz)));
+				min[row] = _mm256_min_ps(min[row], position);
+				max[row] = _mm256_max_ps(max[row], position);
+				_mm256_store_ps(positions[row], position);
+				_mm256_store_ps(normals[row], normal);
+			}
+			for (int lane = 0; lane < 8; ++lane)
+			{
+				Positions[v + lane] = glm::vec3(positions[0][lane], positions[1][lane], positions[2][lane]);
+				Normals[v + lane] = glm::vec3(normals[0][lane], normals[1][lane], normals[2][lane]);
+			}
+		}
+
+		SkinnedBounds bounds = EmptyBounds();
+		for (int row = 0; row < 3; ++row)
+		{
+			alignas(32) float lanes[2][8];
+			_mm256_store_ps(lanes[0], min[row]);
+			_mm256_store_ps(lanes[1], max[row]);
+			bounds.Min[row] = *std::min_element(lanes[0], lanes[0] + 8);
+			bounds.Max[row] = *std::max_element(lanes[1], lanes[1] + 8);
+		}
+		if (v < Count)
+		{
+			Merge(bounds, SkinNarrow(Vertices + v, Count - v, Palette, PaletteSize, Positions + v, Normals + v));
+		}
+		return bounds;
+	}
+#endif
+}
+
+SkinnedBounds CPUSkinning::Skin(const SkinnedVertex* Vertices, uint32_t Count, const glm::mat4* Palette, uint32_t PaletteSize,
+	glm::vec3* Positions, glm::vec3* Normals)
+{
+	return SkinWith(GetBestKernel(), Vertices, Count, Palette, PaletteSize, Positions, Normals);
+}
+
+SkinnedBounds CPUSkinning::SkinWith(SkinningKernel Kernel, const SkinnedVertex* Vertices, uint32_t Count, const glm::mat4* Palette,
+	uint32_t PaletteSize, glm::vec3* Positions, glm::vec3* Normals)
+{
+	if (Count == 0)
+	{
+		return SkinnedBounds();
+	}
+	if (!IsSupported(Kernel))
+	{
+		Kernel = SkinningKernel::SCALAR;
+	}
+
+	switch (Kernel)
+	{
+#ifdef SKINNING_USE_AVX2
+	case SkinningKernel::AVX2:
+		return SkinAvx2(Vertices, Count, Palette, PaletteSize, Positions, Normals);
+#endif
+#ifdef SKINNING_USE_SSE2
+	case SkinningKernel::SSE2:
+		return SkinSse2(Vertices, Count, Palette, PaletteSize, Positions, Normals);
+#endif
+	default:
+		return SkinScalar(Vertices, Count, Palette, PaletteSize, Positions, Normals);
+	}
+}
+
+SkinnedBounds CPUSkinning::SkinParallel(const std::vector<SkinnedVertex>& Vertices, const std::vector<glm::mat4>& Palette,
+	std::vector<glm::vec3>& Positions, std::vector<glm::vec3>& Normals)
+{
+	const uint32_t count = Vertices.size();
+	Positions.resize(count);
+	Normals.resize(count);
+	if (count == 0)
+	{
+		return SkinnedBounds();
+	}
+
+	// One slot per batch, merged once every batch finished
+	std::vector<SkinnedBounds> batchBounds((count + BATCH_SIZE - 1) / BATCH_SIZE);
+	JobPool::GetInstance().ParallelFor(count, BATCH_SIZE,
+		[&](uint32_t Begin, uint32_t End)
+		{
+			batchBounds[Begin / BATCH_SIZE] = Skin(Vertices.data() + Begin, End - Begin, Palette.data(), Palette.size(),
+				Positions.data() + Begin, Normals.data() + Begin);
+		}
+	);
+
+	SkinnedBounds bounds = batchBounds[0];
+	for (const SkinnedBounds& batch : batchBounds)
+	{
+		Merge(bounds, batch);
+	}
+	return bounds;
+}
+
+SkinnedBounds CPUSkinning::SkinScalar(const SkinnedVertex* Vertices, uint32_t Count, const glm::mat4* Palette, uint32_t PaletteSize,
+	glm::vec3* Positions, glm::vec3* Normals)
+{
+	if (Count == 0)
+	{
+		return SkinnedBounds();
+	}
+
+	SkinnedBounds bounds = EmptyBounds();
+	for (uint32_t v = 0; v < Count; ++v)
+	{
+		const SkinnedVertex& vertex = Vertices[v];
+		glm::mat4 blended(0.0f);
+		for (int i = 0; i < MAX_BONE_INFLUENCE; ++i)
+		{
+			if (IsInfluence(vertex, i, PaletteSize))
+			{
+				blended += Palette[vertex.BoneIDs[i]] * vertex.Weights[i];
+			}
+		}
+		Positions[v] = glm::vec3(blended * glm::vec4(vertex.Position, 1.0f));
+		Normals[v] = glm::vec3(blended * glm::vec4(vertex.Normal, 0.0f));
+		bounds.Min = glm::min(bounds.Min, Positions[v]);
+		bounds.Max = glm::max(bounds.Max, Positions[v]);
+	}
+	return bounds;
+}
+
+bool CPUSkinning::IsSupported(SkinningKernel Kernel)
+{
+	switch (Kernel)
+	{
+	case SkinningKernel::SSE2:
+#ifdef SKINNING_USE_SSE2
+		return true;
+#else
+		return false;
+#endif
+	case SkinningKernel::AVX2:
+	{
+#ifdef SKINNING_USE_AVX2
+		static const bool isAvx2 = DetectAvx2();
+		return isAvx2;
+#else
+		return false;
+#endif
+	}
+	default:
+		return true;
+	}
+}
+
+SkinningKernel CPUSkinning::GetBestKernel()
+{
+	if (IsSupported(SkinningKernel::AVX2))
+	{
+		return SkinningKernel::AVX2;
+	}
+	return IsSupported(SkinningKernel::SSE2) ? SkinningKernel::SSE2 : SkinningKernel::SCALAR;
+}
+
+const char* CPUSkinning::GetKernelName(SkinningKernel Kernel)
+{
+	switch (Kernel)
+	{
+	case SkinningKernel::SSE2:
+		return "SSE2";
+	case SkinningKernel::AVX2:
+		return "AVX2";
+	default:
+		return "scalar";
+	}
+}
+
+CPUSkinningBenchmarkResult CPUSkinning::Benchmark(const std::string& ModelPath, const std::string& ClipPath, int Iterations)
+{
+	using Clock = std::chrono::high_resolution_clock;
+
+	CPUSkinningBenchmarkResult result;
+	result.Iterations = std::max(Iterations, 1);
+	result.Threads = JobPool::GetInstance().GetWorkerCount() + 1;
+	result.ParallelKernel = GetKernelName(GetBestKernel());
+
+	SkinnedModel model(ModelPath.c_str());
+	Animation clip(ClipPath, &model);
+	Skeleton skeleton(clip, model);
+	Animator animator(&clip);
+	animator.SetSkeleton(&skeleton);
+	// Halfway through the clip, away from the bind pose
+	animator.UpdateAnimation(clip.GetTicksPerSecond() > 0.0f ? clip.GetDuration() * 0.5f / clip.GetTicksPerSecond() : 0.0f);
+	const std::vector<glm::mat4>& palette = animator.GetFinalBoneMatrices();
+
+	// Largest component differences of one kernel's output to the reference
+	auto compare = [](const std::vector<glm::vec3>& Values, const std::vector<glm::vec3>& Reference, float& MaxError)
+	{
+		for (size_t v = 0; v < Values.size(); ++v)
+		{
+			const glm::vec3 difference = glm::abs(Values[v] - Reference[v]);
+			MaxError = std::max({ MaxError, difference.x, difference.y, difference.z });
+		}
+	};
+	auto compareBounds = [](const SkinnedBounds& Bounds, const SkinnedBounds& Reference, float& MaxError)
+	{
+		const glm::vec3 min = glm::abs(Bounds.Min - Reference.Min);
+		const glm::vec3 max = glm::abs(Bounds.Max - Reference.Max);
+		MaxError = std::max({ MaxError, min.x, min.y, min.z, max.x, max.y, max.z });
+	};
+
+	for (uint32_t mesh = 0; mesh < model.GetMeshCount(); ++mesh)
+	{
+		const std::vector<SkinnedVertex>& vertices = model.GetMesh(mesh).Vertexes;
+		const uint32_t count = vertices.size();
+		result.Vertices += count;
+		std::vector<glm::vec3> referencePositions(count);
+		std::vector<glm::vec3> referenceNormals(count);
+		std::vector<glm::vec3> positions(count);
+		std::vector<glm::vec3> normals(count);
+		const SkinnedBounds reference = SkinScalar(vertices.data(), count, palette.data(), palette.size(), referencePositions.data(),
+			referenceNormals.data());
+
+		for (uint32_t kernel = 0; kernel < SKINNING_KERNEL_COUNT; ++kernel)
+		{
+			CPUSkinningKernelResult& kernelResult = result.Kernels[kernel];
+			kernelResult.IsSupported = IsSupported(SkinningKernel(kernel));
+			if (!kernelResult.IsSupported)
+			{
+				continue;
+			}
+			SkinnedBounds bounds;
+			const Clock::time_point start = Clock::now();
+			for (int i = 0; i < result.Iterations; ++i)
+			{
+				bounds = SkinWith(SkinningKernel(kernel), vertices.data(), count, palette.data(), palette.size(), positions.data(), normals.data());
+			}
+			kernelResult.Ms += std::chrono::duration<double, std::milli>(Clock::now() - start).count() / result.Iterations;
+			compare(positions, referencePositions, kernelResult.MaxPositionError);
+			compare(normals, referenceNormals, kernelResult.MaxNormalError);
+			compareBounds(bounds, reference, kernelResult.MaxBoundsError);
+		}
+
+		SkinnedBounds parallelBounds;
+		const Clock::time_point start = Clock::now();
+		for (int i = 0; i < result.Iterations; ++i)
+		{
+			parallelBounds = SkinParallel(vertices, palette, positions, normals);
+		}
+		result.ParallelMs += std::chrono::duration<double, std::milli>(Clock::now() - start).count() / result.Iterations;
+		compare(positions, referencePositions, result.ParallelMaxError);
+		compare(normals, referenceNormals, result.ParallelMaxError);
+		compareBounds(parallelBounds, reference, result.ParallelMaxError);
+	}
+	return result;
+}
@@ -1,19 +1,70 @@
 #include "Public/Circle.h"
+#include "Public/GPUResourceTracker.h"
+#include "Public/GLState.h"
+#include <algorithm>
+#include <iterator>
 #define _USE_MATH_DEFINES
 #include <math.h>
 
 void Circle::Draw(Shader& Shader)
 {
     Shader.Use();
-    glBindVertexArray(m_VAO);
+    GLState::BindVertexArray(m_VAO);
     glDrawArrays(GL_LINE_STRIP, 0, 21);
-    glBindVertexArray(0);
+    GLState::BindVertexArray(0);
+}
+
+Circle::Circle(const Circle& Other)
+	: m_VAO(Other.m_VAO)
+	, m_VBO(Other.m_VBO)
+{
+	std::copy(std::begin(Other.vertices), std::end(Other.vertices), vertices);
+	const_cast<Circle&>(Other).m_VAO = 0;
+	const_cast<Circle&>(Other).m_VBO = 0;
+}
+
+Circle::Circle(Circle&& Other) noexcept
+	: m_VAO(Other.m_VAO)
+	, m_VBO(Other.m_VBO)
+{
+	std::copy(std::begin(Other.vertices), std::end(Other.vertices), vertices);
+	Other.m_VAO = 0;
+	Other.m_VBO = 0;
 }
 
 Circle::~Circle()
 {
-	//glDeleteVertexArrays(1, &m_VAO);
-	//glDeleteBuffers(1, &m_VBO);
+	if (m_VAO)
+	{
+		GPUResourceTracker::GetInstance().DeleteVertexArrays(1, &m_VAO);
+		GPUResourceTracker::GetInstance().DeleteBuffers(1, &m_VBO);
+		m_VAO = 0;
+		m_VBO = 0;
+	}
+}
+
+Circle& Circle::operator=(const Circle& Other)
+{
+	if (this != &Other)
+	{
+		this->~Circle();
+		std::swap(m_VAO, const_cast<Circle&>(Other).m_VAO);
+		std::swap(m_VBO, const_cast<Circle&>(Other).m_VBO);
+		std::copy(std::begin(Other.vertices), std::end(Other.vertices), vertices);
+	}
+	return *this;
+}
+
+Circle& Circle::operator=(Circle&& Other) noexcept
+{
+	if (this != &Other)
+	{
+		this->~Circle();
+		std::swap(m_VAO, Other.m_VAO);
+		std::swap(m_VBO, Other.m_VBO);
+		std::copy(std::begin(Other.vertices), std::end(Other.vertices), vertices);
+	}
+	return *this;
 }
 
 Circle::Circle(float Radius, glm::vec3 Position)
@@ -27,15 +78,17 @@ Circle::Circle(float Radius, glm::vec3 Position)
 		vertices[i * 3 + 2] = Position.z;
 	}
 
-	glGenVertexArrays(1, &m_VAO);
-	glGenBuffers(1, &m_VBO);
+	GPUResourceTracker& tracker = GPUResourceTracker::GetInstance();
+	tracker.GenVertexArrays(1, &m_VAO, GPUResourceOwner::GIZMO);
+	tracker.GenBuffers(1, &m_VBO, GPUResourceOwner::GIZMO);
 	// fill buffer
-	glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
+	GLState::BindBuffer(GL_ARRAY_BUFFER, m_VBO);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+	tracker.SetBufferSize(m_VBO, sizeof(vertices));
 	// link vertex attributes
-	glBindVertexArray(m_VAO);
+	GLState::BindVertexArray(m_VAO);
 	glEnableVertexAttribArray(0);
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glBindVertexArray(0);
+	GLState::BindBuffer(GL_ARRAY_BUFFER, 0);
+	GLState::BindVertexArray(0);
 }
@@ -0,0 +1,451 @@
+#include "Public/ClipCache.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+	const uint32_t CACHE_MAGIC = 0x50494C43; // "CLIP"
+	// Bump when the layout below or the import settings change
+	const uint32_t CACHE_VERSION = 1;
+
+	struct CacheHeader
+	{
+		uint32_t Magic;
+		uint32_t Version;
+		// Keys are stored as they are in memory, another compiler or glm configuration may lay them out differently
+		uint32_t PositionKeySize;
+		uint32_t RotationKeySize;
+		uint32_t ClipCount;
+		uint32_t Padding;
+	};
+
+	// Read only view of a whole file, empty when it cannot be opened
+	class MappedFile
+	{
+	public:
+		explicit MappedFile(const std::string& Path)
+		{
+#ifdef _WIN32
+			m_File = CreateFileA(Path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+			LARGE_INTEGER size = {};
+			if (m_File == INVALID_HANDLE_VALUE || !GetFileSizeEx(m_File, &size) || size.QuadPart == 0)
+			{
+				return;
+			}
+			m_Mapping = CreateFileMappingA(m_File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (m_Mapping)
+			{
+				m_Data = static_cast<const char*>(MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0));
+				m_Size = m_Data ? size_t(size.QuadPart) : 0;
+			}
+#else
+			m_File = open(Path.c_str(), O_RDONLY);
+			struct stat status = {};
+			if (m_File < 0 || fstat(m_File, &status) != 0 || status.st_size == 0)
+			{
+				return;
+			}
+			void* data = mmap(nullptr, size_t(status.st_size), PROT_READ, MAP_PRIVATE, m_File, 0);
+			if (data != MAP_FAILED)
+			{
+				m_Data = static_cast<const char*>(data);
+				m_Size = size_t(status.st_size);
+			}
+#endif
+		}
+
+		~MappedFile()
+		{
+#ifdef _WIN32
+			if (m_Data)
+			{
+				UnmapViewOfFile(m_Data);
+			}
+			if (m_Mapping)
+			{
+				CloseHandle(m_Mapping);
+			}
+			if (m_File != INVALID_HANDLE_VALUE)
+			{
+				CloseHandle(m_File);
+			}
+#else
+			if (m_Data)
+			{
+				munmap(const_cast<char*>(m_Data), m_Size);
+			}
+			if (m_File >= 0)
+			{
+				close(m_File);
+			}
+#endif
+		}
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		const char* GetData() const
+		{
+			return m_Data;
+		}
+
+		size_t GetSize() const
+		{
+			return m_Size;
+		}
+
+	private:
+#ifdef _WIN32
+		HANDLE m_File = INVALID_HANDLE_VALUE;
+		HANDLE m_Mapping = nullptr;
+#else
+		int m_File = -1;
+#endif
+		const char* m_Data = nullptr;
+		size_t m_Size = 0;
+	};
+
+	void HashBytes(uint64_t& Hash, const void* Data, size_t Size)
+	{
+		// FNV-1a
+		const unsigned char* bytes = static_cast<const unsigned char*>(Data);
+		for (size_t i = 0; i < Size; ++i)
+		{
+			Hash ^= bytes[i];
+			Hash *= 0x100000001B3ULL;
+		}
+	}
+
+	bool HashFile(uint64_t& Hash, const std::string& Path)
+	{
+		MappedFile file(Path);
+		if (!file.GetData())
+		{
+			return false;
+		}
+		uint64_t size = file.GetSize();
+		HashBytes(Hash, &size, sizeof(size));
+		HashBytes(Hash, file.GetData(), file.GetSize());
+		return true;
+	}
+
+	// Buffers a .gltf keeps next to it hold the keys, only the JSON would miss edits to them
+	void HashExternalBuffers(uint64_t& Hash, const std::string& SourcePath)
+	{
+		if (std::filesystem::path(SourcePath).extension() != ".gltf")
+		{
+			return;
+		}
+
+		std::ifstream file(SourcePath, std::ios::binary);
+		std::string json((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+		const std::filesystem::path directory = std::filesystem::path(SourcePath).parent_path();
+		for (size_t key = json.find("\"uri\""); key != std::string::npos; key = json.find("\"uri\"", key + 5))
+		{
+			size_t begin = json.find('"', json.find(':', key));
+			size_t end = begin == std::string::npos ? begin : json.find('"', begin + 1);
+			if (end == std::string::npos)
+			{
+				break;
+			}
+			std::string uri = json.substr(begin + 1, end - begin - 1);
+			if (uri.rfind("data:", 0) != 0 && std::filesystem::path(uri).extension() == ".bin")
+			{
+				HashFile(Hash, (directory / uri).string());
+			}
+		}
+	}
+
+	class Writer
+	{
+	public:
+		template<typename T>
+		void Write(const T& Value)
+		{
+			WriteBytes(&Value, sizeof(T));
+		}
+
+		void WriteString(const std::string& Value)
+		{
+			Write(uint32_t(Value.size()));
+			WriteBytes(Value.data(), Value.size());
+		}
+
+		template<typename T>
+		void WriteArray(const std::vector<T>& Values)
+		{
+			Write(uint32_t(Values.size()));
+			WriteBytes(Values.data(), Values.size() * sizeof(T));
+		}
+
+		void WriteNode(const AssimpNodeData& Node)
+		{
+			Write(Node.position);
+			Write(Node.rotation);
+			WriteString(Node.name);
+			Write(uint32_t(Node.children.size()));
+			for (const AssimpNodeData& child : Node.children)
+			{
+				WriteNode(child);
+			}
+		}
+
+		const std::vector<char>& GetBytes() const
+		{
+			return m_Bytes;
+		}
+
+	private:
+		void WriteBytes(const void* Data, size_t Size)
+		{
+			const char* bytes = static_cast<const char*>(Data);
+			m_Bytes.insert(m_Bytes.end(), bytes, bytes + Size);
+		}
+
+		std::vector<char> m_Bytes;
+	};
+
+	// Every read is bounds checked, a truncated or corrupted file turns IsValid false instead of reading past the mapping
+	class Reader
+	{
+	public:
+		Reader(const char* Data, size_t Size)
+			: m_Data(Data)
+			, m_Size(Size)
+		{
+		}
+
+		template<typename T>
+		T Read()
+		{
+			T value = {};
+			ReadBytes(&value, sizeof(T));
+			return value;
+		}
+
+		std::string ReadString()
+		{
+			const uint32_t length = Read<uint32_t>();
+			if (!Fits(length))
+			{
+				return std::string();
+			}
+			std::string value(m_Data + m_Offset, length);
+			m_Offset += length;
+			return value;
+		}
+
+		template<typename T>
+		void ReadArray(std::vector<T>& Values)
+		{
+			const uint32_t count = Read<uint32_t>();
+			if (!Fits(size_t(count) * sizeof(T)))
+			{
+				return;
+			}
+			Values.resize(count);
+			ReadBytes(Values.data(), size_t(count) * sizeof(T));
+		}
+
+		void ReadNode(AssimpNodeData& Node)
+		{
+			Node.position = Read<glm::vec3>();
+			Node.rotation = Read<glm::quat>();
+			Node.name = ReadString();
+			const uint32_t childCount = Read<uint32_t>();
+			// Every child takes more than one byte, larger counts come from a corrupted file
+			if (!Fits(childCount))
+			{
+				return;
+			}
+			Node.children.resize(childCount);
+			for (AssimpNodeData& child : Node.children)
+			{
+				ReadNode(child);
+			}
+		}
+
+		// Invalidates the reader when the rest of the file cannot hold Count records of at least RecordSize bytes
+		bool HasRoomFor(uint32_t Count, size_t RecordSize)
+		{
+			return Fits(size_t(Count) * RecordSize);
+		}
+
+		bool IsValid() const
+		{
+			return m_IsValid;
+		}
+
+		bool IsAtEnd() const
+		{
+			return m_Offset == m_Size;
+		}
+
+	private:
+		bool Fits(size_t Size)
+		{
+			m_IsValid = m_IsValid && Size <= m_Size - m_Offset;
+			return m_IsValid;
+		}
+
+		void ReadBytes(void* Destination, size_t Size)
+		{
+			if (Fits(Size))
+			{
+				memcpy(Destination, m_Data + m_Offset, Size);
+				m_Offset += Size;
+			}
+		}
+
+		const char* m_Data;
+		size_t m_Size;
+		size_t m_Offset = 0;
+		bool m_IsValid = true;
+	};
+}
+
+uint64_t ClipCache::GetKey(const std::string& SourcePath)
+{
+	uint64_t hash = 0xCBF29CE484222325ULL;
+	if (!HashFile(hash, SourcePath))
+	{
+		return 0;
+	}
+	HashExternalBuffers(hash, SourcePath);
+	return hash;
+}
+
+bool ClipCache::Load(uint64_t Key, ClipFileData& Data)
+{
+	if (Key == 0)
+	{
+		++m_Stats.Misses;
+		return false;
+	}
+	MappedFile file(GetPath(Key));
+	if (!file.GetData())
+	{
+		++m_Stats.Misses;
+		return false;
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	Reader reader(file.GetData(), file.GetSize());
+	CacheHeader header = reader.Read<CacheHeader>();
+	if (!reader.IsValid() || header.Magic != CACHE_MAGIC || header.Version != CACHE_VERSION
+		|| header.PositionKeySize != sizeof(KeyPosition) || header.RotationKeySize != sizeof(KeyRotation))
+	{
+		++m_Stats.Rejected;
+		return false;
+	}
+
+	// Smallest clip and channel records: empty names and arrays, their lengths and the clip's scalars
+	const size_t minClipSize = 3 * sizeof(uint32_t) + 2 * sizeof(float);
+	const size_t minChannelSize = 3 * sizeof(uint32_t);
+
+	ClipFileData data;
+	reader.ReadNode(data.Root);
+	data.Clips.resize(reader.IsValid() && reader.HasRoomFor(header.ClipCount, minClipSize) ? header.ClipCount : 0);
+	for (ClipData& clip : data.Clips)
+	{
+		clip.Name = reader.ReadString();
+		clip.Duration = reader.Read<float>();
+		clip.TicksPerSecond = reader.Read<float>();
+		const uint32_t channelCount = reader.Read<uint32_t>();
+		if (!reader.IsValid() || !reader.HasRoomFor(channelCount, minChannelSize))
+		{
+			break;
+		}
+		clip.Channels.resize(channelCount);
+		for (ClipChannel& channel : clip.Channels)
+		{
+			channel.Name = reader.ReadString();
+			reader.ReadArray(channel.Positions);
+			reader.ReadArray(channel.Rotations);
+		}
+	}
+	if (!reader.IsValid() || !reader.IsAtEnd())
+	{
+		// The caller imports the source again and overwrites the entry
+		++m_Stats.Rejected;
+		return false;
+	}
+
+	Data = std::move(data);
+	++m_Stats.Hits;
+	m_Stats.LoadMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	return true;
+}
+
+void ClipCache::Save(uint64_t Key, const ClipFileData& Data)
+{
+	if (Key == 0)
+	{
+		return;
+	}
+
+	Writer writer;
+	CacheHeader header = { CACHE_MAGIC, CACHE_VERSION, uint32_t(sizeof(KeyPosition)), uint32_t(sizeof(KeyRotation)), uint32_t(Data.Clips.size()), 0 };
+	writer.Write(header);
+	writer.WriteNode(Data.Root);
+	for (const ClipData& clip : Data.Clips)
+	{
+		writer.WriteString(clip.Name);
+		writer.Write(clip.Duration);
+		writer.Write(clip.TicksPerSecond);
+		writer.Write(uint32_t(clip.Channels.size()));
+		for (const ClipChannel& channel : clip.Channels)
+		{
+			writer.WriteString(channel.Name);
+			writer.WriteArray(channel.Positions);
+			writer.WriteArray(channel.Rotations);
+		}
+	}
+
+	std::error_code error;
+	std::filesystem::create_directories(CACHE_DIRECTORY, error);
+	std::ofstream file(GetPath(Key), std::ios::binary | std::ios::trunc);
+	if (!file)
+	{
+		fprintf(stderr, "ERROR::CLIP_CACHE::Failed to write %s\n", GetPath(Key).c_str());
+		return;
+	}
+	file.write(writer.GetBytes().data(), writer.GetBytes().size());
+}
+
+void ClipCache::Clear()
+{
+	std::error_code error;
+	std::filesystem::remove_all(CACHE_DIRECTORY, error);
+}
+
+void ClipCache::AddImportTime(double Milliseconds)
+{
+	m_Stats.ImportMs += Milliseconds;
+}
+
+const ClipCacheStats& ClipCache::GetStats()
+{
+	return m_Stats;
+}
+
+std::string ClipCache::GetPath(uint64_t Key)
+{
+	char name[32];
+	snprintf(name, sizeof(name), "/%016llx.clip", (unsigned long long)Key);
+	return std::string(CACHE_DIRECTORY) + name;
+}
@@ -0,0 +1,325 @@
+#include "Public/CompressedClip.h"
+#include "Public/Animation.h"
+#include "Public/BoneInfo.h"
+#include "Public/Skeleton.h"
+#include "Public/SkinnedModel.h"
+
+#include <glm/gtx/quaternion.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+namespace
+{
+	float GetAngle(const glm::quat& a, const glm::quat& b)
+	{
+		float cosine = std::min(std::abs(glm::dot(a, b)), 1.0f);
+		return 2.0f * std::acos(cosine);
+	}
+
+	// Keeps the first and last key plus every key whose removal would move an interpolated dropped key further
+	// than the tolerance. Error(First, Last, Key) measures Key against interpolation between First and Last
+	template<typename ErrorFunction>
+	std::vector<uint32_t> ReduceKeys(uint32_t Count, float Tolerance, ErrorFunction Error)
+	{
+		std::vector<uint32_t> kept = { 0 };
+		uint32_t first = 0;
+		for (uint32_t last = 2; last < Count; ++last)
+		{
+			for (uint32_t key = first + 1; key < last; ++key)
+			{
+				if (Error(first, last, key) > Tolerance)
+				{
+					first = last - 1;
+					kept.push_back(first);
+					break;
+				}
+			}
+		}
+		if (Count > 1)
+		{
+			kept.push_back(Count - 1);
+		}
+		return kept;
+	}
+
+	// Neighbouring keys may quantize to the same time
+	float GetAlpha(float First, float Last, float Time)
+	{
+		return Last > First ? glm::clamp((Time - First) / (Last - First), 0.0f, 1.0f) : 1.0f;
+	}
+
+	// Index of the key starting the segment around the time, both keys are the same for single key curves
+	uint32_t FindSegment(const CompressedKey* Keys, uint32_t Count, uint16_t Time)
+	{
+		if (Count < 2)
+		{
+			return 0;
+		}
+		const CompressedKey* next = std::upper_bound(Keys + 1, Keys + Count - 1, Time,
+			[](uint16_t time, const CompressedKey& key)
+			{
+				return time < key.Time;
+			}
+		);
+		return uint32_t(next - Keys) - 1;
+	}
+}
+
+CompressedClip::CompressedClip(const Animation& Clip, const ClipCompressionSettings& Settings)
+	: m_Duration(Clip.GetDuration())
+	, m_TicksPerSecond(Clip.GetTicksPerSecond())
+{
+	// Keys may sit slightly past the duration, the scale covers whichever ends later
+	float end = m_Duration;
+	for (uint32_t i = 0; i < Clip.GetBoneCount(); ++i)
+	{
+		const Bone& bone = Clip.GetBone(i);
+		end = std::max({ end, bone.m_Positions.back().timeStamp, bone.m_Rotations.back().timeStamp });
+	}
+	m_TimeScale = end > 0.0f ? 65535.0f / end : 0.0f;
+
+	m_Curves.reserve(Clip.GetBoneCount());
+	for (uint32_t i = 0; i < Clip.GetBoneCount(); ++i)
+	{
+		const std::vector<KeyPosition>& positions = Clip.GetBone(i).m_Positions;
+		const std::vector<KeyRotation>& rotations = Clip.GetBone(i).m_Rotations;
+		CompressedCurve curve;
+
+		// Rotations
+		std::vector<uint32_t> kept = ReduceKeys(rotations.size(), Settings.RotationTolerance,
+			[&](uint32_t First, uint32_t Last, uint32_t Key)
+			{
+				float alpha = (rotations[Key].timeStamp - rotations[First].timeStamp) / (rotations[Last].timeStamp - rotations[First].timeStamp);
+				glm::quat interpolated = glm::normalize(glm::slerp(rotations[First].orientation, rotations[Last].orientation, alpha));
+				return GetAngle(interpolated, glm::normalize(rotations[Key].orientation));
+			}
+		);
+		if (kept.size() == 2 && GetAngle(glm::normalize(rotations[kept[0]].orientation), glm::normalize(rotations[kept[1]].orientation)) <= Settings.RotationTolerance)
+		{
+			kept.pop_back();
+		}
+
+		curve.FirstRotation = m_Keys.size();
+		curve.NumRotations = kept.size();
+		for (uint32_t index : kept)
+		{
+			CompressedKey key;
+			key.Time = CompressKeyTime(rotations[index].timeStamp);
+			AnimationOptimizer::QuatFhm16bit(glm::normalize(rotations[index].orientation), key.Data);
+			m_Keys.push_back(key);
+		}
+
+		// Positions
+		glm::vec3 min = positions[0].position;
+		glm::vec3 max = positions[0].position;
+		for (const KeyPosition& key : positions)
+		{
+			min = glm::min(min, key.position);
+			max = glm::max(max, key.position);
+		}
+		curve.PositionCenter = (min + max) * 0.5f;
+		curve.PositionHalfExtent = (max - min) * 0.5f;
+		for (int32_t axis = 0; axis < 3; ++axis)
+		{
+			// Constant axes decode to the center exactly
+			if (curve.PositionHalfExtent[axis] <= 0.0f)
+			{
+				curve.PositionHalfExtent[axis] = 1.0f;
+			}
+		}
+
+		kept = ReduceKeys(positions.size(), Settings.PositionTolerance,
+			[&](uint32_t First, uint32_t Last, uint32_t Key)
+			{
+				float alpha = (positions[Key].timeStamp - positions[First].timeStamp) / (positions[Last].timeStamp - positions[First].timeStamp);
+				glm::vec3 interpolated = glm::mix(positions[First].position, positions[Last].position, alpha);
+				return glm::length(interpolated - positions[Key].position);
+			}
+		);
+		if (kept.size() == 2 && glm::length(positions[kept[0]].position - positions[kept[1]].position) <= Settings.PositionTolerance)
+		{
+			kept.pop_back();
+		}
+
+		curve.FirstPosition = m_Keys.size();
+		curve.NumPositions = kept.size();
+		for (uint32_t index : kept)
+		{
+			CompressedKey key;
+			key.Time = CompressKeyTime(positions[index].timeStamp);
+			AnimationOptimizer::Vec3Com16bit(positions[index].position, curve.PositionCenter, curve.PositionHalfExtent, key.Data);
+			m_Keys.push_back(key);
+		}
+
+		m_Curves.push_back(curve);
+	}
+	m_Keys.shrink_to_fit();
+}
+
+void CompressedClip::Sample(uint32_t Curve, float AnimationTime, glm::vec3& Position, glm::quat& Rotation) const
+{
+	const CompressedCurve& curve = m_Curves[Curve];
+	const float keyTime = glm::clamp(AnimationTime * m_TimeScale, 0.0f, 65535.0f);
+	const uint16_t time = uint16_t(keyTime);
+
+	const CompressedKey* rotations = m_Keys.data() + curve.FirstRotation;
+	uint32_t index = FindSegment(rotations, curve.NumRotations, time);
+	Rotation = AnimationOptimizer::QuatIhm16bit(rotations[index].Data);
+	if (index + 1 < curve.NumRotations)
+	{
+		float first = rotations[index].Time;
+		float alpha = GetAlpha(first, rotations[index + 1].Time, keyTime);
+		Rotation = glm::normalize(glm::slerp(Rotation, AnimationOptimizer::QuatIhm16bit(rotations[index + 1].Data), alpha));
+	}
+
+	const CompressedKey* positions = m_Keys.data() + curve.FirstPosition;
+	index = FindSegment(positions, curve.NumPositions, time);
+	Position = AnimationOptimizer::Vec3Decom16bit(positions[index].Data, curve.PositionCenter, curve.PositionHalfExtent);
+	if (index + 1 < curve.NumPositions)
+	{
+		float first = positions[index].Time;
+		float alpha = GetAlpha(first, positions[index + 1].Time, keyTime);
+		Position = glm::mix(Position, AnimationOptimizer::Vec3Decom16bit(positions[index + 1].Data, curve.PositionCenter, curve.PositionHalfExtent), alpha);
+	}
+}
+
+glm::mat4 CompressedClip::SampleLocalTransform(uint32_t Curve, float AnimationTime) const
+{
+	glm::vec3 position;
+	glm::quat rotation;
+	Sample(Curve, AnimationTime, position, rotation);
+	return glm::translate(glm::mat4(1.0f), position) * glm::toMat4(rotation);
+}
+
+uint32_t CompressedClip::GetCurveCount() const
+{
+	return m_Curves.size();
+}
+
+uint32_t CompressedClip::GetKeyCount() const
+{
+	return m_Keys.size();
+}
+
+size_t CompressedClip::GetMemorySize() const
+{
+	return sizeof(CompressedClip) + m_Curves.capacity() * sizeof(CompressedCurve) + m_Keys.capacity() * sizeof(CompressedKey);
+}
+
+float CompressedClip::GetDuration() const
+{
+	return m_Duration;
+}
+
+float CompressedClip::GetTicksPerSecond() const
+{
+	return m_TicksPerSecond;
+}
+
+const std::vector<CompressedCurve>& CompressedClip::GetCurves() const
+{
+	return m_Curves;
+}
+
+const std::vector<CompressedKey>& CompressedClip::GetKeys() const
+{
+	return m_Keys;
+}
+
+float CompressedClip::GetTimeScale() const
+{
+	return m_TimeScale;
+}
+
+ClipCompressionReport CompressedClip::Benchmark(const std::string& ModelPath, const std::string& ClipPath, int Samples)
+{
+	using Clock = std::chrono::high_resolution_clock;
+
+	SkinnedModel model(ModelPath.c_str());
+	Animation clip(ClipPath, &model);
+	Skeleton skeleton(clip, model);
+	CompressedClip compressed(clip);
+
+	ClipCompressionReport report;
+	report.CompressedBytes = compressed.GetMemorySize();
+	report.Keys = compressed.GetKeyCount();
+	for (uint32_t i = 0; i < clip.GetBoneCount(); ++i)
+	{
+		const Bone& bone = clip.GetBone(i);
+		report.RawBytes += bone.m_Positions.capacity() * sizeof(KeyPosition) + bone.m_Rotations.capacity() * sizeof(KeyRotation);
+		report.RawKeys += bone.m_Positions.size() + bone.m_Rotations.size();
+	}
+
+	Samples = std::max(Samples, 2);
+	const std::vector<SkeletonJoint>& joints = skeleton.GetJoints();
+	std::vector<glm::mat4> rawGlobals(joints.size());
+	std::vector<glm::mat4> compressedGlobals(joints.size());
+	for (int sample = 0; sample < Samples; ++sample)
+	{
+		const float time = clip.GetDuration() * sample / (Samples - 1);
+		for (size_t i = 0; i < joints.size(); ++i)
+		{
+			const SkeletonJoint& joint = joints[i];
+			glm::mat4 rawLocal = joint.BindLocal;
+			glm::mat4 compressedLocal = joint.BindLocal;
+			if (joint.Channel >= 0)
+			{
+				Bone& bone = clip.GetBone(joint.Channel);
+				glm::vec3 position;
+				glm::quat rotation;
+				compressed.Sample(joint.Channel, time, position, rotation);
+				report.MaxRotationError = std::max(report.MaxRotationError, glm::degrees(GetAngle(rotation, bone.SampleRotation(time))));
+
+				bone.Update(time);
+				rawLocal = bone.GetLocalTransform();
+				compressedLocal = glm::translate(glm::mat4(1.0f), position) * glm::toMat4(rotation);
+			}
+			rawGlobals[i] = joint.Parent >= 0 ? rawGlobals[joint.Parent] * rawLocal : rawLocal;
+			compressedGlobals[i] = joint.Parent >= 0 ? compressedGlobals[joint.Parent] * compressedLocal : compressedLocal;
+			report.MaxJointError = std::max(report.MaxJointError, glm::length(glm::vec3(rawGlobals[i][3] - compressedGlobals[i][3])));
+		}
+	}
+
+	// Sampling cost of every channel over the same times
+	glm::vec3 sink(0.0f);
+	Clock::time_point start = Clock::now();
+	for (int sample = 0; sample < Samples; ++sample)
+	{
+		const float time = clip.GetDuration() * sample / (Samples - 1);
+		for (uint32_t i = 0; i < clip.GetBoneCount(); ++i)
+		{
+			sink += clip.GetBone(i).SamplePosition(time);
+			sink.x += clip.GetBone(i).SampleRotation(time).w;
+		}
+	}
+	report.RawSampleMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count() / Samples;
+
+	start = Clock::now();
+	for (int sample = 0; sample < Samples; ++sample)
+	{
+		const float time = clip.GetDuration() * sample / (Samples - 1);
+		for (uint32_t i = 0; i < compressed.GetCurveCount(); ++i)
+		{
+			glm::vec3 position;
+			glm::quat rotation;
+			compressed.Sample(i, time, position, rotation);
+			sink += position;
+			sink.x += rotation.w;
+		}
+	}
+	report.CompressedSampleMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count() / Samples;
+
+	// Reading the sum keeps both loops from being optimised out
+	if (std::isnan(sink.x))
+	{
+		fprintf(stderr, "ERROR::COMPRESSED_CLIP::Sampled a NaN\n");
+	}
+	return report;
+}
+
+uint16_t CompressedClip::CompressKeyTime(float Time) const
+{
+	return uint16_t(glm::clamp(Time * m_TimeScale + 0.5f, 0.0f, 65535.0f));
+}
@@ -1,4 +1,6 @@
 #include "Public/Cube.h"
+#include "Public/GPUResourceTracker.h"
+#include "Public/GLState.h"
 #include <glad/glad.h>
 
 Cube& Cube::GetInstance()
@@ -10,15 +12,15 @@ Cube& Cube::GetInstance()
 void Cube::Draw(Shader& Shader)
 {
     Shader.Use();
-    glBindVertexArray(m_VAO);
+    GLState::BindVertexArray(m_VAO);
     glDrawArrays(GL_TRIANGLES, 0, 36);
-    glBindVertexArray(0);
+    GLState::BindVertexArray(0);
 }
 
 Cube::~Cube()
 {
-    glDeleteVertexArrays(1, &m_VAO);
-    glDeleteBuffers(1, &m_VBO);
+    GPUResourceTracker::GetInstance().DeleteVertexArrays(1, &m_VAO);
+    GPUResourceTracker::GetInstance().DeleteBuffers(1, &m_VBO);
 }
 
 Cube::Cube()
@@ -70,19 +72,23 @@ Cube::Cube()
         -1.0f,  1.0f,  1.0f,    0.0f,  1.0f,  0.0f,   0.0f, 0.0f  // bottom-left        
     };
 
-    glGenVertexArrays(1, &m_VAO);
-    glGenBuffers(1, &m_VBO);
+    GPUResourceTracker& tracker = GPUResourceTracker::GetInstance();
+    tracker.GenVertexArrays(1, &m_VAO, GPUResourceOwner::MESH);
+    tracker.GenBuffers(1, &m_VBO, GPUResourceOwner::MESH);
+    tracker.SetPersistent(GPUResourceType::VERTEXARRAY, m_VAO);
+    tracker.SetPersistent(GPUResourceType::BUFFER, m_VBO);
     // fill buffer
-    glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
+    GLState::BindBuffer(GL_ARRAY_BUFFER, m_VBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    tracker.SetBufferSize(m_VBO, sizeof(vertices));
     // link vertex attributes
-    glBindVertexArray(m_VAO);
+    GLState::BindVertexArray(m_VAO);
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(1);
     glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
     glEnableVertexAttribArray(2);
     glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+    GLState::BindBuffer(GL_ARRAY_BUFFER, 0);
+    GLState::BindVertexArray(0);
 }
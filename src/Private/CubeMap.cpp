@@ -1,4 +1,6 @@
 #include "Public/CubeMap.h"
+#include "Public/GPUResourceTracker.h"
+#include "Public/GLState.h"
 #include <stb_image.h>
 
 CubeMap::CubeMap(std::vector<const char*> Faces, bool IsStandarised)
@@ -32,7 +34,7 @@ CubeMap::~CubeMap()
 {
     if (m_Id)
     {
-        glDeleteTextures(1, &m_Id);
+        GPUResourceTracker::GetInstance().DeleteTextures(1, &m_Id);
         m_Id = 0;
         m_Faces.clear();
     }
@@ -62,8 +64,8 @@ CubeMap& CubeMap::operator=(CubeMap&& Other) noexcept
 
 void CubeMap::LoadCubeMap(std::vector<const char*> Faces, bool IsStandarised)
 {
-    glGenTextures(1, &m_Id);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, m_Id);
+    GPUResourceTracker::GetInstance().GenTextures(1, &m_Id, GPUResourceOwner::TEXTURE);
+    GLState::BindTexture(GL_TEXTURE_CUBE_MAP, m_Id);
 
     int nrChannels;
     GLenum format, level;
@@ -95,7 +97,7 @@ void CubeMap::LoadCubeMap(std::vector<const char*> Faces, bool IsStandarised)
                 level = GL_SRGB_ALPHA;
             }
 
-            glBindTexture(GL_TEXTURE_2D, m_Id);
+            GLState::BindTexture(GL_TEXTURE_2D, m_Id);
             if (IsStandarised)
             {
                 glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, level, m_Width, m_Height, 0, format, GL_UNSIGNED_BYTE, data);
@@ -112,31 +114,34 @@ void CubeMap::LoadCubeMap(std::vector<const char*> Faces, bool IsStandarised)
         }
         stbi_image_free(data);
     }
+    GPUResourceTracker::GetInstance().SetTextureSize(m_Id, GL_RGB, m_Width, m_Height, 6);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
 
-    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    GLState::BindTexture(GL_TEXTURE_CUBE_MAP, 0);
+    GLState::BindTexture(GL_TEXTURE_2D, 0);
 }
 
 void CubeMap::LoadCubeMap()
 {
-    glGenTextures(1, &m_Id);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, m_Id);
+    GPUResourceTracker::GetInstance().GenTextures(1, &m_Id, GPUResourceOwner::IBL);
+    GLState::BindTexture(GL_TEXTURE_CUBE_MAP, m_Id);
     for (unsigned int i = 0; i < 6; ++i)
     {
         glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F, m_Width, m_Height, 0, GL_RGB, GL_FLOAT, nullptr);
     }
+    // Environment and prefilter maps get a full mip chain later on
+    GPUResourceTracker::GetInstance().SetTextureSize(m_Id, GL_RGB16F, m_Width, m_Height, 6, true);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR); // enable pre-filter mipmap sampling (combatting visible dots artifact)
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+    GLState::BindTexture(GL_TEXTURE_CUBE_MAP, 0);
 }
 
 void CubeMap::BindCubeMap(GLuint Number)
@@ -148,9 +153,7 @@ void CubeMap::BindCubeMap(GLuint Number)
     }
     else
     {
-        glActiveTexture(GL_TEXTURE0 + Number);
-        glBindTexture(GL_TEXTURE_CUBE_MAP, m_Id);
-        glActiveTexture(GL_TEXTURE0);
+        GLState::BindTexture(Number, GL_TEXTURE_CUBE_MAP, m_Id);
     }
 }
 
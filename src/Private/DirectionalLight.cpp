@@ -1,8 +1,6 @@
 #include "Public/DirectionalLight.h"
 
 #include <glm/gtc/type_ptr.hpp>
-#include "Public/Line.h"
-#include "Public/Circle.h"
 
 DirectionalLight::DirectionalLight(const glm::vec3& Direction, const glm::vec3& Color)
 	: Light(Color)
@@ -15,7 +13,8 @@ DirectionalLight::DirectionalLight(const glm::vec3& Direction, const glm::vec3&
 	}
 
 	m_ID = m_IDCounter++;
-	m_Prefix = "dirLights[" + std::to_string(m_ID) + ']';
+	m_ArrayName = "dirLights";
+	SetSlot(m_ID);
 }
 
 void DirectionalLight::SetDirection(const glm::vec3& Direction)
@@ -26,9 +25,9 @@ void DirectionalLight::SetDirection(const glm::vec3& Direction)
 void DirectionalLight::SetupShader(Shader& Shader)
 {
 	Shader.Use();
-	Shader.setBool((m_Prefix + ".isOn").c_str(), m_IsOn);
-	Shader.setVec3((m_Prefix + ".direction").c_str(), m_Direction);
-	Shader.setVec3((m_Prefix + ".color").c_str(), m_Color * m_Intensity);
+	ResolveUniforms(Shader);
+	Shader.setVec3(m_Uniforms.Direction, m_Direction);
+	Shader.setVec3(m_Uniforms.Color, m_Color * m_Intensity);
 }
 
 void DirectionalLight::Draw(Shader& Shader)
@@ -39,20 +38,21 @@ void DirectionalLight::Draw(Shader& Shader)
 	}
 	Shader.Use();
 	Shader.setMat4("model", glm::mat4(1.0f));
-	Circle circle(0.5f, -m_Direction);
-	circle.Draw(Shader);
-	glm::vec3 pos = glm::vec3(circle.vertices[0], circle.vertices[1], circle.vertices[2]);
-	Line line(pos, pos + m_Direction * 0.2f);
-	line.Draw(Shader);
-	pos = glm::vec3(circle.vertices[15], circle.vertices[16], circle.vertices[17]);
-	line = Line(pos, pos + m_Direction * 0.2f);
-	line.Draw(Shader);
-	pos = glm::vec3(circle.vertices[30], circle.vertices[31], circle.vertices[32]);
-	line = Line(pos, pos + m_Direction * 0.2f);
-	line.Draw(Shader);
-	pos = glm::vec3(circle.vertices[45], circle.vertices[46], circle.vertices[47]);
-	line = Line(pos, pos + m_Direction * 0.2f);
-	line.Draw(Shader);
+	if (m_Direction != m_GizmoDirection)
+	{
+		m_GizmoDirection = m_Direction;
+		m_Gizmo = Circle(0.5f, -m_Direction);
+		for (int i = 0; i < 4; ++i)
+		{
+			glm::vec3 pos = glm::vec3(m_Gizmo.vertices[i * 15], m_Gizmo.vertices[i * 15 + 1], m_Gizmo.vertices[i * 15 + 2]);
+			m_GizmoLines[i] = Line(pos, pos + m_Direction * 0.2f);
+		}
+	}
+	m_Gizmo.Draw(Shader);
+	for (Line& line : m_GizmoLines)
+	{
+		line.Draw(Shader);
+	}
 }
 
 const glm::vec3& DirectionalLight::GetDirection() const
@@ -6,6 +6,8 @@
 #include "Public/PointLight.h"
 #include "Public/SpotLight.h"
 #include "Public/DirectionalLight.h"
+#include "Public/ShaderVariants.h"
+#include "Public/FrameRingBuffer.h"
 
 Entity::Entity(Object& Object, const std::string& Name, Shader& DefaultShader)
 	: object(&Object)
@@ -18,6 +20,18 @@ Entity::Entity(Object& Object, const std::string& Name, Shader& DefaultShader)
 {
 }
 
+Entity::Entity(Object& Object, const std::string& Name, ShaderVariants& Variants)
+	: object(&Object)
+	, parent(nullptr)
+	, defaultShader(nullptr)
+	, name(Name)
+	, m_ID(m_IDCounter++)
+	, m_IsRefract(false)
+	, m_Variants(&Variants)
+	, transform(glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(1.0f))
+{
+}
+
 Entity::Entity(const std::string& Name)
 	: parent(nullptr)
 	, object(nullptr)
@@ -35,6 +49,12 @@ void Entity::AddChild(Object& Object, const std::string& Name, Shader& DefaultSh
 	children.back()->parent = this;
 }
 
+void Entity::AddChild(Object& Object, const std::string& Name, ShaderVariants& Variants)
+{
+	children.emplace_back(std::make_shared<Entity>(Object, Name, Variants));
+	children.back()->parent = this;
+}
+
 void Entity::UpdateSelfAndChildren()
 {
 	if (!transform.IsDirty())
@@ -66,8 +86,7 @@ void Entity::DrawSelfAndChildren(Shader& Shader)
 {
 	if (object)
 	{
-		Shader.setMat4("model", transform.GetModel());
-		Shader.setBool("isRefract", m_IsRefract);
+		BindObjectData(Shader);
 		object->Draw(Shader);
 	}
 
@@ -81,10 +100,15 @@ void Entity::DrawSelfAndChildren()
 {
 	if (object)
 	{
-		defaultShader->Use();
-		defaultShader->setMat4("model", transform.GetModel());
-		defaultShader->setBool("isRefract", m_IsRefract);
-		object->Draw(*defaultShader);
+		Shader* shader = defaultShader;
+		if (m_Variants)
+		{
+			// Refraction is a compiled variant instead of a per fragment branch
+			shader = &m_Variants->Get(m_Variants->GetBase().With(ShaderFeature::REFRACTION, m_IsRefract));
+		}
+		shader->Use();
+		BindObjectData(*shader);
+		object->Draw(*shader);
 	}
 
 	for (std::shared_ptr<Entity>& child : children)
@@ -93,6 +117,25 @@ void Entity::DrawSelfAndChildren()
 	}
 }
 
+void Entity::BindObjectData(const Shader& Shader)
+{
+	FrameRingBuffer& frame = FrameRingBuffer::GetInstance();
+	if (m_ObjectFrame != frame.GetFrameNumber())
+	{
+		uint32_t flags = (this == m_SelectedEntity ? OBJECT_SELECTED : 0u) | (m_IsRefract ? OBJECT_REFRACT : 0u);
+		m_ObjectIndex = frame.PushObject(transform.GetModel(), flags);
+		m_ObjectFrame = frame.GetFrameNumber();
+	}
+	frame.SetCurrentObject(m_ObjectIndex);
+
+	UniformHandle<glm::mat4> model = Shader.GetUniform<glm::mat4>("model");
+	if (model.IsValid())
+	{
+		// Shaders not reading the object buffer
+		Shader.setMat4(model, transform.GetModel());
+	}
+}
+
 void Entity::DrawGUITree()
 {
 	ImGuiTreeNodeFlags flags = (this == m_SelectedEntity ? ImGuiTreeNodeFlags_Selected : 0) | ImGuiTreeNodeFlags_OpenOnArrow;
@@ -0,0 +1,221 @@
+#include "Public/FrameRingBuffer.h"
+
+#include "Public/GPUResourceTracker.h"
+#include "Public/GLState.h"
+
+#include <glm/gtc/matrix_inverse.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+namespace
+{
+    // Nanoseconds per glClientWaitSync call, the loop keeps waiting until the fence is signaled
+    const GLuint64 FENCE_TIMEOUT = 1000000;
+
+    GLsizeiptr Align(GLsizeiptr Value, GLsizeiptr Alignment)
+    {
+        return (Value + Alignment - 1) / Alignment * Alignment;
+    }
+}
+
+FrameRingBuffer& FrameRingBuffer::GetInstance()
+{
+    // Never destroyed, released explicitly while the context is alive
+    static FrameRingBuffer* instance = new FrameRingBuffer();
+    return *instance;
+}
+
+FrameRingBuffer::FrameRingBuffer()
+{
+    GLint uniformAlignment = 256;
+    GLint storageAlignment = 256;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformAlignment);
+    glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &storageAlignment);
+    GLsizeiptr alignment = std::max<GLsizeiptr>(std::max(uniformAlignment, storageAlignment), 16);
+
+    m_ObjectsOffset = Align(sizeof(FrameConstants), alignment);
+    m_BonesOffset = Align(m_ObjectsOffset + MAX_OBJECTS * sizeof(ObjectData), alignment);
+    m_FrameStride = Align(m_BonesOffset + MAX_BONES * sizeof(PackedBone), alignment);
+    GLsizeiptr size = m_FrameStride * FRAMES;
+
+    GPUResourceTracker& tracker = GPUResourceTracker::GetInstance();
+    tracker.GenBuffers(1, &m_Buffer, GPUResourceOwner::OTHER);
+    GLState::BindBuffer(GL_UNIFORM_BUFFER, m_Buffer);
+    // Coherent so writes need neither explicit flushes nor barriers before the draw
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glBufferStorage(GL_UNIFORM_BUFFER, size, nullptr, flags);
+    m_Mapped = static_cast<char*>(glMapBufferRange(GL_UNIFORM_BUFFER, 0, size, flags));
+    GLState::BindBuffer(GL_UNIFORM_BUFFER, 0);
+    tracker.SetBufferSize(m_Buffer, size);
+
+    if (!m_Mapped)
+    {
+        fprintf(stderr, "ERROR::FRAME_RING_BUFFER::Failed to map %lld bytes\n", (long long)size);
+    }
+}
+
+void FrameRingBuffer::BeginFrame()
+{
+    m_Region = (m_Region + 1) % FRAMES;
+    ++m_FrameNumber;
+    m_ObjectCount = 0;
+    m_BoneCount = 0;
+    m_CurrentObject = 0;
+    m_IsObjectOverflowReported = false;
+    m_IsBoneOverflowReported = false;
+
+    auto start = std::chrono::steady_clock::now();
+    if (GLsync fence = m_Fences[m_Region])
+    {
+        GLbitfield waitFlags = 0;
+        GLenum result;
+        while ((result = glClientWaitSync(fence, waitFlags, FENCE_TIMEOUT)) == GL_TIMEOUT_EXPIRED)
+        {
+            // Make sure the fence itself reached the GPU before blocking on it
+            waitFlags = GL_SYNC_FLUSH_COMMANDS_BIT;
+        }
+        if (result == GL_WAIT_FAILED)
+        {
+            fprintf(stderr, "ERROR::FRAME_RING_BUFFER::Waiting for frame fence failed\n");
+        }
+        glDeleteSync(fence);
+        m_Fences[m_Region] = nullptr;
+    }
+    m_WaitMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    GLintptr offset = m_FrameStride * m_Region;
+    GLState::BindBufferRange(GL_UNIFORM_BUFFER, CONSTANTS_BINDING, m_Buffer, offset, sizeof(FrameConstants));
+    GLState::BindBufferRange(GL_SHADER_STORAGE_BUFFER, OBJECTS_BINDING, m_Buffer, offset + m_ObjectsOffset, MAX_OBJECTS * sizeof(ObjectData));
+    GLState::BindBufferRange(GL_SHADER_STORAGE_BUFFER, BONES_BINDING, m_Buffer, offset + m_BonesOffset, MAX_BONES * sizeof(PackedBone));
+}
+
+void FrameRingBuffer::EndFrame()
+{
+    if (m_Fences[m_Region])
+    {
+        glDeleteSync(m_Fences[m_Region]);
+    }
+    m_Fences[m_Region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+FrameConstants& FrameRingBuffer::GetConstants()
+{
+    return *reinterpret_cast<FrameConstants*>(m_Mapped + m_FrameStride * m_Region);
+}
+
+uint32_t FrameRingBuffer::PushObject(const glm::mat4& Model, uint32_t Flags, uint32_t BoneOffset)
+{
+    if (m_ObjectCount == MAX_OBJECTS)
+    {
+        if (!m_IsObjectOverflowReported)
+        {
+            fprintf(stderr, "ERROR::FRAME_RING_BUFFER::More than %u objects in a frame\n", MAX_OBJECTS);
+            m_IsObjectOverflowReported = true;
+        }
+        return 0;
+    }
+
+    ObjectData* objects = reinterpret_cast<ObjectData*>(m_Mapped + m_FrameStride * m_Region + m_ObjectsOffset);
+    ObjectData& object = objects[m_ObjectCount];
+    object.Model = Model;
+    object.NormalMatrix = glm::mat4(glm::inverseTranspose(glm::mat3(Model)));
+    object.Flags = Flags;
+    object.BoneOffset = BoneOffset;
+    return m_ObjectCount++;
+}
+
+uint32_t FrameRingBuffer::PushPalette(const glm::mat4* Bones, uint32_t Count)
+{
+    if (m_BoneCount + Count > MAX_BONES)
+    {
+        if (!m_IsBoneOverflowReported)
+        {
+            fprintf(stderr, "ERROR::FRAME_RING_BUFFER::More than %u bones in a frame\n", MAX_BONES);
+            m_IsBoneOverflowReported = true;
+        }
+        return 0;
+    }
+
+    PackedBone* bones = reinterpret_cast<PackedBone*>(m_Mapped + m_FrameStride * m_Region + m_BonesOffset) + m_BoneCount;
+    for (uint32_t i = 0; i < Count; ++i)
+    {
+        // Affine, the last row is always 0 0 0 1
+        const glm::mat4 rows = glm::transpose(Bones[i]);
+        bones[i].Rows[0] = rows[0];
+        bones[i].Rows[1] = rows[1];
+        bones[i].Rows[2] = rows[2];
+    }
+
+    uint32_t offset = m_BoneCount;
+    m_BoneCount += Count;
+    return offset;
+}
+
+uint32_t FrameRingBuffer::ReserveBones(uint32_t Count)
+{
+    if (m_BoneCount + Count > MAX_BONES)
+    {
+        if (!m_IsBoneOverflowReported)
+        {
+            fprintf(stderr, "ERROR::FRAME_RING_BUFFER::More than %u bones in a frame\n", MAX_BONES);
+            m_IsBoneOverflowReported = true;
+        }
+        return 0;
+    }
+
+    uint32_t offset = m_BoneCount;
+    m_BoneCount += Count;
+    return offset;
+}
+
+void FrameRingBuffer::SetCurrentObject(uint32_t Index)
+{
+    m_CurrentObject = Index;
+}
+
+uint32_t FrameRingBuffer::GetCurrentObject() const
+{
+    return m_CurrentObject;
+}
+
+uint64_t FrameRingBuffer::GetFrameNumber() const
+{
+    return m_FrameNumber;
+}
+
+uint32_t FrameRingBuffer::GetObjectCount() const
+{
+    return m_ObjectCount;
+}
+
+uint32_t FrameRingBuffer::GetBoneCount() const
+{
+    return m_BoneCount;
+}
+
+double FrameRingBuffer::GetWaitMs() const
+{
+    return m_WaitMs;
+}
+
+void FrameRingBuffer::Release()
+{
+    for (GLsync& fence : m_Fences)
+    {
+        if (fence)
+        {
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+    }
+    if (m_Buffer)
+    {
+        GLState::BindBuffer(GL_UNIFORM_BUFFER, m_Buffer);
+        glUnmapBuffer(GL_UNIFORM_BUFFER);
+        GLState::BindBuffer(GL_UNIFORM_BUFFER, 0);
+        GPUResourceTracker::GetInstance().DeleteBuffers(1, &m_Buffer);
+        m_Buffer = 0;
+        m_Mapped = nullptr;
+    }
+}
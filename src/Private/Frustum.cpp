@@ -0,0 +1,29 @@
+#include "Public/Frustum.h"
+
+Frustum Frustum::FromViewProjection(const glm::mat4& ViewProjection)
+{
+    const glm::mat4 rows = glm::transpose(ViewProjection);
+    Frustum frustum;
+    for (int i = 0; i < 3; ++i)
+    {
+        frustum.Planes[i * 2] = rows[3] + rows[i];
+        frustum.Planes[i * 2 + 1] = rows[3] - rows[i];
+    }
+    for (glm::vec4& plane : frustum.Planes)
+    {
+        plane /= glm::length(glm::vec3(plane));
+    }
+    return frustum;
+}
+
+bool Frustum::IsSphereVisible(const glm::vec3& Center, float Radius) const
+{
+    for (const glm::vec4& plane : Planes)
+    {
+        if (glm::dot(glm::vec3(plane), Center) + plane.w < -Radius)
+        {
+            return false;
+        }
+    }
+    return true;
+}
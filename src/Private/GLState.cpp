@@ -0,0 +1,378 @@
+#include "Public/GLState.h"
+
+#include <cstdio>
+
+GLState::TextureUnit GLState::m_Units[GLState::MAX_TEXTURE_UNITS];
+
+void GLState::UseProgram(GLuint Program)
+{
+    if (Update(m_Program, Program))
+    {
+        glUseProgram(Program);
+    }
+}
+
+GLuint GLState::GetProgram()
+{
+    return m_Program;
+}
+
+void GLState::ActiveTexture(GLuint Unit)
+{
+    if (Update(m_ActiveUnit, Unit))
+    {
+        glActiveTexture(GL_TEXTURE0 + Unit);
+    }
+}
+
+void GLState::BindTexture(GLenum Target, GLuint Texture)
+{
+    uint32_t target = GetTextureTarget(Target);
+    if (m_ActiveUnit >= MAX_TEXTURE_UNITS || target == UNKNOWN)
+    {
+        ++m_Stats.Issued;
+        glBindTexture(Target, Texture);
+        return;
+    }
+    if (Update(m_Units[m_ActiveUnit].Textures[target], Texture))
+    {
+        glBindTexture(Target, Texture);
+    }
+}
+
+void GLState::BindTexture(GLuint Unit, GLenum Target, GLuint Texture)
+{
+    if (Unit >= MAX_TEXTURE_UNITS)
+    {
+        fprintf(stderr, "Failed to bind texture to %d", Unit);
+        return;
+    }
+
+    // Checked first so binding an already bound texture does not switch units either
+    uint32_t target = GetTextureTarget(Target);
+    if (target != UNKNOWN && m_Units[Unit].Textures[target] == Texture)
+    {
+        ++m_Stats.Filtered;
+        return;
+    }
+    ActiveTexture(Unit);
+    BindTexture(Target, Texture);
+}
+
+void GLState::BindVertexArray(GLuint VertexArray)
+{
+    if (Update(m_VertexArray, VertexArray))
+    {
+        glBindVertexArray(VertexArray);
+        // The element buffer binding is part of the vertex array
+        m_Buffers[ELEMENT_ARRAY_BUFFER] = UNKNOWN;
+    }
+}
+
+void GLState::BindBuffer(GLenum Target, GLuint Buffer)
+{
+    uint32_t target = GetBufferTarget(Target);
+    if (target == UNKNOWN)
+    {
+        ++m_Stats.Issued;
+        glBindBuffer(Target, Buffer);
+        return;
+    }
+    if (Update(m_Buffers[target], Buffer))
+    {
+        glBindBuffer(Target, Buffer);
+    }
+}
+
+void GLState::BindBufferBase(GLenum Target, GLuint Index, GLuint Buffer)
+{
+    // Indexed bindings are not cached but they replace the generic binding as well
+    ++m_Stats.Issued;
+    glBindBufferBase(Target, Index, Buffer);
+    uint32_t target = GetBufferTarget(Target);
+    if (target != UNKNOWN)
+    {
+        m_Buffers[target] = Buffer;
+    }
+}
+
+void GLState::BindBufferRange(GLenum Target, GLuint Index, GLuint Buffer, GLintptr Offset, GLsizeiptr Size)
+{
+    ++m_Stats.Issued;
+    glBindBufferRange(Target, Index, Buffer, Offset, Size);
+    uint32_t target = GetBufferTarget(Target);
+    if (target != UNKNOWN)
+    {
+        m_Buffers[target] = Buffer;
+    }
+}
+
+void GLState::BindFramebuffer(GLenum Target, GLuint Framebuffer)
+{
+    bool isDraw = Target == GL_FRAMEBUFFER || Target == GL_DRAW_FRAMEBUFFER;
+    bool isRead = Target == GL_FRAMEBUFFER || Target == GL_READ_FRAMEBUFFER;
+    if ((!isDraw || m_DrawFramebuffer == Framebuffer) && (!isRead || m_ReadFramebuffer == Framebuffer))
+    {
+        ++m_Stats.Filtered;
+        return;
+    }
+
+    ++m_Stats.Issued;
+    glBindFramebuffer(Target, Framebuffer);
+    if (isDraw)
+    {
+        m_DrawFramebuffer = Framebuffer;
+    }
+    if (isRead)
+    {
+        m_ReadFramebuffer = Framebuffer;
+    }
+}
+
+void GLState::Viewport(GLint X, GLint Y, GLsizei Width, GLsizei Height)
+{
+    if (m_Viewport[0] == X && m_Viewport[1] == Y && m_Viewport[2] == Width && m_Viewport[3] == Height)
+    {
+        ++m_Stats.Filtered;
+        return;
+    }
+
+    ++m_Stats.Issued;
+    glViewport(X, Y, Width, Height);
+    m_Viewport[0] = X;
+    m_Viewport[1] = Y;
+    m_Viewport[2] = Width;
+    m_Viewport[3] = Height;
+}
+
+void GLState::Enable(GLenum Capability)
+{
+    SetEnabled(Capability, true);
+}
+
+void GLState::Disable(GLenum Capability)
+{
+    SetEnabled(Capability, false);
+}
+
+void GLState::SetEnabled(GLenum Capability, bool IsEnabled)
+{
+    uint32_t capability = GetCapability(Capability);
+    if (capability == UNKNOWN)
+    {
+        ++m_Stats.Issued;
+    }
+    else if (!Update(m_Capabilities[capability], IsEnabled))
+    {
+        return;
+    }
+
+    if (IsEnabled)
+    {
+        glEnable(Capability);
+    }
+    else
+    {
+        glDisable(Capability);
+    }
+}
+
+void GLState::DepthFunc(GLenum Function)
+{
+    if (Update(m_DepthFunc, Function))
+    {
+        glDepthFunc(Function);
+    }
+}
+
+void GLState::DepthMask(GLboolean Mask)
+{
+    if (Update(m_DepthMask, Mask))
+    {
+        glDepthMask(Mask);
+    }
+}
+
+void GLState::BlendFunc(GLenum Source, GLenum Destination)
+{
+    if (m_BlendFunc[0] == Source && m_BlendFunc[1] == Destination)
+    {
+        ++m_Stats.Filtered;
+        return;
+    }
+
+    ++m_Stats.Issued;
+    glBlendFunc(Source, Destination);
+    m_BlendFunc[0] = Source;
+    m_BlendFunc[1] = Destination;
+}
+
+void GLState::CullFace(GLenum Face)
+{
+    if (Update(m_CullFace, Face))
+    {
+        glCullFace(Face);
+    }
+}
+
+void GLState::PolygonMode(GLenum Mode)
+{
+    if (Update(m_PolygonMode, Mode))
+    {
+        glPolygonMode(GL_FRONT_AND_BACK, Mode);
+    }
+}
+
+void GLState::ForgetProgram(GLuint Program)
+{
+    if (m_Program == Program)
+    {
+        m_Program = UNKNOWN;
+    }
+}
+
+void GLState::ForgetTextures(GLsizei Count, const GLuint* Ids)
+{
+    for (GLsizei i = 0; i < Count; ++i)
+    {
+        for (TextureUnit& unit : m_Units)
+        {
+            for (GLuint& texture : unit.Textures)
+            {
+                if (texture == Ids[i])
+                {
+                    texture = 0;
+                }
+            }
+        }
+    }
+}
+
+void GLState::ForgetBuffers(GLsizei Count, const GLuint* Ids)
+{
+    for (GLsizei i = 0; i < Count; ++i)
+    {
+        for (GLuint& buffer : m_Buffers)
+        {
+            if (buffer == Ids[i])
+            {
+                buffer = 0;
+            }
+        }
+    }
+}
+
+void GLState::ForgetFramebuffers(GLsizei Count, const GLuint* Ids)
+{
+    for (GLsizei i = 0; i < Count; ++i)
+    {
+        if (m_DrawFramebuffer == Ids[i])
+        {
+            m_DrawFramebuffer = 0;
+        }
+        if (m_ReadFramebuffer == Ids[i])
+        {
+            m_ReadFramebuffer = 0;
+        }
+    }
+}
+
+void GLState::ForgetVertexArrays(GLsizei Count, const GLuint* Ids)
+{
+    for (GLsizei i = 0; i < Count; ++i)
+    {
+        if (m_VertexArray == Ids[i])
+        {
+            m_VertexArray = 0;
+            m_Buffers[ELEMENT_ARRAY_BUFFER] = UNKNOWN;
+        }
+    }
+}
+
+void GLState::Invalidate()
+{
+    m_Program = UNKNOWN;
+    m_ActiveUnit = UNKNOWN;
+    for (TextureUnit& unit : m_Units)
+    {
+        unit = TextureUnit();
+    }
+    m_VertexArray = UNKNOWN;
+    for (GLuint& buffer : m_Buffers)
+    {
+        buffer = UNKNOWN;
+    }
+    m_DrawFramebuffer = UNKNOWN;
+    m_ReadFramebuffer = UNKNOWN;
+    for (GLint& value : m_Viewport)
+    {
+        value = -1;
+    }
+    for (GLuint& capability : m_Capabilities)
+    {
+        capability = UNKNOWN;
+    }
+    m_DepthFunc = UNKNOWN;
+    m_DepthMask = UNKNOWN;
+    m_BlendFunc[0] = UNKNOWN;
+    m_BlendFunc[1] = UNKNOWN;
+    m_CullFace = UNKNOWN;
+    m_PolygonMode = UNKNOWN;
+}
+
+const GLStateStats& GLState::GetStats()
+{
+    return m_Stats;
+}
+
+void GLState::ResetStats()
+{
+    m_Stats = GLStateStats();
+}
+
+bool GLState::Update(GLuint& Cached, GLuint Value)
+{
+    if (Cached == Value)
+    {
+        ++m_Stats.Filtered;
+        return false;
+    }
+    ++m_Stats.Issued;
+    Cached = Value;
+    return true;
+}
+
+uint32_t GLState::GetTextureTarget(GLenum Target)
+{
+    switch (Target)
+    {
+        case GL_TEXTURE_2D:       return TEXTURE_2D;
+        case GL_TEXTURE_CUBE_MAP: return TEXTURE_CUBE_MAP;
+        case GL_TEXTURE_2D_ARRAY: return TEXTURE_2D_ARRAY;
+        default:                  return UNKNOWN;
+    }
+}
+
+uint32_t GLState::GetBufferTarget(GLenum Target)
+{
+    switch (Target)
+    {
+        case GL_ARRAY_BUFFER:          return ARRAY_BUFFER;
+        case GL_ELEMENT_ARRAY_BUFFER:  return ELEMENT_ARRAY_BUFFER;
+        case GL_UNIFORM_BUFFER:        return UNIFORM_BUFFER;
+        case GL_SHADER_STORAGE_BUFFER: return SHADER_STORAGE_BUFFER;
+        case GL_DRAW_INDIRECT_BUFFER:  return DRAW_INDIRECT_BUFFER;
+        default:                       return UNKNOWN;
+    }
+}
+
+uint32_t GLState::GetCapability(GLenum Capability)
+{
+    switch (Capability)
+    {
+        case GL_DEPTH_TEST: return DEPTH_TEST;
+        case GL_CULL_FACE:  return CULL_FACE;
+        case GL_BLEND:      return BLEND;
+        default:            return UNKNOWN;
+    }
+}
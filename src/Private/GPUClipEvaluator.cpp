@@ -0,0 +1,378 @@
+#include "Public/GPUClipEvaluator.h"
+#include "Public/Animation.h"
+#include "Public/CompressedClip.h"
+#include "Public/GLState.h"
+#include "Public/GPUResourceTracker.h"
+#include "Public/Shader.h"
+#include "Public/Skeleton.h"
+#include "Public/SkinnedModel.h"
+
+#include <glad/glad.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+namespace
+{
+	// local_size_x of ClipEvaluation.comp
+	const uint32_t EVALUATION_GROUP_SIZE = 64;
+
+	// The helpers below are written operation for operation like their counterparts in ClipEvaluation.comp
+
+	float DecompressValue(uint32_t Value)
+	{
+		return float(Value) / 65535.0f * 2.0f - 1.0f;
+	}
+
+	// AnimationOptimizer::QuatIhm as x, y, z, w
+	glm::vec4 DecompressRotation(const glm::vec3& Value)
+	{
+		const float khi = 0.17157287895679473876953125f;
+		const float km = 4.0f * 0.4142135679721832275390625f;
+		const float d = khi * glm::dot(Value, Value);
+		const float a = 1.0f + d;
+		const float b = (1.0f - d) * km;
+		const float c = 1.0f / (a * a);
+		return glm::vec4(Value * (b * c), (1.0f + d * (d - 6.0f)) * c);
+	}
+
+	float GetAlpha(float First, float Last, float Time)
+	{
+		return Last > First ? glm::clamp((Time - First) / (Last - First), 0.0f, 1.0f) : 1.0f;
+	}
+
+	// Rotation x, y, z, w and translation to the matrix glm::translate * glm::toMat4 builds
+	glm::mat4 ToMatrix(const glm::vec3& Position, const glm::vec4& Rotation)
+	{
+		const float xx = Rotation.x * Rotation.x;
+		const float yy = Rotation.y * Rotation.y;
+		const float zz = Rotation.z * Rotation.z;
+		const float xy = Rotation.x * Rotation.y;
+		const float xz = Rotation.x * Rotation.z;
+		const float yz = Rotation.y * Rotation.z;
+		const float wx = Rotation.w * Rotation.x;
+		const float wy = Rotation.w * Rotation.y;
+		const float wz = Rotation.w * Rotation.z;
+		return glm::mat4(
+			glm::vec4(1.0f - 2.0f * (yy + zz), 2.0f * (xy + wz), 2.0f * (xz - wy), 0.0f),
+			glm::vec4(2.0f * (xy - wz), 1.0f - 2.0f * (xx + zz), 2.0f * (yz + wx), 0.0f),
+			glm::vec4(2.0f * (xz + wy), 2.0f * (yz - wx), 1.0f - 2.0f * (xx + yy), 0.0f),
+			glm::vec4(Position, 1.0f));
+	}
+
+	PackedBone ToPackedBone(const glm::mat4& Matrix)
+	{
+		const glm::mat4 rows = glm::transpose(Matrix);
+		return { { rows[0], rows[1], rows[2] } };
+	}
+}
+
+GPUClipEvaluator::GPUClipEvaluator()
+{
+	GPUResourceTracker& tracker = GPUResourceTracker::GetInstance();
+	tracker.GenBuffers(1, &m_ClipBuffer, GPUResourceOwner::OTHER);
+	tracker.GenBuffers(1, &m_JointBuffer, GPUResourceOwner::OTHER);
+	tracker.GenBuffers(1, &m_CurveBuffer, GPUResourceOwner::OTHER);
+	tracker.GenBuffers(1, &m_KeyBuffer, GPUResourceOwner::OTHER);
+	tracker.GenBuffers(1, &m_InstanceBuffer, GPUResourceOwner::OTHER);
+}
+
+GPUClipEvaluator::~GPUClipEvaluator()
+{
+	GPUResourceTracker& tracker = GPUResourceTracker::GetInstance();
+	tracker.DeleteBuffers(1, &m_ClipBuffer);
+	tracker.DeleteBuffers(1, &m_JointBuffer);
+	tracker.DeleteBuffers(1, &m_CurveBuffer);
+	tracker.DeleteBuffers(1, &m_KeyBuffer);
+	tracker.DeleteBuffers(1, &m_InstanceBuffer);
+}
+
+int32_t GPUClipEvaluator::AddClip(const CompressedClip& Clip, const Skeleton& Skeleton)
+{
+	const std::vector<SkeletonJoint>& joints = Skeleton.GetJoints();
+	if (joints.size() > MAX_JOINTS)
+	{
+		fprintf(stderr, "ERROR::GPU_CLIP_EVALUATOR::%zu joints, at most %u are supported\n", joints.size(), MAX_JOINTS);
+		return -1;
+	}
+
+	ClipInfo clip = {};
+	clip.FirstJoint = m_Joints.size();
+	clip.JointCount = joints.size();
+	clip.PaletteSize = Skeleton.GetPaletteSize();
+	clip.TimeScale = Clip.GetTimeScale();
+
+	const uint32_t firstCurve = m_Curves.size();
+	const uint32_t firstKey = m_Keys.size();
+	for (const CompressedCurve& source : Clip.GetCurves())
+	{
+		Curve curve;
+		curve.FirstRotation = firstKey + source.FirstRotation;
+		curve.NumRotations = source.NumRotations;
+		curve.FirstPosition = firstKey + source.FirstPosition;
+		curve.NumPositions = source.NumPositions;
+		curve.PositionCenter = glm::vec4(source.PositionCenter, 0.0f);
+		curve.PositionHalfExtent = glm::vec4(source.PositionHalfExtent, 0.0f);
+		m_Curves.push_back(curve);
+	}
+	for (const CompressedKey& source : Clip.GetKeys())
+	{
+		m_Keys.push_back({ uint32_t(source.Time) | uint32_t(source.Data[0]) << 16, uint32_t(source.Data[1]) | uint32_t(source.Data[2]) << 16 });
+	}
+
+	for (const SkeletonJoint& source : joints)
+	{
+		Joint joint;
+		joint.Parent = source.Parent;
+		joint.BoneID = source.BoneID;
+		joint.Curve = source.Channel >= 0 ? int32_t(firstCurve) + source.Channel : -1;
+		// Parents come first, their depth is known
+		joint.Depth = source.Parent >= 0 ? m_Joints[clip.FirstJoint + source.Parent].Depth + 1 : 0;
+		joint.BindPosition = glm::vec4(source.BindPosition, 0.0f);
+		joint.BindRotation = glm::vec4(source.BindRotation.x, source.BindRotation.y, source.BindRotation.z, source.BindRotation.w);
+		joint.Offset = source.Offset;
+		clip.DepthCount = std::max(clip.DepthCount, joint.Depth + 1);
+		m_Joints.push_back(joint);
+	}
+
+	m_Clips.push_back(clip);
+	m_IsDirty = true;
+	return m_Clips.size() - 1;
+}
+
+uint32_t GPUClipEvaluator::GetClipCount() const
+{
+	return m_Clips.size();
+}
+
+uint32_t GPUClipEvaluator::GetPaletteSize(uint32_t Clip) const
+{
+	return m_Clips[Clip].PaletteSize;
+}
+
+void GPUClipEvaluator::Dispatch(Shader& EvaluationShader, const std::vector<GPUClipInstance>& Instances)
+{
+	if (Instances.empty() || m_Clips.empty())
+	{
+		return;
+	}
+	if (Instances.size() > MAX_INSTANCES)
+	{
+		fprintf(stderr, "ERROR::GPU_CLIP_EVALUATOR::%zu instances, at most %u are supported\n", Instances.size(), MAX_INSTANCES);
+		return;
+	}
+	Upload();
+
+	// Orphaned every frame, the previous contents may still be read by the GPU
+	const size_t size = Instances.size() * sizeof(GPUClipInstance);
+	GLState::BindBuffer(GL_SHADER_STORAGE_BUFFER, m_InstanceBuffer);
+	m_InstanceCapacity = std::max(m_InstanceCapacity, size);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, m_InstanceCapacity, nullptr, GL_STREAM_DRAW);
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, size, Instances.data());
+	GPUResourceTracker::GetInstance().SetBufferSize(m_InstanceBuffer, m_InstanceCapacity);
+	GLState::BindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	GLState::BindBufferBase(GL_SHADER_STORAGE_BUFFER, CLIPS_BINDING, m_ClipBuffer);
+	GLState::BindBufferBase(GL_SHADER_STORAGE_BUFFER, JOINTS_BINDING, m_JointBuffer);
+	GLState::BindBufferBase(GL_SHADER_STORAGE_BUFFER, CURVES_BINDING, m_CurveBuffer);
+	GLState::BindBufferBase(GL_SHADER_STORAGE_BUFFER, KEYS_BINDING, m_KeyBuffer);
+	GLState::BindBufferBase(GL_SHADER_STORAGE_BUFFER, INSTANCES_BINDING, m_InstanceBuffer);
+	EvaluationShader.Use();
+	EvaluationShader.setInt("instanceCount", int(Instances.size()));
+	glDispatchCompute(Instances.size(), 1, 1);
+}
+
+void GPUClipEvaluator::Evaluate(const std::vector<GPUClipInstance>& Instances, std::vector<PackedBone>& Bones) const
+{
+	const PackedBone identity = ToPackedBone(glm::mat4(1.0f));
+	glm::mat4 transforms[MAX_JOINTS];
+	for (const GPUClipInstance& instance : Instances)
+	{
+		const ClipInfo& clip = m_Clips[instance.Clip];
+		if (Bones.size() < size_t(instance.BoneOffset) + clip.PaletteSize)
+		{
+			Bones.resize(size_t(instance.BoneOffset) + clip.PaletteSize);
+		}
+		std::fill_n(Bones.begin() + instance.BoneOffset, clip.PaletteSize, identity);
+
+		// Joint order already has parents first, the shader gets the same products level by level
+		for (uint32_t i = 0; i < clip.JointCount; ++i)
+		{
+			const Joint& joint = m_Joints[clip.FirstJoint + i];
+			glm::vec3 position = glm::vec3(joint.BindPosition);
+			glm::vec4 rotation = joint.BindRotation;
+			if (joint.Curve >= 0)
+			{
+				SampleCurve(m_Curves[joint.Curve], instance.Time, clip.TimeScale, position, rotation);
+			}
+			const glm::mat4 local = ToMatrix(position, rotation);
+			transforms[i] = joint.Parent >= 0 ? transforms[joint.Parent] * local : local;
+		}
+
+		for (uint32_t i = 0; i < clip.JointCount; ++i)
+		{
+			const Joint& joint = m_Joints[clip.FirstJoint + i];
+			if (joint.BoneID >= 0 && uint32_t(joint.BoneID) < clip.PaletteSize)
+			{
+				Bones[instance.BoneOffset + joint.BoneID] = ToPackedBone(transforms[i] * joint.Offset);
+			}
+		}
+	}
+}
+
+size_t GPUClipEvaluator::GetMemorySize() const
+{
+	return m_Clips.size() * sizeof(ClipInfo) + m_Joints.size() * sizeof(Joint) + m_Curves.size() * sizeof(Curve)
+		+ m_Keys.size() * sizeof(Key) + m_InstanceCapacity;
+}
+
+void GPUClipEvaluator::Upload()
+{
+	if (!m_IsDirty)
+	{
+		return;
+	}
+
+	GPUResourceTracker& tracker = GPUResourceTracker::GetInstance();
+	const auto upload = [&](uint32_t Buffer, const void* Data, size_t Size)
+	{
+		// Empty buffers cannot be bound, clips without keys still get one element
+		const size_t size = std::max<size_t>(Size, 16);
+		GLState::BindBuffer(GL_SHADER_STORAGE_BUFFER, Buffer);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, size, nullptr, GL_STATIC_DRAW);
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, Size, Data);
+		tracker.SetBufferSize(Buffer, size);
+	};
+	upload(m_ClipBuffer, m_Clips.data(), m_Clips.size() * sizeof(ClipInfo));
+	upload(m_JointBuffer, m_Joints.data(), m_Joints.size() * sizeof(Joint));
+	upload(m_CurveBuffer, m_Curves.data(), m_Curves.size() * sizeof(Curve));
+	upload(m_KeyBuffer, m_Keys.data(), m_Keys.size() * sizeof(Key));
+	GLState::BindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	m_IsDirty = false;
+}
+
+void GPUClipEvaluator::SampleCurve(const Curve& Curve, float Time, float TimeScale, glm::vec3& Position, glm::vec4& Rotation) const
+{
+	const float keyTime = glm::clamp(Time * TimeScale, 0.0f, 65535.0f);
+	const uint32_t time = uint32_t(keyTime);
+	const auto getTime = [&](uint32_t Index) { return m_Keys[Index].TimeAndX & 0xFFFFu; };
+	const auto getValue = [&](uint32_t Index)
+	{
+		const Key& key = m_Keys[Index];
+		return glm::vec3(DecompressValue(key.TimeAndX >> 16), DecompressValue(key.YAndZ & 0xFFFFu), DecompressValue(key.YAndZ >> 16));
+	};
+	// Like CompressedClip's segment search, the last key never starts a segment
+	const auto findSegment = [&](uint32_t First, uint32_t Count)
+	{
+		if (Count < 2)
+		{
+			return First;
+		}
+		uint32_t low = 1;
+		uint32_t high = Count - 1;
+		while (low < high)
+		{
+			const uint32_t middle = (low + high) / 2;
+			if (time < getTime(First + middle))
+			{
+				high = middle;
+			}
+			else
+			{
+				low = middle + 1;
+			}
+		}
+		return First + low - 1;
+	};
+
+	uint32_t key = findSegment(Curve.FirstRotation, Curve.NumRotations);
+	Rotation = DecompressRotation(getValue(key));
+	if (key + 1 < Curve.FirstRotation + Curve.NumRotations)
+	{
+		glm::vec4 next = DecompressRotation(getValue(key + 1));
+		next = glm::dot(Rotation, next) < 0.0f ? -next : next;
+		const float alpha = GetAlpha(float(getTime(key)), float(getTime(key + 1)), keyTime);
+		Rotation = glm::normalize(Rotation + (next - Rotation) * alpha);
+	}
+
+	const glm::vec3 center = glm::vec3(Curve.PositionCenter);
+	const glm::vec3 halfExtent = glm::vec3(Curve.PositionHalfExtent);
+	key = findSegment(Curve.FirstPosition, Curve.NumPositions);
+	Position = center + getValue(key) * halfExtent;
+	if (key + 1 < Curve.FirstPosition + Curve.NumPositions)
+	{
+		const glm::vec3 next = center + getValue(key + 1) * halfExtent;
+		const float alpha = GetAlpha(float(getTime(key)), float(getTime(key + 1)), keyTime);
+		Position = Position + (next - Position) * alpha;
+	}
+}
+
+GPUClipBenchmarkResult GPUClipEvaluator::Benchmark(const std::string& ModelPath, const std::string& ClipPath, Shader& EvaluationShader, uint32_t Instances)
+{
+	GPUClipBenchmarkResult result;
+	SkinnedModel model(ModelPath.c_str());
+	Animation animation(ClipPath, &model);
+	Skeleton skeleton(animation, model);
+	CompressedClip compressed(animation);
+
+	GPUClipEvaluator evaluator;
+	if (evaluator.AddClip(compressed, skeleton) < 0)
+	{
+		return result;
+	}
+	const uint32_t paletteSize = evaluator.GetPaletteSize(0);
+	Instances = std::min(Instances, std::min(MAX_INSTANCES, FrameRingBuffer::MAX_BONES / std::max(paletteSize, 1U)));
+	result.Instances = Instances;
+	result.Joints = skeleton.GetJointCount();
+
+	std::vector<GPUClipInstance> instances(Instances);
+	for (uint32_t i = 0; i < Instances; ++i)
+	{
+		// Spread over the clip so most instances sample different keys
+		instances[i] = { 0, std::fmod(animation.GetDuration() * (i * 0.618034f), animation.GetDuration()), i * paletteSize, 0 };
+	}
+
+	std::vector<PackedBone> reference;
+	auto start = std::chrono::high_resolution_clock::now();
+	evaluator.Evaluate(instances, reference);
+	result.CpuMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+	// The frame's bone buffer is bound again by the next FrameRingBuffer::BeginFrame
+	GLuint output = 0;
+	GPUResourceTracker& tracker = GPUResourceTracker::GetInstance();
+	tracker.GenBuffers(1, &output, GPUResourceOwner::OTHER);
+	GLState::BindBuffer(GL_SHADER_STORAGE_BUFFER, output);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, reference.size() * sizeof(PackedBone), nullptr, GL_STREAM_READ);
+	tracker.SetBufferSize(output, reference.size() * sizeof(PackedBone));
+	GLState::BindBufferBase(GL_SHADER_STORAGE_BUFFER, FrameRingBuffer::BONES_BINDING, output);
+
+	// Uploads happen on the first dispatch, the timed one only evaluates
+	evaluator.Dispatch(EvaluationShader, instances);
+	GLuint query = 0;
+	glGenQueries(1, &query);
+	glBeginQuery(GL_TIME_ELAPSED, query);
+	evaluator.Dispatch(EvaluationShader, instances);
+	glEndQuery(GL_TIME_ELAPSED);
+	GLuint64 nanoseconds = 0;
+	glGetQueryObjectui64v(query, GL_QUERY_RESULT, &nanoseconds);
+	glDeleteQueries(1, &query);
+	result.GpuMs = nanoseconds / 1000000.0;
+
+	glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+	std::vector<PackedBone> bones(reference.size());
+	GLState::BindBuffer(GL_SHADER_STORAGE_BUFFER, output);
+	glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, bones.size() * sizeof(PackedBone), bones.data());
+	GLState::BindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	tracker.DeleteBuffers(1, &output);
+
+	for (size_t bone = 0; bone < bones.size(); ++bone)
+	{
+		for (int row = 0; row < 3; ++row)
+		{
+			const glm::vec4 difference = glm::abs(bones[bone].Rows[row] - reference[bone].Rows[row]);
+			result.MaxError = std::max({ result.MaxError, difference.x, difference.y, difference.z, difference.w });
+		}
+	}
+	return result;
+}
@@ -0,0 +1,307 @@
+#include "Public/GPUResourceTracker.h"
+#include "Public/GLState.h"
+
+#include "imgui.h"
+#include <cstdio>
+
+GPUResourceTracker& GPUResourceTracker::GetInstance()
+{
+    // Never destroyed, static objects may still release GL objects after main returns
+    static GPUResourceTracker* instance = new GPUResourceTracker();
+    return *instance;
+}
+
+void GPUResourceTracker::GenBuffers(GLsizei Count, GLuint* Ids, GPUResourceOwner Owner)
+{
+    glGenBuffers(Count, Ids);
+    Register(GPUResourceType::BUFFER, Count, Ids, Owner);
+}
+
+void GPUResourceTracker::GenTextures(GLsizei Count, GLuint* Ids, GPUResourceOwner Owner)
+{
+    glGenTextures(Count, Ids);
+    Register(GPUResourceType::TEXTURE, Count, Ids, Owner);
+}
+
+void GPUResourceTracker::GenFramebuffers(GLsizei Count, GLuint* Ids, GPUResourceOwner Owner)
+{
+    glGenFramebuffers(Count, Ids);
+    Register(GPUResourceType::FRAMEBUFFER, Count, Ids, Owner);
+}
+
+void GPUResourceTracker::GenRenderbuffers(GLsizei Count, GLuint* Ids, GPUResourceOwner Owner)
+{
+    glGenRenderbuffers(Count, Ids);
+    Register(GPUResourceType::RENDERBUFFER, Count, Ids, Owner);
+}
+
+void GPUResourceTracker::GenVertexArrays(GLsizei Count, GLuint* Ids, GPUResourceOwner Owner)
+{
+    glGenVertexArrays(Count, Ids);
+    Register(GPUResourceType::VERTEXARRAY, Count, Ids, Owner);
+}
+
+void GPUResourceTracker::CreateVertexArrays(GLsizei Count, GLuint* Ids, GPUResourceOwner Owner)
+{
+    glCreateVertexArrays(Count, Ids);
+    Register(GPUResourceType::VERTEXARRAY, Count, Ids, Owner);
+}
+
+void GPUResourceTracker::DeleteBuffers(GLsizei Count, const GLuint* Ids)
+{
+    Unregister(GPUResourceType::BUFFER, Count, Ids);
+    GLState::ForgetBuffers(Count, Ids);
+    glDeleteBuffers(Count, Ids);
+}
+
+void GPUResourceTracker::DeleteTextures(GLsizei Count, const GLuint* Ids)
+{
+    Unregister(GPUResourceType::TEXTURE, Count, Ids);
+    GLState::ForgetTextures(Count, Ids);
+    glDeleteTextures(Count, Ids);
+}
+
+void GPUResourceTracker::DeleteFramebuffers(GLsizei Count, const GLuint* Ids)
+{
+    Unregister(GPUResourceType::FRAMEBUFFER, Count, Ids);
+    GLState::ForgetFramebuffers(Count, Ids);
+    glDeleteFramebuffers(Count, Ids);
+}
+
+void GPUResourceTracker::DeleteRenderbuffers(GLsizei Count, const GLuint* Ids)
+{
+    Unregister(GPUResourceType::RENDERBUFFER, Count, Ids);
+    glDeleteRenderbuffers(Count, Ids);
+}
+
+void GPUResourceTracker::DeleteVertexArrays(GLsizei Count, const GLuint* Ids)
+{
+    Unregister(GPUResourceType::VERTEXARRAY, Count, Ids);
+    GLState::ForgetVertexArrays(Count, Ids);
+    glDeleteVertexArrays(Count, Ids);
+}
+
+void GPUResourceTracker::SetBufferSize(GLuint Id, GLsizeiptr Bytes)
+{
+    SetBytes(GPUResourceType::BUFFER, Id, uint64_t(Bytes));
+}
+
+void GPUResourceTracker::SetTextureSize(GLuint Id, GLenum InternalFormat, int Width, int Height, int Layers, bool HasMipmaps)
+{
+    uint64_t bytes = uint64_t(GetBytesPerPixel(InternalFormat)) * Width * Height * Layers;
+    if (HasMipmaps)
+    {
+        // Full mip chain adds a third of the base level
+        bytes += bytes / 3;
+    }
+    SetBytes(GPUResourceType::TEXTURE, Id, bytes);
+}
+
+void GPUResourceTracker::SetRenderbufferSize(GLuint Id, GLenum InternalFormat, int Width, int Height)
+{
+    SetBytes(GPUResourceType::RENDERBUFFER, Id, uint64_t(GetBytesPerPixel(InternalFormat)) * Width * Height);
+}
+
+void GPUResourceTracker::SetPersistent(GPUResourceType Type, GLuint Id)
+{
+    auto iter = m_Records.find(GetKey(Type, Id));
+    if (iter != m_Records.end())
+    {
+        iter->second.IsPersistent = true;
+    }
+}
+
+uint64_t GPUResourceTracker::GetTotalBytes() const
+{
+    uint64_t total = 0;
+    for (uint64_t bytes : m_Bytes)
+    {
+        total += bytes;
+    }
+    return total;
+}
+
+uint64_t GPUResourceTracker::GetBytes(GPUResourceOwner Owner) const
+{
+    return m_Bytes[(int)Owner];
+}
+
+uint32_t GPUResourceTracker::GetCount(GPUResourceOwner Owner, GPUResourceType Type) const
+{
+    return m_Counts[(int)Owner][(int)Type];
+}
+
+void GPUResourceTracker::DrawGUI()
+{
+    ImGui::Begin("GPU resources");
+
+    ImGui::Text("Estimated VRAM: %.2f MB", GetTotalBytes() / (1024.0 * 1024.0));
+    if (ImGui::BeginTable("Resources", (int)GPUResourceType::TYPESCOUNT + 2, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+    {
+        ImGui::TableSetupColumn("Owner");
+        for (int type = 0; type < (int)GPUResourceType::TYPESCOUNT; ++type)
+        {
+            ImGui::TableSetupColumn(GetTypeName(GPUResourceType(type)));
+        }
+        ImGui::TableSetupColumn("MB");
+        ImGui::TableHeadersRow();
+
+        for (int owner = 0; owner < (int)GPUResourceOwner::OWNERSCOUNT; ++owner)
+        {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::Text("%s", GetOwnerName(GPUResourceOwner(owner)));
+            for (int type = 0; type < (int)GPUResourceType::TYPESCOUNT; ++type)
+            {
+                ImGui::TableNextColumn();
+                ImGui::Text("%u", m_Counts[owner][type]);
+            }
+            ImGui::TableNextColumn();
+            ImGui::Text("%.2f", m_Bytes[owner] / (1024.0 * 1024.0));
+        }
+        ImGui::EndTable();
+    }
+
+    ImGui::End();
+}
+
+uint32_t GPUResourceTracker::ReportLeaks() const
+{
+    uint32_t leaks = 0;
+    for (const auto& [key, record] : m_Records)
+    {
+        if (record.IsPersistent)
+        {
+            continue;
+        }
+        fprintf(stderr, "GPU resource leak: %s %u owned by %s (%llu bytes)\n",
+                GetTypeName(GPUResourceType(key >> 32)), GLuint(key & 0xFFFFFFFFu),
+                GetOwnerName(record.Owner), (unsigned long long)record.Bytes);
+        ++leaks;
+    }
+
+    if (leaks)
+    {
+        fprintf(stderr, "%u GPU resources leaked\n", leaks);
+    }
+    return leaks;
+}
+
+const char* GPUResourceTracker::GetOwnerName(GPUResourceOwner Owner)
+{
+    switch (Owner)
+    {
+        case GPUResourceOwner::MESH:        return "Mesh";
+        case GPUResourceOwner::TEXTURE:     return "Texture";
+        case GPUResourceOwner::BLOOM:       return "Bloom";
+        case GPUResourceOwner::SHADOW:      return "Shadow";
+        case GPUResourceOwner::IBL:         return "IBL";
+        case GPUResourceOwner::POSTPROCESS: return "PostProcess";
+        case GPUResourceOwner::PARTICLES:   return "Particles";
+        case GPUResourceOwner::GIZMO:       return "Gizmo";
+        case GPUResourceOwner::OTHER:
+        case GPUResourceOwner::OWNERSCOUNT:
+        default:                            return "Other";
+    }
+}
+
+const char* GPUResourceTracker::GetTypeName(GPUResourceType Type)
+{
+    switch (Type)
+    {
+        case GPUResourceType::BUFFER:       return "Buffers";
+        case GPUResourceType::TEXTURE:      return "Textures";
+        case GPUResourceType::FRAMEBUFFER:  return "Framebuffers";
+        case GPUResourceType::RENDERBUFFER: return "Renderbuffers";
+        case GPUResourceType::VERTEXARRAY:  return "VAOs";
+        case GPUResourceType::TYPESCOUNT:
+        default:                            return "Unknown";
+    }
+}
+
+uint32_t GPUResourceTracker::GetBytesPerPixel(GLenum InternalFormat)
+{
+    // Drivers pad 3 channel formats to 4
+    switch (InternalFormat)
+    {
+        case GL_RED:
+        case GL_R8:
+            return 1;
+        case GL_RG:
+        case GL_RG8:
+        case GL_R16F:
+            return 2;
+        case GL_RGB:
+        case GL_RGB8:
+        case GL_SRGB:
+        case GL_SRGB8:
+        case GL_RGBA:
+        case GL_RGBA8:
+        case GL_SRGB_ALPHA:
+        case GL_SRGB8_ALPHA8:
+        case GL_RG16F:
+        case GL_R32F:
+        case GL_R11F_G11F_B10F:
+        case GL_DEPTH_COMPONENT:
+        case GL_DEPTH_COMPONENT24:
+        case GL_DEPTH_COMPONENT32F:
+        case GL_DEPTH24_STENCIL8:
+            return 4;
+        case GL_RGB16F:
+        case GL_RGBA16F:
+        case GL_RG32F:
+            return 8;
+        case GL_RGB32F:
+        case GL_RGBA32F:
+            return 16;
+        default:
+            return 4;
+    }
+}
+
+uint64_t GPUResourceTracker::GetKey(GPUResourceType Type, GLuint Id)
+{
+    return (uint64_t(Type) << 32) | Id;
+}
+
+void GPUResourceTracker::Register(GPUResourceType Type, GLsizei Count, const GLuint* Ids, GPUResourceOwner Owner)
+{
+    for (GLsizei i = 0; i < Count; ++i)
+    {
+        if (Ids[i] == 0)
+        {
+            continue;
+        }
+        m_Records[GetKey(Type, Ids[i])] = { Owner, 0, false };
+        ++m_Counts[(int)Owner][(int)Type];
+    }
+}
+
+void GPUResourceTracker::Unregister(GPUResourceType Type, GLsizei Count, const GLuint* Ids)
+{
+    for (GLsizei i = 0; i < Count; ++i)
+    {
+        auto iter = m_Records.find(GetKey(Type, Ids[i]));
+        if (iter == m_Records.end())
+        {
+            continue;
+        }
+        const Record& record = iter->second;
+        --m_Counts[(int)record.Owner][(int)Type];
+        m_Bytes[(int)record.Owner] -= record.Bytes;
+        m_Records.erase(iter);
+    }
+}
+
+void GPUResourceTracker::SetBytes(GPUResourceType Type, GLuint Id, uint64_t Bytes)
+{
+    auto iter = m_Records.find(GetKey(Type, Id));
+    if (iter == m_Records.end())
+    {
+        return;
+    }
+    Record& record = iter->second;
+    m_Bytes[(int)record.Owner] -= record.Bytes;
+    record.Bytes = Bytes;
+    m_Bytes[(int)record.Owner] += Bytes;
+}
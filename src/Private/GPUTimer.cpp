@@ -0,0 +1,40 @@
+#include "Public/GPUTimer.h"
+
+GPUTimer::GPUTimer()
+{
+    glGenQueries(FrameRingBuffer::FRAMES, m_Queries);
+}
+
+GPUTimer::~GPUTimer()
+{
+    glDeleteQueries(FrameRingBuffer::FRAMES, m_Queries);
+}
+
+void GPUTimer::Begin()
+{
+    const uint32_t index = FrameRingBuffer::GetInstance().GetFrameNumber() % FrameRingBuffer::FRAMES;
+    if (m_IsIssued[index])
+    {
+        GLuint isAvailable = GL_FALSE;
+        glGetQueryObjectuiv(m_Queries[index], GL_QUERY_RESULT_AVAILABLE, &isAvailable);
+        if (isAvailable)
+        {
+            GLuint64 nanoseconds = 0;
+            glGetQueryObjectui64v(m_Queries[index], GL_QUERY_RESULT, &nanoseconds);
+            m_Ms = nanoseconds / 1000000.0;
+        }
+    }
+
+    glBeginQuery(GL_TIME_ELAPSED, m_Queries[index]);
+    m_IsIssued[index] = true;
+}
+
+void GPUTimer::End()
+{
+    glEndQuery(GL_TIME_ELAPSED);
+}
+
+double GPUTimer::GetMs() const
+{
+    return m_Ms;
+}
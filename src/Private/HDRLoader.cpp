@@ -0,0 +1,402 @@
+#include "Public/HDRLoader.h"
+
+#include <stb_image.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <thread>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define HDR_USE_SSE2
+#include <emmintrin.h>
+#if defined(__F16C__) || defined(__AVX2__)
+#define HDR_USE_F16C
+#include <immintrin.h>
+#endif
+#endif
+
+namespace
+{
+    // Rows decoded by one job, smaller blocks are not worth a thread
+    const int MIN_ROWS_PER_JOB = 16;
+
+    // RGBE exponent to the float scale applied on the 8 bit mantissas, 2^(e - 136).
+    // Exponents below 10 give values far under the smallest half float so they flush to zero.
+    inline float ExponentScale(uint8_t Exponent)
+    {
+        if (Exponent < 10)
+        {
+            return 0.0f;
+        }
+        uint32_t bits = uint32_t(Exponent - 9) << 23;
+        float scale;
+        std::memcpy(&scale, &bits, sizeof(float));
+        return scale;
+    }
+
+    // Non-negative float to half, round to nearest even, clamped to the largest finite half
+    inline uint16_t FloatToHalf(float Value)
+    {
+        Value = std::min(Value, 65504.0f);
+        uint32_t bits;
+        std::memcpy(&bits, &Value, sizeof(float));
+        if (bits < (113U << 23)) // below 2^-14, subnormal half
+        {
+            return uint16_t(std::lrint(Value * 16777216.0f));
+        }
+        uint32_t lsb = (bits >> 13) & 1U;
+        return uint16_t((bits - (112U << 23) + 0xFFFU + lsb) >> 13);
+    }
+
+#ifdef HDR_USE_SSE2
+    inline __m128i FloatToHalf4(__m128 Value)
+    {
+        Value = _mm_min_ps(Value, _mm_set1_ps(65504.0f));
+#ifdef HDR_USE_F16C
+        return _mm_cvtepu16_epi32(_mm_cvtps_ph(Value, _MM_FROUND_TO_NEAREST_INT));
+#else
+        const __m128i bits = _mm_castps_si128(Value);
+
+        const __m128i lsb = _mm_and_si128(_mm_srli_epi32(bits, 13), _mm_set1_epi32(1));
+        __m128i normal = _mm_add_epi32(bits, _mm_set1_epi32(0xFFF - (112 << 23)));
+        normal = _mm_srli_epi32(_mm_add_epi32(normal, lsb), 13);
+
+        const __m128i subnormal = _mm_cvtps_epi32(_mm_mul_ps(Value, _mm_set1_ps(16777216.0f)));
+
+        const __m128i isNormal = _mm_cmpgt_epi32(bits, _mm_set1_epi32((113 << 23) - 1));
+        return _mm_or_si128(_mm_and_si128(isNormal, normal), _mm_andnot_si128(isNormal, subnormal));
+#endif
+    }
+
+    // 4 mantissas times their scale, converted to halves
+    inline __m128i ChannelToHalf4(__m128i Mantissa, __m128 Scale)
+    {
+        return FloatToHalf4(_mm_mul_ps(_mm_cvtepi32_ps(Mantissa), Scale));
+    }
+#endif
+
+    bool ReadLine(const unsigned char* Data, size_t Size, size_t& Offset, std::string& Line)
+    {
+        Line.clear();
+        while (Offset < Size && Data[Offset] != '\n')
+        {
+            Line.push_back(char(Data[Offset++]));
+        }
+        if (Offset >= Size)
+        {
+            return false;
+        }
+        ++Offset;
+        return true;
+    }
+}
+
+bool HDRLoader::Load(const std::string& Path, HDRImage& Image)
+{
+    std::ifstream file(Path, std::ios::binary | std::ios::ate);
+    if (!file)
+    {
+        fprintf(stderr, "Failed to open HDR file %s\n", Path.c_str());
+        return false;
+    }
+
+    const std::streamsize size = file.tellg();
+    std::vector<unsigned char> data(size_t(std::max<std::streamsize>(size, 0)));
+    file.seekg(0, std::ios::beg);
+    if (!file.read(reinterpret_cast<char*>(data.data()), size))
+    {
+        fprintf(stderr, "Failed to read HDR file %s\n", Path.c_str());
+        return false;
+    }
+
+    if (!Decode(data.data(), data.size(), Image))
+    {
+        fprintf(stderr, "Failed to decode HDR file %s\n", Path.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool HDRLoader::Decode(const unsigned char* Data, size_t Size, HDRImage& Image)
+{
+    size_t offset = 0;
+    int width, height;
+    if (!ParseHeader(Data, Size, offset, width, height))
+    {
+        return false;
+    }
+
+    std::vector<size_t> rowOffsets;
+    bool isRunLength;
+    if (!FindScanlines(Data, Size, offset, width, height, rowOffsets, isRunLength))
+    {
+        return false;
+    }
+
+    Image.Width = width;
+    Image.Height = height;
+    Image.Pixels.resize(size_t(width) * size_t(height) * 3);
+
+    // Scanline boundaries are known, so blocks of rows decode independently
+    const int maxJobs = std::max(1, height / MIN_ROWS_PER_JOB);
+    const int jobs = std::clamp(int(std::thread::hardware_concurrency()), 1, maxJobs);
+    const int rowsPerJob = (height + jobs - 1) / jobs;
+
+    std::vector<std::thread> workers;
+    workers.reserve(jobs - 1);
+    for (int job = 1; job < jobs; ++job)
+    {
+        const int firstRow = job * rowsPerJob;
+        const int lastRow = std::min(height, firstRow + rowsPerJob);
+        workers.emplace_back(DecodeRows, Data, std::cref(rowOffsets), isRunLength, width, height, firstRow, lastRow, Image.Pixels.data());
+    }
+    DecodeRows(Data, rowOffsets, isRunLength, width, height, 0, std::min(height, rowsPerJob), Image.Pixels.data());
+
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+    return true;
+}
+
+HDRBenchmarkResult HDRLoader::Benchmark(const std::string& Path, int Iterations)
+{
+    using Clock = std::chrono::high_resolution_clock;
+
+    HDRBenchmarkResult result;
+    result.Iterations = std::max(Iterations, 1);
+
+    for (int i = 0; i < result.Iterations; ++i)
+    {
+        int width, height, channels;
+        Clock::time_point start = Clock::now();
+        float* data = stbi_loadf(Path.c_str(), &width, &height, &channels, 0);
+        result.StbMs += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        stbi_image_free(data);
+
+        HDRImage image;
+        start = Clock::now();
+        Load(Path, image);
+        result.DecoderMs += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    result.StbMs /= result.Iterations;
+    result.DecoderMs /= result.Iterations;
+    return result;
+}
+
+bool HDRLoader::ParseHeader(const unsigned char* Data, size_t Size, size_t& Offset, int& Width, int& Height)
+{
+    std::string line;
+    if (!ReadLine(Data, Size, Offset, line) || (line != "#?RADIANCE" && line != "#?RGBE"))
+    {
+        fprintf(stderr, "HDR: missing Radiance signature\n");
+        return false;
+    }
+
+    bool isValidFormat = false;
+    while (ReadLine(Data, Size, Offset, line) && !line.empty())
+    {
+        if (line == "FORMAT=32-bit_rle_rgbe")
+        {
+            isValidFormat = true;
+        }
+    }
+    if (!isValidFormat)
+    {
+        fprintf(stderr, "HDR: unsupported pixel format\n");
+        return false;
+    }
+
+    // Only the standard top-down, left-to-right orientation is supported (same as stb_image)
+    if (!ReadLine(Data, Size, Offset, line) || sscanf(line.c_str(), "-Y %d +X %d", &Height, &Width) != 2)
+    {
+        fprintf(stderr, "HDR: unsupported image orientation\n");
+        return false;
+    }
+    if (Width <= 0 || Height <= 0 || Width > (1 << 24) || Height > (1 << 24))
+    {
+        fprintf(stderr, "HDR: invalid image size %dx%d\n", Width, Height);
+        return false;
+    }
+    return true;
+}
+
+bool HDRLoader::FindScanlines(const unsigned char* Data, size_t Size, size_t Offset, int Width, int Height, std::vector<size_t>& RowOffsets, bool& IsRunLength)
+{
+    RowOffsets.resize(Height);
+
+    IsRunLength = Width >= 8 && Width < 32768 && Offset + 4 <= Size
+               && Data[Offset] == 2 && Data[Offset + 1] == 2 && !(Data[Offset + 2] & 0x80);
+
+    if (!IsRunLength)
+    {
+        const size_t rowSize = size_t(Width) * 4;
+        if (Size - Offset < rowSize * Height)
+        {
+            fprintf(stderr, "HDR: truncated pixel data\n");
+            return false;
+        }
+        for (int y = 0; y < Height; ++y)
+        {
+            RowOffsets[y] = Offset + rowSize * y;
+        }
+        return true;
+    }
+
+    // Walk run headers only, runs and literals are skipped without being decoded
+    for (int y = 0; y < Height; ++y)
+    {
+        RowOffsets[y] = Offset;
+        if (Offset + 4 > Size || Data[Offset] != 2 || Data[Offset + 1] != 2
+            || ((Data[Offset + 2] << 8) | Data[Offset + 3]) != Width)
+        {
+            fprintf(stderr, "HDR: invalid scanline header in row %d\n", y);
+            return false;
+        }
+        Offset += 4;
+
+        for (int channel = 0; channel < 4; ++channel)
+        {
+            int x = 0;
+            while (x < Width)
+            {
+                if (Offset >= Size)
+                {
+                    fprintf(stderr, "HDR: truncated scanline in row %d\n", y);
+                    return false;
+                }
+                int count = Data[Offset++];
+                size_t skip = count;
+                if (count > 128)
+                {
+                    count -= 128;
+                    skip = 1;
+                }
+                if (count == 0 || x + count > Width)
+                {
+                    fprintf(stderr, "HDR: bad RLE data in row %d\n", y);
+                    return false;
+                }
+                Offset += skip;
+                x += count;
+            }
+        }
+        if (Offset > Size)
+        {
+            fprintf(stderr, "HDR: truncated scanline in row %d\n", y);
+            return false;
+        }
+    }
+    return true;
+}
+
+void HDRLoader::DecodeRows(const unsigned char* Data, const std::vector<size_t>& RowOffsets, bool IsRunLength, int Width, int Height, int FirstRow, int LastRow, uint16_t* Output)
+{
+    // Planar R, G, B, E scratch for one scanline
+    std::vector<uint8_t> scanline(size_t(Width) * 4);
+    uint8_t* channels[4] = { &scanline[0], &scanline[Width], &scanline[2 * Width], &scanline[3 * Width] };
+
+    for (int y = FirstRow; y < LastRow; ++y)
+    {
+        const unsigned char* src = Data + RowOffsets[y];
+        if (IsRunLength)
+        {
+            src += 4;
+            for (int channel = 0; channel < 4; ++channel)
+            {
+                uint8_t* dst = channels[channel];
+                int x = 0;
+                while (x < Width)
+                {
+                    int count = *src++;
+                    if (count > 128)
+                    {
+                        count -= 128;
+                        std::memset(dst + x, *src++, count);
+                    }
+                    else
+                    {
+                        std::memcpy(dst + x, src, count);
+                        src += count;
+                    }
+                    x += count;
+                }
+            }
+        }
+        else
+        {
+            for (int x = 0; x < Width; ++x)
+            {
+                channels[0][x] = src[x * 4];
+                channels[1][x] = src[x * 4 + 1];
+                channels[2][x] = src[x * 4 + 2];
+                channels[3][x] = src[x * 4 + 3];
+            }
+        }
+
+        // File rows go top-down, OpenGL expects bottom-up
+        uint16_t* dstRow = Output + size_t(Height - 1 - y) * size_t(Width) * 3;
+        ConvertRow(channels[0], channels[1], channels[2], channels[3], Width, dstRow);
+    }
+}
+
+void HDRLoader::ConvertRow(const uint8_t* R, const uint8_t* G, const uint8_t* B, const uint8_t* E, int Width, uint16_t* Output)
+{
+    int x = 0;
+#ifdef HDR_USE_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i exponentBias = _mm_set1_epi32(9);
+    alignas(16) uint16_t red[8], green[8], blue[8];
+
+    for (; x + 8 <= Width; x += 8)
+    {
+        const __m128i r16 = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(R + x)), zero);
+        const __m128i g16 = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(G + x)), zero);
+        const __m128i b16 = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(B + x)), zero);
+        const __m128i e16 = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(E + x)), zero);
+
+        for (int half = 0; half < 2; ++half)
+        {
+            const __m128i r32 = half ? _mm_unpackhi_epi16(r16, zero) : _mm_unpacklo_epi16(r16, zero);
+            const __m128i g32 = half ? _mm_unpackhi_epi16(g16, zero) : _mm_unpacklo_epi16(g16, zero);
+            const __m128i b32 = half ? _mm_unpackhi_epi16(b16, zero) : _mm_unpacklo_epi16(b16, zero);
+            const __m128i e32 = half ? _mm_unpackhi_epi16(e16, zero) : _mm_unpacklo_epi16(e16, zero);
+
+            // Build 2^(e - 136) directly in the float exponent bits, zero for e < 10
+            const __m128i isRepresentable = _mm_cmpgt_epi32(e32, exponentBias);
+            const __m128i scaleBits = _mm_slli_epi32(_mm_sub_epi32(e32, exponentBias), 23);
+            const __m128 scale = _mm_castsi128_ps(_mm_and_si128(scaleBits, isRepresentable));
+
+            const __m128i r = ChannelToHalf4(r32, scale);
+            const __m128i g = ChannelToHalf4(g32, scale);
+            const __m128i b = ChannelToHalf4(b32, scale);
+
+            // Halves are at most 0x7BFF so signed saturation never triggers
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(red + half * 4), _mm_packs_epi32(r, r));
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(green + half * 4), _mm_packs_epi32(g, g));
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(blue + half * 4), _mm_packs_epi32(b, b));
+        }
+
+        uint16_t* dst = Output + size_t(x) * 3;
+        for (int i = 0; i < 8; ++i)
+        {
+            dst[i * 3] = red[i];
+            dst[i * 3 + 1] = green[i];
+            dst[i * 3 + 2] = blue[i];
+        }
+    }
+#endif
+
+    for (; x < Width; ++x)
+    {
+        const float scale = ExponentScale(E[x]);
+        Output[x * 3] = FloatToHalf(R[x] * scale);
+        Output[x * 3 + 1] = FloatToHalf(G[x] * scale);
+        Output[x * 3 + 2] = FloatToHalf(B[x] * scale);
+    }
+}
@@ -0,0 +1,187 @@
+#include "Public/InstanceCulling.h"
+#include "Public/JobPool.h"
+
+#include <algorithm>
+#include <glm/gtc/quaternion.hpp>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CULLING_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+    // Instances tested together, one per SSE2 lane
+    const uint32_t LANES = 4U;
+
+    uint32_t GetStride(InstanceFormat Format)
+    {
+        return InstanceBuilder::GetStride(Format) / sizeof(glm::vec4);
+    }
+
+    // World space sphere of one instance, like InstanceCulling.comp
+    void PlaceSphere(const glm::vec4* Instance, InstanceFormat Format, const glm::mat4& Model, const glm::vec4& Bounds, glm::vec3& Center, float& Radius)
+    {
+        const glm::mat4 world = Model * InstanceCulling::DecodeInstance(Instance, Format);
+        Center = glm::vec3(world * glm::vec4(glm::vec3(Bounds), 1.0f));
+        const float scale = std::max({ glm::length(glm::vec3(world[0])), glm::length(glm::vec3(world[1])), glm::length(glm::vec3(world[2])) });
+        Radius = Bounds.w * scale;
+    }
+
+    // Bit i is set when sphere i is visible, lanes past Count stay clear
+    uint32_t TestSpheres(const float* X, const float* Y, const float* Z, const float* Radius, uint32_t Count, const Frustum& View)
+    {
+#ifdef CULLING_USE_SSE2
+        const __m128 x = _mm_loadu_ps(X);
+        const __m128 y = _mm_loadu_ps(Y);
+        const __m128 z = _mm_loadu_ps(Z);
+        const __m128 negativeRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(Radius));
+        __m128 isVisible = _mm_cmpeq_ps(x, x);
+        for (const glm::vec4& plane : View.Planes)
+        {
+            // Summed in the order of glm::dot plus w, the scalar path gives the same answers
+            __m128 distance = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.x), x), _mm_mul_ps(_mm_set1_ps(plane.y), y));
+            distance = _mm_add_ps(_mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(plane.z), z)), _mm_set1_ps(plane.w));
+            isVisible = _mm_and_ps(isVisible, _mm_cmpge_ps(distance, negativeRadius));
+        }
+        return uint32_t(_mm_movemask_ps(isVisible)) & ((1U << Count) - 1U);
+#else
+        uint32_t mask = 0U;
+        for (uint32_t i = 0; i < Count; ++i)
+        {
+            mask |= View.IsSphereVisible(glm::vec3(X[i], Y[i], Z[i]), Radius[i]) ? 1U << i : 0U;
+        }
+        return mask;
+#endif
+    }
+}
+
+uint32_t InstanceCulling::Cull(const glm::vec4* Instances, uint32_t Count, InstanceFormat Format, const glm::mat4& Model, const Frustum& View,
+    const glm::vec4& Bounds, std::vector<glm::vec4>& Visible)
+{
+    const uint32_t stride = GetStride(Format);
+    uint32_t visibleCount = 0;
+    for (uint32_t first = 0; first < Count; first += LANES)
+    {
+        const uint32_t lanes = std::min(LANES, Count - first);
+        // Unused lanes hold zeros and are masked out
+        float x[LANES] = {};
+        float y[LANES] = {};
+        float z[LANES] = {};
+        float radius[LANES] = {};
+        for (uint32_t lane = 0; lane < lanes; ++lane)
+        {
+            glm::vec3 center;
+            PlaceSphere(Instances + size_t(first + lane) * stride, Format, Model, Bounds, center, radius[lane]);
+            x[lane] = center.x;
+            y[lane] = center.y;
+            z[lane] = center.z;
+        }
+
+        const uint32_t mask = TestSpheres(x, y, z, radius, lanes, View);
+        for (uint32_t lane = 0; lane < lanes; ++lane)
+        {
+            if (mask & (1U << lane))
+            {
+                const glm::vec4* instance = Instances + size_t(first + lane) * stride;
+                Visible.insert(Visible.end(), instance, instance + stride);
+                ++visibleCount;
+            }
+        }
+    }
+    return visibleCount;
+}
+
+uint32_t InstanceCulling::CullParallel(const std::vector<glm::vec4>& Instances, InstanceFormat Format, const glm::mat4& Model, const Frustum& View,
+    const glm::vec4& Bounds, std::vector<glm::vec4>& Visible)
+{
+    const uint32_t count = Instances.size() / GetStride(Format);
+    if (count == 0)
+    {
+        return 0;
+    }
+
+    std::vector<std::vector<glm::vec4>> batches((count + BATCH_SIZE - 1) / BATCH_SIZE);
+    JobPool::GetInstance().ParallelFor(count, BATCH_SIZE,
+        [&](uint32_t Begin, uint32_t End)
+        {
+            Cull(Instances.data() + size_t(Begin) * GetStride(Format), End - Begin, Format, Model, View, Bounds, batches[Begin / BATCH_SIZE]);
+        }
+    );
+
+    const size_t start = Visible.size();
+    size_t size = start;
+    for (const std::vector<glm::vec4>& batch : batches)
+    {
+        size += batch.size();
+    }
+    Visible.reserve(size);
+    for (const std::vector<glm::vec4>& batch : batches)
+    {
+        Visible.insert(Visible.end(), batch.begin(), batch.end());
+    }
+    return (size - start) / GetStride(Format);
+}
+
+glm::mat4 InstanceCulling::DecodeInstance(const glm::vec4* Instance, InstanceFormat Format)
+{
+    switch (Format)
+    {
+    case InstanceFormat::AFFINE:
+        // Rows of the matrix
+        return glm::transpose(glm::mat4(Instance[0], Instance[1], Instance[2], glm::vec4(0.0f, 0.0f, 0.0f, 1.0f)));
+    case InstanceFormat::QUAT_SCALE:
+    {
+        const glm::vec4& q = Instance[1];
+        glm::mat4 transform = glm::mat4_cast(glm::quat(q.w, q.x, q.y, q.z)) * Instance[0].w;
+        transform[3] = glm::vec4(glm::vec3(Instance[0]), 1.0f);
+        return transform;
+    }
+    default:
+        return glm::mat4(Instance[0], Instance[1], Instance[2], Instance[3]);
+    }
+}
+
+uint32_t InstanceCulling::CountMismatches(const std::vector<glm::vec4>& First, const std::vector<glm::vec4>& Second, InstanceFormat Format)
+{
+    const uint32_t stride = GetStride(Format);
+    // Both lists sorted by their raw values, then walked together
+    auto sortRecords = [stride](const std::vector<glm::vec4>& Data)
+    {
+        std::vector<const float*> records(Data.size() / stride);
+        for (size_t i = 0; i < records.size(); ++i)
+        {
+            records[i] = &Data[i * stride].x;
+        }
+        std::sort(records.begin(), records.end(), [stride](const float* Left, const float* Right)
+        {
+            return std::lexicographical_compare(Left, Left + stride * 4, Right, Right + stride * 4);
+        });
+        return records;
+    };
+    const std::vector<const float*> first = sortRecords(First);
+    const std::vector<const float*> second = sortRecords(Second);
+
+    uint32_t mismatches = 0;
+    size_t i = 0;
+    size_t j = 0;
+    while (i < first.size() && j < second.size())
+    {
+        if (std::lexicographical_compare(first[i], first[i] + stride * 4, second[j], second[j] + stride * 4))
+        {
+            ++mismatches;
+            ++i;
+        }
+        else if (std::lexicographical_compare(second[j], second[j] + stride * 4, first[i], first[i] + stride * 4))
+        {
+            ++mismatches;
+            ++j;
+        }
+        else
+        {
+            ++i;
+            ++j;
+        }
+    }
+    return mismatches + (first.size() - i) + (second.size() - j);
+}
@@ -1,45 +1,430 @@
 #include "Public/InstancedModel.h"
+#include "Public/FrameRingBuffer.h"
+#include "Public/Frustum.h"
+#include "Public/GPUResourceTracker.h"
+#include "Public/GLState.h"
+#include "Public/InstanceCulling.h"
+#include "Public/JobPool.h"
 
-InstancedModel::InstancedModel(const char* Path, std::vector<glm::mat4> Transforms)
-	: Model(Path)
-    , m_ElementsCount(Transforms.size())
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cstdio>
+
+namespace
 {
-    glGenBuffers(1, &m_InstanceVBO);
-    glBindBuffer(GL_ARRAY_BUFFER, m_InstanceVBO);
+    // local_size_x of InstanceCulling.comp
+    const uint32_t CULLING_GROUP_SIZE = 64;
+    // Guaranteed work group count along x
+    const uint32_t MAX_CULLING_GROUPS = 65535;
 
-    glBufferData(GL_ARRAY_BUFFER, m_ElementsCount * sizeof(glm::mat4), &Transforms[0], GL_STATIC_DRAW);
-    for (Mesh& mesh : m_Meshes)
+    const char* const PLANE_UNIFORMS[6] = { "planes[0]", "planes[1]", "planes[2]", "planes[3]", "planes[4]", "planes[5]" };
+
+    // Layout glDrawElementsIndirect reads
+    struct DrawElementsCommand
+    {
+        uint32_t Count;
+        uint32_t InstanceCount;
+        uint32_t FirstIndex;
+        int32_t BaseVertex;
+        uint32_t BaseInstance;
+    };
+}
+
+InstanceBuilder::InstanceBuilder(InstanceFormat Format, uint32_t Reserve)
+    : m_Format(Format)
+    , m_Count(0U)
+{
+    m_Data.reserve(size_t(Reserve) * (GetStride(Format) / sizeof(glm::vec4)));
+}
+
+void InstanceBuilder::Add(const glm::mat4& Transform)
+{
+    switch (m_Format)
+    {
+    case InstanceFormat::MATRIX:
+        m_Data.insert(m_Data.end(), { Transform[0], Transform[1], Transform[2], Transform[3] });
+        ++m_Count;
+        break;
+    case InstanceFormat::AFFINE:
+        // The bottom row of an affine transform is always (0, 0, 0, 1)
+        for (int row = 0; row < 3; ++row)
+        {
+            m_Data.push_back(glm::vec4(Transform[0][row], Transform[1][row], Transform[2][row], Transform[3][row]));
+        }
+        ++m_Count;
+        break;
+    case InstanceFormat::QUAT_SCALE:
+    {
+        const float scale = glm::length(glm::vec3(Transform[0]));
+        const float inverseScale = scale > 0.0f ? 1.0f / scale : 0.0f;
+        const glm::mat3 rotation(glm::vec3(Transform[0]) * inverseScale, glm::vec3(Transform[1]) * inverseScale, glm::vec3(Transform[2]) * inverseScale);
+        Add(glm::vec3(Transform[3]), glm::quat_cast(rotation), scale);
+        break;
+    }
+    }
+}
+
+void InstanceBuilder::Add(const glm::vec3& Position, const glm::quat& Rotation, float Scale)
+{
+    if (m_Format != InstanceFormat::QUAT_SCALE)
+    {
+        glm::mat4 transform = glm::mat4_cast(Rotation) * Scale;
+        transform[3] = glm::vec4(Position, 1.0f);
+        Add(transform);
+        return;
+    }
+    m_Data.push_back(glm::vec4(Position, Scale));
+    m_Data.push_back(glm::vec4(Rotation.x, Rotation.y, Rotation.z, Rotation.w));
+    ++m_Count;
+}
+
+InstanceFormat InstanceBuilder::GetFormat() const
+{
+    return m_Format;
+}
+
+uint32_t InstanceBuilder::GetCount() const
+{
+    return m_Count;
+}
+
+const glm::vec4* InstanceBuilder::GetData() const
+{
+    return m_Data.data();
+}
+
+size_t InstanceBuilder::GetSize() const
+{
+    return m_Data.size() * sizeof(glm::vec4);
+}
+
+void InstanceBuilder::Release()
+{
+    // clear() keeps the capacity
+    std::vector<glm::vec4>().swap(m_Data);
+    m_Count = 0U;
+}
+
+uint32_t InstanceBuilder::GetStride(InstanceFormat Format)
+{
+    switch (Format)
+    {
+    case InstanceFormat::AFFINE:
+        return 3U * sizeof(glm::vec4);
+    case InstanceFormat::QUAT_SCALE:
+        return 2U * sizeof(glm::vec4);
+    default:
+        return sizeof(glm::mat4);
+    }
+}
+
+const char* InstanceBuilder::GetFormatName(InstanceFormat Format)
+{
+    switch (Format)
     {
-        glBindVertexArray(mesh.GetVAO());
-        // Atrybuty wierzchokw
-        glEnableVertexAttribArray(3);
-        glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)0);
-        glEnableVertexAttribArray(4);
-        glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(sizeof(glm::vec4)));
-        glEnableVertexAttribArray(5);
-        glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(2 * sizeof(glm::vec4)));
-        glEnableVertexAttribArray(6);
-        glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(3 * sizeof(glm::vec4)));
+    case InstanceFormat::AFFINE:
+        return "3x4 matrix";
+    case InstanceFormat::QUAT_SCALE:
+        return "quaternion + scale";
+    default:
+        return "4x4 matrix";
+    }
+}
+
+InstancedModel::InstancedModel(const char* Path, InstanceBuilder&& Instances)
+	: Model(Path)
+    , m_ElementsCount(0)
+    , m_Format(Instances.GetFormat())
+{
+    GPUResourceTracker& tracker = GPUResourceTracker::GetInstance();
+    tracker.GenBuffers(1, &m_InstanceVBO, GPUResourceOwner::MESH);
+    tracker.GenBuffers(1, &m_VisibleVBO, GPUResourceOwner::MESH);
+    tracker.GenBuffers(1, &m_CommandBuffer, GPUResourceOwner::MESH);
 
-        glVertexAttribDivisor(3, 1);
-        glVertexAttribDivisor(4, 1);
-        glVertexAttribDivisor(5, 1);
-        glVertexAttribDivisor(6, 1);
+    GLState::BindBuffer(GL_DRAW_INDIRECT_BUFFER, m_CommandBuffer);
+    const GLsizeiptr commandsSize = m_Meshes.size() * sizeof(DrawElementsCommand);
+    glBufferData(GL_DRAW_INDIRECT_BUFFER, commandsSize, nullptr, GL_DYNAMIC_DRAW);
+    tracker.SetBufferSize(m_CommandBuffer, commandsSize);
+    GLState::BindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
 
-        glBindVertexArray(0);
+    // Sphere around the center of the box holding every vertex
+    glm::vec3 min(FLT_MAX);
+    glm::vec3 max(-FLT_MAX);
+    for (const Mesh& mesh : m_Meshes)
+    {
+        for (const Vertex& vertex : mesh.Vertexes)
+        {
+            min = glm::min(min, vertex.Position);
+            max = glm::max(max, vertex.Position);
+        }
+    }
+    if (min.x <= max.x)
+    {
+        const glm::vec3 center = (min + max) * 0.5f;
+        float radius = 0.0f;
+        for (const Mesh& mesh : m_Meshes)
+        {
+            for (const Vertex& vertex : mesh.Vertexes)
+            {
+                radius = std::max(radius, glm::length(vertex.Position - center));
+            }
+        }
+        m_Bounds = glm::vec4(center, radius);
     }
 
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    Upload(std::move(Instances));
 }
 
-InstancedModel::~InstancedModel() = default;
+InstancedModel::~InstancedModel()
+{
+    GPUResourceTracker& tracker = GPUResourceTracker::GetInstance();
+    tracker.DeleteBuffers(1, &m_InstanceVBO);
+    tracker.DeleteBuffers(1, &m_VisibleVBO);
+    tracker.DeleteBuffers(1, &m_CommandBuffer);
+    m_InstanceVBO = 0;
+}
 
 void InstancedModel::Draw(Shader& Shader)
 {
     Shader.Use();
+    Shader.setInt("instanceFormat", int(m_Format));
+
+    if (!m_IsCulling)
+    {
+        for (Mesh& mesh : m_Meshes)
+        {
+            mesh.Draw(Shader, m_ElementsCount);
+        }
+        return;
+    }
+
+    // Without a successful Cull this frame the commands and survivors are stale or were never written
+    if (m_CulledFrame != FrameRingBuffer::GetInstance().GetFrameNumber())
+    {
+        KeepAllInstances();
+    }
+
+    // Instance counts come from the last Cull, nothing is read back
+    GLState::BindBuffer(GL_DRAW_INDIRECT_BUFFER, m_CommandBuffer);
+    for (size_t i = 0; i < m_Meshes.size(); ++i)
+    {
+        m_Meshes[i].BindMaterial(Shader);
+        GLState::BindVertexArray(m_Meshes[i].GetVAO());
+        glDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (void*)(i * sizeof(DrawElementsCommand)));
+    }
+}
+
+void InstancedModel::Upload(InstanceBuilder&& Instances)
+{
+    m_ElementsCount = Instances.GetCount();
+    m_Format = Instances.GetFormat();
+
+    GPUResourceTracker& tracker = GPUResourceTracker::GetInstance();
+    GLState::BindBuffer(GL_ARRAY_BUFFER, m_InstanceVBO);
+    glBufferData(GL_ARRAY_BUFFER, Instances.GetSize(), Instances.GetData(), GL_STATIC_DRAW);
+    tracker.SetBufferSize(m_InstanceVBO, Instances.GetSize());
+
+    // Room for every instance, only allocated while culling
+    const GLsizeiptr visibleSize = m_IsCulling ? Instances.GetSize() : 0;
+    GLState::BindBuffer(GL_ARRAY_BUFFER, m_VisibleVBO);
+    glBufferData(GL_ARRAY_BUFFER, visibleSize, nullptr, GL_DYNAMIC_COPY);
+    tracker.SetBufferSize(m_VisibleVBO, visibleSize);
+    GLState::BindBuffer(GL_ARRAY_BUFFER, 0);
+    Instances.Release();
+
+    BindInstanceAttributes();
+}
+
+InstanceFormat InstancedModel::GetFormat() const
+{
+    return m_Format;
+}
+
+uint32_t InstancedModel::GetCount() const
+{
+    return m_ElementsCount;
+}
+
+size_t InstancedModel::GetMemorySize() const
+{
+    const size_t size = size_t(m_ElementsCount) * InstanceBuilder::GetStride(m_Format);
+    return m_IsCulling ? size * 2 + m_Meshes.size() * sizeof(DrawElementsCommand) : size;
+}
+
+void InstancedModel::SetCulling(bool IsEnabled)
+{
+    if (m_IsCulling == IsEnabled)
+    {
+        return;
+    }
+    m_IsCulling = IsEnabled;
+
+    const GLsizeiptr visibleSize = m_IsCulling ? GLsizeiptr(m_ElementsCount) * InstanceBuilder::GetStride(m_Format) : 0;
+    GLState::BindBuffer(GL_ARRAY_BUFFER, m_VisibleVBO);
+    glBufferData(GL_ARRAY_BUFFER, visibleSize, nullptr, GL_DYNAMIC_COPY);
+    GPUResourceTracker::GetInstance().SetBufferSize(m_VisibleVBO, visibleSize);
+    GLState::BindBuffer(GL_ARRAY_BUFFER, 0);
+
+    BindInstanceAttributes();
+}
+
+bool InstancedModel::IsCulling() const
+{
+    return m_IsCulling;
+}
+
+void InstancedModel::Cull(Shader& CullingShader, const glm::mat4& Model, const Frustum& View)
+{
+    if (!m_IsCulling)
+    {
+        return;
+    }
+    const uint32_t groups = (m_ElementsCount + CULLING_GROUP_SIZE - 1) / CULLING_GROUP_SIZE;
+    if (groups > MAX_CULLING_GROUPS)
+    {
+        fprintf(stderr, "ERROR::INSTANCED_MODEL::%d instances are too many to cull in one dispatch\n", m_ElementsCount);
+        return;
+    }
+
+    // Counts restart at zero, every mesh draws its whole index range
+    std::vector<DrawElementsCommand> commands(m_Meshes.size());
+    for (size_t i = 0; i < m_Meshes.size(); ++i)
+    {
+        commands[i] = { uint32_t(m_Meshes[i].Indexes.size()), 0u, 0u, 0, 0u };
+    }
+    GLState::BindBuffer(GL_DRAW_INDIRECT_BUFFER, m_CommandBuffer);
+    glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, commands.size() * sizeof(DrawElementsCommand), commands.data());
+
+    CullingShader.Use();
+    CullingShader.setInt("instanceCount", m_ElementsCount);
+    CullingShader.setInt("instanceFormat", int(m_Format));
+    CullingShader.setInt("commandCount", int(m_Meshes.size()));
+    CullingShader.setMat4("model", Model);
+    for (int i = 0; i < 6; ++i)
+    {
+        CullingShader.setVec4(PLANE_UNIFORMS[i], View.Planes[i]);
+    }
+    CullingShader.setVec4("bounds", m_Bounds);
+    GLState::BindBufferBase(GL_SHADER_STORAGE_BUFFER, INSTANCES_BINDING, m_InstanceVBO);
+    GLState::BindBufferBase(GL_SHADER_STORAGE_BUFFER, VISIBLE_INSTANCES_BINDING, m_VisibleVBO);
+    GLState::BindBufferBase(GL_SHADER_STORAGE_BUFFER, DRAW_COMMANDS_BINDING, m_CommandBuffer);
+    glDispatchCompute(groups, 1, 1);
+    // Draw reads the counts as indirect parameters and the survivors as vertex attributes
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+    m_CulledFrame = FrameRingBuffer::GetInstance().GetFrameNumber();
+}
+
+InstanceCullingReport InstancedModel::ValidateCulling(Shader& CullingShader, const glm::mat4& Model, const Frustum& View)
+{
+    using Clock = std::chrono::high_resolution_clock;
+
+    InstanceCullingReport report;
+    report.Instances = m_ElementsCount;
+    report.Threads = JobPool::GetInstance().GetWorkerCount() + 1;
+    const bool wasCulling = m_IsCulling;
+    SetCulling(true);
+
+    // The builder's copy is gone, the CPU culls what the GPU holds
+    std::vector<glm::vec4> instances;
+    ReadInstances(m_InstanceVBO, m_ElementsCount, instances);
+
+    std::vector<glm::vec4> cpuVisible;
+    Clock::time_point start = Clock::now();
+    report.CpuVisible = InstanceCulling::Cull(instances.data(), m_ElementsCount, m_Format, Model, View, m_Bounds, cpuVisible);
+    report.CpuMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+    std::vector<glm::vec4> parallelVisible;
+    start = Clock::now();
+    InstanceCulling::CullParallel(instances, m_Format, Model, View, m_Bounds, parallelVisible);
+    report.ParallelMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    if (parallelVisible != cpuVisible)
+    {
+        fprintf(stderr, "ERROR::INSTANCED_MODEL::Parallel CPU culling differs from the serial one\n");
+    }
+
+    GLuint query = 0;
+    glGenQueries(1, &query);
+    glBeginQuery(GL_TIME_ELAPSED, query);
+    Cull(CullingShader, Model, View);
+    glEndQuery(GL_TIME_ELAPSED);
+    GLuint64 nanoseconds = 0;
+    glGetQueryObjectui64v(query, GL_QUERY_RESULT, &nanoseconds);
+    glDeleteQueries(1, &query);
+    report.GpuMs = nanoseconds / 1000000.0;
+
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+    DrawElementsCommand command = {};
+    GLState::BindBuffer(GL_DRAW_INDIRECT_BUFFER, m_CommandBuffer);
+    glGetBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, sizeof(DrawElementsCommand), &command);
+    report.GpuVisible = command.InstanceCount;
+    std::vector<glm::vec4> gpuVisible;
+    ReadInstances(m_VisibleVBO, std::min<uint32_t>(report.GpuVisible, m_ElementsCount), gpuVisible);
+    // Groups reserve their ranges in any order, the sets are compared instead of the buffers
+    report.Mismatches = InstanceCulling::CountMismatches(gpuVisible, cpuVisible, m_Format);
+
+    SetCulling(wasCulling);
+    return report;
+}
+
+const glm::vec4& InstancedModel::GetBounds() const
+{
+    return m_Bounds;
+}
+
+void InstancedModel::KeepAllInstances()
+{
+    const GLsizeiptr size = GLsizeiptr(m_ElementsCount) * InstanceBuilder::GetStride(m_Format);
+    GLState::BindBuffer(GL_COPY_READ_BUFFER, m_InstanceVBO);
+    GLState::BindBuffer(GL_COPY_WRITE_BUFFER, m_VisibleVBO);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, size);
+    GLState::BindBuffer(GL_COPY_READ_BUFFER, 0);
+    GLState::BindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    std::vector<DrawElementsCommand> commands(m_Meshes.size());
+    for (size_t i = 0; i < m_Meshes.size(); ++i)
+    {
+        commands[i] = { uint32_t(m_Meshes[i].Indexes.size()), uint32_t(m_ElementsCount), 0u, 0, 0u };
+    }
+    GLState::BindBuffer(GL_DRAW_INDIRECT_BUFFER, m_CommandBuffer);
+    glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, commands.size() * sizeof(DrawElementsCommand), commands.data());
+}
 
+void InstancedModel::BindInstanceAttributes()
+{
+    const GLsizei stride = InstanceBuilder::GetStride(m_Format);
+    const unsigned int attributes = stride / sizeof(glm::vec4);
+    GLState::BindBuffer(GL_ARRAY_BUFFER, m_IsCulling ? m_VisibleVBO : m_InstanceVBO);
     for (Mesh& mesh : m_Meshes)
     {
-        mesh.Draw(Shader, m_ElementsCount);
+        GLState::BindVertexArray(mesh.GetVAO());
+        // Instance attributes of the mesh vertex array
+        // Formats shorter than a matrix leave the last attributes disabled, Instance.vs does not read them
+        for (unsigned int i = 0; i < MAX_INSTANCE_ATTRIBUTES; ++i)
+        {
+            const unsigned int location = FIRST_INSTANCE_LOCATION + i;
+            if (i < attributes)
+            {
+                glEnableVertexAttribArray(location);
+                glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, stride, (void*)(i * sizeof(glm::vec4)));
+                glVertexAttribDivisor(location, 1);
+            }
+            else
+            {
+                glDisableVertexAttribArray(location);
+            }
+        }
+
+        GLState::BindVertexArray(0);
     }
+
+    GLState::BindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void InstancedModel::ReadInstances(unsigned int Buffer, uint32_t Count, std::vector<glm::vec4>& Instances) const
+{
+    Instances.resize(size_t(Count) * (InstanceBuilder::GetStride(m_Format) / sizeof(glm::vec4)));
+    GLState::BindBuffer(GL_COPY_READ_BUFFER, Buffer);
+    glGetBufferSubData(GL_COPY_READ_BUFFER, 0, Instances.size() * sizeof(glm::vec4), Instances.data());
+    GLState::BindBuffer(GL_COPY_READ_BUFFER, 0);
 }
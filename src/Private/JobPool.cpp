@@ -0,0 +1,110 @@
+#include "Public/JobPool.h"
+
+#include <algorithm>
+
+JobPool& JobPool::GetInstance()
+{
+    // Never destroyed, the workers sleep until the process exits
+    static JobPool* instance = new JobPool();
+    return *instance;
+}
+
+JobPool::JobPool()
+{
+    // The thread waiting on a job works on it as well
+    const uint32_t workers = std::max(int(std::thread::hardware_concurrency()) - 1, 1);
+    m_Workers.reserve(workers);
+    for (uint32_t i = 0; i < workers; ++i)
+    {
+        m_Workers.emplace_back(&JobPool::WorkerLoop, this);
+    }
+}
+
+JobHandle JobPool::Dispatch(uint32_t Count, uint32_t BatchSize, std::function<void(uint32_t Begin, uint32_t End)> Function)
+{
+    JobHandle job = std::make_shared<Job>();
+    job->Function = std::move(Function);
+    job->Count = Count;
+    job->BatchSize = std::max(BatchSize, 1u);
+    job->RemainingBatches = (Count + job->BatchSize - 1) / job->BatchSize;
+
+    if (Count == 0)
+    {
+        job->IsDone = true;
+        return job;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Jobs.push_back(job);
+    }
+    m_WorkAvailable.notify_all();
+    return job;
+}
+
+void JobPool::Wait(const JobHandle& Handle)
+{
+    if (!Handle)
+    {
+        return;
+    }
+
+    while (RunBatch(*Handle))
+    {
+    }
+
+    std::unique_lock<std::mutex> lock(Handle->DoneMutex);
+    Handle->DoneCondition.wait(lock, [&]() { return Handle->IsDone; });
+}
+
+void JobPool::ParallelFor(uint32_t Count, uint32_t BatchSize, std::function<void(uint32_t Begin, uint32_t End)> Function)
+{
+    Wait(Dispatch(Count, BatchSize, std::move(Function)));
+}
+
+uint32_t JobPool::GetWorkerCount() const
+{
+    return m_Workers.size();
+}
+
+void JobPool::WorkerLoop()
+{
+    while (true)
+    {
+        JobHandle job;
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_WorkAvailable.wait(lock, [this]() { return !m_Jobs.empty(); });
+            job = m_Jobs.front();
+        }
+
+        if (!RunBatch(*job))
+        {
+            // Batches still running elsewhere finish without the queue
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            if (!m_Jobs.empty() && m_Jobs.front() == job)
+            {
+                m_Jobs.pop_front();
+            }
+        }
+    }
+}
+
+bool JobPool::RunBatch(Job& Job)
+{
+    const uint32_t begin = Job.Next.fetch_add(Job.BatchSize);
+    if (begin >= Job.Count)
+    {
+        return false;
+    }
+
+    Job.Function(begin, std::min(begin + Job.BatchSize, Job.Count));
+
+    if (Job.RemainingBatches.fetch_sub(1) == 1)
+    {
+        std::lock_guard<std::mutex> lock(Job.DoneMutex);
+        Job.IsDone = true;
+        Job.DoneCondition.notify_all();
+    }
+    return true;
+}
@@ -32,11 +32,55 @@ void Light::SetIsOn(bool IsOn)
 	m_IsOn = IsOn;
 }
 
+bool Light::GetIsOn() const
+{
+	return m_IsOn;
+}
+
+void Light::SetSlot(unsigned int Slot)
+{
+	if (Slot == m_Slot && !m_Prefix.empty())
+	{
+		return;
+	}
+	m_Slot = Slot;
+	m_Prefix = m_ArrayName + '[' + std::to_string(Slot) + ']';
+	// Handles point at the old slot
+	m_UniformsProgram = 0U;
+	m_ProgramUniforms.clear();
+}
+
 unsigned int Light::GetID() const
 {
 	return m_ID;
 }
 
+void Light::ResolveUniforms(Shader& Shader)
+{
+	if (m_UniformsProgram == Shader.ID)
+	{
+		return;
+	}
+	m_UniformsProgram = Shader.ID;
+
+	auto iter = m_ProgramUniforms.find(Shader.ID);
+	if (iter != m_ProgramUniforms.end())
+	{
+		m_Uniforms = iter->second;
+		return;
+	}
+
+	m_Uniforms.Position = Shader.GetUniform<glm::vec3>((m_Prefix + ".position").c_str());
+	m_Uniforms.Direction = Shader.GetUniform<glm::vec3>((m_Prefix + ".direction").c_str());
+	m_Uniforms.Color = Shader.GetUniform<glm::vec3>((m_Prefix + ".color").c_str());
+	m_Uniforms.CutOff = Shader.GetUniform<float>((m_Prefix + ".cutOff").c_str());
+	m_Uniforms.OuterCutOff = Shader.GetUniform<float>((m_Prefix + ".outerCutOff").c_str());
+	m_Uniforms.Constant = Shader.GetUniform<float>((m_Prefix + ".constant").c_str());
+	m_Uniforms.Linear = Shader.GetUniform<float>((m_Prefix + ".linear").c_str());
+	m_Uniforms.Quadratic = Shader.GetUniform<float>((m_Prefix + ".quadratic").c_str());
+	m_ProgramUniforms.emplace(Shader.ID, m_Uniforms);
+}
+
 void Light::PrintVec(glm::vec3 V)
 {
 	fprintf(stdout, "(%f, %f, %f)\n", V.x, V.y, V.z);
@@ -1,4 +1,8 @@
 #include "Public/Line.h"
+#include "Public/GPUResourceTracker.h"
+#include "Public/GLState.h"
+#include <algorithm>
+#include <iterator>
 
 Line::Line(glm::vec3 Start, glm::vec3 End)
 {
@@ -9,29 +13,78 @@ Line::Line(glm::vec3 Start, glm::vec3 End)
 	vertices[4] = End[1];
 	vertices[5] = End[2];
 
-	glGenVertexArrays(1, &m_VAO);
-	glGenBuffers(1, &m_VBO);
+	GPUResourceTracker& tracker = GPUResourceTracker::GetInstance();
+	tracker.GenVertexArrays(1, &m_VAO, GPUResourceOwner::GIZMO);
+	tracker.GenBuffers(1, &m_VBO, GPUResourceOwner::GIZMO);
 	// fill buffer
-	glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
+	GLState::BindBuffer(GL_ARRAY_BUFFER, m_VBO);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+	tracker.SetBufferSize(m_VBO, sizeof(vertices));
 	// link vertex attributes
-	glBindVertexArray(m_VAO);
+	GLState::BindVertexArray(m_VAO);
 	glEnableVertexAttribArray(0);
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glBindVertexArray(0);
+	GLState::BindBuffer(GL_ARRAY_BUFFER, 0);
+	GLState::BindVertexArray(0);
 }
 
 void Line::Draw(Shader& Shader)
 {
     Shader.Use();
-    glBindVertexArray(m_VAO);
+    GLState::BindVertexArray(m_VAO);
     glDrawArrays(GL_LINE_STRIP, 0, 2);
-    glBindVertexArray(0);
+    GLState::BindVertexArray(0);
+}
+
+Line::Line(const Line& Other)
+	: m_VAO(Other.m_VAO)
+	, m_VBO(Other.m_VBO)
+{
+	std::copy(std::begin(Other.vertices), std::end(Other.vertices), vertices);
+	const_cast<Line&>(Other).m_VAO = 0;
+	const_cast<Line&>(Other).m_VBO = 0;
+}
+
+Line::Line(Line&& Other) noexcept
+	: m_VAO(Other.m_VAO)
+	, m_VBO(Other.m_VBO)
+{
+	std::copy(std::begin(Other.vertices), std::end(Other.vertices), vertices);
+	Other.m_VAO = 0;
+	Other.m_VBO = 0;
 }
 
 Line::~Line()
 {
-	//glDeleteBuffers(1, &m_VBO);
-	//glDeleteVertexArrays(1, &m_VAO);
+	if (m_VAO)
+	{
+		GPUResourceTracker::GetInstance().DeleteVertexArrays(1, &m_VAO);
+		GPUResourceTracker::GetInstance().DeleteBuffers(1, &m_VBO);
+		m_VAO = 0;
+		m_VBO = 0;
+	}
+}
+
+Line& Line::operator=(const Line& Other)
+{
+	if (this != &Other)
+	{
+		this->~Line();
+		std::swap(m_VAO, const_cast<Line&>(Other).m_VAO);
+		std::swap(m_VBO, const_cast<Line&>(Other).m_VBO);
+		std::copy(std::begin(Other.vertices), std::end(Other.vertices), vertices);
+	}
+	return *this;
+}
+
+Line& Line::operator=(Line&& Other) noexcept
+{
+	if (this != &Other)
+	{
+		this->~Line();
+		std::swap(m_VAO, Other.m_VAO);
+		std::swap(m_VBO, Other.m_VBO);
+		std::copy(std::begin(Other.vertices), std::end(Other.vertices), vertices);
+	}
+	return *this;
 }
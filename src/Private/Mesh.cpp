@@ -1,6 +1,9 @@
 #include "Public/Mesh.h"
 
 #include "Public/Shader.h"
+#include "Public/GPUResourceTracker.h"
+#include "Public/FrameRingBuffer.h"
+#include "Public/GLState.h"
 #include <iostream>
 #include <algorithm>
 
@@ -35,6 +38,7 @@ Mesh::Mesh(std::vector<Vertex> vertexes, std::vector<unsigned int> indexes, std:
         for (int i = 0; i < Mesh::DefaultTextures.size(); ++i)
         {
             Mesh::DefaultTextures[i].BindTexture(31 - i);
+            GPUResourceTracker::GetInstance().SetPersistent(GPUResourceType::TEXTURE, Mesh::DefaultTextures[i].GetId());
         }
     }
     SetupMesh();
@@ -68,11 +72,11 @@ Mesh::Mesh(Mesh&& Other) noexcept
 
 Mesh::~Mesh()
 {
-    glDeleteBuffers(1, &m_VBO);
+    GPUResourceTracker::GetInstance().DeleteBuffers(1, &m_VBO);
     m_VBO = 0;
-    glDeleteBuffers(1, &m_EBO);
+    GPUResourceTracker::GetInstance().DeleteBuffers(1, &m_EBO);
     m_EBO = 0;
-    glDeleteVertexArrays(1, &m_VAO);
+    GPUResourceTracker::GetInstance().DeleteVertexArrays(1, &m_VAO);
     m_VAO = 0;
     Vertexes.clear();
     Indexes.clear();
@@ -115,17 +119,20 @@ Mesh& Mesh::operator=(Mesh&& Other) noexcept
 
 void Mesh::SetupMesh()
 {
-    glGenVertexArrays(1, &m_VAO);
-    glGenBuffers(1, &m_VBO);
-    glGenBuffers(1, &m_EBO);
+    GPUResourceTracker& tracker = GPUResourceTracker::GetInstance();
+    tracker.GenVertexArrays(1, &m_VAO, GPUResourceOwner::MESH);
+    tracker.GenBuffers(1, &m_VBO, GPUResourceOwner::MESH);
+    tracker.GenBuffers(1, &m_EBO, GPUResourceOwner::MESH);
 
-    glBindVertexArray(m_VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
+    GLState::BindVertexArray(m_VAO);
+    GLState::BindBuffer(GL_ARRAY_BUFFER, m_VBO);
 
     glBufferData(GL_ARRAY_BUFFER, Vertexes.size() * sizeof(Vertex), &Vertexes[0], GL_STATIC_DRAW);
+    tracker.SetBufferSize(m_VBO, Vertexes.size() * sizeof(Vertex));
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
+    GLState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, Indexes.size() * sizeof(unsigned int), &Indexes[0], GL_STATIC_DRAW);
+    tracker.SetBufferSize(m_EBO, Indexes.size() * sizeof(unsigned int));
     
     // Position attribute
     glEnableVertexAttribArray(0);
@@ -137,94 +144,48 @@ void Mesh::SetupMesh()
     glEnableVertexAttribArray(2);
     glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
 
-    glBindVertexArray(0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    GLState::BindVertexArray(0);
+    GLState::BindBuffer(GL_ARRAY_BUFFER, 0);
+    GLState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
 
-void Mesh::ResetTextures(Shader& Shader)
+void Mesh::BindMaterial(Shader& Shader)
 {
-    for (int i = 0; i < Mesh::DefaultTextures.size(); ++i)
+    // Units and sampler values never change, so the sampler uniforms are uploaded once per program
+    const unsigned int slots = (unsigned int)TextureType::TYPESCOUNT - 1;
+    Texture* maps[slots] = {};
+    for (Texture& texture : Textures)
     {
-        Mesh::DefaultTextures[i].BindTexture(31 - i);
+        TextureType type = texture.GetType();
+        if (type != TextureType::NONE && type < TextureType::TYPESCOUNT && !maps[(unsigned int)type - 1])
+        {
+            maps[(unsigned int)type - 1] = &texture;
+        }
+    }
+
+    for (unsigned int slot = 0; slot < slots; ++slot)
+    {
+        Texture& texture = maps[slot] ? *maps[slot] : Mesh::DefaultTextures[slot];
+        texture.BindTexture(slot);
+        Shader.setInt(Texture::GetMaterialUniformName((TextureType)(slot + 1), 0), slot);
     }
-    Shader.setInt("material.albedo[0]"          , 31);
-    Shader.setInt("material.normal[0]"          , 30);
-    Shader.setInt("material.emission[0]"        , 29);
-    Shader.setInt("material.metalness[0]"       , 28);
-    Shader.setInt("material.roughness[0]"       , 27);
-    Shader.setInt("material.ambientocclusion[0]", 26);
 }
 
 void Mesh::Draw(Shader& Shader, unsigned int Amount)
 {
-    ResetTextures(Shader);
-    unsigned int textureNrs[(int)TextureType::TYPESCOUNT];
-    std::fill(textureNrs, textureNrs + (int)TextureType::TYPESCOUNT, 0U);
-    std::string number;
-    TextureType type;
-    std::string name;
-    ResetTextures(Shader);
-    for (unsigned int i = 0; i < Textures.size(); ++i)
-    {
-        Textures[i].BindTexture(i);
-        type = Textures[i].GetType();
-
-        number = std::to_string(textureNrs[(int)type]++);
+    BindMaterial(Shader);
 
-        switch (type)
-        {
-            case TextureType::ALBEDO:
-            {
-                name = "albedo";
-                break;
-            }
-            case TextureType::NORMAL:
-            {
-                name = "normal";
-                break;
-            }
-            case TextureType::EMISSION:
-            {
-                name = "emission";
-                break;
-            }
-            case TextureType::METALNESS:
-            {
-                name = "metalness";
-                break;
-            }
-            case TextureType::ROUGHNESS:
-            {
-                name = "roughness";
-                break;
-            }
-            case TextureType::AMBIENTOCCLUSION:
-            {
-                name = "ambientocclusion";
-                break;
-            }
-            case TextureType::NONE:
-            case TextureType::TYPESCOUNT:
-            default:
-                break;
-        }
-
-        Shader.setInt(("material." + name + '[' + number + ']').c_str(), i);
-    }
-
-    glBindVertexArray(m_VAO);
+    GLState::BindVertexArray(m_VAO);
     if (Amount == 1U)
     {
-        glDrawElements(GL_TRIANGLES, Indexes.size(), GL_UNSIGNED_INT, 0);
+        // Object data of the entity being drawn is read at gl_BaseInstance
+        glDrawElementsInstancedBaseInstance(GL_TRIANGLES, Indexes.size(), GL_UNSIGNED_INT, 0, 1, FrameRingBuffer::GetInstance().GetCurrentObject());
     }
     else
     {
         glDrawElementsInstanced(GL_TRIANGLES, Indexes.size(), GL_UNSIGNED_INT, 0, Amount);
     }
-
-    glBindVertexArray(0);
-    glActiveTexture(GL_TEXTURE0);
+    // The vertex array stays bound, consecutive draws of the same mesh skip the rebind
 }
 
 unsigned int Mesh::GetVAO()
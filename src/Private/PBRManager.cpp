@@ -7,19 +7,25 @@
 #include "Public/CubeMap.h"
 #include "Public/Cube.h"
 #include "Public/Quad.h"
+#include "Public/GPUResourceTracker.h"
+#include "Public/GLState.h"
 
 PBRManager::PBRManager()
 {
     SetMatrixes();
 
-    glGenFramebuffers(1, &m_FBO);
-    glGenRenderbuffers(1, &m_RBO);
+    GPUResourceTracker& tracker = GPUResourceTracker::GetInstance();
+    tracker.GenFramebuffers(1, &m_FBO, GPUResourceOwner::IBL);
+    tracker.GenRenderbuffers(1, &m_RBO, GPUResourceOwner::IBL);
+    // Capture targets live as long as the manager itself
+    tracker.SetPersistent(GPUResourceType::FRAMEBUFFER, m_FBO);
+    tracker.SetPersistent(GPUResourceType::RENDERBUFFER, m_RBO);
 
-    glBindFramebuffer(GL_FRAMEBUFFER, m_FBO);
+    GLState::BindFramebuffer(GL_FRAMEBUFFER, m_FBO);
     glBindRenderbuffer(GL_RENDERBUFFER, m_RBO);
     glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_RBO);
 
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    GLState::BindFramebuffer(GL_FRAMEBUFFER, 0);
     glBindRenderbuffer(GL_RENDERBUFFER, 0);
 }
 
@@ -31,22 +37,23 @@ PBRManager& PBRManager::GetInstance()
 
 PBRManager::~PBRManager()
 {
-    glDeleteFramebuffers(1, &m_FBO);
-    glDeleteRenderbuffers(1, &m_RBO);
+    GPUResourceTracker::GetInstance().DeleteFramebuffers(1, &m_FBO);
+    GPUResourceTracker::GetInstance().DeleteRenderbuffers(1, &m_RBO);
 }
 
 void PBRManager::SetupEquirectangular(Shader& Shader, Texture& HDRMap, CubeMap& EnvironmentMap)
 {
-    glBindFramebuffer(GL_FRAMEBUFFER, m_FBO);
+    GLState::BindFramebuffer(GL_FRAMEBUFFER, m_FBO);
     glBindRenderbuffer(GL_RENDERBUFFER, m_RBO);
     glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, EnvironmentMap.GetWidth(), EnvironmentMap.GetHeight());
+    GPUResourceTracker::GetInstance().SetRenderbufferSize(m_RBO, GL_DEPTH_COMPONENT24, EnvironmentMap.GetWidth(), EnvironmentMap.GetHeight());
 
     Shader.Use();
     HDRMap.BindTexture(0);
     Shader.setInt("equirectangularMap", 0);
     Shader.setMat4("projection", m_Projection);
     
-    glViewport(0, 0, EnvironmentMap.GetWidth(), EnvironmentMap.GetHeight());
+    GLState::Viewport(0, 0, EnvironmentMap.GetWidth(), EnvironmentMap.GetHeight());
     for (unsigned int i = 0; i < 6; ++i)
     {
         Shader.setMat4("view", m_Views[i]);
@@ -57,19 +64,20 @@ void PBRManager::SetupEquirectangular(Shader& Shader, Texture& HDRMap, CubeMap&
     }
 
     // then let OpenGL generate mipmaps from first mip face (combatting visible dots artifact)
-    glBindTexture(GL_TEXTURE_CUBE_MAP, EnvironmentMap.GetId());
+    GLState::BindTexture(GL_TEXTURE_CUBE_MAP, EnvironmentMap.GetId());
     glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
 
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    GLState::BindFramebuffer(GL_FRAMEBUFFER, 0);
     glBindRenderbuffer(GL_RENDERBUFFER, 0);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+    GLState::BindTexture(GL_TEXTURE_CUBE_MAP, 0);
 }
 
 void PBRManager::SetupIrradiance(Shader& Shader, CubeMap& IrradianceMap, CubeMap& EnvironmentMap)
 {
-    glBindFramebuffer(GL_FRAMEBUFFER, m_FBO);
+    GLState::BindFramebuffer(GL_FRAMEBUFFER, m_FBO);
     glBindRenderbuffer(GL_RENDERBUFFER, m_RBO);
     glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, IrradianceMap.GetWidth(), IrradianceMap.GetHeight());
+    GPUResourceTracker::GetInstance().SetRenderbufferSize(m_RBO, GL_DEPTH_COMPONENT24, IrradianceMap.GetWidth(), IrradianceMap.GetHeight());
 
     // pbr: solve diffuse integral by convolution to create an irradiance (cube)map.
     // -----------------------------------------------------------------------------
@@ -78,7 +86,7 @@ void PBRManager::SetupIrradiance(Shader& Shader, CubeMap& IrradianceMap, CubeMap
     Shader.setInt("environmentMap", 0);
     Shader.setMat4("projection", m_Projection);
 
-    glViewport(0, 0, IrradianceMap.GetWidth(), IrradianceMap.GetHeight());
+    GLState::Viewport(0, 0, IrradianceMap.GetWidth(), IrradianceMap.GetHeight());
     for (unsigned int i = 0; i < 6; ++i)
     {
         Shader.setMat4("view", m_Views[i]);
@@ -88,14 +96,14 @@ void PBRManager::SetupIrradiance(Shader& Shader, CubeMap& IrradianceMap, CubeMap
         Cube::GetInstance().Draw(Shader);
     }
 
-    glBindVertexArray(0);
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    GLState::BindVertexArray(0);
+    GLState::BindFramebuffer(GL_FRAMEBUFFER, 0);
     glBindRenderbuffer(GL_RENDERBUFFER, 0);
 }
 
 void PBRManager::SetupPrefilter(Shader& Shader, CubeMap& PrefilterMap, CubeMap& EnvironmentMap, unsigned int MaxMipLevels)
 {
-    glBindTexture(GL_TEXTURE_CUBE_MAP, PrefilterMap.GetId());
+    GLState::BindTexture(GL_TEXTURE_CUBE_MAP, PrefilterMap.GetId());
     glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
 
     // pbr: run a quasi monte-carlo simulation on the environment lighting to create a prefilter (cube)map.
@@ -105,7 +113,7 @@ void PBRManager::SetupPrefilter(Shader& Shader, CubeMap& PrefilterMap, CubeMap&
     Shader.setInt("environmentMap", 0);
     Shader.setMat4("projection", m_Projection);
 
-    glBindFramebuffer(GL_FRAMEBUFFER, m_FBO);
+    GLState::BindFramebuffer(GL_FRAMEBUFFER, m_FBO);
     for (unsigned int mip = 0; mip < MaxMipLevels; ++mip)
     {
         // reisze framebuffer according to mip-level size.
@@ -113,7 +121,8 @@ void PBRManager::SetupPrefilter(Shader& Shader, CubeMap& PrefilterMap, CubeMap&
         unsigned int mipHeight = static_cast<unsigned int>(PrefilterMap.GetHeight() * std::pow(0.5, mip));
         glBindRenderbuffer(GL_RENDERBUFFER, m_RBO);
         glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, mipWidth, mipHeight);
-        glViewport(0, 0, mipWidth, mipHeight);
+        GPUResourceTracker::GetInstance().SetRenderbufferSize(m_RBO, GL_DEPTH_COMPONENT24, mipWidth, mipHeight);
+        GLState::Viewport(0, 0, mipWidth, mipHeight);
 
         float roughness = (float)mip / (float)(MaxMipLevels - 1);
         Shader.setFloat("roughness", roughness);
@@ -127,28 +136,29 @@ void PBRManager::SetupPrefilter(Shader& Shader, CubeMap& PrefilterMap, CubeMap&
             Cube::GetInstance().Draw(Shader);
         }
     }
-    glBindVertexArray(0);
+    GLState::BindVertexArray(0);
     glBindRenderbuffer(GL_RENDERBUFFER, 0);
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+    GLState::BindFramebuffer(GL_FRAMEBUFFER, 0);
+    GLState::BindTexture(GL_TEXTURE_CUBE_MAP, 0);
 }
 
 void PBRManager::SetupBRDF(Shader& Shader, Texture& BRDFMap)
 {   
     // then re-configure capture framebuffer object and render screen-space quad with BRDF shader.
-    glBindFramebuffer(GL_FRAMEBUFFER, m_FBO);
+    GLState::BindFramebuffer(GL_FRAMEBUFFER, m_FBO);
     glBindRenderbuffer(GL_RENDERBUFFER, m_RBO);
     glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, BRDFMap.GetWidth(), BRDFMap.GetHeight());
+    GPUResourceTracker::GetInstance().SetRenderbufferSize(m_RBO, GL_DEPTH_COMPONENT24, BRDFMap.GetWidth(), BRDFMap.GetHeight());
     glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, BRDFMap.GetId(), 0);
 
-    glViewport(0, 0, BRDFMap.GetWidth(), BRDFMap.GetHeight());
+    GLState::Viewport(0, 0, BRDFMap.GetWidth(), BRDFMap.GetHeight());
     Shader.Use();
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     Quad::GetInstance().Draw(Shader);
 
-    glBindVertexArray(0);
+    GLState::BindVertexArray(0);
     glBindRenderbuffer(GL_RENDERBUFFER, 0);
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    GLState::BindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
 void PBRManager::SetMatrixes()
@@ -1,5 +1,7 @@
 #include "Public/ParticleSystem.h"
 #include "Public/Quad.h"
+#include "Public/GPUResourceTracker.h"
+#include "Public/GLState.h"
 
 ParticleSystem::ParticleSystem(Texture& texture, GLuint amount, float maxLifeTime)
     : m_Texture(&texture)
@@ -11,8 +13,8 @@ ParticleSystem::ParticleSystem(Texture& texture, GLuint amount, float maxLifeTim
 
 ParticleSystem::~ParticleSystem()
 {
-    glDeleteBuffers(3, m_SSBO);
-    glDeleteVertexArrays(1, &m_VAO);
+    GPUResourceTracker::GetInstance().DeleteBuffers(3, m_SSBO);
+    GPUResourceTracker::GetInstance().DeleteVertexArrays(1, &m_VAO);
 }
 
 void ParticleSystem::Update(Shader& Shader, GLfloat DeltaTime, Entity& entity)
@@ -28,15 +30,15 @@ void ParticleSystem::Update(Shader& Shader, GLfloat DeltaTime, Entity& entity)
 void ParticleSystem::Draw(Shader& shader)
 {
     shader.Use();
-    glDisable(GL_CULL_FACE);
-    glBindVertexArray(m_VAO);
-    glEnable(GL_PROGRAM_POINT_SIZE);
+    GLState::Disable(GL_CULL_FACE);
+    GLState::BindVertexArray(m_VAO);
+    GLState::Enable(GL_PROGRAM_POINT_SIZE);
 
     glDrawArrays(GL_POINTS, 0, m_Amount);
 
-    glDisable(GL_PROGRAM_POINT_SIZE);
-    glBindVertexArray(0);
-    glEnable(GL_CULL_FACE);
+    GLState::Disable(GL_PROGRAM_POINT_SIZE);
+    GLState::BindVertexArray(0);
+    GLState::Enable(GL_CULL_FACE);
 }
 
 void ParticleSystem::init()
@@ -56,24 +58,28 @@ void ParticleSystem::init()
         m_Lifetimes.push_back(glm::vec2(0.0f, lifeTime));
     }
 
-    glGenBuffers(3, m_SSBO);
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_SSBO[0]);
+    GPUResourceTracker& tracker = GPUResourceTracker::GetInstance();
+    tracker.GenBuffers(3, m_SSBO, GPUResourceOwner::PARTICLES);
+    GLState::BindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_SSBO[0]);
     glBufferData(GL_SHADER_STORAGE_BUFFER, m_Amount * sizeof(glm::vec4), &m_Positions[0], GL_DYNAMIC_DRAW);
+    tracker.SetBufferSize(m_SSBO[0], m_Amount * sizeof(glm::vec4));
 
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, m_SSBO[1]);
+    GLState::BindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, m_SSBO[1]);
     glBufferData(GL_SHADER_STORAGE_BUFFER, m_Amount * sizeof(glm::vec4), &m_Velocities[0], GL_DYNAMIC_DRAW);
+    tracker.SetBufferSize(m_SSBO[1], m_Amount * sizeof(glm::vec4));
 
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, m_SSBO[2]);
+    GLState::BindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, m_SSBO[2]);
     glBufferData(GL_SHADER_STORAGE_BUFFER, m_Amount * sizeof(glm::vec2), &m_Lifetimes[0], GL_DYNAMIC_DRAW);
+    tracker.SetBufferSize(m_SSBO[2], m_Amount * sizeof(glm::vec2));
 
-    glCreateVertexArrays(1, &m_VAO);
+    tracker.CreateVertexArrays(1, &m_VAO, GPUResourceOwner::PARTICLES);
 
     glVertexArrayVertexBuffer(m_VAO, 0, m_SSBO[0], 0, sizeof(glm::vec4));
     glEnableVertexArrayAttrib(m_VAO, 0);
     glVertexArrayAttribFormat(m_VAO, 0, 4, GL_FLOAT, GL_FALSE, 0);
     glVertexArrayAttribBinding(m_VAO, 0, 0);
 
-    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
-    glBindVertexArray(0);
+    GLState::BindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    GLState::BindVertexArray(0);
 
 }
\ No newline at end of file
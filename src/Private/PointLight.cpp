@@ -14,7 +14,8 @@ PointLight::PointLight(glm::vec3 Position, glm::vec3 Color, AttenuationDist Dist
 
 	SetAttenuationParams(Distance);
 	m_ID = m_IDCounter++;
-	m_Prefix = "pointLights[" + std::to_string(m_ID) + ']';
+	m_ArrayName = "pointLights";
+	SetSlot(m_ID);
 }
 
 void PointLight::SetPosition(glm::vec3 Position)
@@ -121,12 +122,12 @@ void PointLight::SetAttenuationParams(AttenuationDist Distance)
 void PointLight::SetupShader(Shader& Shader)
 {
 	Shader.Use();
-	Shader.setBool((m_Prefix + ".isOn").c_str(), m_IsOn);
-	Shader.setVec3((m_Prefix + ".position").c_str(), m_Position);
-	Shader.setVec3((m_Prefix + ".color").c_str(), m_Color * m_Intensity);
-	Shader.setFloat((m_Prefix + ".constant").c_str(), m_Constant);
-	Shader.setFloat((m_Prefix + ".linear").c_str(), m_Linear);
-	Shader.setFloat((m_Prefix + ".quadratic").c_str(), m_Quadratic);
+	ResolveUniforms(Shader);
+	Shader.setVec3(m_Uniforms.Position, m_Position);
+	Shader.setVec3(m_Uniforms.Color, m_Color * m_Intensity);
+	Shader.setFloat(m_Uniforms.Constant, m_Constant);
+	Shader.setFloat(m_Uniforms.Linear, m_Linear);
+	Shader.setFloat(m_Uniforms.Quadratic, m_Quadratic);
 }
 
 void PointLight::Draw(Shader& Shader)
@@ -0,0 +1,689 @@
+#include "Public/Pose.h"
+#include "Public/Animation.h"
+#include "Public/Animator.h"
+#include "Public/Bone.h"
+#include "Public/CompressedClip.h"
+#include "Public/Skeleton.h"
+#include "Public/SkinnedModel.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define POSE_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+	// Keys around the sample time of LANES joints, gathered one joint at a time and interpolated together
+	struct KeyGroup
+	{
+		alignas(16) float From[Pose::STREAM_COUNT][Pose::LANES];
+		alignas(16) float To[Pose::STREAM_COUNT][Pose::LANES];
+		alignas(16) float PositionAlpha[Pose::LANES];
+		alignas(16) float RotationAlpha[Pose::LANES];
+
+		void Set(uint32_t Lane, const glm::vec3& FromPosition, const glm::vec3& ToPosition, float PositionFactor,
+			const glm::quat& FromRotation, const glm::quat& ToRotation, float RotationFactor)
+		{
+			const float from[Pose::STREAM_COUNT] = { FromPosition.x, FromPosition.y, FromPosition.z, FromRotation.x, FromRotation.y, FromRotation.z, FromRotation.w };
+			const float to[Pose::STREAM_COUNT] = { ToPosition.x, ToPosition.y, ToPosition.z, ToRotation.x, ToRotation.y, ToRotation.z, ToRotation.w };
+			for (uint32_t stream = 0; stream < Pose::STREAM_COUNT; ++stream)
+			{
+				From[stream][Lane] = from[stream];
+				To[stream][Lane] = to[stream];
+			}
+			PositionAlpha[Lane] = PositionFactor;
+			RotationAlpha[Lane] = RotationFactor;
+		}
+	};
+
+#ifdef POSE_USE_SSE2
+	inline __m128 Load(const Pose& Source, Pose::Stream Stream, uint32_t First)
+	{
+		return _mm_loadu_ps(Source.GetStream(Stream) + First);
+	}
+
+	inline void Store(Pose& Target, Pose::Stream Stream, uint32_t First, __m128 Value)
+	{
+		_mm_storeu_ps(Target.GetStream(Stream) + First, Value);
+	}
+
+	inline __m128 Mix(__m128 From, __m128 To, __m128 Alpha)
+	{
+		return _mm_add_ps(From, _mm_mul_ps(_mm_sub_ps(To, From), Alpha));
+	}
+
+	inline __m128 Dot4(__m128 AX, __m128 AY, __m128 AZ, __m128 AW, __m128 BX, __m128 BY, __m128 BZ, __m128 BW)
+	{
+		return _mm_add_ps(_mm_add_ps(_mm_mul_ps(AX, BX), _mm_mul_ps(AY, BY)), _mm_add_ps(_mm_mul_ps(AZ, BZ), _mm_mul_ps(AW, BW)));
+	}
+
+	// Sign bit of the lanes where Dot is negative, xor with it to flip a quaternion into the other hemisphere
+	inline __m128 NegativeMask(__m128 Dot)
+	{
+		return _mm_and_ps(_mm_cmplt_ps(Dot, _mm_setzero_ps()), _mm_set1_ps(-0.0f));
+	}
+
+	inline void Normalize4(__m128& X, __m128& Y, __m128& Z, __m128& W)
+	{
+		// Full precision, an estimate drifts visibly once it feeds a hierarchy
+		const __m128 inverse = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(Dot4(X, Y, Z, W, X, Y, Z, W)));
+		X = _mm_mul_ps(X, inverse);
+		Y = _mm_mul_ps(Y, inverse);
+		Z = _mm_mul_ps(Z, inverse);
+		W = _mm_mul_ps(W, inverse);
+	}
+
+	// Hamilton product A * B of four quaternion pairs
+	inline void Multiply4(__m128 AX, __m128 AY, __m128 AZ, __m128 AW, __m128 BX, __m128 BY, __m128 BZ, __m128 BW,
+		__m128& X, __m128& Y, __m128& Z, __m128& W)
+	{
+		X = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(AW, BX), _mm_mul_ps(AX, BW)), _mm_mul_ps(AY, BZ)), _mm_mul_ps(AZ, BY));
+		Y = _mm_add_ps(_mm_add_ps(_mm_sub_ps(_mm_mul_ps(AW, BY), _mm_mul_ps(AX, BZ)), _mm_mul_ps(AY, BW)), _mm_mul_ps(AZ, BX));
+		Z = _mm_add_ps(_mm_sub_ps(_mm_add_ps(_mm_mul_ps(AW, BZ), _mm_mul_ps(AX, BY)), _mm_mul_ps(AY, BX)), _mm_mul_ps(AZ, BW));
+		W = _mm_sub_ps(_mm_sub_ps(_mm_sub_ps(_mm_mul_ps(AW, BW), _mm_mul_ps(AX, BX)), _mm_mul_ps(AY, BY)), _mm_mul_ps(AZ, BZ));
+	}
+
+	inline __m128 Splat(__m128 Value, int Lane)
+	{
+		switch (Lane)
+		{
+			case 0:  return _mm_shuffle_ps(Value, Value, _MM_SHUFFLE(0, 0, 0, 0));
+			case 1:  return _mm_shuffle_ps(Value, Value, _MM_SHUFFLE(1, 1, 1, 1));
+			case 2:  return _mm_shuffle_ps(Value, Value, _MM_SHUFFLE(2, 2, 2, 2));
+			default: return _mm_shuffle_ps(Value, Value, _MM_SHUFFLE(3, 3, 3, 3));
+		}
+	}
+
+	// Columns of A * B for column major matrices given by their columns
+	inline void MultiplyColumns(const __m128* A, const __m128* B, __m128* Out)
+	{
+		for (int column = 0; column < 4; ++column)
+		{
+			Out[column] = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(A[0], Splat(B[column], 0)), _mm_mul_ps(A[1], Splat(B[column], 1))),
+				_mm_add_ps(_mm_mul_ps(A[2], Splat(B[column], 2)), _mm_mul_ps(A[3], Splat(B[column], 3))));
+		}
+	}
+
+	inline void LoadColumns(const glm::mat4& Matrix, __m128* Columns)
+	{
+		for (int column = 0; column < 4; ++column)
+		{
+			Columns[column] = _mm_loadu_ps(&Matrix[column][0]);
+		}
+	}
+
+	inline void StoreColumns(const __m128* Columns, glm::mat4& Matrix)
+	{
+		for (int column = 0; column < 4; ++column)
+		{
+			_mm_storeu_ps(&Matrix[column][0], Columns[column]);
+		}
+	}
+#endif
+
+	inline float Mix(float From, float To, float Alpha)
+	{
+		return From + (To - From) * Alpha;
+	}
+
+	void InterpolateGroup(const KeyGroup& Group, Pose& Out, uint32_t First, bool IsSimd)
+	{
+#ifdef POSE_USE_SSE2
+		if (IsSimd)
+		{
+			const __m128 positionAlpha = _mm_load_ps(Group.PositionAlpha);
+			for (uint32_t stream = Pose::TX; stream <= Pose::TZ; ++stream)
+			{
+				Store(Out, Pose::Stream(stream), First, Mix(_mm_load_ps(Group.From[stream]), _mm_load_ps(Group.To[stream]), positionAlpha));
+			}
+
+			const __m128 fromX = _mm_load_ps(Group.From[Pose::RX]);
+			const __m128 fromY = _mm_load_ps(Group.From[Pose::RY]);
+			const __m128 fromZ = _mm_load_ps(Group.From[Pose::RZ]);
+			const __m128 fromW = _mm_load_ps(Group.From[Pose::RW]);
+			__m128 toX = _mm_load_ps(Group.To[Pose::RX]);
+			__m128 toY = _mm_load_ps(Group.To[Pose::RY]);
+			__m128 toZ = _mm_load_ps(Group.To[Pose::RZ]);
+			__m128 toW = _mm_load_ps(Group.To[Pose::RW]);
+			// Shortest arc, like slerp
+			const __m128 flip = NegativeMask(Dot4(fromX, fromY, fromZ, fromW, toX, toY, toZ, toW));
+			toX = _mm_xor_ps(toX, flip);
+			toY = _mm_xor_ps(toY, flip);
+			toZ = _mm_xor_ps(toZ, flip);
+			toW = _mm_xor_ps(toW, flip);
+
+			const __m128 rotationAlpha = _mm_load_ps(Group.RotationAlpha);
+			__m128 x = Mix(fromX, toX, rotationAlpha);
+			__m128 y = Mix(fromY, toY, rotationAlpha);
+			__m128 z = Mix(fromZ, toZ, rotationAlpha);
+			__m128 w = Mix(fromW, toW, rotationAlpha);
+			Normalize4(x, y, z, w);
+			Store(Out, Pose::RX, First, x);
+			Store(Out, Pose::RY, First, y);
+			Store(Out, Pose::RZ, First, z);
+			Store(Out, Pose::RW, First, w);
+			return;
+		}
+#endif
+
+		for (uint32_t lane = 0; lane < Pose::LANES; ++lane)
+		{
+			for (uint32_t stream = Pose::TX; stream <= Pose::TZ; ++stream)
+			{
+				Out.GetStream(Pose::Stream(stream))[First + lane] = Mix(Group.From[stream][lane], Group.To[stream][lane], Group.PositionAlpha[lane]);
+			}
+
+			float dot = 0.0f;
+			for (uint32_t stream = Pose::RX; stream <= Pose::RW; ++stream)
+			{
+				dot += Group.From[stream][lane] * Group.To[stream][lane];
+			}
+			const float sign = dot < 0.0f ? -1.0f : 1.0f;
+			float rotation[4];
+			float length = 0.0f;
+			for (uint32_t i = 0; i < 4; ++i)
+			{
+				rotation[i] = Mix(Group.From[Pose::RX + i][lane], sign * Group.To[Pose::RX + i][lane], Group.RotationAlpha[lane]);
+				length += rotation[i] * rotation[i];
+			}
+			const float inverse = 1.0f / std::sqrt(length);
+			for (uint32_t i = 0; i < 4; ++i)
+			{
+				Out.GetStream(Pose::Stream(Pose::RX + i))[First + lane] = rotation[i] * inverse;
+			}
+		}
+	}
+
+	uint32_t SamplePose(const Skeleton& Skeleton, float Time, std::vector<int32_t>& Cursors, Pose& Out,
+		uint32_t LeafCulling, const CompressedClip* Compressed, bool IsSimd)
+	{
+		const std::vector<SkeletonJoint>& joints = Skeleton.GetJoints();
+		const Animation& clip = *Skeleton.GetClip();
+		if (Out.GetJointCount() != joints.size())
+		{
+			Out.Resize(joints.size());
+		}
+		if (Cursors.size() < clip.GetBoneCount() * 2)
+		{
+			Cursors.resize(clip.GetBoneCount() * 2, 0);
+		}
+
+		uint32_t sampled = 0;
+		KeyGroup group;
+		for (uint32_t first = 0; first < Out.GetPaddedCount(); first += Pose::LANES)
+		{
+			// Key search stays scalar, every joint has its own key times
+			for (uint32_t lane = 0; lane < Pose::LANES; ++lane)
+			{
+				const uint32_t index = first + lane;
+				if (index >= joints.size())
+				{
+					group.Set(lane, glm::vec3(0.0f), glm::vec3(0.0f), 0.0f, glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::quat(1.0f, 0.0f, 0.0f, 0.0f), 0.0f);
+					continue;
+				}
+
+				const SkeletonJoint& joint = joints[index];
+				const bool isSampled = joint.Channel >= 0 && joint.LeafDistance >= LeafCulling;
+				if (isSampled && Compressed)
+				{
+					glm::vec3 position;
+					glm::quat rotation;
+					Compressed->Sample(joint.Channel, Time, position, rotation);
+					group.Set(lane, position, position, 0.0f, rotation, rotation, 0.0f);
+				}
+				else if (isSampled)
+				{
+					const Bone& bone = clip.GetBone(joint.Channel);
+					glm::vec3 fromPosition, toPosition;
+					glm::quat fromRotation, toRotation;
+					float positionAlpha, rotationAlpha;
+					bone.GetPositionKeys(Time, Cursors[joint.Channel * 2], fromPosition, toPosition, positionAlpha);
+					bone.GetRotationKeys(Time, Cursors[joint.Channel * 2 + 1], fromRotation, toRotation, rotationAlpha);
+					group.Set(lane, fromPosition, toPosition, positionAlpha, fromRotation, toRotation, rotationAlpha);
+				}
+				else
+				{
+					group.Set(lane, joint.BindPosition, joint.BindPosition, 0.0f, joint.BindRotation, joint.BindRotation, 0.0f);
+				}
+				sampled += isSampled ? 1 : 0;
+			}
+			InterpolateGroup(group, Out, first, IsSimd);
+		}
+		return sampled;
+	}
+
+	void BlendPoses(const Pose* const* Poses, const float* Weights, uint32_t Count, Pose& Out, bool IsSimd)
+	{
+		if (Count == 0)
+		{
+			return;
+		}
+		if (Out.GetJointCount() != Poses[0]->GetJointCount())
+		{
+			Out.Resize(Poses[0]->GetJointCount());
+		}
+
+		for (uint32_t first = 0; first < Out.GetPaddedCount(); first += Pose::LANES)
+		{
+#ifdef POSE_USE_SSE2
+			if (IsSimd)
+			{
+				const Pose& reference = *Poses[0];
+				const __m128 referenceX = Load(reference, Pose::RX, first);
+				const __m128 referenceY = Load(reference, Pose::RY, first);
+				const __m128 referenceZ = Load(reference, Pose::RZ, first);
+				const __m128 referenceW = Load(reference, Pose::RW, first);
+				__m128 sum[Pose::STREAM_COUNT];
+				for (__m128& value : sum)
+				{
+					value = _mm_setzero_ps();
+				}
+
+				for (uint32_t i = 0; i < Count; ++i)
+				{
+					const Pose& pose = *Poses[i];
+					const __m128 weight = _mm_set1_ps(Weights[i]);
+					for (uint32_t stream = Pose::TX; stream <= Pose::TZ; ++stream)
+					{
+						sum[stream] = _mm_add_ps(sum[stream], _mm_mul_ps(weight, Load(pose, Pose::Stream(stream), first)));
+					}
+
+					const __m128 x = Load(pose, Pose::RX, first);
+					const __m128 y = Load(pose, Pose::RY, first);
+					const __m128 z = Load(pose, Pose::RZ, first);
+					const __m128 w = Load(pose, Pose::RW, first);
+					const __m128 signedWeight = _mm_xor_ps(weight, NegativeMask(Dot4(x, y, z, w, referenceX, referenceY, referenceZ, referenceW)));
+					sum[Pose::RX] = _mm_add_ps(sum[Pose::RX], _mm_mul_ps(signedWeight, x));
+					sum[Pose::RY] = _mm_add_ps(sum[Pose::RY], _mm_mul_ps(signedWeight, y));
+					sum[Pose::RZ] = _mm_add_ps(sum[Pose::RZ], _mm_mul_ps(signedWeight, z));
+					sum[Pose::RW] = _mm_add_ps(sum[Pose::RW], _mm_mul_ps(signedWeight, w));
+				}
+
+				Normalize4(sum[Pose::RX], sum[Pose::RY], sum[Pose::RZ], sum[Pose::RW]);
+				for (uint32_t stream = 0; stream < Pose::STREAM_COUNT; ++stream)
+				{
+					Store(Out, Pose::Stream(stream), first, sum[stream]);
+				}
+				continue;
+			}
+#endif
+
+			for (uint32_t joint = first; joint < first + Pose::LANES; ++joint)
+			{
+				const glm::quat reference = Poses[0]->GetRotation(joint);
+				glm::vec3 translation(0.0f);
+				glm::quat rotation(0.0f, 0.0f, 0.0f, 0.0f);
+				for (uint32_t i = 0; i < Count; ++i)
+				{
+					const glm::quat poseRotation = Poses[i]->GetRotation(joint);
+					const float weight = glm::dot(poseRotation, reference) < 0.0f ? -Weights[i] : Weights[i];
+					translation += Weights[i] * Poses[i]->GetTranslation(joint);
+					rotation = rotation + poseRotation * weight;
+				}
+				Out.SetJoint(joint, translation, glm::normalize(rotation));
+			}
+		}
+	}
+
+	void MakeAdditivePose(const Pose& Source, const Pose& Reference, Pose& Out, bool IsSimd)
+	{
+		if (Out.GetJointCount() != Source.GetJointCount())
+		{
+			Out.Resize(Source.GetJointCount());
+		}
+
+		for (uint32_t first = 0; first < Out.GetPaddedCount(); first += Pose::LANES)
+		{
+#ifdef POSE_USE_SSE2
+			if (IsSimd)
+			{
+				for (uint32_t stream = Pose::TX; stream <= Pose::TZ; ++stream)
+				{
+					Store(Out, Pose::Stream(stream), first, _mm_sub_ps(Load(Source, Pose::Stream(stream), first), Load(Reference, Pose::Stream(stream), first)));
+				}
+
+				// Source * conjugate(Reference)
+				const __m128 sign = _mm_set1_ps(-0.0f);
+				__m128 x, y, z, w;
+				Multiply4(Load(Source, Pose::RX, first), Load(Source, Pose::RY, first), Load(Source, Pose::RZ, first), Load(Source, Pose::RW, first),
+					_mm_xor_ps(Load(Reference, Pose::RX, first), sign), _mm_xor_ps(Load(Reference, Pose::RY, first), sign),
+					_mm_xor_ps(Load(Reference, Pose::RZ, first), sign), Load(Reference, Pose::RW, first), x, y, z, w);
+				Store(Out, Pose::RX, first, x);
+				Store(Out, Pose::RY, first, y);
+				Store(Out, Pose::RZ, first, z);
+				Store(Out, Pose::RW, first, w);
+				continue;
+			}
+#endif
+
+			for (uint32_t joint = first; joint < first + Pose::LANES; ++joint)
+			{
+				Out.SetJoint(joint, Source.GetTranslation(joint) - Reference.GetTranslation(joint),
+					Source.GetRotation(joint) * glm::conjugate(Reference.GetRotation(joint)));
+			}
+		}
+	}
+
+	void AddLayerPose(const Pose& Base, const Pose& Additive, float Weight, Pose& Out, bool IsSimd)
+	{
+		if (Out.GetJointCount() != Base.GetJointCount())
+		{
+			Out.Resize(Base.GetJointCount());
+		}
+
+		for (uint32_t first = 0; first < Out.GetPaddedCount(); first += Pose::LANES)
+		{
+#ifdef POSE_USE_SSE2
+			if (IsSimd)
+			{
+				const __m128 weight = _mm_set1_ps(Weight);
+				for (uint32_t stream = Pose::TX; stream <= Pose::TZ; ++stream)
+				{
+					const Pose::Stream translation = Pose::Stream(stream);
+					Store(Out, translation, first, _mm_add_ps(Load(Base, translation, first), _mm_mul_ps(weight, Load(Additive, translation, first))));
+				}
+
+				// nlerp from the identity to the layer, flipped to the identity's hemisphere first
+				__m128 x = Load(Additive, Pose::RX, first);
+				__m128 y = Load(Additive, Pose::RY, first);
+				__m128 z = Load(Additive, Pose::RZ, first);
+				__m128 w = Load(Additive, Pose::RW, first);
+				const __m128 signedWeight = _mm_xor_ps(weight, NegativeMask(w));
+				x = _mm_mul_ps(x, signedWeight);
+				y = _mm_mul_ps(y, signedWeight);
+				z = _mm_mul_ps(z, signedWeight);
+				w = _mm_add_ps(_mm_set1_ps(1.0f - Weight), _mm_mul_ps(w, signedWeight));
+				Normalize4(x, y, z, w);
+
+				__m128 outX, outY, outZ, outW;
+				Multiply4(x, y, z, w, Load(Base, Pose::RX, first), Load(Base, Pose::RY, first), Load(Base, Pose::RZ, first), Load(Base, Pose::RW, first),
+					outX, outY, outZ, outW);
+				Store(Out, Pose::RX, first, outX);
+				Store(Out, Pose::RY, first, outY);
+				Store(Out, Pose::RZ, first, outZ);
+				Store(Out, Pose::RW, first, outW);
+				continue;
+			}
+#endif
+
+			for (uint32_t joint = first; joint < first + Pose::LANES; ++joint)
+			{
+				glm::quat layer = Additive.GetRotation(joint);
+				const float weight = layer.w < 0.0f ? -Weight : Weight;
+				layer = glm::normalize(glm::quat(1.0f - Weight + layer.w * weight, layer.x * weight, layer.y * weight, layer.z * weight));
+				Out.SetJoint(joint, Base.GetTranslation(joint) + Weight * Additive.GetTranslation(joint), layer * Base.GetRotation(joint));
+			}
+		}
+	}
+
+	void ModelSpacePose(const Skeleton& Skeleton, const Pose& Local, std::vector<glm::mat4>& Globals, std::vector<glm::mat4>& Palette, bool IsSimd)
+	{
+		const std::vector<SkeletonJoint>& joints = Skeleton.GetJoints();
+		if (Globals.size() < joints.size())
+		{
+			Globals.resize(joints.size(), glm::mat4(1.0f));
+		}
+		if (Palette.size() < Skeleton.GetPaletteSize())
+		{
+			Palette.resize(Skeleton.GetPaletteSize(), glm::mat4(1.0f));
+		}
+
+#ifdef POSE_USE_SSE2
+		if (IsSimd)
+		{
+			// Rotation matrices of LANES joints, the parent chain is then walked one joint at a time
+			alignas(16) float rotations[9][Pose::LANES];
+			const __m128 one = _mm_set1_ps(1.0f);
+			const __m128 two = _mm_set1_ps(2.0f);
+			for (uint32_t first = 0; first < joints.size(); first += Pose::LANES)
+			{
+				const __m128 x = Load(Local, Pose::RX, first);
+				const __m128 y = Load(Local, Pose::RY, first);
+				const __m128 z = Load(Local, Pose::RZ, first);
+				const __m128 w = Load(Local, Pose::RW, first);
+				const __m128 xx = _mm_mul_ps(x, x), yy = _mm_mul_ps(y, y), zz = _mm_mul_ps(z, z);
+				const __m128 xy = _mm_mul_ps(x, y), xz = _mm_mul_ps(x, z), yz = _mm_mul_ps(y, z);
+				const __m128 wx = _mm_mul_ps(w, x), wy = _mm_mul_ps(w, y), wz = _mm_mul_ps(w, z);
+				_mm_store_ps(rotations[0], _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))));
+				_mm_store_ps(rotations[1], _mm_mul_ps(two, _mm_add_ps(xy, wz)));
+				_mm_store_ps(rotations[2], _mm_mul_ps(two, _mm_sub_ps(xz, wy)));
+				_mm_store_ps(rotations[3], _mm_mul_ps(two, _mm_sub_ps(xy, wz)));
+				_mm_store_ps(rotations[4], _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))));
+				_mm_store_ps(rotations[5], _mm_mul_ps(two, _mm_add_ps(yz, wx)));
+				_mm_store_ps(rotations[6], _mm_mul_ps(two, _mm_add_ps(xz, wy)));
+				_mm_store_ps(rotations[7], _mm_mul_ps(two, _mm_sub_ps(yz, wx)));
+				_mm_store_ps(rotations[8], _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))));
+
+				const uint32_t last = std::min<uint32_t>(first + Pose::LANES, joints.size());
+				for (uint32_t index = first; index < last; ++index)
+				{
+					const uint32_t lane = index - first;
+					const SkeletonJoint& joint = joints[index];
+					__m128 local[4] = {
+						_mm_setr_ps(rotations[0][lane], rotations[1][lane], rotations[2][lane], 0.0f),
+						_mm_setr_ps(rotations[3][lane], rotations[4][lane], rotations[5][lane], 0.0f),
+						_mm_setr_ps(rotations[6][lane], rotations[7][lane], rotations[8][lane], 0.0f),
+						_mm_setr_ps(Local.GetStream(Pose::TX)[index], Local.GetStream(Pose::TY)[index], Local.GetStream(Pose::TZ)[index], 1.0f),
+					};
+
+					__m128 global[4];
+					if (joint.Parent >= 0)
+					{
+						// Written earlier in this loop, parents come first
+						__m128 parent[4];
+						LoadColumns(Globals[joint.Parent], parent);
+						MultiplyColumns(parent, local, global);
+					}
+					else
+					{
+						std::copy(local, local + 4, global);
+					}
+					StoreColumns(global, Globals[index]);
+
+					if (joint.BoneID >= 0)
+					{
+						__m128 offset[4];
+						__m128 bone[4];
+						LoadColumns(joint.Offset, offset);
+						MultiplyColumns(global, offset, bone);
+						StoreColumns(bone, Palette[joint.BoneID]);
+					}
+				}
+			}
+			return;
+		}
+#endif
+
+		for (size_t index = 0; index < joints.size(); ++index)
+		{
+			const SkeletonJoint& joint = joints[index];
+			const glm::mat4 local = glm::translate(glm::mat4(1.0f), Local.GetTranslation(index)) * glm::toMat4(Local.GetRotation(index));
+			Globals[index] = joint.Parent >= 0 ? Globals[joint.Parent] * local : local;
+			if (joint.BoneID >= 0)
+			{
+				Palette[joint.BoneID] = Globals[index] * joint.Offset;
+			}
+		}
+	}
+
+#ifdef POSE_USE_SSE2
+	const bool HAS_SIMD = true;
+#else
+	const bool HAS_SIMD = false;
+#endif
+}
+
+Pose::Pose(uint32_t JointCount)
+{
+	Resize(JointCount);
+}
+
+void Pose::Resize(uint32_t JointCount)
+{
+	m_JointCount = JointCount;
+	m_PaddedCount = (JointCount + LANES - 1) / LANES * LANES;
+	m_Data.assign(size_t(m_PaddedCount) * STREAM_COUNT, 0.0f);
+	std::fill_n(GetStream(RW), m_PaddedCount, 1.0f);
+}
+
+uint32_t Pose::GetJointCount() const
+{
+	return m_JointCount;
+}
+
+uint32_t Pose::GetPaddedCount() const
+{
+	return m_PaddedCount;
+}
+
+float* Pose::GetStream(Stream Stream)
+{
+	return m_Data.data() + size_t(Stream) * m_PaddedCount;
+}
+
+const float* Pose::GetStream(Stream Stream) const
+{
+	return m_Data.data() + size_t(Stream) * m_PaddedCount;
+}
+
+void Pose::SetJoint(uint32_t Joint, const glm::vec3& Translation, const glm::quat& Rotation)
+{
+	GetStream(TX)[Joint] = Translation.x;
+	GetStream(TY)[Joint] = Translation.y;
+	GetStream(TZ)[Joint] = Translation.z;
+	GetStream(RX)[Joint] = Rotation.x;
+	GetStream(RY)[Joint] = Rotation.y;
+	GetStream(RZ)[Joint] = Rotation.z;
+	GetStream(RW)[Joint] = Rotation.w;
+}
+
+glm::vec3 Pose::GetTranslation(uint32_t Joint) const
+{
+	return glm::vec3(GetStream(TX)[Joint], GetStream(TY)[Joint], GetStream(TZ)[Joint]);
+}
+
+glm::quat Pose::GetRotation(uint32_t Joint) const
+{
+	return glm::quat(GetStream(RW)[Joint], GetStream(RX)[Joint], GetStream(RY)[Joint], GetStream(RZ)[Joint]);
+}
+
+uint32_t Pose::Sample(const Skeleton& Skeleton, float Time, std::vector<int32_t>& Cursors, Pose& Out, uint32_t LeafCulling, const CompressedClip* Compressed)
+{
+	return SamplePose(Skeleton, Time, Cursors, Out, LeafCulling, Compressed, HAS_SIMD);
+}
+
+void Pose::Blend(const Pose* const* Poses, const float* Weights, uint32_t Count, Pose& Out)
+{
+	BlendPoses(Poses, Weights, Count, Out, HAS_SIMD);
+}
+
+void Pose::MakeAdditive(const Pose& Source, const Pose& Reference, Pose& Out)
+{
+	MakeAdditivePose(Source, Reference, Out, HAS_SIMD);
+}
+
+void Pose::AddLayer(const Pose& Base, const Pose& Additive, float Weight, Pose& Out)
+{
+	AddLayerPose(Base, Additive, Weight, Out, HAS_SIMD);
+}
+
+void Pose::ToModelSpace(const Skeleton& Skeleton, const Pose& Local, std::vector<glm::mat4>& Globals, std::vector<glm::mat4>& Palette)
+{
+	ModelSpacePose(Skeleton, Local, Globals, Palette, HAS_SIMD);
+}
+
+PoseBenchmarkResult Pose::Benchmark(const std::string& ModelPath, const std::string& ClipPath, int Iterations)
+{
+	using Clock = std::chrono::high_resolution_clock;
+
+	PoseBenchmarkResult result;
+	result.Iterations = std::max(Iterations, 1);
+
+	SkinnedModel model(ModelPath.c_str());
+	Animation clip(ClipPath, &model);
+	if (clip.GetBoneCount() == 0)
+	{
+		return result;
+	}
+	Skeleton skeleton(clip, model);
+	result.Joints = skeleton.GetJointCount();
+
+	auto measure = [&](auto&& Kernel)
+	{
+		Clock::time_point start = Clock::now();
+		for (int i = 0; i < result.Iterations; ++i)
+		{
+			Kernel(i);
+		}
+		return std::chrono::duration<double, std::micro>(Clock::now() - start).count() / result.Iterations;
+	};
+
+	// Times walk through the clip like playback does, so cursors mostly continue
+	const float duration = clip.GetDuration();
+	const float step = duration / result.Iterations;
+	std::vector<int32_t> cursors;
+	Pose poses[2];
+	Pose blended;
+	Pose additive;
+	std::vector<glm::mat4> globals;
+	std::vector<glm::mat4> palette;
+	const float weights[2] = { 0.7f, 0.3f };
+	const Pose* inputs[2] = { &poses[0], &poses[1] };
+
+	for (bool isSimd : { true, false })
+	{
+		// A file with one clip still blends two different poses, half a clip apart
+		SamplePose(skeleton, duration * 0.25f, cursors, poses[0], 0, nullptr, isSimd);
+		SamplePose(skeleton, duration * 0.75f, cursors, poses[1], 0, nullptr, isSimd);
+		MakeAdditivePose(poses[1], poses[0], additive, isSimd);
+		BlendPoses(inputs, weights, 2, blended, isSimd);
+
+		(isSimd ? result.SampleUs : result.ScalarSampleUs) = measure([&](int i) { SamplePose(skeleton, step * i, cursors, poses[0], 0, nullptr, isSimd); });
+		(isSimd ? result.BlendUs : result.ScalarBlendUs) = measure([&](int) { BlendPoses(inputs, weights, 2, blended, isSimd); });
+		(isSimd ? result.AdditiveUs : result.ScalarAdditiveUs) = measure([&](int) { AddLayerPose(poses[1], additive, 0.5f, blended, isSimd); });
+		(isSimd ? result.ModelSpaceUs : result.ScalarModelSpaceUs) = measure([&](int) { ModelSpacePose(skeleton, blended, globals, palette, isSimd); });
+	}
+
+	// Same chain through both versions of every kernel
+	std::vector<glm::mat4> palettes[2];
+	for (int version = 0; version < 2; ++version)
+	{
+		const bool isSimd = version == 0;
+		SamplePose(skeleton, duration * 0.25f, cursors, poses[0], 0, nullptr, isSimd);
+		SamplePose(skeleton, duration * 0.75f, cursors, poses[1], 0, nullptr, isSimd);
+		MakeAdditivePose(poses[1], poses[0], additive, isSimd);
+		BlendPoses(inputs, weights, 2, blended, isSimd);
+		AddLayerPose(blended, additive, 0.5f, blended, isSimd);
+		ModelSpacePose(skeleton, blended, globals, palettes[version], isSimd);
+	}
+	for (size_t bone = 0; bone < palettes[0].size(); ++bone)
+	{
+		for (int column = 0; column < 4; ++column)
+		{
+			for (int row = 0; row < 4; ++row)
+			{
+				result.MaxError = std::max(result.MaxError, std::abs(palettes[0][bone][column][row] - palettes[1][bone][column][row]));
+			}
+		}
+	}
+
+	const float deltaTime = 1.0f / 60.0f;
+	Animator single(&clip);
+	single.SetSkeleton(&skeleton);
+	result.AnimatorUs = measure([&](int) { single.UpdateAnimation(deltaTime); });
+
+	Animator fading(&clip);
+	fading.SetSkeleton(&skeleton);
+	fading.UpdateAnimation(duration * 0.5f / clip.GetTicksPerSecond());
+	// Long enough to stay in the fade for every iteration
+	fading.CrossFade(&clip, &skeleton, 1.0e6f);
+	result.CrossfadeUs = measure([&](int) { fading.UpdateAnimation(deltaTime); });
+
+	return result;
+}
@@ -1,4 +1,6 @@
 #include "Public/Quad.h"
+#include "Public/GPUResourceTracker.h"
+#include "Public/GLState.h"
 
 Quad& Quad::GetInstance()
 {
@@ -9,15 +11,15 @@ Quad& Quad::GetInstance()
 void Quad::Draw(Shader& Shader)
 {
     Shader.Use();
-    glBindVertexArray(m_VAO);
+    GLState::BindVertexArray(m_VAO);
     glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-    glBindVertexArray(0);
+    GLState::BindVertexArray(0);
 }
 
 Quad::~Quad()
 {
-    glDeleteVertexArrays(1, &m_VAO);
-    glDeleteBuffers(1, &m_VBO);
+    GPUResourceTracker::GetInstance().DeleteVertexArrays(1, &m_VAO);
+    GPUResourceTracker::GetInstance().DeleteBuffers(1, &m_VBO);
 }
 
 Quad::Quad()
@@ -31,11 +33,15 @@ Quad::Quad()
          1.0f, -1.0f, 0.0f,   0.0f, 0.0f, -1.0,   1.0f, 0.0f,
     };
 
-    glGenVertexArrays(1, &m_VAO);
-    glGenBuffers(1, &m_VBO);
-    glBindVertexArray(m_VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
+    GPUResourceTracker& tracker = GPUResourceTracker::GetInstance();
+    tracker.GenVertexArrays(1, &m_VAO, GPUResourceOwner::MESH);
+    tracker.GenBuffers(1, &m_VBO, GPUResourceOwner::MESH);
+    tracker.SetPersistent(GPUResourceType::VERTEXARRAY, m_VAO);
+    tracker.SetPersistent(GPUResourceType::BUFFER, m_VBO);
+    GLState::BindVertexArray(m_VAO);
+    GLState::BindBuffer(GL_ARRAY_BUFFER, m_VBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), &vertices, GL_STATIC_DRAW);
+    tracker.SetBufferSize(m_VBO, sizeof(vertices));
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(1);
@@ -1,211 +1,212 @@
 #include "../Public/Shader.h"
 
 #include <glm/gtc/type_ptr.hpp>
-#include <fstream>
-#include <sstream>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#include "../Public/GLState.h"
+#include "../Public/ShaderCache.h"
+#include "../Public/ShaderPreprocessor.h"
+#include "../Public/ShaderWatcher.h"
 
 Shader::Shader(const char* vertexPath, const char* fragmentPath, const char* geometryPath)
 {
-    std::string vShaderCode;
-    std::string fShaderCode;
-    std::string gShaderCode;
-    std::ifstream vShaderFile;
-    std::ifstream fShaderFile;
-    std::ifstream gShaderFile;
-
-    // zapewnij by obiekt ifstream mg rzuca wyjtkami  
-    vShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-    fShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-
-    try
-    {
-        // Open files
-        vShaderFile.open(vertexPath);
-        fShaderFile.open(fragmentPath);
-        std::stringstream vShaderStream, fShaderStream, gShaderStream;
-        // zapisz zawarto bufora pliku do strumieni  
-        vShaderStream << vShaderFile.rdbuf();
-        fShaderStream << fShaderFile.rdbuf();
-        // zamknij uchtywy do plikw  
-        vShaderFile.close();
-        fShaderFile.close();
-        // zamie strumie w acuch znakw 
-        vShaderCode = vShaderStream.str();
-        fShaderCode = fShaderStream.str();
-
-        if (geometryPath)
-        {
-            gShaderFile.open(geometryPath);
-            gShaderStream << gShaderFile.rdbuf();
-            gShaderFile.close();
-            gShaderCode = gShaderStream.str();
-        }
-
-    }
-    catch (std::ifstream::failure& e)
+    std::vector<ShaderStage> stages =
     {
-        fprintf(stderr, "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ: %s\n", e.what());
-    }
-    const char *vertexShaderCode, *fragmentShaderCode, *geometryShaderCode;
-
-    vertexShaderCode = vShaderCode.c_str();
-    fragmentShaderCode = fShaderCode.c_str();
+        { GL_VERTEX_SHADER, "VERTEX", vertexPath },
+        { GL_FRAGMENT_SHADER, "FRAGMENT", fragmentPath },
+    };
     if (geometryPath)
     {
-        geometryShaderCode = gShaderCode.c_str();
+        stages.push_back({ GL_GEOMETRY_SHADER, "GEOMETRY", geometryPath });
     }
+    Build(stages);
+}
 
-    unsigned int vertex, fragment, geometry;
-
-    // Vertex Shader  
-    vertex = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertex, 1, &vertexShaderCode, NULL);
-    glCompileShader(vertex);
-    CheckCompileErrors(vertex, "VERTEX");
-
-    // Fragment Shader  
-    fragment = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragment, 1, &fragmentShaderCode, NULL);
-    glCompileShader(fragment);
-    CheckCompileErrors(fragment, "FRAGMENT");
-
-    if (geometryPath)
-    {
-        // Geometry Shader  
-        geometry = glCreateShader(GL_GEOMETRY_SHADER);
-        glShaderSource(geometry, 1, &geometryShaderCode, NULL);
-        glCompileShader(geometry);
-        CheckCompileErrors(geometry, "GEOMETRY");
-    }
-
-    // Program Object  
-    ID = glCreateProgram();
-    glAttachShader(ID, vertex);
-    glAttachShader(ID, fragment);
-    if (geometryPath)
-    {
-        glAttachShader(ID, geometry);
-    }
-    glLinkProgram(ID);
-    CheckCompileErrors(ID, "PROGRAM");
-
-    // Deleting shaders
-    glDeleteShader(vertex);
-    glDeleteShader(fragment);
+Shader::Shader(const char* vertexPath, const char* fragmentPath, const ShaderPermutation& Permutation)
+    : m_Defines(Permutation.GetDefines())
+{
+    Build({ { GL_VERTEX_SHADER, "VERTEX", vertexPath }, { GL_FRAGMENT_SHADER, "FRAGMENT", fragmentPath } });
 }
 
 Shader::Shader(const char* ComputePath)
 {
-    // 1. retrieve the vertex/fragment source code from filePath
-    std::string computeCode;
-    std::ifstream cShaderFile;
-    // ensure ifstream objects can throw exceptions:
-    cShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-    try
-    {
-        // open files
-        cShaderFile.open(ComputePath);
-
-        std::stringstream cShaderStream;
-        // read file's buffer contents into streams
-        cShaderStream << cShaderFile.rdbuf();
-        // close file handlers
-        cShaderFile.close();
-        // convert stream into string
-        computeCode = cShaderStream.str();
-    }
-    catch (std::ifstream::failure& e)
-    {
-        fprintf(stderr, "ERROR::COMPUTE::SHADER::FILE_NOT_SUCCESFULLY_READ: %s\n", e.what());
-    }
-    const char* cShaderCode = computeCode.c_str();
-    // 2. compile shaders
-    unsigned int compute;
-    // compute shader
-    compute = glCreateShader(GL_COMPUTE_SHADER);
-    glShaderSource(compute, 1, &cShaderCode, NULL);
-    glCompileShader(compute);
-    CheckCompileErrors(compute, "COMPUTE");
-
-    // shader Program
-    ID = glCreateProgram();
-    glAttachShader(ID, compute);
-    glLinkProgram(ID);
-    CheckCompileErrors(ID, "PROGRAM");
-    // delete the shaders as they're linked into our program now and no longer necessery
-    glDeleteShader(compute);
+    Build({ { GL_COMPUTE_SHADER, "COMPUTE", ComputePath } });
 }
 
 Shader::~Shader()
 {
+    ShaderWatcher::GetInstance().Remove(this);
+    DiscardReload();
     if (ID)
     {
+        GLState::ForgetProgram(ID);
         glDeleteProgram(ID);
     }
 }
 
 void Shader::Use()
 {
-    if (m_ActiveShader != ID)
-    {
-        glUseProgram(ID);
-        m_ActiveShader = ID;
-    }
+    GLState::UseProgram(ID);
 }
 
 void Shader::setBool(const char* name, bool value) const
 {
-    glUniform1i(glGetUniformLocation(ID, name), (int)value);
+    setInt(name, (int)value);
 }
 
 void Shader::setInt(const char* name, int value) const
 {
-    glUniform1i(glGetUniformLocation(ID, name), value);
+    GLint location = GetUniformLocation(name);
+    if (StoreValue(location, GL_INT, &value, sizeof(value)))
+    {
+        glProgramUniform1i(ID, location, value);
+    }
 }
 
 void Shader::setFloat(const char* name, float value) const
 {
-    glUniform1f(glGetUniformLocation(ID, name), value);
+    GLint location = GetUniformLocation(name);
+    if (StoreValue(location, GL_FLOAT, &value, sizeof(value)))
+    {
+        glProgramUniform1f(ID, location, value);
+    }
 }
 
 void Shader::setVec2(const char* name, float x, float y) const
 {
-    glUniform2f(glGetUniformLocation(ID, name), x, y);
+    setVec2(name, glm::vec2(x, y));
 }
 
 void Shader::setVec2(const char* name, const glm::vec2& vector) const
 {
-    glUniform2f(glGetUniformLocation(ID, name), vector.x, vector.y);
+    GLint location = GetUniformLocation(name);
+    if (StoreValue(location, GL_FLOAT_VEC2, glm::value_ptr(vector), sizeof(vector)))
+    {
+        glProgramUniform2f(ID, location, vector.x, vector.y);
+    }
 }
 
 void Shader::setVec3(const char* name, float x, float y, float z) const
 {
-    glUniform3f(glGetUniformLocation(ID, name), x, y, z);
+    setVec3(name, glm::vec3(x, y, z));
 }
 
 void Shader::setVec3(const char* name, const glm::vec3& vector) const
 {
-    glUniform3f(glGetUniformLocation(ID, name), vector.x, vector.y, vector.z);
+    GLint location = GetUniformLocation(name);
+    if (StoreValue(location, GL_FLOAT_VEC3, glm::value_ptr(vector), sizeof(vector)))
+    {
+        glProgramUniform3f(ID, location, vector.x, vector.y, vector.z);
+    }
 }
 
 void Shader::setVec4(const char* name, float x, float y, float z, float w) const
 {
-    glUniform4f(glGetUniformLocation(ID, name), x, y, z, w);
+    setVec4(name, glm::vec4(x, y, z, w));
 }
 
 void Shader::setVec4(const char* name, const glm::vec4& vector) const
 {
-    glUniform4f(glGetUniformLocation(ID, name), vector.x, vector.y, vector.z, vector.w);
+    GLint location = GetUniformLocation(name);
+    if (StoreValue(location, GL_FLOAT_VEC4, glm::value_ptr(vector), sizeof(vector)))
+    {
+        glProgramUniform4f(ID, location, vector.x, vector.y, vector.z, vector.w);
+    }
 }
 
 void Shader::setMat4(const char* name, const glm::mat4& value) const
 {
-    glUniformMatrix4fv(glGetUniformLocation(ID, name), 1, GL_FALSE, glm::value_ptr(value));
+    GLint location = GetUniformLocation(name);
+    if (StoreValue(location, GL_FLOAT_MAT4, glm::value_ptr(value), sizeof(value)))
+    {
+        glProgramUniformMatrix4fv(ID, location, 1, GL_FALSE, glm::value_ptr(value));
+    }
 }
 
 void Shader::setBlock(const char* name, unsigned int number)
 {
-    glUniformBlockBinding(ID, glGetUniformBlockIndex(ID, name), number);
+    m_BlockBindings[name] = number;
+    auto iter = m_UniformBlocks.find(std::string_view(name));
+    if (iter == m_UniformBlocks.end())
+    {
+        return;
+    }
+    glUniformBlockBinding(ID, iter->second, number);
+}
+
+void Shader::setBool(UniformHandle<bool> handle, bool value) const
+{
+    setInt(UniformHandle<int>{ handle.Location }, (int)value);
+}
+
+void Shader::setInt(UniformHandle<int> handle, int value) const
+{
+    if (StoreValue(handle.Location, GL_INT, &value, sizeof(value)))
+    {
+        glProgramUniform1i(ID, handle.Location, value);
+    }
+}
+
+void Shader::setFloat(UniformHandle<float> handle, float value) const
+{
+    if (StoreValue(handle.Location, GL_FLOAT, &value, sizeof(value)))
+    {
+        glProgramUniform1f(ID, handle.Location, value);
+    }
+}
+
+void Shader::setVec2(UniformHandle<glm::vec2> handle, const glm::vec2& vector) const
+{
+    if (StoreValue(handle.Location, GL_FLOAT_VEC2, glm::value_ptr(vector), sizeof(vector)))
+    {
+        glProgramUniform2f(ID, handle.Location, vector.x, vector.y);
+    }
+}
+
+void Shader::setVec3(UniformHandle<glm::vec3> handle, const glm::vec3& vector) const
+{
+    if (StoreValue(handle.Location, GL_FLOAT_VEC3, glm::value_ptr(vector), sizeof(vector)))
+    {
+        glProgramUniform3f(ID, handle.Location, vector.x, vector.y, vector.z);
+    }
+}
+
+void Shader::setVec4(UniformHandle<glm::vec4> handle, const glm::vec4& vector) const
+{
+    if (StoreValue(handle.Location, GL_FLOAT_VEC4, glm::value_ptr(vector), sizeof(vector)))
+    {
+        glProgramUniform4f(ID, handle.Location, vector.x, vector.y, vector.z, vector.w);
+    }
+}
+
+void Shader::setMat4(UniformHandle<glm::mat4> handle, const glm::mat4& value) const
+{
+    if (StoreValue(handle.Location, GL_FLOAT_MAT4, glm::value_ptr(value), sizeof(value)))
+    {
+        glProgramUniformMatrix4fv(ID, handle.Location, 1, GL_FALSE, glm::value_ptr(value));
+    }
+}
+
+GLint Shader::GetUniformLocation(const char* name) const
+{
+    auto iter = m_Uniforms.find(std::string_view(name));
+    if (iter != m_Uniforms.end())
+    {
+        return iter->second.Location;
+    }
+
+    // Not an active uniform, remember the miss so the driver is asked only once
+    ++m_LocationQueries;
+    GLint location = glGetUniformLocation(ID, name);
+    m_Uniforms.emplace(name, UniformInfo{ location, GL_NONE, 0 });
+    return location;
+}
+
+const UniformTable& Shader::GetUniforms() const
+{
+    return m_Uniforms;
 }
 
 void Shader::bindUniformData(GLuint UBO, GLuint Offset, GLuint Size, float* Data)
@@ -215,7 +216,222 @@ void Shader::bindUniformData(GLuint UBO, GLuint Offset, GLuint Size, float* Data
     glBindBuffer(GL_UNIFORM_BUFFER, 0);
 }
 
-void Shader::CheckCompileErrors(unsigned int ShaderID, const char* ShaderType)
+unsigned int Shader::GetLocationQueryCount()
+{
+    return m_LocationQueries;
+}
+
+void Shader::ResetLocationQueryCount()
+{
+    m_LocationQueries = 0U;
+}
+
+unsigned int Shader::GetUploadCount()
+{
+    return m_UniformUploads;
+}
+
+unsigned int Shader::GetFilteredUploadCount()
+{
+    return m_FilteredUploads;
+}
+
+void Shader::ResetUploadCount()
+{
+    m_UniformUploads = 0U;
+    m_FilteredUploads = 0U;
+}
+
+void Shader::Reload()
+{
+    if (m_Stages.empty())
+    {
+        return;
+    }
+    // A newer edit replaces a reload that is still linking
+    DiscardReload();
+
+    std::vector<ShaderStage> stages = m_Stages;
+    if (!Preprocess(stages, m_PendingFiles))
+    {
+        // File may be mid save, the next change event retries
+        return;
+    }
+
+    m_PendingKey = GetCacheKey(stages);
+    m_PendingProgram = glCreateProgram();
+    if (!ShaderCache::Load(m_PendingProgram, m_PendingKey))
+    {
+        BeginLink(m_PendingProgram, stages, m_PendingShaders);
+    }
+}
+
+ShaderReloadResult Shader::UpdateReload()
+{
+    if (!m_PendingProgram)
+    {
+        return ShaderReloadResult::NONE;
+    }
+    if (!ShaderWatcher::GetInstance().IsLinkComplete(m_PendingProgram))
+    {
+        return ShaderReloadResult::PENDING;
+    }
+
+    for (size_t i = 0; i < m_PendingShaders.size(); ++i)
+    {
+        CheckCompileErrors(m_PendingShaders[i], m_Stages[i].Name);
+    }
+    bool isLinked = CheckCompileErrors(m_PendingProgram, "PROGRAM");
+    if (isLinked && !m_PendingShaders.empty())
+    {
+        ShaderCache::Save(m_PendingProgram, m_PendingKey);
+    }
+
+    GLuint program = m_PendingProgram;
+    ReleaseShaders(program, m_PendingShaders);
+    m_PendingProgram = 0;
+    if (!isLinked)
+    {
+        // Keep rendering with the old program
+        glDeleteProgram(program);
+        return ShaderReloadResult::FAILED;
+    }
+
+    UniformTable oldUniforms = std::move(m_Uniforms);
+    std::vector<UniformValue> oldValues = std::move(m_UniformValues);
+    GLuint oldProgram = ID;
+    ID = program;
+    Reflect();
+    RestoreState(oldUniforms, oldValues);
+    if (m_PendingFiles != m_Files)
+    {
+        // Includes changed, watch the new ones too
+        m_Files = m_PendingFiles;
+        ShaderWatcher::GetInstance().Add(this);
+    }
+
+    if (GLState::GetProgram() == oldProgram)
+    {
+        GLState::UseProgram(ID);
+    }
+    glDeleteProgram(oldProgram);
+    fprintf(stdout, "Reloaded shader program %u from %s\n", ID, m_Stages.front().Path.c_str());
+    return ShaderReloadResult::SWAPPED;
+}
+
+const std::vector<ShaderStage>& Shader::GetStages() const
+{
+    return m_Stages;
+}
+
+const std::vector<std::string>& Shader::GetFiles() const
+{
+    return m_Files;
+}
+
+void Shader::CopyState(const Shader& Source)
+{
+    m_BlockBindings = Source.m_BlockBindings;
+    RestoreState(Source.m_Uniforms, Source.m_UniformValues);
+}
+
+void Shader::Build(std::vector<ShaderStage> Stages)
+{
+    // Missing files are reported and left to fail compilation like any other error
+    Preprocess(Stages, m_Files);
+    Link(Stages);
+    ShaderWatcher::GetInstance().Add(this);
+}
+
+bool Shader::Preprocess(std::vector<ShaderStage>& Stages, std::vector<std::string>& Files) const
+{
+    Files.clear();
+    bool isRead = true;
+    std::vector<std::string> stageFiles;
+    for (ShaderStage& stage : Stages)
+    {
+        isRead = ShaderPreprocessor::Process(stage.Path, m_Defines, stage.Source, stageFiles) && isRead;
+        for (std::string& file : stageFiles)
+        {
+            if (std::find(Files.begin(), Files.end(), file) == Files.end())
+            {
+                Files.push_back(std::move(file));
+            }
+        }
+    }
+    return isRead;
+}
+
+void Shader::Link(const std::vector<ShaderStage>& Stages)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+
+    uint64_t key = GetCacheKey(Stages);
+    ID = glCreateProgram();
+    if (!ShaderCache::Load(ID, key))
+    {
+        std::vector<GLuint> shaders;
+        BeginLink(ID, Stages, shaders);
+        for (size_t i = 0; i < shaders.size(); ++i)
+        {
+            CheckCompileErrors(shaders[i], Stages[i].Name);
+        }
+        if (CheckCompileErrors(ID, "PROGRAM"))
+        {
+            ShaderCache::Save(ID, key);
+        }
+        ReleaseShaders(ID, shaders);
+    }
+    Reflect();
+
+    // Only paths are needed to reload
+    m_Stages = Stages;
+    for (ShaderStage& stage : m_Stages)
+    {
+        stage.Source.clear();
+        stage.Source.shrink_to_fit();
+    }
+
+    ShaderCache::AddBuildTime(std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+}
+
+void Shader::BeginLink(GLuint Program, const std::vector<ShaderStage>& Stages, std::vector<GLuint>& Shaders)
+{
+    for (const ShaderStage& stage : Stages)
+    {
+        const char* code = stage.Source.c_str();
+        GLuint shader = glCreateShader(stage.Type);
+        glShaderSource(shader, 1, &code, NULL);
+        glCompileShader(shader);
+        glAttachShader(Program, shader);
+        Shaders.push_back(shader);
+    }
+
+    glProgramParameteri(Program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    glLinkProgram(Program);
+}
+
+void Shader::ReleaseShaders(GLuint Program, std::vector<GLuint>& Shaders)
+{
+    for (GLuint shader : Shaders)
+    {
+        glDetachShader(Program, shader);
+        glDeleteShader(shader);
+    }
+    Shaders.clear();
+}
+
+uint64_t Shader::GetCacheKey(const std::vector<ShaderStage>& Stages)
+{
+    std::vector<std::string> sources;
+    for (const ShaderStage& stage : Stages)
+    {
+        sources.push_back(std::to_string(stage.Type) + '\n' + stage.Source);
+    }
+    return ShaderCache::GetKey(sources);
+}
+
+bool Shader::CheckCompileErrors(unsigned int ShaderID, const char* ShaderType)
 {
     GLint success;
     GLchar infoLog[1024];
@@ -237,4 +453,138 @@ void Shader::CheckCompileErrors(unsigned int ShaderID, const char* ShaderType)
             fprintf(stderr, "ERROR::PROGRAM_LINKING_ERROR::%s\n%s \n -- --------------------------------------------------- -- \n", ShaderType, infoLog);
         }
     }
+    return success;
+}
+
+void Shader::Reflect()
+{
+    m_Uniforms.clear();
+    m_UniformBlocks.clear();
+    GLint maxLocation = -1;
+
+    GLint count = 0, maxLength = 0;
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+    std::string buffer(maxLength > 0 ? maxLength : 1, '\0');
+    for (GLint i = 0; i < count; ++i)
+    {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = GL_NONE;
+        glGetActiveUniform(ID, (GLuint)i, (GLsizei)buffer.size(), &length, &size, &type, buffer.data());
+        std::string name(buffer.data(), length);
+
+        GLint location = glGetUniformLocation(ID, name.c_str());
+        if (location < 0)
+        {
+            // Members of uniform blocks have no location
+            continue;
+        }
+
+        // Arrays are reported as "name[0]", register the bare name and every element
+        if (size > 1 && name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0)
+        {
+            std::string base = name.substr(0, name.size() - 3);
+            m_Uniforms.emplace(base, UniformInfo{ location, type, size });
+            for (GLint element = 0; element < size; ++element)
+            {
+                std::string elementName = base + '[' + std::to_string(element) + ']';
+                GLint elementLocation = glGetUniformLocation(ID, elementName.c_str());
+                m_Uniforms.emplace(elementName, UniformInfo{ elementLocation, type, 1 });
+                maxLocation = std::max(maxLocation, elementLocation);
+            }
+        }
+        else
+        {
+            m_Uniforms.emplace(name, UniformInfo{ location, type, size });
+        }
+        maxLocation = std::max(maxLocation, location);
+    }
+    m_UniformValues.assign(size_t(maxLocation + 1), UniformValue{});
+
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORM_BLOCKS, &count);
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH, &maxLength);
+    buffer.assign(maxLength > 0 ? maxLength : 1, '\0');
+    for (GLint i = 0; i < count; ++i)
+    {
+        GLsizei length = 0;
+        glGetActiveUniformBlockName(ID, (GLuint)i, (GLsizei)buffer.size(), &length, buffer.data());
+        m_UniformBlocks.emplace(std::string(buffer.data(), length), (GLuint)i);
+    }
+}
+
+bool Shader::StoreValue(GLint Location, GLenum Type, const void* Data, size_t Size) const
+{
+    if (Location < 0)
+    {
+        return false;
+    }
+    if (Location < (GLint)m_UniformValues.size())
+    {
+        UniformValue& value = m_UniformValues[Location];
+        if (value.Type == Type && memcmp(value.Float, Data, Size) == 0)
+        {
+            // Program uniforms keep their value, the call would be redundant
+            ++m_FilteredUploads;
+            return false;
+        }
+        value.Type = Type;
+        memcpy(value.Float, Data, Size);
+    }
+    ++m_UniformUploads;
+    return true;
+}
+
+void Shader::RestoreState(const UniformTable& OldUniforms, const std::vector<UniformValue>& OldValues)
+{
+    for (const auto& [name, info] : OldUniforms)
+    {
+        if (info.Location < 0 || info.Location >= (GLint)OldValues.size() || OldValues[info.Location].Type == GL_NONE)
+        {
+            continue;
+        }
+
+        // Locations are not stable between links, match by name
+        auto iter = m_Uniforms.find(name);
+        if (iter == m_Uniforms.end() || iter->second.Location < 0)
+        {
+            continue;
+        }
+        const UniformValue& value = OldValues[info.Location];
+        GLint location = iter->second.Location;
+        switch (value.Type)
+        {
+            case GL_INT:        glProgramUniform1i(ID, location, value.Int); break;
+            case GL_FLOAT:      glProgramUniform1f(ID, location, value.Float[0]); break;
+            case GL_FLOAT_VEC2: glProgramUniform2fv(ID, location, 1, value.Float); break;
+            case GL_FLOAT_VEC3: glProgramUniform3fv(ID, location, 1, value.Float); break;
+            case GL_FLOAT_VEC4: glProgramUniform4fv(ID, location, 1, value.Float); break;
+            case GL_FLOAT_MAT4: glProgramUniformMatrix4fv(ID, location, 1, GL_FALSE, value.Float); break;
+            default: continue;
+        }
+        if (location < (GLint)m_UniformValues.size())
+        {
+            m_UniformValues[location] = value;
+        }
+    }
+
+    for (const auto& [name, binding] : m_BlockBindings)
+    {
+        auto iter = m_UniformBlocks.find(name);
+        if (iter != m_UniformBlocks.end())
+        {
+            glUniformBlockBinding(ID, iter->second, binding);
+        }
+    }
+}
+
+void Shader::DiscardReload()
+{
+    if (!m_PendingProgram)
+    {
+        return;
+    }
+    ReleaseShaders(m_PendingProgram, m_PendingShaders);
+    glDeleteProgram(m_PendingProgram);
+    m_PendingProgram = 0;
 }
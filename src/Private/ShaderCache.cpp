@@ -0,0 +1,148 @@
+#include "Public/ShaderCache.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+
+namespace
+{
+    const uint32_t CACHE_MAGIC = 0x48435350; // "PSCH"
+
+    struct CacheHeader
+    {
+        uint32_t Magic;
+        uint32_t Format;
+        uint32_t Length;
+    };
+
+    void HashBytes(uint64_t& Hash, const void* Data, size_t Size)
+    {
+        // FNV-1a
+        const unsigned char* bytes = static_cast<const unsigned char*>(Data);
+        for (size_t i = 0; i < Size; ++i)
+        {
+            Hash ^= bytes[i];
+            Hash *= 0x100000001B3ULL;
+        }
+    }
+}
+
+uint64_t ShaderCache::GetKey(const std::vector<std::string>& Sources)
+{
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    const std::string& driver = GetDriverString();
+    HashBytes(hash, driver.data(), driver.size());
+    for (const std::string& source : Sources)
+    {
+        // Length first so moving text between stages changes the key
+        uint64_t length = source.size();
+        HashBytes(hash, &length, sizeof(length));
+        HashBytes(hash, source.data(), source.size());
+    }
+    return hash;
+}
+
+bool ShaderCache::Load(GLuint Program, uint64_t Key)
+{
+    std::ifstream file(GetPath(Key), std::ios::binary);
+    if (!file)
+    {
+        ++m_Stats.Misses;
+        return false;
+    }
+
+    CacheHeader header;
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!file || header.Magic != CACHE_MAGIC || header.Length == 0)
+    {
+        ++m_Stats.Rejected;
+        return false;
+    }
+
+    std::vector<char> binary(header.Length);
+    file.read(binary.data(), binary.size());
+    if (!file)
+    {
+        ++m_Stats.Rejected;
+        return false;
+    }
+
+    glProgramBinary(Program, (GLenum)header.Format, binary.data(), (GLsizei)binary.size());
+    GLint success = GL_FALSE;
+    glGetProgramiv(Program, GL_LINK_STATUS, &success);
+    if (!success)
+    {
+        // Driver update or corrupted file, caller compiles from sources and overwrites it
+        ++m_Stats.Rejected;
+        return false;
+    }
+
+    ++m_Stats.Hits;
+    return true;
+}
+
+void ShaderCache::Save(GLuint Program, uint64_t Key)
+{
+    GLint length = 0;
+    glGetProgramiv(Program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+    {
+        return;
+    }
+
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    glGetProgramBinary(Program, length, nullptr, &format, binary.data());
+
+    std::error_code error;
+    std::filesystem::create_directories(CACHE_DIRECTORY, error);
+    std::ofstream file(GetPath(Key), std::ios::binary | std::ios::trunc);
+    if (!file)
+    {
+        fprintf(stderr, "Failed to write shader cache %s\n", GetPath(Key).c_str());
+        return;
+    }
+
+    CacheHeader header = { CACHE_MAGIC, (uint32_t)format, (uint32_t)length };
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(binary.data(), binary.size());
+}
+
+void ShaderCache::Clear()
+{
+    std::error_code error;
+    std::filesystem::remove_all(CACHE_DIRECTORY, error);
+}
+
+void ShaderCache::AddBuildTime(double Milliseconds)
+{
+    m_Stats.BuildMs += Milliseconds;
+}
+
+const ShaderCacheStats& ShaderCache::GetStats()
+{
+    return m_Stats;
+}
+
+std::string ShaderCache::GetPath(uint64_t Key)
+{
+    char name[32];
+    snprintf(name, sizeof(name), "/%016llx.bin", (unsigned long long)Key);
+    return std::string(CACHE_DIRECTORY) + name;
+}
+
+const std::string& ShaderCache::GetDriverString()
+{
+    static const std::string driver = []()
+    {
+        std::string result;
+        for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION })
+        {
+            const GLubyte* value = glGetString(name);
+            result += value ? reinterpret_cast<const char*>(value) : "";
+            result += '\n';
+        }
+        return result;
+    }();
+    return driver;
+}
@@ -0,0 +1,81 @@
+#include "Public/ShaderPermutation.h"
+
+namespace
+{
+    struct FeatureName
+    {
+        ShaderFeature Feature;
+        const char* Name;
+    };
+
+    const FeatureName FEATURE_NAMES[] =
+    {
+        { ShaderFeature::SKINNING, "SKINNING" },
+        { ShaderFeature::SHADOWS, "SHADOWS" },
+        { ShaderFeature::REFRACTION, "REFRACTION" },
+        { ShaderFeature::BAKED_ANIMATION, "BAKED_ANIMATION" },
+    };
+}
+
+bool ShaderPermutation::Has(ShaderFeature Feature) const
+{
+    return (Features & uint32_t(Feature)) != 0U;
+}
+
+ShaderPermutation ShaderPermutation::With(ShaderFeature Feature, bool IsEnabled) const
+{
+    ShaderPermutation result = *this;
+    if (IsEnabled)
+    {
+        result.Features |= uint32_t(Feature);
+    }
+    else
+    {
+        result.Features &= ~uint32_t(Feature);
+    }
+    return result;
+}
+
+uint32_t ShaderPermutation::GetKey() const
+{
+    // Features fit in the low byte
+    return (Features & 0xFFU) | (uint32_t(PointLights) << 8) | (uint32_t(SpotLights) << 16) | (uint32_t(DirLights) << 24);
+}
+
+bool ShaderPermutation::SharesScene(const ShaderPermutation& Other) const
+{
+    return (GetKey() & ~OBJECT_FEATURES) == (Other.GetKey() & ~OBJECT_FEATURES);
+}
+
+std::string ShaderPermutation::GetDefines() const
+{
+    std::string defines;
+    for (const FeatureName& feature : FEATURE_NAMES)
+    {
+        if (Has(feature.Feature))
+        {
+            defines += "#define ";
+            defines += feature.Name;
+            defines += '\n';
+        }
+    }
+    defines += "#define POINT_LIGHTS_COUNT " + std::to_string(PointLights) + '\n';
+    defines += "#define SPOT_LIGHTS_COUNT " + std::to_string(SpotLights) + '\n';
+    defines += "#define DIR_LIGHTS_COUNT " + std::to_string(DirLights) + '\n';
+    return defines;
+}
+
+std::string ShaderPermutation::GetName() const
+{
+    std::string name;
+    for (const FeatureName& feature : FEATURE_NAMES)
+    {
+        if (Has(feature.Feature))
+        {
+            name += feature.Name;
+            name += ' ';
+        }
+    }
+    name += "P" + std::to_string(PointLights) + " S" + std::to_string(SpotLights) + " D" + std::to_string(DirLights);
+    return name;
+}
@@ -0,0 +1,88 @@
+#include "Public/ShaderPreprocessor.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
+bool ShaderPreprocessor::Process(const std::string& Path, const std::string& Defines, std::string& Source, std::vector<std::string>& Files)
+{
+    Source.clear();
+    Files.clear();
+    return Expand(std::filesystem::path(Path).lexically_normal(), Defines, Source, Files, 0);
+}
+
+bool ShaderPreprocessor::Expand(const std::filesystem::path& Path, const std::string& Defines, std::string& Source, std::vector<std::string>& Files, int Depth)
+{
+    if (Depth > MAX_INCLUDE_DEPTH)
+    {
+        fprintf(stderr, "ERROR::SHADER::INCLUDE_TOO_DEEP: %s\n", Path.generic_string().c_str());
+        return false;
+    }
+
+    std::ifstream file(Path);
+    if (!file)
+    {
+        fprintf(stderr, "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ: %s\n", Path.generic_string().c_str());
+        return false;
+    }
+
+    const int fileIndex = (int)Files.size();
+    Files.push_back(Path.generic_string());
+    if (Depth > 0)
+    {
+        Source += "#line 1 " + std::to_string(fileIndex) + '\n';
+    }
+
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line))
+    {
+        ++lineNumber;
+        size_t start = line.find_first_not_of(" \t");
+        if (start == std::string::npos || line[start] != '#')
+        {
+            Source += line;
+            Source += '\n';
+            continue;
+        }
+
+        if (line.compare(start, 8, "#version") == 0)
+        {
+            Source += line;
+            Source += '\n';
+            if (Depth == 0 && !Defines.empty())
+            {
+                Source += Defines;
+                Source += "#line " + std::to_string(lineNumber + 1) + ' ' + std::to_string(fileIndex) + '\n';
+            }
+            continue;
+        }
+
+        if (line.compare(start, 8, "#include") != 0)
+        {
+            Source += line;
+            Source += '\n';
+            continue;
+        }
+
+        size_t open = line.find('"', start);
+        size_t close = open == std::string::npos ? open : line.find('"', open + 1);
+        if (close == std::string::npos)
+        {
+            fprintf(stderr, "ERROR::SHADER::INVALID_INCLUDE: %s(%d)\n", Path.generic_string().c_str(), lineNumber);
+            return false;
+        }
+
+        // Relative to the including file, every file is pasted once per stage
+        std::filesystem::path include = (Path.parent_path() / line.substr(open + 1, close - open - 1)).lexically_normal();
+        if (std::find(Files.begin(), Files.end(), include.generic_string()) == Files.end())
+        {
+            if (!Expand(include, Defines, Source, Files, Depth + 1))
+            {
+                return false;
+            }
+        }
+        Source += "#line " + std::to_string(lineNumber + 1) + ' ' + std::to_string(fileIndex) + '\n';
+    }
+    return true;
+}
@@ -0,0 +1,58 @@
+#include "Public/ShaderVariants.h"
+
+#include "imgui.h"
+#include <cstdio>
+
+ShaderVariants::ShaderVariants(const char* VertexPath, const char* FragmentPath)
+    : m_VertexPath(VertexPath)
+    , m_FragmentPath(FragmentPath)
+{
+}
+
+void ShaderVariants::SetBase(const ShaderPermutation& Permutation)
+{
+    m_Base = Permutation;
+    // Object features are never part of the base
+    m_Base.Features &= ~ShaderPermutation::OBJECT_FEATURES;
+}
+
+const ShaderPermutation& ShaderVariants::GetBase() const
+{
+    return m_Base;
+}
+
+Shader& ShaderVariants::Get(const ShaderPermutation& Permutation)
+{
+    auto iter = m_Variants.find(Permutation.GetKey());
+    if (iter == m_Variants.end())
+    {
+        fprintf(stdout, "Compiling %s variant %s\n", m_FragmentPath.c_str(), Permutation.GetName().c_str());
+        Variant variant = { Permutation, std::make_unique<Shader>(m_VertexPath.c_str(), m_FragmentPath.c_str(), Permutation) };
+        if (m_LastUsed)
+        {
+            // Samplers and blocks are usually set once at startup
+            variant.Program->CopyState(*m_LastUsed);
+        }
+        iter = m_Variants.emplace(Permutation.GetKey(), std::move(variant)).first;
+    }
+    m_LastUsed = iter->second.Program.get();
+    return *m_LastUsed;
+}
+
+size_t ShaderVariants::GetCount() const
+{
+    return m_Variants.size();
+}
+
+void ShaderVariants::DrawGUI(const char* Name) const
+{
+    if (!ImGui::TreeNode(Name, "%s (%u variants)", Name, (unsigned int)m_Variants.size()))
+    {
+        return;
+    }
+    for (const auto& [key, variant] : m_Variants)
+    {
+        ImGui::Text("%s%s", variant.Permutation.GetName().c_str(), variant.Permutation.SharesScene(m_Base) ? " (active)" : "");
+    }
+    ImGui::TreePop();
+}
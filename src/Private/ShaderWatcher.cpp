@@ -0,0 +1,264 @@
+#include "Public/ShaderWatcher.h"
+
+#include "Public/Shader.h"
+
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+// KHR_parallel_shader_compile is not part of the generated loader
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+namespace
+{
+    typedef void (APIENTRY* PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)(GLuint Count);
+
+    // Seconds between modification time checks where inotify is not available
+    const double POLL_INTERVAL = 0.5;
+}
+
+ShaderWatcher& ShaderWatcher::GetInstance()
+{
+    // Never destroyed, shaders owned by static objects unregister after main returns
+    static ShaderWatcher* instance = new ShaderWatcher();
+    return *instance;
+}
+
+ShaderWatcher::ShaderWatcher()
+{
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; ++i)
+    {
+        const char* name = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, (GLuint)i));
+        if (name && (strcmp(name, "GL_KHR_parallel_shader_compile") == 0 || strcmp(name, "GL_ARB_parallel_shader_compile") == 0))
+        {
+            m_HasParallelCompile = true;
+            break;
+        }
+    }
+
+    if (m_HasParallelCompile)
+    {
+        auto maxThreads = reinterpret_cast<PFNGLMAXSHADERCOMPILERTHREADSKHRPROC>(glfwGetProcAddress("glMaxShaderCompilerThreadsKHR"));
+        if (!maxThreads)
+        {
+            maxThreads = reinterpret_cast<PFNGLMAXSHADERCOMPILERTHREADSKHRPROC>(glfwGetProcAddress("glMaxShaderCompilerThreadsARB"));
+        }
+        if (maxThreads)
+        {
+            // Let the driver pick the thread count
+            maxThreads(0xFFFFFFFFu);
+        }
+    }
+
+#ifdef __linux__
+    m_Inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_Inotify < 0)
+    {
+        fprintf(stderr, "Failed to initialize inotify, shader hot reload disabled\n");
+    }
+#endif
+}
+
+void ShaderWatcher::Add(Shader* Shader)
+{
+    for (const std::string& file : Shader->GetFiles())
+    {
+        std::string path = Normalize(file);
+        std::vector<::Shader*>& shaders = m_Files[path];
+        if (std::find(shaders.begin(), shaders.end(), Shader) == shaders.end())
+        {
+            shaders.push_back(Shader);
+        }
+        WatchFile(path);
+    }
+}
+
+void ShaderWatcher::Remove(Shader* Shader)
+{
+    for (auto& [path, shaders] : m_Files)
+    {
+        shaders.erase(std::remove(shaders.begin(), shaders.end(), Shader), shaders.end());
+    }
+    m_Pending.erase(std::remove(m_Pending.begin(), m_Pending.end(), Shader), m_Pending.end());
+    m_Stats.Pending = (uint32_t)m_Pending.size();
+}
+
+void ShaderWatcher::Update()
+{
+    // Drained even when disabled so enabling it later does not replay old edits
+    std::vector<std::string> changes = PollChanges();
+    if (IsEnabled)
+    {
+        for (const std::string& path : changes)
+        {
+            auto iter = m_Files.find(path);
+            if (iter == m_Files.end())
+            {
+                continue;
+            }
+
+            fprintf(stdout, "Shader source changed: %s\n", path.c_str());
+            for (Shader* shader : iter->second)
+            {
+                shader->Reload();
+                if (std::find(m_Pending.begin(), m_Pending.end(), shader) == m_Pending.end())
+                {
+                    m_Pending.push_back(shader);
+                }
+            }
+        }
+    }
+
+    for (size_t i = 0; i < m_Pending.size();)
+    {
+        ShaderReloadResult result = m_Pending[i]->UpdateReload();
+        if (result == ShaderReloadResult::PENDING)
+        {
+            ++i;
+            continue;
+        }
+
+        if (result == ShaderReloadResult::SWAPPED)
+        {
+            ++m_Stats.Reloads;
+        }
+        else if (result == ShaderReloadResult::FAILED)
+        {
+            ++m_Stats.Failures;
+        }
+        m_Pending[i] = m_Pending.back();
+        m_Pending.pop_back();
+    }
+    m_Stats.Pending = (uint32_t)m_Pending.size();
+}
+
+bool ShaderWatcher::HasParallelCompile() const
+{
+    return m_HasParallelCompile;
+}
+
+bool ShaderWatcher::IsLinkComplete(GLuint Program) const
+{
+    if (!m_HasParallelCompile)
+    {
+        return true;
+    }
+    GLint complete = GL_TRUE;
+    glGetProgramiv(Program, GL_COMPLETION_STATUS_KHR, &complete);
+    return complete == GL_TRUE;
+}
+
+const ShaderWatcherStats& ShaderWatcher::GetStats() const
+{
+    return m_Stats;
+}
+
+std::vector<std::string> ShaderWatcher::PollChanges()
+{
+    std::vector<std::string> changes;
+    auto addChange = [&changes](std::string&& Path)
+    {
+        if (std::find(changes.begin(), changes.end(), Path) == changes.end())
+        {
+            changes.push_back(std::move(Path));
+        }
+    };
+
+#ifdef __linux__
+    if (m_Inotify < 0)
+    {
+        return changes;
+    }
+
+    alignas(inotify_event) char buffer[4096];
+    ssize_t length;
+    while ((length = read(m_Inotify, buffer, sizeof(buffer))) > 0)
+    {
+        for (char* pointer = buffer; pointer < buffer + length;)
+        {
+            const inotify_event* event = reinterpret_cast<const inotify_event*>(pointer);
+            pointer += sizeof(inotify_event) + event->len;
+
+            auto directory = m_Directories.find(event->wd);
+            if (event->len == 0 || directory == m_Directories.end())
+            {
+                continue;
+            }
+            addChange(Normalize(directory->second + '/' + event->name));
+        }
+    }
+#else
+    double time = glfwGetTime();
+    if (time - m_LastPoll < POLL_INTERVAL)
+    {
+        return changes;
+    }
+    m_LastPoll = time;
+
+    for (auto& [path, writeTime] : m_WriteTimes)
+    {
+        std::error_code error;
+        std::filesystem::file_time_type current = std::filesystem::last_write_time(path, error);
+        if (!error && current != writeTime)
+        {
+            writeTime = current;
+            addChange(std::string(path));
+        }
+    }
+#endif
+
+    return changes;
+}
+
+void ShaderWatcher::WatchFile(const std::string& Path)
+{
+#ifdef __linux__
+    if (m_Inotify < 0)
+    {
+        return;
+    }
+
+    std::string directory = std::filesystem::path(Path).parent_path().generic_string();
+    if (directory.empty())
+    {
+        directory = ".";
+    }
+    for (const auto& [descriptor, watched] : m_Directories)
+    {
+        if (watched == directory)
+        {
+            return;
+        }
+    }
+
+    // Editors often save through a temporary file renamed over the original
+    int descriptor = inotify_add_watch(m_Inotify, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+    if (descriptor < 0)
+    {
+        fprintf(stderr, "Failed to watch shader directory %s\n", directory.c_str());
+        return;
+    }
+    m_Directories[descriptor] = directory;
+#else
+    if (m_WriteTimes.find(Path) == m_WriteTimes.end())
+    {
+        std::error_code error;
+        m_WriteTimes[Path] = std::filesystem::last_write_time(Path, error);
+    }
+#endif
+}
+
+std::string ShaderWatcher::Normalize(const std::string& Path)
+{
+    return std::filesystem::path(Path).lexically_normal().generic_string();
+}
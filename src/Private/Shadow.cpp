@@ -5,6 +5,8 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 #include "Public/Entity.h"
+#include "Public/GPUResourceTracker.h"
+#include "Public/GLState.h"
 
 Shadow::Shadow(int Width, int Height, float Near, float Far)
 	: WIDTH(Width)
@@ -13,12 +15,13 @@ Shadow::Shadow(int Width, int Height, float Near, float Far)
     , m_Far(Far)
 {
     m_Projection = glm::ortho(-50.0f, 50.0f, -50.0f, 50.0f, m_Near, m_Far);
-    glGenFramebuffers(1, &m_FBO);
-    glBindFramebuffer(GL_FRAMEBUFFER, m_FBO);
+    GPUResourceTracker::GetInstance().GenFramebuffers(1, &m_FBO, GPUResourceOwner::SHADOW);
+    GLState::BindFramebuffer(GL_FRAMEBUFFER, m_FBO);
 
-    glGenTextures(1, &m_MAP);
-    glBindTexture(GL_TEXTURE_2D, m_MAP);
+    GPUResourceTracker::GetInstance().GenTextures(1, &m_MAP, GPUResourceOwner::SHADOW);
+    GLState::BindTexture(GL_TEXTURE_2D, m_MAP);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, WIDTH, HEIGHT, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+    GPUResourceTracker::GetInstance().SetTextureSize(m_MAP, GL_DEPTH_COMPONENT, WIDTH, HEIGHT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
@@ -33,19 +36,19 @@ Shadow::Shadow(int Width, int Height, float Near, float Far)
     glReadBuffer(GL_NONE);
 
     // Bind defaults
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    GLState::BindFramebuffer(GL_FRAMEBUFFER, 0);
+    GLState::BindTexture(GL_TEXTURE_2D, 0);
 }
 
 Shadow::~Shadow()
 {
-    glDeleteFramebuffers(1, &m_FBO);
-    glDeleteTextures(1, &m_MAP);
+    GPUResourceTracker::GetInstance().DeleteFramebuffers(1, &m_FBO);
+    GPUResourceTracker::GetInstance().DeleteTextures(1, &m_MAP);
 }
 
 void Shadow::SetupMap(Shader& Shader, DirectionalLight& Light, Entity& Root)
 {
-    glEnable(GL_DEPTH_TEST);
+    GLState::Enable(GL_DEPTH_TEST);
     glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
@@ -56,13 +59,24 @@ void Shadow::SetupMap(Shader& Shader, DirectionalLight& Light, Entity& Root)
     Shader.Use();
     Shader.setMat4("lightSpaceMatrix", m_LightSpace);
 
-    glViewport(0, 0, WIDTH, HEIGHT);
-    glBindFramebuffer(GL_FRAMEBUFFER, m_FBO);
+    GLState::Viewport(0, 0, WIDTH, HEIGHT);
+    GLState::BindFramebuffer(GL_FRAMEBUFFER, m_FBO);
     glClear(GL_DEPTH_BUFFER_BIT);
 
     Root.DrawSelfAndChildren(Shader);
 
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    GLState::BindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void Shadow::DrawToMap(const std::function<void()>& Draw)
+{
+    GLState::Enable(GL_DEPTH_TEST);
+    GLState::Viewport(0, 0, WIDTH, HEIGHT);
+    GLState::BindFramebuffer(GL_FRAMEBUFFER, m_FBO);
+
+    Draw();
+
+    GLState::BindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
 void Shadow::BindShadowMap(unsigned int Number)
@@ -74,9 +88,7 @@ void Shadow::BindShadowMap(unsigned int Number)
     }
     else
     {
-        glActiveTexture(GL_TEXTURE0 + Number);
-        glBindTexture(GL_TEXTURE_2D, m_MAP);
-        glActiveTexture(GL_TEXTURE0);
+        GLState::BindTexture(Number, GL_TEXTURE_2D, m_MAP);
     }
 }
 
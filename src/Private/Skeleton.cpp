@@ -0,0 +1,95 @@
+#include "Public/Skeleton.h"
+#include "Public/Animation.h"
+#include "Public/SkinnedModel.h"
+
+#include <algorithm>
+
+Skeleton::Skeleton(const Animation& Clip, SkinnedModel& Model)
+	: m_Clip(&Clip)
+{
+	AddJoint(Clip.GetRootNode(), -1, Clip, Model);
+
+	// Children come after their parent, walking backwards finishes every subtree before its root
+	for (size_t i = m_Joints.size(); i-- > 0;)
+	{
+		const SkeletonJoint& joint = m_Joints[i];
+		if (joint.Parent >= 0)
+		{
+			uint32_t& parentDistance = m_Joints[joint.Parent].LeafDistance;
+			parentDistance = std::max(parentDistance, joint.LeafDistance + 1);
+		}
+		m_ChannelCount += joint.Channel >= 0 ? 1 : 0;
+	}
+}
+
+const std::vector<SkeletonJoint>& Skeleton::GetJoints() const
+{
+	return m_Joints;
+}
+
+uint32_t Skeleton::GetJointCount() const
+{
+	return m_Joints.size();
+}
+
+uint32_t Skeleton::GetPaletteSize() const
+{
+	return m_PaletteSize;
+}
+
+uint32_t Skeleton::GetChannelCount() const
+{
+	return m_ChannelCount;
+}
+
+int32_t Skeleton::FindJoint(const std::string& Name) const
+{
+	auto iter = std::find(m_Names.begin(), m_Names.end(), Name);
+	return iter == m_Names.end() ? -1 : int32_t(iter - m_Names.begin());
+}
+
+const Animation* Skeleton::GetClip() const
+{
+	return m_Clip;
+}
+
+size_t Skeleton::GetMemorySize() const
+{
+	size_t size = sizeof(Skeleton) + m_Joints.capacity() * sizeof(SkeletonJoint) + m_Names.capacity() * sizeof(std::string);
+	for (const std::string& name : m_Names)
+	{
+		size += name.capacity();
+	}
+	return size;
+}
+
+void Skeleton::AddJoint(const AssimpNodeData& Node, int32_t Parent, const Animation& Clip, SkinnedModel& Model)
+{
+	SkeletonJoint joint;
+	joint.Parent = Parent;
+	joint.BoneID = -1;
+	joint.Channel = Clip.FindBoneIndex(Node.name);
+	joint.LeafDistance = 0;
+	joint.BindLocal = glm::translate(glm::mat4(1.0f), Node.position) * glm::toMat4(Node.rotation);
+	joint.BindPosition = Node.position;
+	joint.BindRotation = glm::normalize(Node.rotation);
+	joint.Offset = glm::mat4(1.0f);
+
+	auto& boneInfoMap = Model.GetBoneInfoMap();
+	auto iter = boneInfoMap.find(Node.name);
+	if (iter != boneInfoMap.end())
+	{
+		joint.BoneID = iter->second.ID;
+		joint.Offset = glm::translate(glm::mat4(1.0f), iter->second.Position) * glm::toMat4(iter->second.Rotation);
+		m_PaletteSize = std::max(m_PaletteSize, uint32_t(joint.BoneID + 1));
+	}
+
+	int32_t index = m_Joints.size();
+	m_Joints.push_back(joint);
+	m_Names.push_back(Node.name);
+
+	for (const AssimpNodeData& child : Node.children)
+	{
+		AddJoint(child, index, Clip, Model);
+	}
+}
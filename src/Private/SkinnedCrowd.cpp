@@ -0,0 +1,356 @@
+#include "Public/SkinnedCrowd.h"
+#include "Public/Animation.h"
+#include "Public/AnimationLibrary.h"
+#include "Public/Animator.h"
+#include "Public/CompressedClip.h"
+#include "Public/FrameRingBuffer.h"
+#include "Public/Frustum.h"
+#include "Public/GLState.h"
+#include "Public/GPUResourceTracker.h"
+#include "Public/Mesh.h"
+#include "Public/Shader.h"
+#include "Public/Skeleton.h"
+#include "Public/SkinnedModel.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cstdio>
+
+namespace
+{
+	// local_size_x of Skinning.comp
+	const uint32_t SKINNING_GROUP_SIZE = 64;
+	// Bind pose bounds grow by this much to hold the animated poses
+	const float BOUNDS_MARGIN = 1.25f;
+
+	// Layout glMultiDrawElementsIndirect reads
+	struct DrawElementsCommand
+	{
+		uint32_t Count;
+		uint32_t InstanceCount;
+		uint32_t FirstIndex;
+		int32_t BaseVertex;
+		uint32_t BaseInstance;
+	};
+}
+
+SkinnedCrowd::SkinnedCrowd(SkinnedModel& Model, std::shared_ptr<const Animation> Clip)
+	: m_Model(Model)
+	, m_Clip(std::move(Clip))
+	, m_Skeleton(AnimationLibrary::GetInstance().GetSkeleton(m_Clip, Model))
+{
+	glm::vec3 min(FLT_MAX);
+	glm::vec3 max(-FLT_MAX);
+	for (uint32_t mesh = 0; mesh < m_Model.GetMeshCount(); ++mesh)
+	{
+		for (const SkinnedVertex& vertex : m_Model.GetMesh(mesh).Vertexes)
+		{
+			min = glm::min(min, vertex.Position);
+			max = glm::max(max, vertex.Position);
+		}
+	}
+	if (min.x <= max.x)
+	{
+		m_BoundsCenter = (min + max) * 0.5f;
+		m_BoundsRadius = glm::length(max - min) * 0.5f * BOUNDS_MARGIN;
+	}
+}
+
+SkinnedCrowd::~SkinnedCrowd()
+{
+	ReleasePreSkinnedMeshes();
+}
+
+void SkinnedCrowd::Add(const glm::mat4& Transform, float TimeOffset)
+{
+	m_Animators.push_back(std::make_unique<Animator>(m_Clip.get()));
+	Animator& animator = *m_Animators.back();
+	animator.SetSkeleton(m_Skeleton.get());
+	animator.UpdateAnimation(TimeOffset);
+	m_Transforms.push_back(Transform);
+	m_System.Add(&animator);
+}
+
+void SkinnedCrowd::SetTransform(uint32_t Index, const glm::mat4& Transform)
+{
+	m_Transforms[Index] = Transform;
+}
+
+void SkinnedCrowd::SetPreSkinned(bool IsPreSkinned)
+{
+	m_IsPreSkinned = IsPreSkinned;
+	if (!m_IsPreSkinned)
+	{
+		ReleasePreSkinnedMeshes();
+	}
+}
+
+bool SkinnedCrowd::IsPreSkinned() const
+{
+	return m_IsPreSkinned;
+}
+
+void SkinnedCrowd::SetView(const glm::mat4& View, const glm::mat4& Projection)
+{
+	m_View = View;
+	m_Projection = Projection;
+	m_HasView = true;
+}
+
+void SkinnedCrowd::SetLodSettings(const AnimationLodSettings& Settings)
+{
+	m_LodSettings = Settings;
+}
+
+void SkinnedCrowd::SetGPUEvaluation(bool IsGPUEvaluation)
+{
+	m_IsGPUEvaluation = IsGPUEvaluation;
+}
+
+bool SkinnedCrowd::IsGPUEvaluation() const
+{
+	return m_IsGPUEvaluation;
+}
+
+void SkinnedCrowd::Update(float DeltaTime)
+{
+	m_System.EndUpdate();
+	if (m_IsGPUEvaluation)
+	{
+		for (const std::unique_ptr<Animator>& animator : m_Animators)
+		{
+			animator->AdvanceTime(DeltaTime);
+		}
+		return;
+	}
+	if (m_HasView)
+	{
+		UpdateLod();
+	}
+	m_System.BeginUpdate(DeltaTime);
+}
+
+void SkinnedCrowd::UpdateLod()
+{
+	const Frustum frustum = Frustum::FromViewProjection(m_Projection * m_View);
+
+	for (uint32_t i = 0; i < GetCount(); ++i)
+	{
+		const glm::mat4& transform = m_Transforms[i];
+		const glm::vec3 center = glm::vec3(transform * glm::vec4(m_BoundsCenter, 1.0f));
+		const float scale = std::max({ glm::length(glm::vec3(transform[0])), glm::length(glm::vec3(transform[1])), glm::length(glm::vec3(transform[2])) });
+		const float radius = m_BoundsRadius * scale;
+
+		const bool isVisible = frustum.IsSphereVisible(center, radius);
+
+		// Projected diameter over the screen height, clamped once the camera is inside the bounds
+		const float depth = -(m_View * glm::vec4(center, 1.0f)).z;
+		const float screenSize = radius * m_Projection[1][1] / std::max(depth, radius);
+		m_System.SetLod(i, AnimationSystem::SelectLod(screenSize, isVisible, m_LodSettings));
+	}
+}
+
+void SkinnedCrowd::Prepare(Shader& SkinningShader, Shader& EvaluationShader)
+{
+	if (m_Animators.empty())
+	{
+		return;
+	}
+
+	FrameRingBuffer& frame = FrameRingBuffer::GetInstance();
+	const size_t boneCount = m_IsGPUEvaluation ? size_t(GetCount()) * m_Skeleton->GetPaletteSize() : m_System.GetPalettes().size();
+	if (frame.GetObjectCount() + GetCount() > FrameRingBuffer::MAX_OBJECTS || frame.GetBoneCount() + boneCount > FrameRingBuffer::MAX_BONES)
+	{
+		fprintf(stderr, "ERROR::SKINNED_CROWD::%u characters do not fit in the frame buffers\n", GetCount());
+		return;
+	}
+
+	m_FirstObject = frame.GetObjectCount();
+	if (m_IsGPUEvaluation)
+	{
+		const uint32_t firstBone = EvaluateOnGPU(EvaluationShader);
+		for (uint32_t i = 0; i < GetCount(); ++i)
+		{
+			frame.PushObject(m_Transforms[i], 0u, firstBone + i * m_Skeleton->GetPaletteSize());
+		}
+		// Skinning reads the palettes as storage buffer in the vertex shaders and in the pre-skinning pass
+		glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+	}
+	else
+	{
+		// Front palettes are complete while the next update writes the back ones
+		const std::vector<glm::mat4>& palettes = m_System.GetPalettes();
+		const uint32_t firstBone = frame.PushPalette(palettes.data(), palettes.size());
+		for (uint32_t i = 0; i < GetCount(); ++i)
+		{
+			frame.PushObject(m_Transforms[i], 0u, firstBone + m_System.GetPaletteOffset(i));
+		}
+	}
+	m_PreparedFrame = frame.GetFrameNumber();
+
+	if (!m_IsPreSkinned)
+	{
+		return;
+	}
+	if (m_PreSkinnedCapacity < GetCount())
+	{
+		CreatePreSkinnedMeshes();
+	}
+
+	std::vector<DrawElementsCommand> commands(GetCount());
+	SkinningShader.Use();
+	SkinningShader.setInt("firstObject", m_FirstObject);
+	for (uint32_t mesh = 0; mesh < m_PreSkinnedMeshes.size(); ++mesh)
+	{
+		const PreSkinnedMesh& output = m_PreSkinnedMeshes[mesh];
+		SkinningShader.setInt("vertexCount", output.VertexCount);
+		GLState::BindBufferBase(GL_SHADER_STORAGE_BUFFER, SKINNED_VERTICES_BINDING, m_Model.GetMesh(mesh).GetVBO());
+		GLState::BindBufferBase(GL_SHADER_STORAGE_BUFFER, VERTICES_BINDING, output.VBO);
+		// One row of groups per character
+		glDispatchCompute((output.VertexCount + SKINNING_GROUP_SIZE - 1) / SKINNING_GROUP_SIZE, GetCount(), 1);
+
+		// Copy i starts at vertex i * VertexCount and reads the object of character i
+		for (uint32_t i = 0; i < GetCount(); ++i)
+		{
+			commands[i] = { output.IndexCount, 1u, 0u, int32_t(i * output.VertexCount), m_FirstObject + i };
+		}
+		GLState::BindBuffer(GL_DRAW_INDIRECT_BUFFER, output.IndirectBuffer);
+		glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, commands.size() * sizeof(DrawElementsCommand), commands.data());
+	}
+	// One barrier covers every pass drawing the results this frame
+	glMemoryBarrier(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+}
+
+void SkinnedCrowd::Draw(Shader& Shader)
+{
+	if (m_Animators.empty())
+	{
+		return;
+	}
+	if (m_PreparedFrame != FrameRingBuffer::GetInstance().GetFrameNumber())
+	{
+		fprintf(stderr, "ERROR::SKINNED_CROWD::Draw called before Prepare in this frame\n");
+		return;
+	}
+
+	if (!m_IsPreSkinned)
+	{
+		m_Model.DrawInstanced(Shader, m_FirstObject, GetCount());
+		return;
+	}
+
+	Shader.Use();
+	for (uint32_t mesh = 0; mesh < m_PreSkinnedMeshes.size(); ++mesh)
+	{
+		const PreSkinnedMesh& output = m_PreSkinnedMeshes[mesh];
+		m_Model.GetMesh(mesh).BindMaterial(Shader);
+		GLState::BindVertexArray(output.VAO);
+		GLState::BindBuffer(GL_DRAW_INDIRECT_BUFFER, output.IndirectBuffer);
+		glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, GetCount(), 0);
+	}
+}
+
+uint32_t SkinnedCrowd::GetCount() const
+{
+	return m_Animators.size();
+}
+
+size_t SkinnedCrowd::GetPreSkinnedSize() const
+{
+	size_t size = 0;
+	for (const PreSkinnedMesh& output : m_PreSkinnedMeshes)
+	{
+		size += size_t(output.VertexCount) * m_PreSkinnedCapacity * sizeof(Vertex);
+	}
+	return size;
+}
+
+AnimationSystem& SkinnedCrowd::GetAnimationSystem()
+{
+	return m_System;
+}
+
+uint32_t SkinnedCrowd::EvaluateOnGPU(Shader& EvaluationShader)
+{
+	if (!m_Evaluator)
+	{
+		m_CompressedClip = std::make_unique<CompressedClip>(*m_Clip);
+		m_Evaluator = std::make_unique<GPUClipEvaluator>();
+		m_Evaluator->AddClip(*m_CompressedClip, *m_Skeleton);
+	}
+
+	const uint32_t paletteSize = m_Skeleton->GetPaletteSize();
+	const uint32_t firstBone = FrameRingBuffer::GetInstance().ReserveBones(GetCount() * paletteSize);
+	m_GPUInstances.resize(GetCount());
+	for (uint32_t i = 0; i < GetCount(); ++i)
+	{
+		m_GPUInstances[i] = { 0, m_Animators[i]->GetCurrentTime(), firstBone + i * paletteSize, 0 };
+	}
+	if (m_Evaluator->GetClipCount() > 0)
+	{
+		m_Evaluator->Dispatch(EvaluationShader, m_GPUInstances);
+	}
+	return firstBone;
+}
+
+void SkinnedCrowd::CreatePreSkinnedMeshes()
+{
+	ReleasePreSkinnedMeshes();
+
+	GPUResourceTracker& tracker = GPUResourceTracker::GetInstance();
+	m_PreSkinnedCapacity = GetCount();
+	m_PreSkinnedMeshes.resize(m_Model.GetMeshCount());
+	for (uint32_t mesh = 0; mesh < m_PreSkinnedMeshes.size(); ++mesh)
+	{
+		SkinnedMesh& source = m_Model.GetMesh(mesh);
+		PreSkinnedMesh& output = m_PreSkinnedMeshes[mesh];
+		output.VertexCount = source.Vertexes.size();
+		output.IndexCount = source.Indexes.size();
+
+		tracker.GenVertexArrays(1, &output.VAO, GPUResourceOwner::MESH);
+		tracker.GenBuffers(1, &output.VBO, GPUResourceOwner::MESH);
+		tracker.GenBuffers(1, &output.IndirectBuffer, GPUResourceOwner::MESH);
+
+		GLState::BindVertexArray(output.VAO);
+		GLState::BindBuffer(GL_ARRAY_BUFFER, output.VBO);
+		const GLsizeiptr size = GLsizeiptr(output.VertexCount) * m_PreSkinnedCapacity * sizeof(Vertex);
+		// Written by the skinning pass only
+		glBufferData(GL_ARRAY_BUFFER, size, nullptr, GL_DYNAMIC_COPY);
+		tracker.SetBufferSize(output.VBO, size);
+
+		// The copies share the indices of the source mesh, draws offset them with their base vertex
+		GLState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, source.GetEBO());
+
+		// Position attribute
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+		// Normal attribute
+		glEnableVertexAttribArray(1);
+		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
+		// Texture position attribute
+		glEnableVertexAttribArray(2);
+		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
+
+		GLState::BindVertexArray(0);
+		GLState::BindBuffer(GL_ARRAY_BUFFER, 0);
+		GLState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+		GLState::BindBuffer(GL_DRAW_INDIRECT_BUFFER, output.IndirectBuffer);
+		const GLsizeiptr commandsSize = GLsizeiptr(m_PreSkinnedCapacity) * sizeof(DrawElementsCommand);
+		glBufferData(GL_DRAW_INDIRECT_BUFFER, commandsSize, nullptr, GL_DYNAMIC_DRAW);
+		tracker.SetBufferSize(output.IndirectBuffer, commandsSize);
+	}
+}
+
+void SkinnedCrowd::ReleasePreSkinnedMeshes()
+{
+	GPUResourceTracker& tracker = GPUResourceTracker::GetInstance();
+	for (PreSkinnedMesh& output : m_PreSkinnedMeshes)
+	{
+		tracker.DeleteVertexArrays(1, &output.VAO);
+		tracker.DeleteBuffers(1, &output.VBO);
+		tracker.DeleteBuffers(1, &output.IndirectBuffer);
+	}
+	m_PreSkinnedMeshes.clear();
+	m_PreSkinnedCapacity = 0;
+}
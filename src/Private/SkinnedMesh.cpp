@@ -1,14 +1,28 @@
 #include "Public/SkinnedMesh.h"
 #include "Public/Shader.h"
+#include "Public/GPUResourceTracker.h"
+#include "Public/FrameRingBuffer.h"
+#include "Public/GLState.h"
 
+#include <algorithm>
+#include <cstdio>
 
-SkinnedMesh::SkinnedMesh(std::vector<SkinnedVertex> vertexes, std::vector<uint32_t> indexes, std::vector<Texture> textures)
+namespace
+{
+    // local_size_x of Morph.comp
+    const uint32_t MORPH_GROUP_SIZE = 64;
+}
+
+SkinnedMesh::SkinnedMesh(std::vector<SkinnedVertex> vertexes, std::vector<uint32_t> indexes, std::vector<Texture> textures,
+    std::vector<MorphTarget> morphTargets, std::vector<MorphDelta> morphDeltas)
     : m_VBO(0)
     , m_VAO(0)
     , m_EBO(0)
     , Vertexes(vertexes)
     , Indexes(indexes)
     , Textures(textures)
+    , m_MorphTargets(std::move(morphTargets))
+    , m_MorphDeltas(std::move(morphDeltas))
 {
     if (DefaultTextures.empty())
     {
@@ -33,9 +47,11 @@ SkinnedMesh::SkinnedMesh(std::vector<SkinnedVertex> vertexes, std::vector<uint32
         for (int i = 0; i < DefaultTextures.size(); ++i)
         {
             DefaultTextures[i].BindTexture(31 - i);
+            GPUResourceTracker::GetInstance().SetPersistent(GPUResourceType::TEXTURE, DefaultTextures[i].GetId());
         }
     }
     SetupMesh();
+    SetupMorphs();
 }
 
 SkinnedMesh::SkinnedMesh(const SkinnedMesh& Other)
@@ -45,10 +61,17 @@ SkinnedMesh::SkinnedMesh(const SkinnedMesh& Other)
     , Vertexes(Other.Vertexes)
     , Indexes(Other.Indexes)
     , Textures(Other.Textures)
+    , m_MorphBaseVBO(Other.m_MorphBaseVBO)
+    , m_MorphDeltaBuffer(Other.m_MorphDeltaBuffer)
+    , m_MorphTargets(Other.m_MorphTargets)
+    , m_MorphDeltas(Other.m_MorphDeltas)
+    , m_IsMorphDirty(Other.m_IsMorphDirty)
 {
     const_cast<SkinnedMesh&>(Other).m_VBO = 0;
     const_cast<SkinnedMesh&>(Other).m_VAO = 0;
     const_cast<SkinnedMesh&>(Other).m_EBO = 0;
+    const_cast<SkinnedMesh&>(Other).m_MorphBaseVBO = 0;
+    const_cast<SkinnedMesh&>(Other).m_MorphDeltaBuffer = 0;
 }
 
 SkinnedMesh::SkinnedMesh(SkinnedMesh&& Other) noexcept
@@ -58,20 +81,33 @@ SkinnedMesh::SkinnedMesh(SkinnedMesh&& Other) noexcept
     , Vertexes(Other.Vertexes)
     , Indexes(Other.Indexes)
     , Textures(Other.Textures)
+    , m_MorphBaseVBO(Other.m_MorphBaseVBO)
+    , m_MorphDeltaBuffer(Other.m_MorphDeltaBuffer)
+    , m_MorphTargets(std::move(Other.m_MorphTargets))
+    , m_MorphDeltas(std::move(Other.m_MorphDeltas))
+    , m_IsMorphDirty(Other.m_IsMorphDirty)
 {
     Other.m_VBO = 0;
     Other.m_VAO = 0;
     Other.m_EBO = 0;
+    Other.m_MorphBaseVBO = 0;
+    Other.m_MorphDeltaBuffer = 0;
 }
 
 SkinnedMesh::~SkinnedMesh()
 {
-    glDeleteBuffers(1, &m_VBO);
+    GPUResourceTracker::GetInstance().DeleteBuffers(1, &m_VBO);
     m_VBO = 0;
-    glDeleteBuffers(1, &m_EBO);
+    GPUResourceTracker::GetInstance().DeleteBuffers(1, &m_EBO);
     m_EBO = 0;
-    glDeleteVertexArrays(1, &m_VAO);
+    GPUResourceTracker::GetInstance().DeleteVertexArrays(1, &m_VAO);
     m_VAO = 0;
+    GPUResourceTracker::GetInstance().DeleteBuffers(1, &m_MorphBaseVBO);
+    m_MorphBaseVBO = 0;
+    GPUResourceTracker::GetInstance().DeleteBuffers(1, &m_MorphDeltaBuffer);
+    m_MorphDeltaBuffer = 0;
+    m_MorphTargets.clear();
+    m_MorphDeltas.clear();
     Vertexes.clear();
     Indexes.clear();
     Textures.clear();
@@ -86,10 +122,15 @@ SkinnedMesh& SkinnedMesh::operator=(const SkinnedMesh& Other)
         std::swap(m_VBO, const_cast<SkinnedMesh&>(Other).m_VBO);
         std::swap(m_VAO, const_cast<SkinnedMesh&>(Other).m_VAO);
         std::swap(m_EBO, const_cast<SkinnedMesh&>(Other).m_EBO);
+        std::swap(m_MorphBaseVBO, const_cast<SkinnedMesh&>(Other).m_MorphBaseVBO);
+        std::swap(m_MorphDeltaBuffer, const_cast<SkinnedMesh&>(Other).m_MorphDeltaBuffer);
 
         Vertexes = Other.Vertexes;
         Indexes = Other.Indexes;
         Textures = Other.Textures;
+        m_MorphTargets = Other.m_MorphTargets;
+        m_MorphDeltas = Other.m_MorphDeltas;
+        m_IsMorphDirty = Other.m_IsMorphDirty;
     }
     return *this;
 }
@@ -103,112 +144,67 @@ SkinnedMesh& SkinnedMesh::operator=(SkinnedMesh&& Other) noexcept
         std::swap(m_VBO, Other.m_VBO);
         std::swap(m_VAO, Other.m_VAO);
         std::swap(m_EBO, Other.m_EBO);
+        std::swap(m_MorphBaseVBO, Other.m_MorphBaseVBO);
+        std::swap(m_MorphDeltaBuffer, Other.m_MorphDeltaBuffer);
 
         Vertexes = Other.Vertexes;
         Indexes = Other.Indexes;
         Textures = Other.Textures;
+        m_MorphTargets = std::move(Other.m_MorphTargets);
+        m_MorphDeltas = std::move(Other.m_MorphDeltas);
+        m_IsMorphDirty = Other.m_IsMorphDirty;
     }
     return *this;
 }
 
 void SkinnedMesh::Draw(Shader& Shader, uint32_t Amount)
 {
-    ResetTextures(Shader);
-    uint32_t textureNrs[(int32_t)TextureType::TYPESCOUNT];
-    std::fill(textureNrs, textureNrs + (int32_t)TextureType::TYPESCOUNT, 0U);
-    std::string number;
-    TextureType type;
-    std::string name;
-    ResetTextures(Shader);
-    for (uint32_t i = 0; i < Textures.size(); ++i)
-    {
-        Textures[i].BindTexture(i);
-        type = Textures[i].GetType();
+    BindMaterial(Shader);
 
-        number = std::to_string(textureNrs[(int32_t)type]++);
+    GLState::BindVertexArray(m_VAO);
+    // Instance i reads its object data at gl_BaseInstance + i, instanced characters push consecutive objects
+    glDrawElementsInstancedBaseInstance(GL_TRIANGLES, Indexes.size(), GL_UNSIGNED_INT, 0, Amount, FrameRingBuffer::GetInstance().GetCurrentObject());
+    // The vertex array stays bound, consecutive draws of the same mesh skip the rebind
+}
 
-        switch (type)
-        {
-        case TextureType::ALBEDO:
-        {
-            name = "albedo";
-            break;
-        }
-        case TextureType::NORMAL:
-        {
-            name = "normal";
-            break;
-        }
-        case TextureType::EMISSION:
-        {
-            name = "emission";
-            break;
-        }
-        case TextureType::METALNESS:
-        {
-            name = "metalness";
-            break;
-        }
-        case TextureType::ROUGHNESS:
-        {
-            name = "roughness";
-            break;
-        }
-        case TextureType::AMBIENTOCCLUSION:
+void SkinnedMesh::BindMaterial(Shader& Shader)
+{
+    // Units and sampler values never change, so the sampler uniforms are uploaded once per program
+    const uint32_t slots = (uint32_t)TextureType::TYPESCOUNT - 1;
+    Texture* maps[slots] = {};
+    for (Texture& texture : Textures)
+    {
+        TextureType type = texture.GetType();
+        if (type != TextureType::NONE && type < TextureType::TYPESCOUNT && !maps[(uint32_t)type - 1])
         {
-            name = "ambientocclusion";
-            break;
-        }
-        case TextureType::NONE:
-        case TextureType::TYPESCOUNT:
-        default:
-            break;
+            maps[(uint32_t)type - 1] = &texture;
         }
-
-        Shader.setInt(("material." + name + '[' + number + ']').c_str(), i);
     }
 
-    glBindVertexArray(m_VAO);
-    if (Amount == 1U)
-    {
-        glDrawElements(GL_TRIANGLES, Indexes.size(), GL_UNSIGNED_INT, 0);
-    }
-    else
+    for (uint32_t slot = 0; slot < slots; ++slot)
     {
-        glDrawElementsInstanced(GL_TRIANGLES, Indexes.size(), GL_UNSIGNED_INT, 0, Amount);
+        Texture& texture = maps[slot] ? *maps[slot] : DefaultTextures[slot];
+        texture.BindTexture(slot);
+        Shader.setInt(Texture::GetMaterialUniformName((TextureType)(slot + 1), 0), slot);
     }
-
-    glBindVertexArray(0);
-    glActiveTexture(GL_TEXTURE0);
-}
-
-void SkinnedMesh::ResetTextures(Shader& Shader)
-{
-    for (int i = 0; i < DefaultTextures.size(); ++i)
-    {
-        DefaultTextures[i].BindTexture(31 - i);
-    }
-    Shader.setInt("material.albedo[0]", 31);
-    Shader.setInt("material.normal[0]", 30);
-    Shader.setInt("material.emission[0]", 29);
-    Shader.setInt("material.metalness[0]", 28);
-    Shader.setInt("material.roughness[0]", 27);
-    Shader.setInt("material.ambientocclusion[0]", 26);
 }
 
 void SkinnedMesh::SetupMesh()
 {
-    glGenVertexArrays(1, &m_VAO);
-    glGenBuffers(1, &m_VBO);
-    glGenBuffers(1, &m_EBO);
+    GPUResourceTracker& tracker = GPUResourceTracker::GetInstance();
+    tracker.GenVertexArrays(1, &m_VAO, GPUResourceOwner::MESH);
+    tracker.GenBuffers(1, &m_VBO, GPUResourceOwner::MESH);
+    tracker.GenBuffers(1, &m_EBO, GPUResourceOwner::MESH);
 
-    glBindVertexArray(m_VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
+    GLState::BindVertexArray(m_VAO);
+    GLState::BindBuffer(GL_ARRAY_BUFFER, m_VBO);
 
     glBufferData(GL_ARRAY_BUFFER, Vertexes.size() * sizeof(SkinnedVertex), &Vertexes[0], GL_STATIC_DRAW);
+    tracker.SetBufferSize(m_VBO, Vertexes.size() * sizeof(SkinnedVertex));
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
+    GLState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, Indexes.size() * sizeof(unsigned int), &Indexes[0], GL_STATIC_DRAW);
+    tracker.SetBufferSize(m_EBO, Indexes.size() * sizeof(unsigned int));
 
     // Position attribute
     glEnableVertexAttribArray(0);
@@ -226,9 +222,100 @@ void SkinnedMesh::SetupMesh()
     glEnableVertexAttribArray(5);
     glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, sizeof(SkinnedVertex), (void*)offsetof(SkinnedVertex, Weights));
 
-    glBindVertexArray(0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    GLState::BindVertexArray(0);
+    GLState::BindBuffer(GL_ARRAY_BUFFER, 0);
+    GLState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+void SkinnedMesh::SetupMorphs()
+{
+    if (m_MorphTargets.empty() || m_MorphDeltas.empty())
+    {
+        return;
+    }
+
+    GPUResourceTracker& tracker = GPUResourceTracker::GetInstance();
+    const size_t vertexSize = Vertexes.size() * sizeof(SkinnedVertex);
+    tracker.GenBuffers(1, &m_MorphBaseVBO, GPUResourceOwner::MESH);
+    GLState::BindBuffer(GL_COPY_WRITE_BUFFER, m_MorphBaseVBO);
+    glBufferData(GL_COPY_WRITE_BUFFER, vertexSize, Vertexes.data(), GL_STATIC_DRAW);
+    tracker.SetBufferSize(m_MorphBaseVBO, vertexSize);
+
+    tracker.GenBuffers(1, &m_MorphDeltaBuffer, GPUResourceOwner::MESH);
+    GLState::BindBuffer(GL_COPY_WRITE_BUFFER, m_MorphDeltaBuffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, m_MorphDeltas.size() * sizeof(MorphDelta), m_MorphDeltas.data(), GL_STATIC_DRAW);
+    tracker.SetBufferSize(m_MorphDeltaBuffer, m_MorphDeltas.size() * sizeof(MorphDelta));
+    GLState::BindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    // Default weights of the file are applied by the first ApplyMorphs
+    m_IsMorphDirty = std::any_of(m_MorphTargets.begin(), m_MorphTargets.end(), [](const MorphTarget& target) { return target.Weight != 0.0f; });
+}
+
+uint32_t SkinnedMesh::GetMorphTargetCount() const
+{
+    return m_MorphTargets.size();
+}
+
+const MorphTarget& SkinnedMesh::GetMorphTarget(uint32_t Index) const
+{
+    return m_MorphTargets[Index];
+}
+
+void SkinnedMesh::SetMorphWeight(uint32_t Index, float Weight)
+{
+    if (Index >= m_MorphTargets.size())
+    {
+        fprintf(stderr, "ERROR::SKINNED_MESH::Morph target %u out of %zu\n", Index, m_MorphTargets.size());
+        return;
+    }
+    m_IsMorphDirty |= m_MorphTargets[Index].Weight != Weight;
+    m_MorphTargets[Index].Weight = Weight;
+}
+
+void SkinnedMesh::ApplyMorphs(Shader& MorphShader)
+{
+    if (!m_IsMorphDirty || !m_MorphBaseVBO)
+    {
+        return;
+    }
+    m_IsMorphDirty = false;
+
+    // Every target adds to the bind pose, the buffer is restored first instead of subtracting the previous weights
+    GLState::BindBuffer(GL_COPY_READ_BUFFER, m_MorphBaseVBO);
+    GLState::BindBuffer(GL_COPY_WRITE_BUFFER, m_VBO);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, Vertexes.size() * sizeof(SkinnedVertex));
+    GLState::BindBuffer(GL_COPY_READ_BUFFER, 0);
+    GLState::BindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    MorphShader.Use();
+    GLState::BindBufferBase(GL_SHADER_STORAGE_BUFFER, MORPH_DELTAS_BINDING, m_MorphDeltaBuffer);
+    GLState::BindBufferBase(GL_SHADER_STORAGE_BUFFER, MORPH_VERTICES_BINDING, m_VBO);
+    for (const MorphTarget& target : m_MorphTargets)
+    {
+        if (target.Weight == 0.0f || target.DeltaCount == 0)
+        {
+            continue;
+        }
+        // A target moves each vertex once, the vertices of consecutive targets overlap
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        MorphShader.setInt("firstDelta", target.FirstDelta);
+        MorphShader.setInt("deltaCount", target.DeltaCount);
+        MorphShader.setFloat("positionScale", target.PositionScale * target.Weight);
+        MorphShader.setFloat("normalScale", target.NormalScale * target.Weight);
+        glDispatchCompute((target.DeltaCount + MORPH_GROUP_SIZE - 1) / MORPH_GROUP_SIZE, 1, 1);
+    }
+    // Drawn as vertex attributes and read as storage buffer by the pre-skinning pass
+    glMemoryBarrier(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+size_t SkinnedMesh::GetMorphMemorySize() const
+{
+    return m_MorphDeltas.size() * sizeof(MorphDelta);
+}
+
+size_t SkinnedMesh::GetDenseMorphMemorySize() const
+{
+    return m_MorphTargets.size() * Vertexes.size() * 2 * sizeof(glm::vec3);
 }
 
 uint32_t SkinnedMesh::GetVAO()
@@ -1,10 +1,13 @@
 #include "Public/SkinnedModel.h"
 #include "Public/Shader.h"
+#include "Public/FrameRingBuffer.h"
 
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 #include <stb_image.h>
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 
 SkinnedModel::SkinnedModel(const char* Path)
@@ -38,6 +41,17 @@ void SkinnedModel::Draw(Shader& Shader)
     }
 }
 
+void SkinnedModel::DrawInstanced(Shader& Shader, uint32_t FirstObject, uint32_t Count)
+{
+    Shader.Use();
+    FrameRingBuffer::GetInstance().SetCurrentObject(FirstObject);
+
+    for (SkinnedMesh& mesh : m_Meshes)
+    {
+        mesh.Draw(Shader, Count);
+    }
+}
+
 SkinnedMesh& SkinnedModel::GetMesh(uint32_t Index)
 {
     if (Index > m_Meshes.size())
@@ -53,6 +67,28 @@ uint32_t SkinnedModel::GetMeshCount() const
     return m_Meshes.size();
 }
 
+void SkinnedModel::SetMorphWeight(const std::string& Name, float Weight)
+{
+    for (SkinnedMesh& mesh : m_Meshes)
+    {
+        for (uint32_t i = 0; i < mesh.GetMorphTargetCount(); ++i)
+        {
+            if (mesh.GetMorphTarget(i).Name == Name)
+            {
+                mesh.SetMorphWeight(i, Weight);
+            }
+        }
+    }
+}
+
+void SkinnedModel::ApplyMorphs(Shader& MorphShader)
+{
+    for (SkinnedMesh& mesh : m_Meshes)
+    {
+        mesh.ApplyMorphs(MorphShader);
+    }
+}
+
 void SkinnedModel::SetVertexBoneDataToDefault(SkinnedVertex& vertex)
 {
     for (int32_t i = 0; i < MAX_BONE_INFLUENCE; ++i)
@@ -244,7 +280,64 @@ SkinnedMesh SkinnedModel::ProcessMesh(aiMesh* mesh, const aiScene* scene)
 
     ExtractBoneWeightForVertices(vertices, mesh, scene);
 
-    return SkinnedMesh(vertices, indices, textures);
+    std::vector<MorphTarget> morphTargets;
+    std::vector<MorphDelta> morphDeltas;
+    ExtractMorphTargets(vertices, mesh, morphTargets, morphDeltas);
+
+    return SkinnedMesh(vertices, indices, textures, std::move(morphTargets), std::move(morphDeltas));
+}
+
+void SkinnedModel::ExtractMorphTargets(const std::vector<SkinnedVertex>& vertices, aiMesh* mesh, std::vector<MorphTarget>& targets, std::vector<MorphDelta>& deltas)
+{
+    const auto quantize = [](float Value, float Scale)
+    {
+        return int16_t(std::clamp(std::round(Value / Scale), -32767.0f, 32767.0f));
+    };
+
+    for (uint32_t targetIndex = 0; targetIndex < mesh->mNumAnimMeshes; ++targetIndex)
+    {
+        // Assimp stores the displaced vertices, not their offsets
+        const aiAnimMesh* animMesh = mesh->mAnimMeshes[targetIndex];
+        if (!animMesh->mVertices || animMesh->mNumVertices != vertices.size())
+        {
+            continue;
+        }
+
+        std::vector<glm::vec3> positions(vertices.size(), glm::vec3(0.0f));
+        std::vector<glm::vec3> normals(vertices.size(), glm::vec3(0.0f));
+        float maxPosition = 0.0f;
+        float maxNormal = 0.0f;
+        for (uint32_t i = 0; i < vertices.size(); ++i)
+        {
+            positions[i] = AnimationOptimizer::GetGLMVec(animMesh->mVertices[i]) - vertices[i].Position;
+            if (animMesh->mNormals)
+            {
+                normals[i] = AnimationOptimizer::GetGLMVec(animMesh->mNormals[i]) - vertices[i].Normal;
+            }
+            maxPosition = std::max({ maxPosition, std::abs(positions[i].x), std::abs(positions[i].y), std::abs(positions[i].z) });
+            maxNormal = std::max({ maxNormal, std::abs(normals[i].x), std::abs(normals[i].y), std::abs(normals[i].z) });
+        }
+
+        MorphTarget target;
+        target.Name = animMesh->mName.length > 0 ? animMesh->mName.C_Str() : "Target " + std::to_string(targetIndex);
+        target.FirstDelta = deltas.size();
+        target.PositionScale = maxPosition > 0.0f ? maxPosition / 32767.0f : 1.0f;
+        target.NormalScale = maxNormal > 0.0f ? maxNormal / 32767.0f : 1.0f;
+        target.Weight = animMesh->mWeight;
+        for (uint32_t i = 0; i < vertices.size(); ++i)
+        {
+            MorphDelta delta = { i, { quantize(positions[i].x, target.PositionScale), quantize(positions[i].y, target.PositionScale), quantize(positions[i].z, target.PositionScale) },
+                { quantize(normals[i].x, target.NormalScale), quantize(normals[i].y, target.NormalScale), quantize(normals[i].z, target.NormalScale) } };
+            // Vertices the target does not move, or moves less than a quantization step, are left out
+            const bool isMoved = delta.Position[0] || delta.Position[1] || delta.Position[2] || delta.Normal[0] || delta.Normal[1] || delta.Normal[2];
+            if (isMoved)
+            {
+                deltas.push_back(delta);
+            }
+        }
+        target.DeltaCount = deltas.size() - target.FirstDelta;
+        targets.push_back(target);
+    }
 }
 
 void SkinnedModel::ExtractBoneWeightForVertices(std::vector<SkinnedVertex>& vertices, aiMesh* mesh, const aiScene* scene)
@@ -1,5 +1,4 @@
 #include "Public/SpotLight.h"
-#include "Public/Line.h"
 
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtx/quaternion.hpp>
@@ -21,7 +20,8 @@ SpotLight::SpotLight(glm::vec3 Position, glm::vec3 Direction, glm::vec3 Color)
 	m_Outer = 5.0f;
 
 	m_ID = m_IDCounter++;
-	m_Prefix = "spotLights[" + std::to_string(m_ID) + ']';
+	m_ArrayName = "spotLights";
+	SetSlot(m_ID);
 }
 
 void SpotLight::SetDirection(glm::vec3 Direction)
@@ -57,15 +57,15 @@ float SpotLight::GetOuter()
 void SpotLight::SetupShader(Shader& Shader)
 {
 	Shader.Use();
-	Shader.setBool((m_Prefix + ".isOn").c_str(), m_IsOn);
-	Shader.setVec3((m_Prefix + ".position").c_str(), m_Position);
-	Shader.setVec3((m_Prefix + ".direction").c_str(), m_Direction);
-	Shader.setVec3((m_Prefix + ".color").c_str(), m_Color * m_Intensity);
-	Shader.setFloat((m_Prefix + ".cutOff").c_str(), glm::cos(glm::radians(m_LightAngle)));
-	Shader.setFloat((m_Prefix + ".outerCutOff").c_str(), glm::cos(glm::radians(m_LightAngle + m_Outer)));
-	Shader.setFloat((m_Prefix + ".constant").c_str(), m_Constant);
-	Shader.setFloat((m_Prefix + ".linear").c_str(), m_Linear);
-	Shader.setFloat((m_Prefix + ".quadratic").c_str(), m_Quadratic);
+	ResolveUniforms(Shader);
+	Shader.setVec3(m_Uniforms.Position, m_Position);
+	Shader.setVec3(m_Uniforms.Direction, m_Direction);
+	Shader.setVec3(m_Uniforms.Color, m_Color * m_Intensity);
+	Shader.setFloat(m_Uniforms.CutOff, glm::cos(glm::radians(m_LightAngle)));
+	Shader.setFloat(m_Uniforms.OuterCutOff, glm::cos(glm::radians(m_LightAngle + m_Outer)));
+	Shader.setFloat(m_Uniforms.Constant, m_Constant);
+	Shader.setFloat(m_Uniforms.Linear, m_Linear);
+	Shader.setFloat(m_Uniforms.Quadratic, m_Quadratic);
 }
 
 void SpotLight::Draw(Shader& Shader)
@@ -76,7 +76,17 @@ void SpotLight::Draw(Shader& Shader)
 	}
 	Shader.Use();
 	float Radius = glm::length(m_Direction * m_Radius) * tan(glm::radians(m_LightAngle + m_Outer));
-	m_Gizmo = Circle(Radius, glm::vec3(0.0f));
+	if (Radius != m_ConeRadius || m_Radius != m_ConeLength)
+	{
+		m_ConeRadius = Radius;
+		m_ConeLength = m_Radius;
+		m_ConeGizmo = Circle(Radius, glm::vec3(0.0f));
+		for (int i = 0; i < 4; ++i)
+		{
+			glm::vec3 edge(m_ConeGizmo.vertices[i * 15], m_ConeGizmo.vertices[i * 15 + 1], m_ConeGizmo.vertices[i * 15 + 2]);
+			m_ConeLines[i] = Line(glm::vec3(0.0f, 0.0f, -1.0f) * m_Radius, edge);
+		}
+	}
 	glm::mat4 model(1.0f);
 	glm::vec3 forward(0.0f, 0.0f, 1.0f);
 	glm::mat4 RotationMatrix(1.0f);
@@ -94,15 +104,11 @@ void SpotLight::Draw(Shader& Shader)
 	}
 	Shader.setMat4("model", model);
 
-	Line line(glm::vec3(0.0f, 0.0f, -1.0f) * m_Radius, glm::vec3(m_Gizmo.vertices[0], m_Gizmo.vertices[1], m_Gizmo.vertices[2]));
-	line.Draw(Shader);
-	line = Line(glm::vec3(0.0f, 0.0f, -1.0f) * m_Radius, glm::vec3(m_Gizmo.vertices[15], m_Gizmo.vertices[16], m_Gizmo.vertices[17]));
-	line.Draw(Shader);
-	line = Line(glm::vec3(0.0f, 0.0f, -1.0f) * m_Radius, glm::vec3(m_Gizmo.vertices[30], m_Gizmo.vertices[31], m_Gizmo.vertices[32]));
-	line.Draw(Shader);
-	line = Line(glm::vec3(0.0f, 0.0f, -1.0f) * m_Radius, glm::vec3(m_Gizmo.vertices[45], m_Gizmo.vertices[46], m_Gizmo.vertices[47]));
-	line.Draw(Shader);
-	m_Gizmo.Draw(Shader);
+	for (Line& line : m_ConeLines)
+	{
+		line.Draw(Shader);
+	}
+	m_ConeGizmo.Draw(Shader);
 }
 
 void SpotLight::Print()
@@ -1,87 +1,114 @@
 #include "../Public/Texture.h"
+#include "../Public/HDRLoader.h"
+#include "../Public/GPUResourceTracker.h"
+#include "../Public/GLState.h"
 #include <stb_image.h>
+#include <vector>
 
 
-Texture::Texture() = default;
+Texture::Texture()
+    : m_Id(0)
+    , m_Type(TextureType::NONE)
+    , m_Height(0)
+    , m_Width(0)
+    , m_NrChannels(0)
+{
+}
 
 Texture::Texture(TextureType Type, std::string Path, bool IsStandarised)
-	: m_Type(Type)
+	: m_Id(0)
+	, m_Type(Type)
 	, m_Path(Path)
 {
     LoadTexture(IsStandarised);
 }
 
 Texture::Texture(std::string Path, bool IsStandarised)
-    : m_Path(Path)
+    : m_Id(0)
+    , m_Path(Path)
     , m_Type(TextureType::NONE)
 {
     LoadTexture(IsStandarised);
 }
 
 Texture::Texture(std::string Path)
-    : m_Path(Path)
+    : m_Id(0)
+    , m_Path(Path)
     , m_Type(TextureType::NONE)
 {
     LoadTextureHDR();
 }
 
 Texture::Texture(int Width, int Height, int NrChannels)
-    : m_Width(Width)
+    : m_Id(0)
+    , m_Type(TextureType::NONE)
+    , m_Width(Width)
     , m_Height(Height)
     , m_NrChannels(NrChannels)
 {
+    GenerateTexture();
+}
+
+Texture::Texture(const Texture& Other)
+    : m_Id(Other.m_Id)
+    , m_Type(Other.m_Type)
+    , m_Path(Other.m_Path)
+    , m_Height(Other.m_Height)
+    , m_Width(Other.m_Width)
+    , m_NrChannels(Other.m_NrChannels)
+{
+    const_cast<Texture&>(Other).m_Id = 0;
+}
+
+Texture::Texture(Texture&& Other) noexcept
+    : m_Id(Other.m_Id)
+    , m_Type(Other.m_Type)
+    , m_Path(Other.m_Path)
+    , m_Height(Other.m_Height)
+    , m_Width(Other.m_Width)
+    , m_NrChannels(Other.m_NrChannels)
+{
+    Other.m_Id = 0;
+}
+
+Texture::~Texture()
+{
+    if (m_Id)
+    {
+        GPUResourceTracker::GetInstance().DeleteTextures(1, &m_Id);
+        m_Id = 0;
+    }
+}
+
+Texture& Texture::operator=(const Texture& Other)
+{
+    if (this != &Other)
+    {
+        this->~Texture();
+        std::swap(m_Id, const_cast<Texture&>(Other).m_Id);
+        m_Type = Other.m_Type;
+        m_Path = Other.m_Path;
+        m_Height = Other.m_Height;
+        m_Width = Other.m_Width;
+        m_NrChannels = Other.m_NrChannels;
+    }
+    return *this;
 }
 
-//Texture::Texture(const Texture& Other)
-//    : m_Id(Other.m_Id)
-//    , m_Type(Other.m_Type)
-//    , m_Path(Other.m_Path)
-//{
-//    const_cast<Texture&>(Other).m_Id = 0;
-//}
-//
-//Texture::Texture(Texture&& Other) noexcept
-//	: m_Id(Other.m_Id)
-//	, m_Type(Other.m_Type)
-//	, m_Path(Other.m_Path)
-//{
-//	Other.m_Id = 0;
-//}
-//
-//Texture::~Texture()
-//{
-//    if (m_Id)
-//    {
-//        glDeleteTextures(1, &m_Id);
-//        m_Id = 0;
-//        m_Path.clear();
-//        m_Type = TextureType::NONE;
-//    }
-//}
-//
-//Texture& Texture::operator=(Texture& Other)
-//{
-//    if (this != &Other)
-//    {
-//        this->~Texture();
-//        std::swap(m_Id, Other.m_Id);
-//        std::swap(m_Type, Other.m_Type);
-//        std::swap(m_Path, Other.m_Path);
-//    }
-//    return *this;
-//}
-//
-//Texture& Texture::operator=(Texture&& Other) noexcept
-//{
-//    if (this != &Other)
-//    {
-//        this->~Texture();
-//        std::swap(m_Id, Other.m_Id);
-//        std::swap(m_Type, Other.m_Type);
-//        std::swap(m_Path, Other.m_Path);
-//    }
-//    return *this;
-//}
+Texture& Texture::operator=(Texture&& Other) noexcept
+{
+    if (this != &Other)
+    {
+        this->~Texture();
+        std::swap(m_Id, Other.m_Id);
+        m_Type = Other.m_Type;
+        m_Path = Other.m_Path;
+        m_Height = Other.m_Height;
+        m_Width = Other.m_Width;
+        m_NrChannels = Other.m_NrChannels;
+    }
+    return *this;
+}
 
 
 void Texture::BindTexture(GLuint Number)
@@ -93,9 +120,8 @@ void Texture::BindTexture(GLuint Number)
     }
     else
     {
-        glActiveTexture(GL_TEXTURE0 + Number);
-        glBindTexture(GL_TEXTURE_2D, m_Id);
-        glActiveTexture(GL_TEXTURE0);
+        // Does not switch the active unit when the texture is already bound there
+        GLState::BindTexture(Number, GL_TEXTURE_2D, m_Id);
     }
 }
 
@@ -125,11 +151,36 @@ int Texture::GetHeight() const
 }
 
 
+const char* Texture::GetMaterialUniformName(TextureType Type, unsigned int Number)
+{
+    // Built once, draw calls only index into it
+    static const std::vector<std::string> names = []()
+    {
+        const char* typeNames[(int)TextureType::TYPESCOUNT] = { "", "albedo", "normal", "emission", "metalness", "roughness", "ambientocclusion" };
+        std::vector<std::string> result;
+        result.reserve((int)TextureType::TYPESCOUNT * MAX_MATERIAL_MAPS);
+        for (int type = 0; type < (int)TextureType::TYPESCOUNT; ++type)
+        {
+            for (unsigned int number = 0; number < MAX_MATERIAL_MAPS; ++number)
+            {
+                result.push_back(std::string("material.") + typeNames[type] + '[' + std::to_string(number) + ']');
+            }
+        }
+        return result;
+    }();
+
+    if (Type == TextureType::NONE || Type >= TextureType::TYPESCOUNT || Number >= MAX_MATERIAL_MAPS)
+    {
+        return nullptr;
+    }
+    return names[(int)Type * MAX_MATERIAL_MAPS + Number].c_str();
+}
+
 void Texture::LoadTexture(bool IsStandarised)
 {
     unsigned char* data;
 
-    glGenTextures(1, &m_Id);
+    GPUResourceTracker::GetInstance().GenTextures(1, &m_Id, GPUResourceOwner::TEXTURE);
 
     data = stbi_load(m_Path.c_str(), &m_Width, &m_Height, &m_NrChannels, 0);
 
@@ -165,7 +216,7 @@ void Texture::LoadTexture(bool IsStandarised)
             }
         }
 
-        glBindTexture(GL_TEXTURE_2D, m_Id);
+        GLState::BindTexture(GL_TEXTURE_2D, m_Id);
         if (IsStandarised)
         {
             glTexImage2D(GL_TEXTURE_2D, 0, level, m_Width, m_Height, 0, format, GL_UNSIGNED_BYTE, data);
@@ -175,6 +226,7 @@ void Texture::LoadTexture(bool IsStandarised)
             glTexImage2D(GL_TEXTURE_2D, 0, format, m_Width, m_Height, 0, format, GL_UNSIGNED_BYTE, data);
         }
         glGenerateMipmap(GL_TEXTURE_2D);
+        GPUResourceTracker::GetInstance().SetTextureSize(m_Id, IsStandarised ? level : format, m_Width, m_Height, 1, true);
 
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
@@ -186,49 +238,26 @@ void Texture::LoadTexture(bool IsStandarised)
         fprintf(stderr, "Failed to load texture %s\n", m_Path.c_str());
         m_Type = TextureType::NONE;
     }
-    glBindTexture(GL_TEXTURE_2D, 0);
+    GLState::BindTexture(GL_TEXTURE_2D, 0);
     stbi_image_free(data);
 }
 
 void Texture::LoadTextureHDR()
 {
-    stbi_set_flip_vertically_on_load(true);
-    float* data = stbi_loadf(m_Path.c_str(), &m_Width, &m_Height, &m_NrChannels, 0);
-    if (data)
+    HDRImage image;
+    if (HDRLoader::Load(m_Path, image))
     {
-        GLenum format, level;
-        switch (m_NrChannels)
-        {
-            case 1:
-            {
-                format = GL_R16F;
-                level = GL_RED;
-                break;
-            }
-            case 2:
-            {
-                format = GL_RG16F;
-                level = GL_RG;
-                break;
-            }
-            case 4:
-            {
-                format = GL_RGBA16F;
-                level = GL_RGBA;
-                break;
-            }
-            case 3:
-            default:
-            {
-                format = GL_RGB16F;
-                level = GL_RGB;
-                break;
-            }
-        }
+        m_Width = image.Width;
+        m_Height = image.Height;
+        m_NrChannels = 3;
 
-        glGenTextures(1, &m_Id);
-        glBindTexture(GL_TEXTURE_2D, m_Id);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, m_Width, m_Height, 0, level, GL_FLOAT, data); // note how we specify the texture's data value to be float
+        GPUResourceTracker::GetInstance().GenTextures(1, &m_Id, GPUResourceOwner::IBL);
+        GLState::BindTexture(GL_TEXTURE_2D, m_Id);
+        // Rows of RGB halves are only 2 byte aligned for odd widths
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 2);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, m_Width, m_Height, 0, GL_RGB, GL_HALF_FLOAT, image.Pixels.data());
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        GPUResourceTracker::GetInstance().SetTextureSize(m_Id, GL_RGB16F, m_Width, m_Height);
 
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
@@ -239,8 +268,7 @@ void Texture::LoadTextureHDR()
     {
         fprintf(stderr, "Failed to load texture %s\n", m_Path.c_str());
     }
-    glBindTexture(GL_TEXTURE_2D, 0);
-    stbi_image_free(data);
+    GLState::BindTexture(GL_TEXTURE_2D, 0);
 }
 
 void Texture::GenerateTexture()
@@ -275,16 +303,17 @@ void Texture::GenerateTexture()
         }
     }
 
-    glGenTextures(1, &m_Id);
+    GPUResourceTracker::GetInstance().GenTextures(1, &m_Id, GPUResourceOwner::IBL);
 
     // pre-allocate enough memory for the LUT texture.
-    glBindTexture(GL_TEXTURE_2D, m_Id);
-    glTexImage2D(GL_TEXTURE_2D, 0, format, 512, 512, 0, level, GL_FLOAT, 0);
+    GLState::BindTexture(GL_TEXTURE_2D, m_Id);
+    glTexImage2D(GL_TEXTURE_2D, 0, format, m_Width, m_Height, 0, level, GL_FLOAT, 0);
+    GPUResourceTracker::GetInstance().SetTextureSize(m_Id, format, m_Width, m_Height);
     // be sure to set wrapping mode to GL_CLAMP_TO_EDGE
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-    glBindTexture(GL_TEXTURE_2D, 0);
+    GLState::BindTexture(GL_TEXTURE_2D, 0);
 }
\ No newline at end of file
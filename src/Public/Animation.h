@@ -9,6 +9,8 @@ class aiAnimation;
 class aiNode;
 class BoneInfo;
 class SkinnedModel;
+struct ClipData;
+struct ClipFileData;
 
 struct AssimpNodeData
 {
@@ -21,30 +23,58 @@ struct AssimpNodeData
 	std::vector<AssimpNodeData> children;
 };
 
+// Loaded once per clip and shared through AnimationLibrary, players only read it
 class Animation
 {
 public:
 	Animation() = default;
 
-	Animation(const std::string& animationPath, SkinnedModel* model);
+	// The model must outlive the clip, its bone map is referenced rather than copied.
+	// Files imported before are read from the ClipCache instead of assimp
+	Animation(const std::string& animationPath, SkinnedModel* model, uint32_t clipIndex = 0);
+
+	// Every clip of the file from a single import or cache read
+	static std::vector<Animation> LoadAll(const std::string& animationPath, SkinnedModel* model);
 
 	~Animation() = default;
 
+	// Moved rather than copied, the key tracks are the bulk of a clip
+	Animation(Animation&&) = default;
+	Animation& operator=(Animation&&) = default;
+
 	Bone* FindBone(const std::string& name);
+	// Channel index of the bone animating the node, -1 when the clip does not animate it
+	int32_t FindBoneIndex(const std::string& name) const;
+	Bone& GetBone(int32_t index);
+	const Bone& GetBone(int32_t index) const;
+	uint32_t GetBoneCount() const;
+	// Switches every bone to uniformly resampled tracks, zero goes back to searching the keys
+	void Resample(float keysPerSecond);
 
-	float GetTicksPerSecond();
-	float GetDuration();
-	const AssimpNodeData& GetRootNode();
-	const std::unordered_map<std::string, BoneInfo>& GetBoneIDMap();
+	const std::string& GetName() const;
+	float GetTicksPerSecond() const;
+	float GetDuration() const;
+	const AssimpNodeData& GetRootNode() const;
+	const std::unordered_map<std::string, BoneInfo>& GetBoneIDMap() const;
+	// Bytes of the channels and the node tree, the referenced bone map is the model's
+	size_t GetMemorySize() const;
 
 private:
-	void ReadMissingBones(const aiAnimation* animation, SkinnedModel& model);
+	Animation(ClipData& clip, const AssimpNodeData& rootNode, SkinnedModel& model);
+
+	// Cache entry of the file, or an import of every clip written back to the cache
+	static bool ReadClipFile(const std::string& animationPath, ClipFileData& data);
+
+	void ReadMissingBones(ClipData& clip, SkinnedModel& model);
+
+	static void ReadHierarchyData(AssimpNodeData& dest, const aiNode* src);
+	static size_t GetNodeMemorySize(const AssimpNodeData& node);
 
-	void ReadHierarchyData(AssimpNodeData& dest, const aiNode* src);
-	float m_Duration;
-	int m_TicksPerSecond;
+	std::string m_Name;
+	float m_Duration = 0.0f;
+	int m_TicksPerSecond = 0;
 	std::vector<Bone> m_Bones;
 	AssimpNodeData m_RootNode;
-	std::unordered_map<std::string, BoneInfo> m_BoneInfoMap;
+	const std::unordered_map<std::string, BoneInfo>* m_BoneInfoMap = nullptr;
 };
 
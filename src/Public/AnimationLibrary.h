@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <vector>
+
+class Animation;
+class Skeleton;
+class SkinnedModel;
+
+struct CharacterMemoryReport
+{
+	// Bytes one more character costs with its own clip and skeleton, as before the library
+	size_t UnsharedBytes = 0;
+	// Bytes one more character costs when clip and skeleton come from the library
+	size_t SharedBytes = 0;
+	size_t ClipBytes = 0;
+	// Copy of the model's bone map each clip used to hold
+	size_t BoneMapBytes = 0;
+	size_t SkeletonBytes = 0;
+	size_t InstanceBytes = 0;
+};
+
+// Clips and skeletons loaded once and shared read only by every character playing them, a character
+// only owns its Animator. The library holds weak references, an asset goes away with its last user
+class AnimationLibrary
+{
+public:
+	AnimationLibrary(AnimationLibrary const&) = delete;
+	void operator=(AnimationLibrary const&) = delete;
+
+	static AnimationLibrary& GetInstance();
+
+	// Clips store bone IDs of the model they were loaded for, so the same file loaded for another model is another clip
+	std::shared_ptr<const Animation> LoadClip(const std::string& Path, SkinnedModel& Model, uint32_t ClipIndex = 0);
+	// Every clip of the file, read with one import
+	std::vector<std::shared_ptr<const Animation>> LoadClips(const std::string& Path, SkinnedModel& Model);
+	// Compiled once per clip, the skeleton keeps its clip alive
+	std::shared_ptr<const Skeleton> GetSkeleton(const std::shared_ptr<const Animation>& Clip, SkinnedModel& Model);
+
+	uint32_t GetClipCount();
+	uint32_t GetSkeletonCount();
+	// Bytes of the clips and skeletons still in use
+	size_t GetMemorySize();
+
+	// Loads the pair and measures what each additional character costs with and without sharing
+	static CharacterMemoryReport ReportCharacterMemory(const std::string& ModelPath, const std::string& ClipPath);
+
+private:
+	AnimationLibrary() = default;
+
+	// Drops entries whose asset was released, call with the mutex held
+	void RemoveExpired();
+
+	std::map<std::tuple<std::string, const SkinnedModel*, uint32_t>, std::weak_ptr<const Animation>> m_Clips;
+	std::map<const Animation*, std::weak_ptr<const Skeleton>> m_Skeletons;
+	// Characters may be created from jobs
+	std::mutex m_Mutex;
+};
@@ -0,0 +1,174 @@
+#pragma once
+
+#include "Public/JobPool.h"
+
+#include <glm/glm.hpp>
+#include <map>
+#include <string>
+#include <tuple>
+#include <vector>
+
+class Animation;
+class Animator;
+class CompressedClip;
+class Skeleton;
+
+struct AnimationSystemBenchmarkResult
+{
+	uint32_t Instances = 0;
+	uint32_t Threads = 0;
+	// Average milliseconds per frame
+	double SerialMs = 0.0;
+	double ParallelMs = 0.0;
+	int Frames = 0;
+};
+
+// Update rate and detail of one animator
+struct AnimationLod
+{
+	// Frames between pose evaluations, the frames in between blend from the previous pose to the last one
+	uint32_t Interval = 1;
+	// Passed to Animator::SetLeafCulling
+	uint32_t LeafCulling = 0;
+	// Animators off screen only advance their clock
+	bool IsVisible = true;
+};
+
+// Thresholds are the projected height of the bounds over the screen height
+struct AnimationLodSettings
+{
+	bool IsEnabled = true;
+	float HalfRateSize = 0.2f;
+	float QuarterRateSize = 0.08f;
+	float LeafCullingSize = 0.1f;
+	uint32_t LeafCulling = 1;
+};
+
+// Animators playing the same clip at times within one step of each other share one evaluated pose
+struct PoseCacheSettings
+{
+	bool IsEnabled = false;
+	// Seconds, clip times are rounded to a multiple of it
+	float TimeStep = 1.0f / 30.0f;
+};
+
+// Of the last finished update
+struct AnimationSystemStats
+{
+	uint32_t Evaluated = 0;
+	uint32_t Interpolated = 0;
+	uint32_t ClockOnly = 0;
+	// Animators that read the palette of another one, and animators that evaluated a pose for the cache
+	uint32_t CacheHits = 0;
+	uint32_t CacheMisses = 0;
+	// Channels sampled, and the channels a full rate update of every animator samples
+	uint32_t EvaluatedBones = 0;
+	uint32_t FullRateBones = 0;
+};
+
+// Updates every registered Animator on the job pool. Palettes are double buffered: the front copy stays
+// readable while an update writes the back copy, EndUpdate swaps them
+class AnimationSystem
+{
+public:
+	AnimationSystem() = default;
+	~AnimationSystem();
+
+	AnimationSystem(AnimationSystem const&) = delete;
+	void operator=(AnimationSystem const&) = delete;
+
+	// Only animators with a skeleton are accepted, palettes are laid out by its size.
+	// Returns the index palettes are read with, indices of later animators shift on Remove
+	int32_t Add(Animator* Animator);
+	void Remove(Animator* Animator);
+
+	// Steps per second, zero runs one step of the frame delta per update
+	void SetFixedRate(float StepsPerSecond);
+	// Applies from the next BeginUpdate, every animator starts at full rate
+	void SetLod(uint32_t Index, const AnimationLod& Lod);
+	static AnimationLod SelectLod(float ScreenSize, bool IsVisible, const AnimationLodSettings& Settings);
+	// Applies from the next BeginUpdate. Cached animators skip their LOD interval, crossfading ones are not cached
+	void SetPoseCache(const PoseCacheSettings& Settings);
+	const PoseCacheSettings& GetPoseCache() const;
+
+	// Starts the update of all animators without waiting for it
+	void BeginUpdate(float DeltaTime);
+	// Waits for the update started by BeginUpdate and publishes its palettes
+	void EndUpdate();
+	void Update(float DeltaTime);
+
+	const glm::mat4* GetPalette(uint32_t Index) const;
+	uint32_t GetPaletteSize(uint32_t Index) const;
+	// Position of the animator's palette in GetPalettes, the one of another animator after a pose cache hit
+	uint32_t GetPaletteOffset(uint32_t Index) const;
+	// Front palettes of all animators back to back, in the order they were added
+	const std::vector<glm::mat4>& GetPalettes() const;
+	uint32_t GetAnimatorCount() const;
+	// Steps run by the last update, zero when the fixed rate had no step due
+	uint32_t GetLastSteps() const;
+	const AnimationSystemStats& GetStats() const;
+
+	// Animates Instances copies of the clip on one thread and then on the job pool
+	static AnimationSystemBenchmarkResult Benchmark(const std::string& ModelPath, const std::string& ClipPath, uint32_t Instances, int Frames = 20);
+
+	// Steps one update may run before the rest of the accumulated time is dropped
+	static inline const uint32_t MAX_STEPS = 4U;
+	// Animators per job pool batch
+	static inline const uint32_t BATCH_SIZE = 16U;
+
+private:
+	enum class EntryState : uint8_t
+	{
+		EVALUATED,
+		INTERPOLATED,
+		CLOCK_ONLY,
+		CACHED
+	};
+
+	// Clip, skeleton, compressed copy, leaf culling and time step of a cached pose
+	using PoseKey = std::tuple<const Animation*, const Skeleton*, const CompressedClip*, uint32_t, int64_t>;
+
+	struct Entry
+	{
+		Animator* Player;
+		uint32_t PaletteOffset;
+		uint32_t PaletteSize;
+		AnimationLod Lod;
+		// Frames since the pose was evaluated
+		uint32_t Age = 0;
+		// The previous pose is unusable for blending, set when hidden or the interval changes
+		bool IsStale = true;
+		EntryState State = EntryState::EVALUATED;
+		uint32_t EvaluatedBones = 0;
+		// Offset the palette is read at in each copy
+		uint32_t ReadOffset[2] = { 0, 0 };
+		// Entry evaluating the pose this one shows, NO_CACHE_SOURCE when the pose cache is not used
+		uint32_t CacheSource = NO_CACHE_SOURCE;
+		// Ticks the cached pose is evaluated at
+		float CacheTime = 0.0f;
+	};
+
+	// Appends the palette of the entry to both copies
+	void AddPalette(Entry& Entry);
+	// Advances every clock and finds the entry evaluating each cached pose, on the calling thread
+	void AssignCacheSources(uint32_t Steps, float Step);
+	// Takes every entry out of the pose cache, each evaluates a fresh pose in the next update
+	void ClearCacheSources();
+
+	static inline const uint32_t NO_CACHE_SOURCE = UINT32_MAX;
+
+	std::vector<Entry> m_Entries;
+	std::vector<glm::mat4> m_Palettes[2];
+	// Pose each animator had before its last evaluation, laid out like the palettes
+	std::vector<glm::mat4> m_PreviousPoses;
+	uint32_t m_Front = 0;
+	AnimationSystemStats m_Stats;
+	PoseCacheSettings m_PoseCache;
+	// Rebuilt by every update, kept to reuse its nodes
+	std::map<PoseKey, uint32_t> m_PoseSources;
+
+	float m_FixedStep = 0.0f;
+	float m_Accumulator = 0.0f;
+	uint32_t m_Steps = 0;
+	JobHandle m_Update;
+};
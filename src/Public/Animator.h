@@ -1,27 +1,99 @@
 #pragma once
 
+#include "Public/Pose.h"
+
 #include <glm/glm.hpp>
+#include <string>
 #include <vector>
 
 class AssimpNodeData;
 class Animation;
+class Skeleton;
+class CompressedClip;
+
+struct AnimatorBenchmarkResult
+{
+	double LegacyMs = 0.0;
+	double FlatMs = 0.0;
+	uint32_t Joints = 0;
+	float MaxError = 0.0f;
+	int Iterations = 0;
+};
 
 class Animator
 {
 public:
-	Animator(Animation* animation);
+	Animator(const Animation* animation);
 
+	// Advances the clock and evaluates the pose at the new time
 	void UpdateAnimation(float dt);
+	// Clock only, for animators whose pose is not needed this frame
+	void AdvanceTime(float dt);
+	// Pose at the current time
+	void EvaluatePose();
+	// Pose at Time, in ticks of the playing clip, the clock keeps its time
+	void EvaluatePoseAt(float Time);
 
-	void PlayAnimation(Animation* pAnimation);
+	void PlayAnimation(const Animation* pAnimation);
+	// Fades from the playing clip to Clip over Seconds by blending the poses of both, the incoming clip starts at
+	// its beginning. Needs a skeleton for the playing clip, ClipSkeleton has to be compiled from the same hierarchy.
+	// Without them, or with zero seconds, the clip is switched at once
+	void CrossFade(const Animation* Clip, const Skeleton* ClipSkeleton, float Seconds);
+	bool IsFading() const;
+	// Weight of the incoming clip
+	float GetFadeWeight() const;
+	const Animation* GetCurrentAnimation() const;
+	// Ticks into the playing clip
+	float GetCurrentTime() const;
+
+	// Evaluates poses with the flat joint array while the skeleton was compiled from the playing clip,
+	// the node tree is walked otherwise
+	void SetSkeleton(const Skeleton* skeleton);
+	const Skeleton* GetSkeleton() const;
+	// Samples channels from the compressed copy of the playing clip instead of its raw tracks, needs a skeleton
+	void SetCompressedClip(const CompressedClip* clip);
+	const CompressedClip* GetCompressedClip() const;
+	// Joints less than depth levels above their deepest leaf keep the bind pose instead of sampling
+	// their channel, 1 culls the leaves and 0 samples every joint. Needs a skeleton
+	void SetLeafCulling(uint32_t depth);
+	uint32_t GetLeafCulling() const;
+	// Channels sampled by the last pose evaluation
+	uint32_t GetEvaluatedBones() const;
 
 	void CalculateBoneTransform(const AssimpNodeData* node, const glm::mat4& parentTransform);
 
-	std::vector<glm::mat4> GetFinalBoneMatrices();
+	const std::vector<glm::mat4>& GetFinalBoneMatrices() const;
+	// Bytes owned by this animator, clip and skeleton are shared and not counted
+	size_t GetMemorySize() const;
+
+	// Average milliseconds per update of the node tree walk and of the flat skeleton, and the largest matrix element difference
+	static AnimatorBenchmarkResult Benchmark(const std::string& ModelPath, const std::string& ClipPath, int Iterations = 1000);
 
 private:
+	void CalculatePose();
+	// Both clips sampled into poses, blended and converted to the palette
+	void CalculateBlendedPose();
+	void FinishFade();
+
 	std::vector<glm::mat4> m_FinalBoneMatrices;
-	Animation* m_CurrentAnimation;
+	// Model space transform of every skeleton joint, sized once in SetSkeleton
+	std::vector<glm::mat4> m_GlobalTransforms;
+	// Position and rotation key cursor of every clip channel
+	std::vector<int32_t> m_KeyCursors;
+	const Animation* m_CurrentAnimation;
+	const Skeleton* m_Skeleton = nullptr;
+	const CompressedClip* m_CompressedClip = nullptr;
+	// Incoming clip of a crossfade, it becomes the current clip when the fade ends
+	const Animation* m_NextAnimation = nullptr;
+	const Skeleton* m_NextSkeleton = nullptr;
+	std::vector<int32_t> m_NextKeyCursors;
+	float m_NextTime = 0.0f;
+	float m_FadeTime = 0.0f;
+	float m_FadeDuration = 0.0f;
+	// Outgoing, incoming and blended pose, only used while fading
+	Pose m_Poses[3];
+	uint32_t m_LeafCulling = 0;
+	uint32_t m_EvaluatedBones = 0;
 	float m_CurrentTime;
 	float m_DeltaTime;
 
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class Animation;
+class SkinnedModel;
+
+enum class BakedFormat
+{
+	RGBA32F,
+	// Half the memory, translations lose precision past a few hundred units
+	RGBA16F
+};
+
+// std430 element of the "BakedClips" storage buffer, mirrored in BakedAnimation.glsl
+struct BakedClip
+{
+	uint32_t FirstFrame;
+	uint32_t FrameCount;
+	// Seconds
+	float Duration;
+	float Padding;
+};
+
+// Clips of one SkinnedModel sampled at a fixed rate into a bone matrix texture. Every frame is a row
+// holding the rows of each palette matrix in three texels, shaders blend two rows instead of evaluating a skeleton.
+// A vertex animation texture would need a row of the size of the mesh per frame, the palette is much smaller
+class BakedAnimation
+{
+public:
+	// Clips are sampled once here, the first and last frame of a clip are its start and its end
+	BakedAnimation(SkinnedModel& Model, const std::vector<const Animation*>& Clips, float FramesPerSecond = 30.0f, BakedFormat Format = BakedFormat::RGBA32F);
+	~BakedAnimation();
+
+	BakedAnimation(const BakedAnimation&) = delete;
+	BakedAnimation& operator=(const BakedAnimation&) = delete;
+
+	// Texture to Unit and clip table to CLIPS_BINDING
+	void Bind(uint32_t Unit) const;
+
+	uint32_t GetClipCount() const;
+	// Rows of all clips
+	uint32_t GetFrameCount() const;
+	uint32_t GetPaletteSize() const;
+	// Bytes of the texture
+	size_t GetMemorySize() const;
+	double GetBakeMs() const;
+
+	static inline const uint32_t CLIPS_BINDING = 7U;
+
+private:
+	uint32_t m_Texture = 0;
+	uint32_t m_ClipBuffer = 0;
+	std::vector<BakedClip> m_Clips;
+	uint32_t m_FrameCount = 0;
+	uint32_t m_PaletteSize = 0;
+	BakedFormat m_Format;
+	double m_BakeMs = 0.0;
+};
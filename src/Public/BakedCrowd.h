@@ -0,0 +1,49 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+class BakedAnimation;
+class Shader;
+class SkinnedModel;
+
+// Per instance vertex data of a BakedCrowd
+struct BakedInstance
+{
+	glm::mat4 Transform;
+	// Index of the clip in the BakedAnimation
+	uint32_t Clip;
+	// Seconds added to the crowd time
+	float TimeOffset;
+};
+
+// Instances of a SkinnedModel animated from a BakedAnimation, every mesh is one instanced draw for all of them.
+// Nothing is evaluated on the CPU per instance, the vertex shader reads the pose from the baked texture
+class BakedCrowd
+{
+public:
+	BakedCrowd(SkinnedModel& Model, const BakedAnimation& Animation, const std::vector<BakedInstance>& Instances);
+	~BakedCrowd();
+
+	BakedCrowd(const BakedCrowd&) = delete;
+	BakedCrowd& operator=(const BakedCrowd&) = delete;
+
+	void Update(float DeltaTime);
+	// Needs the BAKED_ANIMATION variant of the shader
+	void Draw(Shader& Shader);
+
+	uint32_t GetCount() const;
+	uint32_t GetDrawCount() const;
+
+	static inline const uint32_t BAKED_BONES_UNIT = 10U;
+
+private:
+	SkinnedModel& m_Model;
+	const BakedAnimation& m_Animation;
+	// One per mesh, the mesh vertices with the instance attributes added
+	std::vector<uint32_t> m_VAOs;
+	uint32_t m_InstanceVBO = 0;
+	uint32_t m_Count = 0;
+	float m_Time = 0.0f;
+};
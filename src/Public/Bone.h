@@ -19,33 +19,80 @@ struct KeyRotation
 	float timeStamp;
 };
 
+struct KeyframeBenchmarkResult
+{
+	// Average microseconds per sample
+	double LinearUs = 0.0;
+	double CursorUs = 0.0;
+	double SeekUs = 0.0;
+	double ResampledUs = 0.0;
+	// Largest position or rotation component difference to the linear scan
+	float CursorError = 0.0f;
+	float SeekError = 0.0f;
+	float ResampledError = 0.0f;
+	int Keys = 0;
+	int Samples = 0;
+};
+
 class Bone
 {
 public:
 	Bone(const std::string& name, int32_t ID, const aiNodeAnim* channel);
+	Bone(const std::string& name, int32_t ID, std::vector<KeyPosition> positions, std::vector<KeyRotation> rotations);
 
 	void Update(float animationTime);
 
 	glm::mat4 GetLocalTransform();
-	std::string GetBoneName() const;
+	const std::string& GetBoneName() const;
 	int32_t GetBoneID();
 
+	// Index of the key starting the segment that contains the time, clamped to the first and last segment.
+	// Continues from the previous result during playback and falls back to a binary search on seeks
 	int32_t GetPositionIndex(float animationTime);
 	int32_t GetRotationIndex(float animationTime);
+
+	glm::vec3 SamplePosition(float animationTime);
+	glm::quat SampleRotation(float animationTime);
+
+	// Leave the bone untouched so players sharing a clip can sample it from several threads, each with its own cursors
+	glm::vec3 SamplePosition(float animationTime, int32_t& cursor) const;
+	glm::quat SampleRotation(float animationTime, int32_t& cursor) const;
+	glm::mat4 SampleLocalTransform(float animationTime, int32_t& positionCursor, int32_t& rotationCursor) const;
+	// The two keys around the time and the factor between them, left to callers interpolating many bones at once.
+	// Reads the resampled tracks when there are some
+	void GetPositionKeys(float animationTime, int32_t& cursor, glm::vec3& from, glm::vec3& to, float& alpha) const;
+	void GetRotationKeys(float animationTime, int32_t& cursor, glm::quat& from, glm::quat& to, float& alpha) const;
+
+	// Resamples both tracks at a fixed rate in keys per tick, Update then reads keys at time * rate
+	// without searching. A rate of zero drops the resampled track
+	void Resample(float keysPerTick);
+	bool IsResampled() const;
+
+	// Bytes of the bone and the key tracks it owns
+	size_t GetMemorySize() const;
+
+	// Compares cursor playback, random seeks and a resampled track with the linear key scan on a synthetic channel
+	static KeyframeBenchmarkResult Benchmark(int32_t keyCount = 10000, int32_t samples = 100000);
+
 	std::vector<KeyPosition> m_Positions;
 	std::vector<KeyRotation> m_Rotations;
 private:
 
-	float GetScaleFactor(float lastTimeStamp, float nextTimeStamp, float animationTime);
+	float GetScaleFactor(float lastTimeStamp, float nextTimeStamp, float animationTime) const;
 
-	glm::mat4 InterpolatePosition(float animationTime);
-	glm::mat4 InterpolateRotation(float animationTime);
+	void SampleResampled(float animationTime, glm::vec3& position, glm::quat& rotation) const;
 
 	int32_t m_NumPositions;
 	int32_t m_NumRotations;
+	int32_t m_PositionCursor = 0;
+	int32_t m_RotationCursor = 0;
+
+	std::vector<glm::vec3> m_ResampledPositions;
+	std::vector<glm::quat> m_ResampledRotations;
+	float m_ResampleRate = 0.0f;
+	float m_ResampleStart = 0.0f;
 
 	glm::mat4 m_LocalTransform;
 	std::string m_Name;
 	int32_t m_ID;
 };
-
@@ -37,7 +37,8 @@ public:
 
 	static void QuatFhm16bit(const glm::quat& q, uint16_t* result)
 	{
-		glm::vec3 vec = QuatFhm(q);
+		// The mapping only covers w >= 0, -q is the same rotation
+		glm::vec3 vec = QuatFhm(q.w < 0.0f ? -q : q);
 		Vec3To16bit(vec, result);
 	}
 
@@ -66,6 +67,17 @@ public:
 		return result;
 	}
 
+	// Like Vec4Com16bit but normalized to the given bounds instead of PosRange
+	static void Vec3Com16bit(const glm::vec3& v, const glm::vec3& center, const glm::vec3& halfExtent, uint16_t* result)
+	{
+		Vec3To16bit((v - center) / halfExtent, result);
+	}
+
+	static glm::vec3 Vec3Decom16bit(const uint16_t* b, const glm::vec3& center, const glm::vec3& halfExtent)
+	{
+		return center + I6bitToVec3(b) * halfExtent;
+	}
+
 private:
 	// 4(sqrt(2)-1)
 	static inline const float Km = 4.0f * 0.4142135679721832275390625f;
@@ -116,7 +128,8 @@ private:
 
 	static inline uint16_t CompressFloatMinusOnePlusOne(float Value)
 	{
-		return uint16_t(((Value + 1.0f) / 2.0f) * 65535.0f);
+		// Rounded, truncating doubled the worst case error
+		return uint16_t(glm::clamp((Value + 1.0f) / 2.0f, 0.0f, 1.0f) * 65535.0f + 0.5f);
 	}
 
 	static void Vec3To16bit(const glm::vec3& v, uint16_t* result)
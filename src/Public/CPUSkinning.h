@@ -0,0 +1,87 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct SkinnedVertex;
+
+struct SkinnedBounds
+{
+	glm::vec3 Min = glm::vec3(0.0f);
+	glm::vec3 Max = glm::vec3(0.0f);
+};
+
+enum class SkinningKernel : uint8_t
+{
+	// glm, one vertex at a time, the reference of the others
+	SCALAR,
+	// One vertex per 128 bit register
+	SSE2,
+	// Eight vertices per iteration in structure of arrays form, bones gathered and blended with FMA
+	AVX2
+};
+
+const uint32_t SKINNING_KERNEL_COUNT = 3U;
+
+struct CPUSkinningKernelResult
+{
+	// Kernels the CPU lacks are neither timed nor compared
+	bool IsSupported = false;
+	// Average milliseconds to skin every mesh of the model once
+	double Ms = 0.0;
+	// Largest component difference to the scalar reference
+	float MaxPositionError = 0.0f;
+	float MaxNormalError = 0.0f;
+	float MaxBoundsError = 0.0f;
+};
+
+struct CPUSkinningBenchmarkResult
+{
+	uint32_t Vertices = 0;
+	uint32_t Threads = 0;
+	// Indexed by SkinningKernel
+	CPUSkinningKernelResult Kernels[SKINNING_KERNEL_COUNT];
+	// SkinParallel, which runs the best kernel
+	double ParallelMs = 0.0;
+	float ParallelMaxError = 0.0f;
+	const char* ParallelKernel = "";
+	int Iterations = 0;
+};
+
+// Skinning of SkinnedVertex on the CPU with the math of Skinning.glsl, for picking, collision, animated bounds
+// and checking skinning without a GPU. Normals are not renormalized, like in the shader
+class CPUSkinning
+{
+public:
+	CPUSkinning(CPUSkinning const&) = delete;
+	void operator=(CPUSkinning const&) = delete;
+
+	// Deformed positions and normals of Count vertices and their bounds, with the best kernel the CPU supports.
+	// Influences with a zero weight or a bone outside the palette are skipped
+	static SkinnedBounds Skin(const SkinnedVertex* Vertices, uint32_t Count, const glm::mat4* Palette, uint32_t PaletteSize,
+		glm::vec3* Positions, glm::vec3* Normals);
+	// Skin with the given kernel, unsupported kernels run the scalar one
+	static SkinnedBounds SkinWith(SkinningKernel Kernel, const SkinnedVertex* Vertices, uint32_t Count, const glm::mat4* Palette,
+		uint32_t PaletteSize, glm::vec3* Positions, glm::vec3* Normals);
+	// Skin split over the job pool, the outputs are resized to the vertex count
+	static SkinnedBounds SkinParallel(const std::vector<SkinnedVertex>& Vertices, const std::vector<glm::mat4>& Palette,
+		std::vector<glm::vec3>& Positions, std::vector<glm::vec3>& Normals);
+	static SkinnedBounds SkinScalar(const SkinnedVertex* Vertices, uint32_t Count, const glm::mat4* Palette, uint32_t PaletteSize,
+		glm::vec3* Positions, glm::vec3* Normals);
+
+	// AVX2 is compiled into every x86 build and checked with cpuid on first use
+	static bool IsSupported(SkinningKernel Kernel);
+	static SkinningKernel GetBestKernel();
+	static const char* GetKernelName(SkinningKernel Kernel);
+
+	// Skins the model in the pose halfway through the clip with every supported kernel and compares them with the scalar reference
+	static CPUSkinningBenchmarkResult Benchmark(const std::string& ModelPath, const std::string& ClipPath, int Iterations = 100);
+
+	// Vertices per job pool batch
+	static inline const uint32_t BATCH_SIZE = 2048U;
+
+private:
+	CPUSkinning() = default;
+};
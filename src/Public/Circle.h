@@ -7,11 +7,17 @@ class Circle : public Object
 public:
     Circle() = default;
     Circle(float Radius, glm::vec3 Position);
+    Circle(const Circle& Other);
+    Circle(Circle&& Other) noexcept;
+
+    ~Circle();
+
+    Circle& operator=(const Circle& Other);
+    Circle& operator=(Circle&& Other) noexcept;
 
     void Draw(Shader& Shader) override;
 
-    ~Circle();
     float vertices[63];
 private:
-    unsigned int m_VAO, m_VBO;
+    unsigned int m_VAO = 0, m_VBO = 0;
 };
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "Public/Animation.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct ClipChannel
+{
+	std::string Name;
+	std::vector<KeyPosition> Positions;
+	std::vector<KeyRotation> Rotations;
+};
+
+struct ClipData
+{
+	std::string Name;
+	float Duration = 0.0f;
+	float TicksPerSecond = 0.0f;
+	std::vector<ClipChannel> Channels;
+};
+
+// Every clip of one source file after import, bone IDs are left out since they belong to the model
+struct ClipFileData
+{
+	AssimpNodeData Root;
+	std::vector<ClipData> Clips;
+};
+
+struct ClipCacheStats
+{
+	uint32_t Hits = 0;
+	uint32_t Misses = 0;
+	uint32_t Rejected = 0;
+	double LoadMs = 0.0;
+	double ImportMs = 0.0;
+};
+
+// On disk cache of imported clips keyed by the contents of the source file, a hit maps the file once
+// and copies the key tracks out instead of running assimp
+class ClipCache
+{
+public:
+	ClipCache(ClipCache const&) = delete;
+	void operator=(ClipCache const&) = delete;
+
+	// Hash of the source file bytes, 0 when it cannot be read
+	static uint64_t GetKey(const std::string& SourcePath);
+
+	// Returns false when there is no entry or it was written by another build
+	static bool Load(uint64_t Key, ClipFileData& Data);
+	static void Save(uint64_t Key, const ClipFileData& Data);
+	static void Clear();
+
+	static void AddImportTime(double Milliseconds);
+	static const ClipCacheStats& GetStats();
+
+	static inline const char* CACHE_DIRECTORY = "cache/clips";
+
+private:
+	ClipCache() = default;
+
+	static std::string GetPath(uint64_t Key);
+
+	static inline ClipCacheStats m_Stats;
+};
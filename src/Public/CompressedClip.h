@@ -0,0 +1,83 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class Animation;
+
+// Key time and value quantized to 16 bits each. Rotations use the AnimationOptimizer hemisphere mapping,
+// positions are normalized to the bounds of their curve
+struct CompressedKey
+{
+	uint16_t Time;
+	uint16_t Data[3];
+};
+
+// Keys of one clip channel, curve indices match the channel indices of the source Animation
+struct CompressedCurve
+{
+	uint32_t FirstRotation;
+	uint32_t NumRotations;
+	uint32_t FirstPosition;
+	uint32_t NumPositions;
+	glm::vec3 PositionCenter;
+	glm::vec3 PositionHalfExtent;
+};
+
+struct ClipCompressionSettings
+{
+	// Largest position error a dropped key may introduce, in model units
+	float PositionTolerance = 0.0005f;
+	// Largest rotation error a dropped key may introduce, in radians
+	float RotationTolerance = 0.0005f;
+};
+
+struct ClipCompressionReport
+{
+	size_t RawBytes = 0;
+	size_t CompressedBytes = 0;
+	uint32_t RawKeys = 0;
+	uint32_t Keys = 0;
+	// Largest distance between raw and compressed joint positions in model space
+	float MaxJointError = 0.0f;
+	// Largest angle between raw and compressed local joint rotations, in degrees
+	float MaxRotationError = 0.0f;
+	double RawSampleMs = 0.0;
+	double CompressedSampleMs = 0.0;
+};
+
+class CompressedClip
+{
+public:
+	CompressedClip(const Animation& Clip, const ClipCompressionSettings& Settings = ClipCompressionSettings());
+
+	// Decompresses the two keys around the time and interpolates them, nothing is unpacked ahead of time
+	void Sample(uint32_t Curve, float AnimationTime, glm::vec3& Position, glm::quat& Rotation) const;
+	glm::mat4 SampleLocalTransform(uint32_t Curve, float AnimationTime) const;
+
+	uint32_t GetCurveCount() const;
+	uint32_t GetKeyCount() const;
+	size_t GetMemorySize() const;
+	float GetDuration() const;
+	float GetTicksPerSecond() const;
+	// Read by GPUClipEvaluator, which decodes the keys on the GPU
+	const std::vector<CompressedCurve>& GetCurves() const;
+	const std::vector<CompressedKey>& GetKeys() const;
+	float GetTimeScale() const;
+
+	// Compresses the clip with default settings and compares it with the raw tracks over the whole clip
+	static ClipCompressionReport Benchmark(const std::string& ModelPath, const std::string& ClipPath, int Samples = 200);
+
+private:
+	uint16_t CompressKeyTime(float Time) const;
+
+	std::vector<CompressedCurve> m_Curves;
+	std::vector<CompressedKey> m_Keys;
+	float m_Duration = 0.0f;
+	float m_TicksPerSecond = 0.0f;
+	// Quantized key times per tick, chosen so the duration spans the full 16 bit range
+	float m_TimeScale = 0.0f;
+};
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "Light.h"
+#include "Circle.h"
+#include "Line.h"
 
 class DirectionalLight : public Light
 {
@@ -20,6 +22,11 @@ public:
 private:
 	glm::vec3 m_Direction;
 
+	// Gizmo, rebuilt only when the direction changes
+	Circle m_Gizmo;
+	Line m_GizmoLines[4];
+	glm::vec3 m_GizmoDirection = glm::vec3(0.0f);
+
 	const unsigned int MAX_LIGHT_NUMBER = 1U;
 
 	static inline unsigned int m_IDCounter = 0U;
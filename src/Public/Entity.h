@@ -1,11 +1,13 @@
 #pragma once
 
+#include <cstdint>
 #include <list>
 #include <memory>
 #include <string>
 #include "Transform.h"
 #include "Object.h"
 
+class ShaderVariants;
 
 class Entity
 {
@@ -21,9 +23,12 @@ public:
     Transform transform;
 
     Entity(Object& Object, const std::string& Name, Shader& DefaultShader);
+    // Drawn with the variant matching the current base permutation and its own features
+    Entity(Object& Object, const std::string& Name, ShaderVariants& Variants);
     Entity(const std::string& Name = "Root");
 
     void AddChild(Object& Object, const std::string& Name, Shader& DefaultShader);
+    void AddChild(Object& Object, const std::string& Name, ShaderVariants& Variants);
 
     void UpdateSelfAndChildren();
     void ForceUpdateSelfAndChildren();
@@ -39,9 +44,15 @@ public:
     bool operator==(const Entity& Other);
 
 private:
+    // Writes the transform to the frame ring buffer once per frame and makes it the current object
+    void BindObjectData(const Shader& Shader);
+
     bool m_IsRefract;
+    ShaderVariants* m_Variants = nullptr;
     inline static Entity* m_SelectedEntity = nullptr;
     inline static unsigned int m_IDCounter = 0u;
     unsigned int m_ID;
+    uint64_t m_ObjectFrame = 0;
+    uint32_t m_ObjectIndex = 0;
 };
 
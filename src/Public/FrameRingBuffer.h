@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <glad/glad.h>
+
+// std140 block "Matrixes", view and projection stay first for shaders declaring only those
+struct FrameConstants
+{
+    glm::mat4 View;
+    glm::mat4 Projection;
+    glm::mat4 ViewProjection;
+    glm::mat4 LightSpace;
+    glm::vec4 CameraPosition;
+};
+
+enum ObjectFlags : uint32_t
+{
+    OBJECT_SELECTED = 1u << 0,
+    OBJECT_REFRACT = 1u << 1,
+};
+
+// std430 element of the "Objects" storage buffer, read in shaders with gl_BaseInstance
+struct ObjectData
+{
+    glm::mat4 Model;
+    glm::mat4 NormalMatrix;
+    uint32_t Flags;
+    // First bone of the object's palette in the "Bones" storage buffer
+    uint32_t BoneOffset;
+    uint32_t Padding[2];
+};
+
+// std430 element of the "Bones" storage buffer, the rows of a bone matrix without the constant last one
+struct PackedBone
+{
+    glm::vec4 Rows[3];
+};
+
+// Persistently mapped buffer split in one region per frame in flight, the CPU writes a region
+// only after the fence of the frame that last used it is signaled
+class FrameRingBuffer
+{
+public:
+    FrameRingBuffer(FrameRingBuffer const&) = delete;
+    void operator=(FrameRingBuffer const&) = delete;
+
+    // First call has to happen with a current context
+    static FrameRingBuffer& GetInstance();
+
+    // Waits for the next region and binds it, call before writing anything for the frame
+    void BeginFrame();
+    // Fences the region, call after the last draw reading it
+    void EndFrame();
+
+    // Written straight into mapped memory
+    FrameConstants& GetConstants();
+    // Returns the index shaders read the object at, 0 is returned once the region is full
+    uint32_t PushObject(const glm::mat4& Model, uint32_t Flags, uint32_t BoneOffset = 0);
+    // Returns the bone offset of the palette, 0 is returned once the region is full
+    uint32_t PushPalette(const glm::mat4* Bones, uint32_t Count);
+    // Leaves Count bones for a GPU pass to write, returns their offset like PushPalette
+    uint32_t ReserveBones(uint32_t Count);
+
+    // Base instance of the next non instanced mesh draw
+    void SetCurrentObject(uint32_t Index);
+    uint32_t GetCurrentObject() const;
+
+    uint64_t GetFrameNumber() const;
+    uint32_t GetObjectCount() const;
+    uint32_t GetBoneCount() const;
+    // Time BeginFrame spent waiting for the GPU
+    double GetWaitMs() const;
+
+    // Unmaps and deletes the buffer, GetInstance must not be used afterwards
+    void Release();
+
+    static inline const uint32_t FRAMES = 3U;
+    static inline const uint32_t MAX_OBJECTS = 4096U;
+    static inline const GLuint CONSTANTS_BINDING = 0U;
+    static inline const GLuint OBJECTS_BINDING = 3U;
+    static inline const uint32_t MAX_BONES = 65536U;
+    static inline const GLuint BONES_BINDING = 4U;
+
+private:
+    FrameRingBuffer();
+
+    GLuint m_Buffer = 0;
+    char* m_Mapped = nullptr;
+    GLsizeiptr m_ObjectsOffset = 0;
+    GLsizeiptr m_BonesOffset = 0;
+    GLsizeiptr m_FrameStride = 0;
+    GLsync m_Fences[FRAMES] = {};
+    uint32_t m_Region = 0;
+    uint64_t m_FrameNumber = 0;
+    uint32_t m_ObjectCount = 0;
+    uint32_t m_BoneCount = 0;
+    uint32_t m_CurrentObject = 0;
+    double m_WaitMs = 0.0;
+    // An overflowing frame rejects every later push, each limit is reported once per frame
+    bool m_IsObjectOverflowReported = false;
+    bool m_IsBoneOverflowReported = false;
+};
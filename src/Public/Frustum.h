@@ -0,0 +1,16 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+// Planes of a view frustum, normals point inside and w holds the distance
+struct Frustum
+{
+    // Left, right, bottom, top, near, far
+    glm::vec4 Planes[6];
+
+    // Rows of the view projection added to and subtracted from its last row, then normalized
+    static Frustum FromViewProjection(const glm::mat4& ViewProjection);
+
+    // False only when the sphere lies fully behind one of the planes
+    bool IsSphereVisible(const glm::vec3& Center, float Radius) const;
+};
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstdint>
+#include <glad/glad.h>
+
+struct GLStateStats
+{
+    uint32_t Issued = 0;
+    uint32_t Filtered = 0;
+};
+
+// Shadow copy of the GL state the renderer touches, calls setting a value that is already current are dropped.
+// State changed with raw GL calls must be reported through Invalidate
+class GLState
+{
+public:
+    GLState(GLState const&) = delete;
+    void operator=(GLState const&) = delete;
+
+    static void UseProgram(GLuint Program);
+    static GLuint GetProgram();
+
+    // Unit is an index, not a GL_TEXTUREi enum
+    static void ActiveTexture(GLuint Unit);
+    // Binds to the active unit
+    static void BindTexture(GLenum Target, GLuint Texture);
+    static void BindTexture(GLuint Unit, GLenum Target, GLuint Texture);
+
+    static void BindVertexArray(GLuint VertexArray);
+    static void BindBuffer(GLenum Target, GLuint Buffer);
+    static void BindBufferBase(GLenum Target, GLuint Index, GLuint Buffer);
+    static void BindBufferRange(GLenum Target, GLuint Index, GLuint Buffer, GLintptr Offset, GLsizeiptr Size);
+    static void BindFramebuffer(GLenum Target, GLuint Framebuffer);
+
+    static void Viewport(GLint X, GLint Y, GLsizei Width, GLsizei Height);
+    static void Enable(GLenum Capability);
+    static void Disable(GLenum Capability);
+    static void SetEnabled(GLenum Capability, bool IsEnabled);
+    static void DepthFunc(GLenum Function);
+    static void DepthMask(GLboolean Mask);
+    static void BlendFunc(GLenum Source, GLenum Destination);
+    static void CullFace(GLenum Face);
+    // Core profile only accepts GL_FRONT_AND_BACK
+    static void PolygonMode(GLenum Mode);
+
+    // Deleted objects are unbound by GL, their names may be reused
+    static void ForgetProgram(GLuint Program);
+    static void ForgetTextures(GLsizei Count, const GLuint* Ids);
+    static void ForgetBuffers(GLsizei Count, const GLuint* Ids);
+    static void ForgetFramebuffers(GLsizei Count, const GLuint* Ids);
+    static void ForgetVertexArrays(GLsizei Count, const GLuint* Ids);
+
+    // Marks everything unknown, the next call of each kind is issued
+    static void Invalidate();
+
+    // Calls issued to the driver and dropped as redundant since the last reset
+    static const GLStateStats& GetStats();
+    static void ResetStats();
+
+    static inline const GLuint MAX_TEXTURE_UNITS = 32U;
+
+private:
+    GLState() = default;
+
+    // Stands for a value not known to the cache
+    static inline const GLuint UNKNOWN = 0xFFFFFFFFu;
+
+    enum TextureTarget : uint32_t
+    {
+        TEXTURE_2D,
+        TEXTURE_CUBE_MAP,
+        TEXTURE_2D_ARRAY,
+        TEXTURE_TARGETS_COUNT, // Number of targets in enum
+    };
+
+    enum BufferTarget : uint32_t
+    {
+        ARRAY_BUFFER,
+        ELEMENT_ARRAY_BUFFER,
+        UNIFORM_BUFFER,
+        SHADER_STORAGE_BUFFER,
+        DRAW_INDIRECT_BUFFER,
+        BUFFER_TARGETS_COUNT, // Number of targets in enum
+    };
+
+    enum Capability : uint32_t
+    {
+        DEPTH_TEST,
+        CULL_FACE,
+        BLEND,
+        CAPABILITIES_COUNT, // Number of capabilities in enum
+    };
+
+    struct TextureUnit
+    {
+        GLuint Textures[TEXTURE_TARGETS_COUNT] = { UNKNOWN, UNKNOWN, UNKNOWN };
+    };
+
+    // Stores Value and returns true when the call has to be issued
+    static bool Update(GLuint& Cached, GLuint Value);
+    // Targets and capabilities outside the enums above are never filtered
+    static uint32_t GetTextureTarget(GLenum Target);
+    static uint32_t GetBufferTarget(GLenum Target);
+    static uint32_t GetCapability(GLenum Capability);
+
+    static inline GLuint m_Program = UNKNOWN;
+    static inline GLuint m_ActiveUnit = UNKNOWN;
+    static TextureUnit m_Units[MAX_TEXTURE_UNITS];
+    static inline GLuint m_VertexArray = UNKNOWN;
+    static inline GLuint m_Buffers[BUFFER_TARGETS_COUNT] = { UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN };
+    static inline GLuint m_DrawFramebuffer = UNKNOWN;
+    static inline GLuint m_ReadFramebuffer = UNKNOWN;
+    static inline GLint m_Viewport[4] = { -1, -1, -1, -1 };
+    static inline GLuint m_Capabilities[CAPABILITIES_COUNT] = { UNKNOWN, UNKNOWN, UNKNOWN };
+    static inline GLuint m_DepthFunc = UNKNOWN;
+    static inline GLuint m_DepthMask = UNKNOWN;
+    static inline GLuint m_BlendFunc[2] = { UNKNOWN, UNKNOWN };
+    static inline GLuint m_CullFace = UNKNOWN;
+    static inline GLuint m_PolygonMode = UNKNOWN;
+
+    static inline GLStateStats m_Stats;
+};
@@ -0,0 +1,136 @@
+#pragma once
+
+#include "Public/FrameRingBuffer.h"
+
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class CompressedClip;
+class Shader;
+class Skeleton;
+
+// std430 element of the "ClipInstances" storage buffer, mirrored in ClipEvaluation.comp
+struct GPUClipInstance
+{
+	uint32_t Clip;
+	// Ticks into the clip, within its duration
+	float Time;
+	// Where the palette goes in the bone buffer
+	uint32_t BoneOffset;
+	uint32_t Padding;
+};
+
+struct GPUClipBenchmarkResult
+{
+	uint32_t Instances = 0;
+	uint32_t Joints = 0;
+	// Milliseconds for all instances
+	double CpuMs = 0.0;
+	double GpuMs = 0.0;
+	// Largest bone row element difference between the GPU palettes and the CPU reference
+	float MaxError = 0.0f;
+};
+
+// Compressed clips and their skeletons in storage buffers, evaluated on the GPU straight into the bone buffer.
+// Every instance is one work group: its invocations sample the joints' keys, then walk the hierarchy one depth
+// level at a time. Rotations are nlerped, the CPU reference runs the same math to validate the shader
+class GPUClipEvaluator
+{
+public:
+	GPUClipEvaluator();
+	~GPUClipEvaluator();
+
+	GPUClipEvaluator(const GPUClipEvaluator&) = delete;
+	GPUClipEvaluator& operator=(const GPUClipEvaluator&) = delete;
+
+	// Skeleton has to be compiled from the clip Clip was compressed from. Returns the index instances play the
+	// clip with, -1 when the skeleton has more than MAX_JOINTS joints
+	int32_t AddClip(const CompressedClip& Clip, const Skeleton& Skeleton);
+	uint32_t GetClipCount() const;
+	uint32_t GetPaletteSize(uint32_t Clip) const;
+
+	// Writes the palette of every instance to the buffer bound at FrameRingBuffer::BONES_BINDING, readers need
+	// a GL_SHADER_STORAGE_BARRIER_BIT barrier. EvaluationShader is ClipEvaluation.comp
+	void Dispatch(Shader& EvaluationShader, const std::vector<GPUClipInstance>& Instances);
+	// CPU reference, Bones is indexed by BoneOffset like the bone buffer and grows to fit every palette
+	void Evaluate(const std::vector<GPUClipInstance>& Instances, std::vector<PackedBone>& Bones) const;
+	// Bytes of the storage buffers
+	size_t GetMemorySize() const;
+
+	// Evaluates Instances copies of the clip at spread times on the CPU and on the GPU and compares the palettes
+	static GPUClipBenchmarkResult Benchmark(const std::string& ModelPath, const std::string& ClipPath, Shader& EvaluationShader, uint32_t Instances);
+
+	// Joint transforms of a work group are kept in shared memory
+	static inline const uint32_t MAX_JOINTS = 256U;
+	// Dispatches are limited to the guaranteed work group count
+	static inline const uint32_t MAX_INSTANCES = 65535U;
+	static inline const uint32_t CLIPS_BINDING = 8U;
+	static inline const uint32_t JOINTS_BINDING = 9U;
+	static inline const uint32_t CURVES_BINDING = 10U;
+	static inline const uint32_t KEYS_BINDING = 11U;
+	static inline const uint32_t INSTANCES_BINDING = 12U;
+
+private:
+	// std430 layouts of ClipEvaluation.comp
+	struct ClipInfo
+	{
+		uint32_t FirstJoint;
+		uint32_t JointCount;
+		// Deepest joint level plus one
+		uint32_t DepthCount;
+		uint32_t PaletteSize;
+		float TimeScale;
+		uint32_t Padding[3];
+	};
+
+	struct Joint
+	{
+		int32_t Parent;
+		int32_t BoneID;
+		// Index into the curves of all clips, -1 keeps the bind pose
+		int32_t Curve;
+		uint32_t Depth;
+		glm::vec4 BindPosition;
+		// x, y, z, w
+		glm::vec4 BindRotation;
+		glm::mat4 Offset;
+	};
+
+	struct Curve
+	{
+		// Into the keys of all clips
+		uint32_t FirstRotation;
+		uint32_t NumRotations;
+		uint32_t FirstPosition;
+		uint32_t NumPositions;
+		glm::vec4 PositionCenter;
+		glm::vec4 PositionHalfExtent;
+	};
+
+	// Key time in the low half of x, the three values in the high half of x and in y
+	struct Key
+	{
+		uint32_t TimeAndX;
+		uint32_t YAndZ;
+	};
+
+	// Uploads the tables when clips were added since the last upload
+	void Upload();
+	void SampleCurve(const Curve& Curve, float Time, float TimeScale, glm::vec3& Position, glm::vec4& Rotation) const;
+
+	std::vector<ClipInfo> m_Clips;
+	std::vector<Joint> m_Joints;
+	std::vector<Curve> m_Curves;
+	std::vector<Key> m_Keys;
+	bool m_IsDirty = false;
+
+	uint32_t m_ClipBuffer = 0;
+	uint32_t m_JointBuffer = 0;
+	uint32_t m_CurveBuffer = 0;
+	uint32_t m_KeyBuffer = 0;
+	uint32_t m_InstanceBuffer = 0;
+	size_t m_InstanceCapacity = 0;
+};
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <glad/glad.h>
+
+enum class GPUResourceType : unsigned char
+{
+    BUFFER,
+    TEXTURE,
+    FRAMEBUFFER,
+    RENDERBUFFER,
+    VERTEXARRAY,
+    TYPESCOUNT, // Number of types in enum
+};
+
+enum class GPUResourceOwner : unsigned char
+{
+    MESH,
+    TEXTURE,
+    BLOOM,
+    SHADOW,
+    IBL,
+    POSTPROCESS,
+    PARTICLES,
+    GIZMO,
+    OTHER,
+    OWNERSCOUNT, // Number of owners in enum
+};
+
+// Central registry of every GL object the application creates, with estimated VRAM usage
+class GPUResourceTracker
+{
+public:
+    GPUResourceTracker(GPUResourceTracker const&) = delete;
+    void operator=(GPUResourceTracker const&) = delete;
+
+    static GPUResourceTracker& GetInstance();
+
+    void GenBuffers(GLsizei Count, GLuint* Ids, GPUResourceOwner Owner);
+    void GenTextures(GLsizei Count, GLuint* Ids, GPUResourceOwner Owner);
+    void GenFramebuffers(GLsizei Count, GLuint* Ids, GPUResourceOwner Owner);
+    void GenRenderbuffers(GLsizei Count, GLuint* Ids, GPUResourceOwner Owner);
+    void GenVertexArrays(GLsizei Count, GLuint* Ids, GPUResourceOwner Owner);
+    void CreateVertexArrays(GLsizei Count, GLuint* Ids, GPUResourceOwner Owner);
+
+    void DeleteBuffers(GLsizei Count, const GLuint* Ids);
+    void DeleteTextures(GLsizei Count, const GLuint* Ids);
+    void DeleteFramebuffers(GLsizei Count, const GLuint* Ids);
+    void DeleteRenderbuffers(GLsizei Count, const GLuint* Ids);
+    void DeleteVertexArrays(GLsizei Count, const GLuint* Ids);
+
+    // Size estimates, call after the storage of the object is (re)allocated
+    void SetBufferSize(GLuint Id, GLsizeiptr Bytes);
+    void SetTextureSize(GLuint Id, GLenum InternalFormat, int Width, int Height, int Layers = 1, bool HasMipmaps = false);
+    void SetRenderbufferSize(GLuint Id, GLenum InternalFormat, int Width, int Height);
+
+    // Objects living for the whole application (singletons) are not reported as leaks
+    void SetPersistent(GPUResourceType Type, GLuint Id);
+
+    uint64_t GetTotalBytes() const;
+    uint64_t GetBytes(GPUResourceOwner Owner) const;
+    uint32_t GetCount(GPUResourceOwner Owner, GPUResourceType Type) const;
+
+    void DrawGUI();
+    // Prints every non persistent object still alive, returns their number
+    uint32_t ReportLeaks() const;
+
+    static const char* GetOwnerName(GPUResourceOwner Owner);
+    static const char* GetTypeName(GPUResourceType Type);
+    static uint32_t GetBytesPerPixel(GLenum InternalFormat);
+
+private:
+    GPUResourceTracker() = default;
+
+    struct Record
+    {
+        GPUResourceOwner Owner;
+        uint64_t Bytes;
+        bool IsPersistent;
+    };
+
+    static uint64_t GetKey(GPUResourceType Type, GLuint Id);
+
+    void Register(GPUResourceType Type, GLsizei Count, const GLuint* Ids, GPUResourceOwner Owner);
+    void Unregister(GPUResourceType Type, GLsizei Count, const GLuint* Ids);
+    void SetBytes(GPUResourceType Type, GLuint Id, uint64_t Bytes);
+
+    std::unordered_map<uint64_t, Record> m_Records;
+    uint32_t m_Counts[(int)GPUResourceOwner::OWNERSCOUNT][(int)GPUResourceType::TYPESCOUNT] = {};
+    uint64_t m_Bytes[(int)GPUResourceOwner::OWNERSCOUNT] = {};
+};
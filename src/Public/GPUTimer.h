@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+#include <glad/glad.h>
+
+#include "Public/FrameRingBuffer.h"
+
+// GL_TIME_ELAPSED query per frame in flight. A query is read back when the timer reuses it, by then
+// FrameRingBuffer has waited for its frame so the result is ready without stalling.
+// Time elapsed queries cannot nest, only one timer may be running at a time
+class GPUTimer
+{
+public:
+    GPUTimer();
+    ~GPUTimer();
+
+    GPUTimer(const GPUTimer&) = delete;
+    GPUTimer& operator=(const GPUTimer&) = delete;
+
+    // At most one Begin and End pair per frame
+    void Begin();
+    void End();
+
+    // GPU time of the latest pair whose result arrived
+    double GetMs() const;
+
+private:
+    GLuint m_Queries[FrameRingBuffer::FRAMES] = {};
+    bool m_IsIssued[FrameRingBuffer::FRAMES] = {};
+    double m_Ms = 0.0;
+};
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "Public/Frustum.h"
+#include "Public/InstancedModel.h"
+
+struct InstanceCullingReport
+{
+    uint32_t Instances = 0;
+    uint32_t Threads = 0;
+    uint32_t GpuVisible = 0;
+    uint32_t CpuVisible = 0;
+    // Instances in only one of the two visible sets, spheres touching a plane may round either way
+    uint32_t Mismatches = 0;
+    double GpuMs = 0.0;
+    double CpuMs = 0.0;
+    double ParallelMs = 0.0;
+};
+
+// InstanceCulling.comp on the CPU, only to validate the GPU pass against.
+// Spheres are placed with scalar math, the plane tests run on four instances at once with SSE2
+class InstanceCulling
+{
+public:
+    InstanceCulling(InstanceCulling const&) = delete;
+    void operator=(InstanceCulling const&) = delete;
+
+    // Appends the data of every instance whose sphere intersects the frustum to Visible, in input order.
+    // Bounds is the model space sphere of the meshes with the radius in w. Returns the number of visible instances
+    static uint32_t Cull(const glm::vec4* Instances, uint32_t Count, InstanceFormat Format, const glm::mat4& Model, const Frustum& View,
+        const glm::vec4& Bounds, std::vector<glm::vec4>& Visible);
+    // Cull split over the job pool, batches are appended in order so Visible matches Cull's
+    static uint32_t CullParallel(const std::vector<glm::vec4>& Instances, InstanceFormat Format, const glm::mat4& Model, const Frustum& View,
+        const glm::vec4& Bounds, std::vector<glm::vec4>& Visible);
+
+    // Same decoding as Common/Instance.glsl
+    static glm::mat4 DecodeInstance(const glm::vec4* Instance, InstanceFormat Format);
+    // Instances found in only one of the lists, their order is ignored
+    static uint32_t CountMismatches(const std::vector<glm::vec4>& First, const std::vector<glm::vec4>& Second, InstanceFormat Format);
+
+    // Instances per job pool batch
+    static inline const uint32_t BATCH_SIZE = 16384U;
+
+private:
+    InstanceCulling() = default;
+};
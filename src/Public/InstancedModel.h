@@ -1,18 +1,107 @@
 #pragma once
+#include <cstddef>
+#include <cstdint>
 #include <vector>
 
+#include <glm/gtc/quaternion.hpp>
+
 #include "Model.h"
 #include "Transform.h"
 
+struct Frustum;
+struct InstanceCullingReport;
+
+// Layout of one instance in the instance buffer, Instance.vs decodes each of them into a matrix
+enum class InstanceFormat : int
+{
+	// Whole matrix, 64 bytes
+	MATRIX,
+	// Top three rows of the matrix, 48 bytes
+	AFFINE,
+	// Position with a uniform scale, then the rotation quaternion, 32 bytes
+	QUAT_SCALE
+};
+
+// CPU staging of instance transforms already encoded in one InstanceFormat. InstancedModel takes it by
+// rvalue and releases its memory once the instance buffer holds the data
+class InstanceBuilder
+{
+public:
+	explicit InstanceBuilder(InstanceFormat Format = InstanceFormat::MATRIX, uint32_t Reserve = 0U);
+
+	// QUAT_SCALE keeps the length of the first column as the scale, shears and non uniform scales are lost
+	void Add(const glm::mat4& Transform);
+	void Add(const glm::vec3& Position, const glm::quat& Rotation, float Scale);
+
+	InstanceFormat GetFormat() const;
+	uint32_t GetCount() const;
+	const glm::vec4* GetData() const;
+	// Bytes
+	size_t GetSize() const;
+	// Frees the staging memory and empties the builder
+	void Release();
+
+	// Bytes of one instance
+	static uint32_t GetStride(InstanceFormat Format);
+	static const char* GetFormatName(InstanceFormat Format);
+
+private:
+	InstanceFormat m_Format;
+	uint32_t m_Count;
+	std::vector<glm::vec4> m_Data;
+};
+
 class InstancedModel : public Model
 {
 public:
-	InstancedModel(const char* Path, std::vector<glm::mat4> Transforms);
+	InstancedModel(const char* Path, InstanceBuilder&& Instances);
 	~InstancedModel();
 
 	void Draw(Shader& Shader) override;
+
+	// Replaces every instance, the format may change. The builder is released after the upload
+	void Upload(InstanceBuilder&& Instances);
+
+	InstanceFormat GetFormat() const;
+	uint32_t GetCount() const;
+	// Bytes of the instance buffer, plus the compacted copy and draw commands while culling
+	size_t GetMemorySize() const;
+
+	// Draws only the instances the last Cull kept, with one indirect draw per mesh. Every instance is drawn
+	// in a frame without a successful Cull
+	void SetCulling(bool IsEnabled);
+	bool IsCulling() const;
+	// Tests the instances placed by Model against the frustum in InstanceCulling.comp and packs the visible ones
+	// into the buffer Draw reads. Call once per frame before Draw while culling is enabled
+	void Cull(Shader& CullingShader, const glm::mat4& Model, const Frustum& View);
+	// Culls the same instances with Cull and with InstanceCulling and compares the visible sets, stalls on the read backs
+	InstanceCullingReport ValidateCulling(Shader& CullingShader, const glm::mat4& Model, const Frustum& View);
+	// Sphere around every mesh in model space, radius in w
+	const glm::vec4& GetBounds() const;
+
+	// Instance.vs reads an instance from up to four vec4 attributes starting here
+	static inline const unsigned int FIRST_INSTANCE_LOCATION = 3U;
+	static inline const unsigned int MAX_INSTANCE_ATTRIBUTES = 4U;
+	// Storage buffers of InstanceCulling.comp
+	static inline const unsigned int INSTANCES_BINDING = 15U;
+	static inline const unsigned int VISIBLE_INSTANCES_BINDING = 16U;
+	static inline const unsigned int DRAW_COMMANDS_BINDING = 17U;
 private:
 	unsigned int m_InstanceVBO;
 	int m_ElementsCount;
-};
+	InstanceFormat m_Format;
+	// Compacted survivors of the culling pass and a DrawElementsIndirectCommand per mesh
+	unsigned int m_VisibleVBO = 0;
+	unsigned int m_CommandBuffer = 0;
+	glm::vec4 m_Bounds = glm::vec4(0.0f);
+	bool m_IsCulling = false;
+	// FrameRingBuffer frame of the last successful Cull
+	uint64_t m_CulledFrame = 0;
 
+	// Copies every instance into the compacted buffer and sets the draw commands to draw all of them
+	void KeepAllInstances();
+	// Points the instance attributes of every mesh at the buffer Draw reads
+	void BindInstanceAttributes();
+	// Reads an instance buffer back into Instances
+	void ReadInstances(unsigned int Buffer, uint32_t Count, std::vector<glm::vec4>& Instances) const;
+};
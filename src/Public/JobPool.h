@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Range of work split in batches, any thread may run the next unclaimed batch
+struct Job
+{
+    std::function<void(uint32_t Begin, uint32_t End)> Function;
+    uint32_t Count = 0;
+    uint32_t BatchSize = 1;
+    std::atomic<uint32_t> Next = 0;
+    std::atomic<uint32_t> RemainingBatches = 0;
+
+    std::mutex DoneMutex;
+    std::condition_variable DoneCondition;
+    bool IsDone = false;
+};
+
+using JobHandle = std::shared_ptr<Job>;
+
+// Worker threads started once and reused for every parallel loop
+class JobPool
+{
+public:
+    static JobPool& GetInstance();
+
+    JobPool(JobPool const&) = delete;
+    void operator=(JobPool const&) = delete;
+
+    // Queues Function(Begin, End) over [0, Count) in batches of BatchSize and returns without waiting.
+    // Whatever the function references has to outlive the matching Wait
+    JobHandle Dispatch(uint32_t Count, uint32_t BatchSize, std::function<void(uint32_t Begin, uint32_t End)> Function);
+    // Runs remaining batches of the job on the calling thread, then blocks until the workers finished theirs
+    void Wait(const JobHandle& Handle);
+    void ParallelFor(uint32_t Count, uint32_t BatchSize, std::function<void(uint32_t Begin, uint32_t End)> Function);
+
+    // Threads besides the one calling Wait
+    uint32_t GetWorkerCount() const;
+
+private:
+    JobPool();
+
+    void WorkerLoop();
+    // Returns false once every batch of the job was claimed
+    static bool RunBatch(Job& Job);
+
+    std::vector<std::thread> m_Workers;
+    std::deque<JobHandle> m_Jobs;
+    std::mutex m_Mutex;
+    std::condition_variable m_WorkAvailable;
+};
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <unordered_map>
 #include <glm/glm.hpp>
 
 #include "Object.h"
@@ -18,17 +19,43 @@ public:
 	void SetIntensity(float Intensity);
 	float GetIntensity();
 	void SetIsOn(bool IsOn);
+	bool GetIsOn() const;
+	// Index into the shader light array, lights that are on are packed in front
+	void SetSlot(unsigned int Slot);
 	unsigned int GetID() const;
 
 	static inline bool isGizmosOn = false;
 protected:
 	unsigned int m_ID;
+	unsigned int m_Slot = 0U;
+	std::string m_ArrayName;
 	std::string m_Prefix;
 
+	// Handles into one program the light was set up with
+	struct LightUniforms
+	{
+		UniformHandle<glm::vec3> Position;
+		UniformHandle<glm::vec3> Direction;
+		UniformHandle<glm::vec3> Color;
+		UniformHandle<float> CutOff;
+		UniformHandle<float> OuterCutOff;
+		UniformHandle<float> Constant;
+		UniformHandle<float> Linear;
+		UniformHandle<float> Quadratic;
+	};
+	// Handles of the program being set up, copied from m_ProgramUniforms
+	LightUniforms m_Uniforms;
+	unsigned int m_UniformsProgram = 0U;
+	// Every program the light was set up with since its slot last changed, the active shader variants
+	// take turns each frame
+	std::unordered_map<unsigned int, LightUniforms> m_ProgramUniforms;
+
 	bool m_IsOn;
 	glm::vec3 m_Color;
 	float m_Intensity;
 
 	void PrintVec(glm::vec3 V);
+	// Resolves the handles once per program, switching between known programs is a lookup
+	void ResolveUniforms(Shader& Shader);
 };
 
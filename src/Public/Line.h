@@ -7,11 +7,17 @@ class Line : public Object
 public:
     Line() = default;
     Line(glm::vec3 Start, glm::vec3 End);
+    Line(const Line& Other);
+    Line(Line&& Other) noexcept;
+
+    ~Line();
+
+    Line& operator=(const Line& Other);
+    Line& operator=(Line&& Other) noexcept;
 
     void Draw(Shader& Shader) override;
 
-    ~Line();
     float vertices[6];
 private:
-    unsigned int m_VAO, m_VBO;
+    unsigned int m_VAO = 0, m_VBO = 0;
 };
\ No newline at end of file
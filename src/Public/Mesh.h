@@ -35,7 +35,8 @@ public:
 
     void Draw(Shader& Shader, unsigned int Amount = 1U);
 
-    static void ResetTextures(Shader& Shader);
+    // Binds the first map of every material type, or its default, to the unit of that type
+    void BindMaterial(Shader& Shader);
 
     unsigned int GetVAO();
     unsigned int GetVBO();
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class CompressedClip;
+class Skeleton;
+
+struct PoseBenchmarkResult
+{
+	// Average microseconds per pose of each kernel and of its scalar reference
+	double SampleUs = 0.0;
+	double ScalarSampleUs = 0.0;
+	double BlendUs = 0.0;
+	double ScalarBlendUs = 0.0;
+	double AdditiveUs = 0.0;
+	double ScalarAdditiveUs = 0.0;
+	double ModelSpaceUs = 0.0;
+	double ScalarModelSpaceUs = 0.0;
+	// Whole Animator update playing one clip on the matrix path, and crossfading two clips on the pose path
+	double AnimatorUs = 0.0;
+	double CrossfadeUs = 0.0;
+	// Largest palette element difference between the SIMD and the scalar kernels
+	float MaxError = 0.0f;
+	uint32_t Joints = 0;
+	int Iterations = 0;
+};
+
+// Local transforms of a skeleton's joints as structure of arrays. Every translation and rotation component
+// has its own array, padded to a multiple of LANES joints so the kernels handle LANES joints per instruction
+// and never a scalar tail. Padding joints hold the identity
+class Pose
+{
+public:
+	enum Stream : uint32_t
+	{
+		TX,
+		TY,
+		TZ,
+		RX,
+		RY,
+		RZ,
+		RW,
+		STREAM_COUNT, // Number of streams in enum
+	};
+
+	Pose() = default;
+	explicit Pose(uint32_t JointCount);
+
+	// Resets every joint to the identity
+	void Resize(uint32_t JointCount);
+	uint32_t GetJointCount() const;
+	uint32_t GetPaddedCount() const;
+	float* GetStream(Stream Stream);
+	const float* GetStream(Stream Stream) const;
+
+	void SetJoint(uint32_t Joint, const glm::vec3& Translation, const glm::quat& Rotation);
+	glm::vec3 GetTranslation(uint32_t Joint) const;
+	glm::quat GetRotation(uint32_t Joint) const;
+
+	// Samples the clip the skeleton was compiled from at Time, in ticks. Joints without a channel or closer than
+	// LeafCulling to a leaf keep the bind pose. Cursors hold two entries per clip channel. Keys are interpolated
+	// with nlerp rather than slerp. Returns the number of sampled joints
+	static uint32_t Sample(const Skeleton& Skeleton, float Time, std::vector<int32_t>& Cursors, Pose& Out,
+		uint32_t LeafCulling = 0, const CompressedClip* Compressed = nullptr);
+	// Weighted sum of translations and normalized weighted sum of rotations. Rotations are first flipped into
+	// the hemisphere of the first pose's, q and -q would cancel out otherwise. Weights are expected to add up to one
+	static void Blend(const Pose* const* Poses, const float* Weights, uint32_t Count, Pose& Out);
+	// Difference from Reference to Source, the layer AddLayer applies
+	static void MakeAdditive(const Pose& Source, const Pose& Reference, Pose& Out);
+	// Base with Weight of the additive layer on top, Out may be Base
+	static void AddLayer(const Pose& Base, const Pose& Additive, float Weight, Pose& Out);
+	// Model space transforms of the joints and the bone palette of the skeleton in a single pass over the joints
+	static void ToModelSpace(const Skeleton& Skeleton, const Pose& Local, std::vector<glm::mat4>& Globals, std::vector<glm::mat4>& Palette);
+
+	// Times each kernel against its scalar version, and a crossfading Animator against one playing a single clip
+	static PoseBenchmarkResult Benchmark(const std::string& ModelPath, const std::string& ClipPath, int Iterations = 1000);
+
+	static inline const uint32_t LANES = 4U;
+
+private:
+	std::vector<float> m_Data;
+	uint32_t m_JointCount = 0;
+	uint32_t m_PaddedCount = 0;
+};
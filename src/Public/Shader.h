@@ -1,8 +1,57 @@
 #pragma once
 
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
 #include <glm/glm.hpp>
 #include <glad/glad.h>
 
+#include "ShaderPermutation.h"
+
+// Location of a uniform resolved once, T is the type on the GLSL side
+template<typename T>
+struct UniformHandle
+{
+    GLint Location = -1;
+
+    bool IsValid() const { return Location >= 0; }
+};
+
+struct UniformInfo
+{
+    GLint Location;
+    GLenum Type;
+    GLint Size;
+};
+
+// Allows looking up std::string keys with const char* without allocating
+struct StringHash
+{
+    using is_transparent = void;
+    size_t operator()(std::string_view Value) const { return std::hash<std::string_view>{}(Value); }
+};
+
+struct ShaderStage
+{
+    GLenum Type;
+    // Used in error messages
+    const char* Name;
+    std::string Path;
+    std::string Source;
+};
+
+enum class ShaderReloadResult
+{
+    NONE,
+    PENDING,
+    SWAPPED,
+    FAILED
+};
+
+using UniformTable = std::unordered_map<std::string, UniformInfo, StringHash, std::equal_to<>>;
+
 class Shader
 {
 public:
@@ -11,13 +60,30 @@ public:
 
     // Read shaders from disk and create them
     Shader(const char* vertexPath, const char* fragmentPath, const char* geometryPath = nullptr);
+    // Variant with the permutation defines injected into both stages
+    Shader(const char* vertexPath, const char* fragmentPath, const ShaderPermutation& Permutation);
     Shader(const char* ComputePath);
 
     ~Shader();
 
+    // Registered in ShaderWatcher by address
+    Shader(const Shader&) = delete;
+    Shader& operator=(const Shader&) = delete;
+
     void Use();
 
-    // Setters for uniforms
+    // Starts rebuilding the program from its files, the current program stays in use until the new one links
+    void Reload();
+    // Swaps in the reloaded program once the driver finished linking it
+    ShaderReloadResult UpdateReload();
+    // Stage types and paths, sources are not kept after linking
+    const std::vector<ShaderStage>& GetStages() const;
+    // Stage files and everything they include
+    const std::vector<std::string>& GetFiles() const;
+    // Takes over the uniform values and block bindings set on another variant of the same sources
+    void CopyState(const Shader& Source);
+
+    // Setters for uniforms, values equal to the last one set are not uploaded again
     void setBool(const char* name, bool value) const;
     void setInt(const char* name, int value) const;
     void setFloat(const char* name, float value) const;
@@ -30,13 +96,84 @@ public:
     void setMat4(const char* name, const glm::mat4& value) const;
     void setBlock(const char* name, unsigned int number);
 
+    // Setters for resolved handles
+    void setBool(UniformHandle<bool> handle, bool value) const;
+    void setInt(UniformHandle<int> handle, int value) const;
+    void setFloat(UniformHandle<float> handle, float value) const;
+    void setVec2(UniformHandle<glm::vec2> handle, const glm::vec2& vector) const;
+    void setVec3(UniformHandle<glm::vec3> handle, const glm::vec3& vector) const;
+    void setVec4(UniformHandle<glm::vec4> handle, const glm::vec4& vector) const;
+    void setMat4(UniformHandle<glm::mat4> handle, const glm::mat4& value) const;
+
+    template<typename T>
+    UniformHandle<T> GetUniform(const char* name) const
+    {
+        return UniformHandle<T>{ GetUniformLocation(name) };
+    }
+
+    GLint GetUniformLocation(const char* name) const;
+    const UniformTable& GetUniforms() const;
+
     static void bindUniformData(GLuint UBO, GLuint Offset, GLuint Size, float* Data);
 
+    // Number of glGetUniformLocation calls made outside of linking since the last reset
+    static unsigned int GetLocationQueryCount();
+    static void ResetLocationQueryCount();
+    // glProgramUniform calls issued and skipped as redundant since the last reset
+    static unsigned int GetUploadCount();
+    static unsigned int GetFilteredUploadCount();
+    static void ResetUploadCount();
+
 protected:
     Shader() = default;
 
-    void CheckCompileErrors(unsigned int ShaderID, const char* ShaderType);
+    // Last value written to a location, applied again to a reloaded program
+    struct UniformValue
+    {
+        GLenum Type = GL_NONE;
+        union
+        {
+            GLint Int;
+            GLfloat Float[16];
+        };
+    };
+
+    // Preprocesses and links the stages and registers the files for hot reload
+    void Build(std::vector<ShaderStage> Stages);
+    // Fills every stage source, Files receives all files read
+    bool Preprocess(std::vector<ShaderStage>& Stages, std::vector<std::string>& Files) const;
+    // Creates ID from the program binary cache, or compiles and links the stages
+    void Link(const std::vector<ShaderStage>& Stages);
+    // Compiles and attaches the stages and issues the link without waiting for it
+    static void BeginLink(GLuint Program, const std::vector<ShaderStage>& Stages, std::vector<GLuint>& Shaders);
+    static void ReleaseShaders(GLuint Program, std::vector<GLuint>& Shaders);
+    static uint64_t GetCacheKey(const std::vector<ShaderStage>& Stages);
+    bool CheckCompileErrors(unsigned int ShaderID, const char* ShaderType);
+    // Fills the uniform and block tables of the linked program
+    void Reflect();
+    // Records the value, returns false when the location already holds it
+    bool StoreValue(GLint Location, GLenum Type, const void* Data, size_t Size) const;
+    // Writes the values recorded for the previous program into the current one
+    void RestoreState(const UniformTable& OldUniforms, const std::vector<UniformValue>& OldValues);
+    void DiscardReload();
+
+    // Mutable as misses are cached from const setters
+    mutable UniformTable m_Uniforms;
+    std::unordered_map<std::string, GLuint, StringHash, std::equal_to<>> m_UniformBlocks;
+    // Indexed by location
+    mutable std::vector<UniformValue> m_UniformValues;
+    std::unordered_map<std::string, unsigned int, StringHash, std::equal_to<>> m_BlockBindings;
+
+    std::vector<ShaderStage> m_Stages;
+    std::vector<std::string> m_Files;
+    std::string m_Defines;
+    GLuint m_PendingProgram = 0;
+    std::vector<GLuint> m_PendingShaders;
+    std::vector<std::string> m_PendingFiles;
+    uint64_t m_PendingKey = 0;
 
-    static inline unsigned int m_ActiveShader = 0U;
+    static inline unsigned int m_LocationQueries = 0U;
+    static inline unsigned int m_UniformUploads = 0U;
+    static inline unsigned int m_FilteredUploads = 0U;
 };
 
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <glad/glad.h>
+
+struct ShaderCacheStats
+{
+    uint32_t Hits = 0;
+    uint32_t Misses = 0;
+    uint32_t Rejected = 0;
+    double BuildMs = 0.0;
+};
+
+// On disk cache of linked program binaries, keyed by program sources and driver
+class ShaderCache
+{
+public:
+    ShaderCache(ShaderCache const&) = delete;
+    void operator=(ShaderCache const&) = delete;
+
+    // Hash of every stage source together with the driver vendor, renderer and version
+    static uint64_t GetKey(const std::vector<std::string>& Sources);
+
+    // Returns false when there is no binary or the driver rejects it
+    static bool Load(GLuint Program, uint64_t Key);
+    static void Save(GLuint Program, uint64_t Key);
+    static void Clear();
+
+    static void AddBuildTime(double Milliseconds);
+    static const ShaderCacheStats& GetStats();
+
+    static inline const char* CACHE_DIRECTORY = "cache/shaders";
+
+private:
+    ShaderCache() = default;
+
+    static std::string GetPath(uint64_t Key);
+    static const std::string& GetDriverString();
+
+    static inline ShaderCacheStats m_Stats;
+};
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Compile time switches, each one is a #define in the generated source
+enum class ShaderFeature : uint32_t
+{
+    SKINNING = 1U << 0,
+    SHADOWS = 1U << 1,
+    REFRACTION = 1U << 2,
+    BAKED_ANIMATION = 1U << 3
+};
+
+// Compile time configuration of a shader, every distinct key is a separate program
+struct ShaderPermutation
+{
+    uint32_t Features = 0U;
+    uint8_t PointLights = 0U;
+    uint8_t SpotLights = 0U;
+    uint8_t DirLights = 0U;
+
+    // Features chosen per drawn object rather than per frame
+    static inline const uint32_t OBJECT_FEATURES = uint32_t(ShaderFeature::SKINNING) | uint32_t(ShaderFeature::REFRACTION) |
+                                                   uint32_t(ShaderFeature::BAKED_ANIMATION);
+
+    bool Has(ShaderFeature Feature) const;
+    ShaderPermutation With(ShaderFeature Feature, bool IsEnabled = true) const;
+
+    uint32_t GetKey() const;
+    // Same frame wide configuration, object features may differ
+    bool SharesScene(const ShaderPermutation& Other) const;
+    // Defines block inserted after #version
+    std::string GetDefines() const;
+    std::string GetName() const;
+};
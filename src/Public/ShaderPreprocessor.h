@@ -0,0 +1,23 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// Expands #include "file" directives and injects defines after the #version line
+class ShaderPreprocessor
+{
+public:
+    ShaderPreprocessor(ShaderPreprocessor const&) = delete;
+    void operator=(ShaderPreprocessor const&) = delete;
+
+    // Files lists the stage file followed by every included file, its index is the #line source number
+    static bool Process(const std::string& Path, const std::string& Defines, std::string& Source, std::vector<std::string>& Files);
+
+    static inline const int MAX_INCLUDE_DEPTH = 16;
+
+private:
+    ShaderPreprocessor() = default;
+
+    static bool Expand(const std::filesystem::path& Path, const std::string& Defines, std::string& Source, std::vector<std::string>& Files, int Depth);
+};
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "Shader.h"
+#include "ShaderPermutation.h"
+
+// Permutations of one vertex and fragment pair, each variant is compiled the first time it is requested
+class ShaderVariants
+{
+public:
+    ShaderVariants(const char* VertexPath, const char* FragmentPath);
+
+    ShaderVariants(const ShaderVariants&) = delete;
+    ShaderVariants& operator=(const ShaderVariants&) = delete;
+
+    // Frame wide part of the permutation, objects add their own features on top
+    void SetBase(const ShaderPermutation& Permutation);
+    const ShaderPermutation& GetBase() const;
+
+    // Compiled variants start with the uniform state of the variant used before them
+    Shader& Get(const ShaderPermutation& Permutation);
+
+    // Calls Function for every compiled variant sharing the base permutation
+    template<typename F>
+    void ForEachActive(F&& Function)
+    {
+        for (auto& [key, variant] : m_Variants)
+        {
+            if (variant.Permutation.SharesScene(m_Base))
+            {
+                Function(*variant.Program);
+            }
+        }
+    }
+
+    size_t GetCount() const;
+    void DrawGUI(const char* Name) const;
+
+private:
+    struct Variant
+    {
+        ShaderPermutation Permutation;
+        std::unique_ptr<Shader> Program;
+    };
+
+    std::string m_VertexPath;
+    std::string m_FragmentPath;
+    ShaderPermutation m_Base;
+    std::unordered_map<uint32_t, Variant> m_Variants;
+    Shader* m_LastUsed = nullptr;
+};
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <glad/glad.h>
+
+class Shader;
+
+struct ShaderWatcherStats
+{
+    uint32_t Reloads = 0;
+    uint32_t Failures = 0;
+    uint32_t Pending = 0;
+};
+
+// Watches the source files of every shader and recompiles programs whose files changed
+class ShaderWatcher
+{
+public:
+    static ShaderWatcher& GetInstance();
+
+    ShaderWatcher(ShaderWatcher const&) = delete;
+    void operator=(ShaderWatcher const&) = delete;
+
+    // Called by Shader once its program is linked and on destruction
+    void Add(Shader* Shader);
+    void Remove(Shader* Shader);
+
+    // Starts reloads of changed files and swaps in programs that finished linking, call once per frame
+    void Update();
+
+    // True when KHR_parallel_shader_compile is exposed, links then run on driver threads
+    bool HasParallelCompile() const;
+    // Without parallel compile this is always true and the link status query blocks instead
+    bool IsLinkComplete(GLuint Program) const;
+
+    const ShaderWatcherStats& GetStats() const;
+
+    bool IsEnabled = true;
+
+private:
+    ShaderWatcher();
+
+    // Normalized paths of the files that changed since the last call
+    std::vector<std::string> PollChanges();
+    void WatchFile(const std::string& Path);
+    static std::string Normalize(const std::string& Path);
+
+    std::unordered_map<std::string, std::vector<Shader*>> m_Files;
+    std::vector<Shader*> m_Pending;
+    ShaderWatcherStats m_Stats;
+    bool m_HasParallelCompile = false;
+
+#ifdef __linux__
+    int m_Inotify = -1;
+    // Watch descriptor to directory, editors replace files so directories are watched
+    std::unordered_map<int, std::string> m_Directories;
+#else
+    std::unordered_map<std::string, std::filesystem::file_time_type> m_WriteTimes;
+    double m_LastPoll = 0.0;
+#endif
+};
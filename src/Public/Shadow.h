@@ -2,6 +2,8 @@
 
 #include "DirectionalLight.h"
 
+#include <functional>
+
 class Shader;
 class Entity;
 
@@ -13,6 +15,8 @@ public:
 	~Shadow();
 
 	void SetupMap(Shader& Shader, DirectionalLight& Light, Entity& Root);
+	// Adds draws with other shaders to the map rendered by SetupMap, they set lightSpaceMatrix from GetLightSpace
+	void DrawToMap(const std::function<void()>& Draw);
 	// Bind shadow map to specified texture
 	void BindShadowMap(unsigned int Number);
 
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <string>
+#include <vector>
+
+class Animation;
+class SkinnedModel;
+struct AssimpNodeData;
+
+struct SkeletonJoint
+{
+	// Always lower than the joint's own index, -1 for the root
+	int32_t Parent;
+	// Slot in the final bone matrices, -1 for nodes no vertex is weighted to
+	int32_t BoneID;
+	// Index of the clip channel animating the joint, -1 keeps the bind pose
+	int32_t Channel;
+	// Joints between this one and the deepest leaf under it, 0 for leaves such as finger tips
+	uint32_t LeafDistance;
+	glm::mat4 BindLocal;
+	// BindLocal split for Pose, which keeps translations and rotations apart
+	glm::vec3 BindPosition;
+	glm::quat BindRotation;
+	glm::mat4 Offset;
+};
+
+// Node hierarchy of a clip compiled against the bones of a model. Joints are stored parent before child
+// so a pose is evaluated in a single pass over the array, without name lookups
+class Skeleton
+{
+public:
+	Skeleton(const Animation& Clip, SkinnedModel& Model);
+
+	const std::vector<SkeletonJoint>& GetJoints() const;
+	uint32_t GetJointCount() const;
+	// Number of final bone matrices the joints write to
+	uint32_t GetPaletteSize() const;
+	// Joints animated by a clip channel
+	uint32_t GetChannelCount() const;
+	// Returns -1 when there is no node with the name
+	int32_t FindJoint(const std::string& Name) const;
+	const Animation* GetClip() const;
+	size_t GetMemorySize() const;
+
+private:
+	void AddJoint(const AssimpNodeData& Node, int32_t Parent, const Animation& Clip, SkinnedModel& Model);
+
+	std::vector<SkeletonJoint> m_Joints;
+	// Parallel to m_Joints, only read by FindJoint
+	std::vector<std::string> m_Names;
+	uint32_t m_PaletteSize = 0;
+	uint32_t m_ChannelCount = 0;
+	const Animation* m_Clip = nullptr;
+};
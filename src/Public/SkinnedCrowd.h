@@ -0,0 +1,108 @@
+#pragma once
+
+#include "Public/AnimationSystem.h"
+#include "Public/GPUClipEvaluator.h"
+
+#include <glm/glm.hpp>
+#include <memory>
+#include <vector>
+
+class Animation;
+class Animator;
+class CompressedClip;
+class GPUClipEvaluator;
+class Skeleton;
+class Shader;
+class SkinnedModel;
+
+// Characters sharing one SkinnedModel and clip, each one only owns its Animator. Palettes of all characters go to the frame's bone buffer
+// together and every mesh is drawn once for the whole crowd
+class SkinnedCrowd
+{
+public:
+	// The skeleton comes from AnimationLibrary, crowds playing the same clip share it
+	SkinnedCrowd(SkinnedModel& Model, std::shared_ptr<const Animation> Clip);
+	~SkinnedCrowd();
+
+	SkinnedCrowd(const SkinnedCrowd&) = delete;
+	SkinnedCrowd& operator=(const SkinnedCrowd&) = delete;
+
+	// TimeOffset in seconds spreads characters over the clip
+	void Add(const glm::mat4& Transform, float TimeOffset = 0.0f);
+	void SetTransform(uint32_t Index, const glm::mat4& Transform);
+
+	// Pre-skinned crowds are skinned once per frame by a compute pass into Vertex layout buffers,
+	// so every pass draws them with the static mesh shaders instead of skinning again
+	void SetPreSkinned(bool IsPreSkinned);
+	bool IsPreSkinned() const;
+
+	// Camera the next Update picks each character's animation LOD for, without one every character runs at full rate
+	void SetView(const glm::mat4& View, const glm::mat4& Projection);
+	void SetLodSettings(const AnimationLodSettings& Settings);
+
+	// Clips of GPU evaluated crowds are sampled by a compute pass writing the palettes into the frame's bone buffer,
+	// the animators only keep the clocks. LOD and the pose cache do not apply
+	void SetGPUEvaluation(bool IsGPUEvaluation);
+	bool IsGPUEvaluation() const;
+
+	// Publishes the update started last frame and starts the next one, drawing reads the published palettes
+	void Update(float DeltaTime);
+	// Pushes the frame's palettes and objects and runs the skinning pass, SkinningShader is Skinning.comp and
+	// EvaluationShader is ClipEvaluation.comp. Call after FrameRingBuffer::BeginFrame and before the first Draw of the frame
+	void Prepare(Shader& SkinningShader, Shader& EvaluationShader);
+	// Needs the static variant of the shader when pre-skinned and the SKINNING variant otherwise
+	void Draw(Shader& Shader);
+
+	uint32_t GetCount() const;
+	// Bytes of the pre-skinned vertex buffers
+	size_t GetPreSkinnedSize() const;
+	AnimationSystem& GetAnimationSystem();
+
+	static inline const uint32_t SKINNED_VERTICES_BINDING = 5U;
+	static inline const uint32_t VERTICES_BINDING = 6U;
+
+private:
+	// Skinned copies of one mesh for every character and the draw command of each copy
+	struct PreSkinnedMesh
+	{
+		uint32_t VAO = 0;
+		uint32_t VBO = 0;
+		uint32_t IndirectBuffer = 0;
+		uint32_t VertexCount = 0;
+		uint32_t IndexCount = 0;
+	};
+
+	// From the bounds of each character against the view set last
+	void UpdateLod();
+	// Reserves the palettes in the frame's bone buffer and dispatches their evaluation, returns the first bone
+	uint32_t EvaluateOnGPU(Shader& EvaluationShader);
+	// Sized for the current character count
+	void CreatePreSkinnedMeshes();
+	void ReleasePreSkinnedMeshes();
+
+	SkinnedModel& m_Model;
+	std::shared_ptr<const Animation> m_Clip;
+	std::shared_ptr<const Skeleton> m_Skeleton;
+	std::vector<std::unique_ptr<Animator>> m_Animators;
+	std::vector<glm::mat4> m_Transforms;
+	// Sphere around the bind pose in model space, with room for poses reaching out of it
+	glm::vec3 m_BoundsCenter = glm::vec3(0.0f);
+	float m_BoundsRadius = 0.0f;
+	glm::mat4 m_View = glm::mat4(1.0f);
+	glm::mat4 m_Projection = glm::mat4(1.0f);
+	bool m_HasView = false;
+	AnimationLodSettings m_LodSettings;
+	bool m_IsGPUEvaluation = false;
+	// Created the first time the crowd is evaluated on the GPU
+	std::unique_ptr<CompressedClip> m_CompressedClip;
+	std::unique_ptr<GPUClipEvaluator> m_Evaluator;
+	std::vector<GPUClipInstance> m_GPUInstances;
+	bool m_IsPreSkinned = false;
+	std::vector<PreSkinnedMesh> m_PreSkinnedMeshes;
+	uint32_t m_PreSkinnedCapacity = 0;
+	// Object of the first character in the frame Prepare ran for, frame numbers start at 1
+	uint32_t m_FirstObject = 0;
+	uint64_t m_PreparedFrame = 0;
+	// Declared last so it is destroyed first, waiting for the update that uses the animators
+	AnimationSystem m_System;
+};
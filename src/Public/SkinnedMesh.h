@@ -1,4 +1,5 @@
 #pragma once
+#include <string>
 #include <vector>
 #include "glm/glm.hpp"
 #include "Public/Texture.h"
@@ -15,6 +16,27 @@ struct SkinnedVertex
 };
 
 
+// Offset of one vertex in one morph target, components quantized to 16 bits against the target's scales.
+// std430 element of the "MorphDeltas" storage buffer, read as uvec4 in Morph.comp
+struct MorphDelta
+{
+    uint32_t Vertex;
+    int16_t Position[3];
+    int16_t Normal[3];
+};
+
+// Blend shape of a mesh, only the vertices it moves have a delta
+struct MorphTarget
+{
+    std::string Name;
+    uint32_t FirstDelta = 0;
+    uint32_t DeltaCount = 0;
+    // Model units and normal units per quantization step
+    float PositionScale = 0.0f;
+    float NormalScale = 0.0f;
+    float Weight = 0.0f;
+};
+
 class Vertex;
 class Shader;
 class Texture;
@@ -28,7 +50,8 @@ public:
 
     static inline std::vector<Texture> DefaultTextures = {};
 
-    SkinnedMesh(std::vector<SkinnedVertex> vertexes, std::vector<uint32_t> indexes, std::vector<Texture> textures);
+    SkinnedMesh(std::vector<SkinnedVertex> vertexes, std::vector<uint32_t> indexes, std::vector<Texture> textures,
+        std::vector<MorphTarget> morphTargets = {}, std::vector<MorphDelta> morphDeltas = {});
     SkinnedMesh(const SkinnedMesh& Other);
     SkinnedMesh(SkinnedMesh&& Other) noexcept;
 
@@ -39,13 +62,35 @@ public:
 
     void Draw(Shader& Shader, uint32_t Amount = 1U);
 
-    static void ResetTextures(Shader& Shader);
+    // Binds the first map of every material type, or its default, to the unit of that type
+    void BindMaterial(Shader& Shader);
+
+    uint32_t GetMorphTargetCount() const;
+    const MorphTarget& GetMorphTarget(uint32_t Index) const;
+    // Takes effect on the next ApplyMorphs
+    void SetMorphWeight(uint32_t Index, float Weight);
+    // Rewrites the vertex buffer from the bind pose plus every target with a nonzero weight, only when a weight
+    // changed since the last call. MorphShader is Morph.comp. Skinning reads the result after the barrier it issues
+    void ApplyMorphs(Shader& MorphShader);
+    // Bytes of the sparse deltas, and of the same targets stored as a full position and normal delta per vertex
+    size_t GetMorphMemorySize() const;
+    size_t GetDenseMorphMemorySize() const;
 
     uint32_t GetVAO();
     uint32_t GetVBO();
     uint32_t GetEBO();
 
+    static inline const uint32_t MORPH_DELTAS_BINDING = 13U;
+    static inline const uint32_t MORPH_VERTICES_BINDING = 14U;
+
 protected:
     uint32_t m_VBO, m_VAO, m_EBO;
+    // Unmorphed copy of the vertex buffer and the deltas of all targets, only created for meshes with targets
+    uint32_t m_MorphBaseVBO = 0;
+    uint32_t m_MorphDeltaBuffer = 0;
+    std::vector<MorphTarget> m_MorphTargets;
+    std::vector<MorphDelta> m_MorphDeltas;
+    bool m_IsMorphDirty = false;
     void SetupMesh();
+    void SetupMorphs();
 };
\ No newline at end of file
@@ -19,10 +19,16 @@ class SkinnedModel : public Object
 public:
     SkinnedModel(const char* Path);
     virtual void Draw(Shader& Shader) override;
+    // One draw per mesh for Count characters whose object data was pushed consecutively from FirstObject
+    void DrawInstanced(Shader& Shader, uint32_t FirstObject, uint32_t Count);
 
     SkinnedMesh& GetMesh(uint32_t Index);
 
     uint32_t GetMeshCount() const;
+    // Sets the weight of the targets with this name in every mesh
+    void SetMorphWeight(const std::string& Name, float Weight);
+    // SkinnedMesh::ApplyMorphs for every mesh, call before the first draw or skinning pass of the frame
+    void ApplyMorphs(Shader& MorphShader);
     auto& GetBoneInfoMap() { return m_BoneInfoMap; }
     int32_t& GetBoneCount() { return m_BoneCounter; }
 protected:
@@ -40,6 +46,8 @@ private:
     void ProcessNode(aiNode* node, const aiScene* scene);
     SkinnedMesh ProcessMesh(aiMesh* mesh, const aiScene* scene);
     void ExtractBoneWeightForVertices(std::vector<SkinnedVertex>& vertices, aiMesh* mesh, const aiScene* scene);
+    // Keeps only the vertices each aiAnimMesh moves, as quantized deltas
+    void ExtractMorphTargets(const std::vector<SkinnedVertex>& vertices, aiMesh* mesh, std::vector<MorphTarget>& targets, std::vector<MorphDelta>& deltas);
     std::vector<Texture> LoadMaterialTextures(aiMaterial* material, aiTextureType type, TextureType typeName);
 };
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "PointLight.h"
+#include "Line.h"
 
 class SpotLight : public PointLight
 {
@@ -27,6 +28,12 @@ private:
 	float m_LightAngle;
 	float m_Outer;
 
+	// Cone gizmo, rebuilt only when its shape changes
+	Circle m_ConeGizmo;
+	Line m_ConeLines[4];
+	float m_ConeRadius = -1.0f;
+	float m_ConeLength = -1.0f;
+
 	const unsigned int MAX_LIGHT_NUMBER = 2U;
 	static inline unsigned int m_IDCounter = 0U;
 };
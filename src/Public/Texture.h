@@ -30,13 +30,13 @@ public:
     // Create custom texture
     Texture(int Width, int Height, int NrChannels);
 
-    //Texture(const Texture& Other);
-    //Texture(Texture&& Other) noexcept;
+    Texture(const Texture& Other);
+    Texture(Texture&& Other) noexcept;
 
-    //~Texture();
+    ~Texture();
 
-    //Texture& operator=(Texture& Other);
-    //Texture& operator=(Texture&& Other) noexcept;
+    Texture& operator=(const Texture& Other);
+    Texture& operator=(Texture&& Other) noexcept;
 
     // Bind texture to specified texture
     void BindTexture(GLuint Number);
@@ -47,6 +47,10 @@ public:
     int GetWidth() const;
     int GetHeight() const;
 
+    // Name of the sampler in the material struct, nullptr for untyped textures
+    static const char* GetMaterialUniformName(TextureType Type, unsigned int Number);
+    static const unsigned int MAX_MATERIAL_MAPS = 8U;
+
 private:
     void LoadTexture(bool IsStandarised = false);
     void LoadTextureHDR();
@@ -3,17 +3,40 @@
 #include "imgui_impl/imgui_impl_opengl3.h"
 
 #include "Public/Shader.h"
+#include "Public/ShaderCache.h"
+#include "Public/ShaderWatcher.h"
+#include "Public/ShaderVariants.h"
 #include "Public/Camera.h"
 
 #include "Public/Texture.h"
+#include "Public/HDRLoader.h"
+#include "Public/Animator.h"
+#include "Public/Bone.h"
+#include "Public/Pose.h"
+#include "Public/CompressedClip.h"
+#include "Public/AnimationSystem.h"
+#include "Public/BakedAnimation.h"
+#include "Public/BakedCrowd.h"
+#include "Public/Animation.h"
+#include "Public/AnimationLibrary.h"
+#include "Public/ClipCache.h"
+#include "Public/SkinnedCrowd.h"
+#include "Public/GPUClipEvaluator.h"
+#include "Public/CPUSkinning.h"
+#include "Public/SkinnedModel.h"
 #include "Public/CubeMap.h"
 #include "Public/PBRManager.h"
 #include "Public/BloomRenderer.h"
+#include "Public/GPUResourceTracker.h"
+#include "Public/FrameRingBuffer.h"
+#include "Public/GLState.h"
+#include "Public/GPUTimer.h"
 
 #include "Public/ParticleSystem.h"
 
 #include "Public/Model.h"
 #include "Public/InstancedModel.h"
+#include "Public/InstanceCulling.h"
 #include "Public/Cube.h"
 #include "Public/Quad.h"
 #include "Public/Entity.h"
@@ -63,6 +86,7 @@ void MouseCallback(GLFWwindow* window, double xoffset, double yoffset)
 }
 
 bool isSpotlightOn = true;
+bool isShadows = true;
 void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods)
 {
     if (action == GLFW_PRESS)
@@ -145,570 +169,1116 @@ int main(int, char**)
     // Setup style
     ImGui::StyleColorsDark();
 
-    unsigned int amount = 1000000U;
-    std::vector<glm::mat4> modelMatrices;
-    modelMatrices.reserve(amount);
-    srand(glfwGetTime()); // zainicjuj losowe ziarno
-    float radius = 80.0;
-    float offset = 20.0f;
-    for (unsigned int i = 0; i < amount; ++i)
+    // Scene scope, all of its GL objects are released before the leak report
     {
-        glm::mat4 model = glm::mat4(1.0f);
-        // 1. translacja: przesuwaj po okręgu o "promieniu" w zakresie [-offset, offset]
-        float angle = (float)i / (float)amount * 360.0f;
-        float displacement = (rand() % (int)(2 * offset * 100)) / 100.0f - offset;
-        float x = sin(angle) * radius + displacement;
-        displacement = (rand() % (int)(2 * offset * 100)) / 100.0f - offset;
-        float y = displacement * 0.4f; // keep height of field smaller compared to width of x and z
-        displacement = (rand() % (int)(2 * offset * 100)) / 100.0f - offset;
-        float z = cos(angle) * radius + displacement;
-        model = glm::translate(model, glm::vec3(x, y, z));
-
-        // 2. Skala: przeskaluj od 0.05 do 0.25f
-        float scale = (rand() % 20) / 100.0f + 0.05;
-        model = glm::scale(model, glm::vec3(scale));
-
-        // 3. rotation: dodaj losow¹ rotacjê wokó³ (pó³) losowo wybranego wektora osi obrotu
-        float rotAngle = (rand() % 360);
-        model = glm::rotate(model, rotAngle, glm::vec3(0.4f, 0.6f, 0.8f));
-
-        // 4. teraz dodaj do listy macierzy
-        modelMatrices.push_back(model);
-    }
-
-    glEnable(GL_DEPTH_TEST);
-    // set depth function to less than AND equal for skybox depth trick.
-    glDepthFunc(GL_LEQUAL);
-    // enable seamless cubemap sampling for lower mip levels in the pre-filter map.
-    glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
-
-    Shader lightShader("res/shaders/MVP.vs", "res/shaders/LightGizmo.fs");
-    Shader screenShader("res/shaders/Screen.vs", "res/shaders/Screen.fs");
-    Shader skyBoxShader("res/shaders/SkyBox.vs", "res/shaders/SkyBox.fs");
-    Shader normalShader("res/shaders/Normals.vs", "res/shaders/Normals.fs", "res/shaders/Normals.gs");
-    Shader shadowShader("res/shaders/ShadowMap.vs", "res/shaders/ShadowMap.fs");
-    Shader instanceShader("res/shaders/Instance.vs", "res/shaders/Instance.fs");
-    Shader blurShader("res/shaders/Screen.vs", "res/shaders/Blur.fs");
-    Shader particleShader("res/shaders/Particle.vert", "res/shaders/Particle.frag");
-    Shader computeShader("res/shaders/Compute.comp");
-
-    Shader PBRShader("res/shaders/PBR/PBR.vs", "res/shaders/PBR/PBR.fs");
-    Shader equirectangularShader("res/shaders/PBR/CubeMap.vs", "res/shaders/PBR/Equirectangular.fs");
-    Shader irradianceShader("res/shaders/PBR/CubeMap.vs", "res/shaders/PBR/IrradianceConvolution.fs");
-    Shader prefilterShader("res/shaders/PBR/CubeMap.vs", "res/shaders/PBR/Prefilter.fs");
-    Shader BRDFShader("res/shaders/PBR/BRDF.vs", "res/shaders/PBR/BRDF.fs");
-
-    Model generator("res/models/generator/generator.obj");
-    InstancedModel box("res/models/box/box.obj", modelMatrices);
-    //Model Scene1 = Model("res/models/sponza/Sponza.gltf");
-    Model Scene2 = Model("res/models/bistro/bistro.gltf");
-    // pbr: load the HDR environment map
-    // ---------------------------------
-    Texture HDR("res/textures/Canyon/Canyon.hdr");
-
-    // pbr: setup cubemap to render to and attach to framebuffer
-    // ---------------------------------------------------------
-    CubeMap Environment(512, 512);
-
-    CubeMap Irradiance(32, 32);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, Irradiance.GetId());
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-
-    CubeMap Prefilter(128, 128);
-
-    Texture BRDF(512, 512, 2);
-
-    PBRManager::GetInstance().SetupEquirectangular(equirectangularShader, HDR, Environment);
-    PBRManager::GetInstance().SetupIrradiance(irradianceShader, Irradiance, Environment);
-    PBRManager::GetInstance().SetupPrefilter(prefilterShader, Prefilter, Environment);
-    PBRManager::GetInstance().SetupBRDF(BRDFShader, BRDF);
-
-    BloomRenderer bloomRenderer(WINDOW_WIDTH, WINDOW_HEIGHT);
-
-    Camera camera;
-
-    std::vector<PointLight> pointLights =
-    {
-        PointLight(pointLightPositions[0], glm::vec3(1.0f, 0.078f, 0.576f), AttenuationDist::D_7),
-        PointLight(pointLightPositions[1], glm::vec3(1.0f, 0.078f, 0.576f), AttenuationDist::D_7),
-        PointLight(pointLightPositions[2], glm::vec3(1.0f, 0.078f, 0.576f), AttenuationDist::D_7),
-        PointLight(pointLightPositions[3], glm::vec3(1.0f, 0.078f, 0.576f), AttenuationDist::D_7),
-    };
-    for (PointLight& light : pointLights)
-    {
-        light.SetIntensity(30.0f);
-    }
+        // The ring is rebuilt from the same seed when its instance format changes
+        const unsigned int ringSeed = glfwGetTime(); // zainicjuj losowe ziarno
+        auto buildRing = [ringSeed](InstanceFormat Format)
+        {
+            unsigned int amount = 1000000U;
+            InstanceBuilder instances(Format, amount);
+            srand(ringSeed);
+            float radius = 80.0;
+            float offset = 20.0f;
+            for (unsigned int i = 0; i < amount; ++i)
+            {
+                glm::mat4 model = glm::mat4(1.0f);
+                // 1. translacja: przesuwaj po okręgu o "promieniu" w zakresie [-offset, offset]
+                float angle = (float)i / (float)amount * 360.0f;
+                float displacement = (rand() % (int)(2 * offset * 100)) / 100.0f - offset;
+                float x = sin(angle) * radius + displacement;
+                displacement = (rand() % (int)(2 * offset * 100)) / 100.0f - offset;
+                float y = displacement * 0.4f; // keep height of field smaller compared to width of x and z
+                displacement = (rand() % (int)(2 * offset * 100)) / 100.0f - offset;
+                float z = cos(angle) * radius + displacement;
+                model = glm::translate(model, glm::vec3(x, y, z));
+
+                // 2. Skala: przeskaluj od 0.05 do 0.25f
+                float scale = (rand() % 20) / 100.0f + 0.05;
+                model = glm::scale(model, glm::vec3(scale));
+
+                // 3. rotation: dodaj losow¹ rotacjê wokó³ (pó³) losowo wybranego wektora osi obrotu
+                float rotAngle = (rand() % 360);
+                model = glm::rotate(model, rotAngle, glm::vec3(0.4f, 0.6f, 0.8f));
+
+                // 4. teraz dodaj do listy macierzy
+                instances.Add(model);
+            }
+            return instances;
+        };
+
+        GLState::Enable(GL_DEPTH_TEST);
+        // set depth function to less than AND equal for skybox depth trick.
+        GLState::DepthFunc(GL_LEQUAL);
+        // enable seamless cubemap sampling for lower mip levels in the pre-filter map.
+        GLState::Enable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
+
+        Shader lightShader("res/shaders/MVP.vs", "res/shaders/LightGizmo.fs");
+        Shader screenShader("res/shaders/Screen.vs", "res/shaders/Screen.fs");
+        Shader skyBoxShader("res/shaders/SkyBox.vs", "res/shaders/SkyBox.fs");
+        Shader normalShader("res/shaders/Normals.vs", "res/shaders/Normals.fs", "res/shaders/Normals.gs");
+        Shader shadowShader("res/shaders/ShadowMap.vs", "res/shaders/ShadowMap.fs");
+        Shader instanceShader("res/shaders/Instance.vs", "res/shaders/Instance.fs");
+        Shader blurShader("res/shaders/Screen.vs", "res/shaders/Blur.fs");
+        Shader particleShader("res/shaders/Particle.vert", "res/shaders/Particle.frag");
+        Shader computeShader("res/shaders/Compute.comp");
+        Shader skinningShader("res/shaders/Skinning.comp");
+        Shader clipEvaluationShader("res/shaders/ClipEvaluation.comp");
+        Shader morphShader("res/shaders/Morph.comp");
+        Shader instanceCullingShader("res/shaders/InstanceCulling.comp");
+        Shader skinnedShadowShader("res/shaders/ShadowMap.vs", "res/shaders/ShadowMap.fs", ShaderPermutation().With(ShaderFeature::SKINNING));
+
+        // Variants are compiled once the lights select a permutation
+        ShaderVariants PBRShaders("res/shaders/PBR/PBR.vs", "res/shaders/PBR/PBR.fs");
+        Shader equirectangularShader("res/shaders/PBR/CubeMap.vs", "res/shaders/PBR/Equirectangular.fs");
+        Shader irradianceShader("res/shaders/PBR/CubeMap.vs", "res/shaders/PBR/IrradianceConvolution.fs");
+        Shader prefilterShader("res/shaders/PBR/CubeMap.vs", "res/shaders/PBR/Prefilter.fs");
+        Shader BRDFShader("res/shaders/PBR/BRDF.vs", "res/shaders/PBR/BRDF.fs");
+
+        Model generator("res/models/generator/generator.obj");
+        int ringFormat = int(InstanceFormat::QUAT_SCALE);
+        InstancedModel box("res/models/box/box.obj", buildRing(InstanceFormat(ringFormat)));
+        //Model Scene1 = Model("res/models/sponza/Sponza.gltf");
+        Model Scene2 = Model("res/models/bistro/bistro.gltf");
+        // pbr: load the HDR environment map
+        // ---------------------------------
+        Texture HDR("res/textures/Canyon/Canyon.hdr");
+
+        // pbr: setup cubemap to render to and attach to framebuffer
+        // ---------------------------------------------------------
+        CubeMap Environment(512, 512);
+
+        CubeMap Irradiance(32, 32);
+        GLState::BindTexture(GL_TEXTURE_CUBE_MAP, Irradiance.GetId());
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+
+        CubeMap Prefilter(128, 128);
+
+        Texture BRDF(512, 512, 2);
+
+        PBRManager::GetInstance().SetupEquirectangular(equirectangularShader, HDR, Environment);
+        PBRManager::GetInstance().SetupIrradiance(irradianceShader, Irradiance, Environment);
+        PBRManager::GetInstance().SetupPrefilter(prefilterShader, Prefilter, Environment);
+        PBRManager::GetInstance().SetupBRDF(BRDFShader, BRDF);
+
+        BloomRenderer bloomRenderer(WINDOW_WIDTH, WINDOW_HEIGHT);
+
+        Camera camera;
+
+        std::vector<PointLight> pointLights =
+        {
+            PointLight(pointLightPositions[0], glm::vec3(1.0f, 0.078f, 0.576f), AttenuationDist::D_7),
+            PointLight(pointLightPositions[1], glm::vec3(1.0f, 0.078f, 0.576f), AttenuationDist::D_7),
+            PointLight(pointLightPositions[2], glm::vec3(1.0f, 0.078f, 0.576f), AttenuationDist::D_7),
+            PointLight(pointLightPositions[3], glm::vec3(1.0f, 0.078f, 0.576f), AttenuationDist::D_7),
+        };
+        for (PointLight& light : pointLights)
+        {
+            light.SetIntensity(30.0f);
+        }
 
-    std::vector<DirectionalLight> dirLights =
-    {
-        DirectionalLight(glm::vec3(0.0f, -15.0f, 4.0f), glm::vec3(0.5647f, 0.7529f, 0.8745f))
-    };
-    dirLights[0].SetIntensity(2.0f);
+        std::vector<DirectionalLight> dirLights =
+        {
+            DirectionalLight(glm::vec3(0.0f, -15.0f, 4.0f), glm::vec3(0.5647f, 0.7529f, 0.8745f))
+        };
+        dirLights[0].SetIntensity(2.0f);
 
-    std::vector<SpotLight> spotLights =
-    {
-        SpotLight(camera.Position, camera.ForwardVector, glm::vec3(1.0f)),
-        SpotLight(glm::vec3(-5.0f, 7.0f, 0.5f), glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(1.0f))
-    };
-    for (SpotLight& light : spotLights)
-    {
-        light.SetIntensity(100.0f);
-    }
-    spotLights[0].SetAttenuationParams(AttenuationDist::D_20);
-    spotLights[1].SetAttenuationParams(AttenuationDist::D_7);
+        std::vector<SpotLight> spotLights =
+        {
+            SpotLight(camera.Position, camera.ForwardVector, glm::vec3(1.0f)),
+            SpotLight(glm::vec3(-5.0f, 7.0f, 0.5f), glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(1.0f))
+        };
+        for (SpotLight& light : spotLights)
+        {
+            light.SetIntensity(100.0f);
+        }
+        spotLights[0].SetAttenuationParams(AttenuationDist::D_20);
+        spotLights[1].SetAttenuationParams(AttenuationDist::D_7);
 
-    std::vector<Light*> lights;
-    lights.reserve(pointLights.size() + dirLights.size() + spotLights.size());
-    for (Light& light : pointLights)
-    {
-        lights.push_back(&light);
-    }
-    for (Light& light : dirLights)
-    {
-        lights.push_back(&light);
-    }
-    for (Light& light : spotLights)
-    {
-        lights.push_back(&light);
-    }
+        // Lights that are on take the first slots of their array, the counts select the PBR variant
+        auto updateLightSlots = [&]()
+        {
+            ShaderPermutation permutation;
+            for (PointLight& light : pointLights)
+            {
+                if (light.GetIsOn())
+                {
+                    light.SetSlot(permutation.PointLights++);
+                }
+            }
+            for (SpotLight& light : spotLights)
+            {
+                if (light.GetIsOn())
+                {
+                    light.SetSlot(permutation.SpotLights++);
+                }
+            }
+            for (DirectionalLight& light : dirLights)
+            {
+                if (light.GetIsOn())
+                {
+                    light.SetSlot(permutation.DirLights++);
+                }
+            }
+            // Only the first directional light has a shadow map
+            PBRShaders.SetBase(permutation.With(ShaderFeature::SHADOWS, isShadows && dirLights[0].GetIsOn()));
+        };
 
+        std::vector<Light*> lights;
+        lights.reserve(pointLights.size() + dirLights.size() + spotLights.size());
+        for (Light& light : pointLights)
+        {
+            lights.push_back(&light);
+        }
+        for (Light& light : dirLights)
+        {
+            lights.push_back(&light);
+        }
+        for (Light& light : spotLights)
+        {
+            lights.push_back(&light);
+        }
 
-    Entity Root;
-    //Root.AddChild(Scene1, "Sponza", PBRShader);
-    //Root.children.back().get()->transform.SetLocalPosition(glm::vec3(0.0f, 0.0f, 0.0f));
-    //Root.children.back().get()->transform.SetLocalScale(glm::vec3(0.01f));
 
-    Root.AddChild(Scene2, "Bistro", PBRShader);
-    Root.children.back().get()->transform.SetLocalPosition(glm::vec3(0.0f, 0.0f, 0.0f));
+        Entity Root;
+        //Root.AddChild(Scene1, "Sponza", PBRShaders);
+        //Root.children.back().get()->transform.SetLocalPosition(glm::vec3(0.0f, 0.0f, 0.0f));
+        //Root.children.back().get()->transform.SetLocalScale(glm::vec3(0.01f));
 
-    Root.AddChild(generator, "Generator", PBRShader);
-    Root.children.back().get()->transform.SetLocalPosition(glm::vec3(-8.0f, 0.4f, 0.0f));
+        Root.AddChild(Scene2, "Bistro", PBRShaders);
+        Root.children.back().get()->transform.SetLocalPosition(glm::vec3(0.0f, 0.0f, 0.0f));
 
-    Root.AddChild(pointLights[0], "PointLight1", lightShader);
-    Root.AddChild(pointLights[1], "PointLight2", lightShader);
-    Root.AddChild(pointLights[2], "PointLight3", lightShader);
-    Root.AddChild(pointLights[3], "PointLight4", lightShader);
-    Root.AddChild(dirLights[0], "DirectionalLight", lightShader);
-    Root.AddChild(spotLights[1], "SpotLight", lightShader);
+        Root.AddChild(generator, "Generator", PBRShaders);
+        Root.children.back().get()->transform.SetLocalPosition(glm::vec3(-8.0f, 0.4f, 0.0f));
 
-    Root.AddChild(box, "CubeRing", instanceShader);
-    Root.children.back().get()->transform.SetLocalPosition(glm::vec3(0.0f, 20.0f, 0.0f));
+        Root.AddChild(pointLights[0], "PointLight1", lightShader);
+        Root.AddChild(pointLights[1], "PointLight2", lightShader);
+        Root.AddChild(pointLights[2], "PointLight3", lightShader);
+        Root.AddChild(pointLights[3], "PointLight4", lightShader);
+        Root.AddChild(dirLights[0], "DirectionalLight", lightShader);
+        Root.AddChild(spotLights[1], "SpotLight", lightShader);
 
-    Root.UpdateSelfAndChildren();
+        Root.AddChild(box, "CubeRing", instanceShader);
+        Root.children.back().get()->transform.SetLocalPosition(glm::vec3(0.0f, 20.0f, 0.0f));
 
-    Shadow DirLightShadow(2048, 2048);
+        Root.UpdateSelfAndChildren();
 
+        Shadow DirLightShadow(2048, 2048);
 
-    // Framebuffer for post-processing
-    GLuint FBO, CBO[2], RBO;
-    GLuint attachments[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
-    {
-        glGenFramebuffers(1, &FBO);
-        glBindFramebuffer(GL_FRAMEBUFFER, FBO);
 
-        // Setup CBOs
-        glGenTextures(2, CBO);
-        for (unsigned int i = 0; i < 2; i++)
+        // Framebuffer for post-processing
+        GLuint FBO, CBO[2], RBO;
+        GLuint attachments[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
         {
-            glBindTexture(GL_TEXTURE_2D, CBO[i]);
-
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, WINDOW_WIDTH, WINDOW_HEIGHT, 0, GL_RGBA, GL_FLOAT, NULL);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);  // we clamp to the edge as the blur filter would otherwise sample repeated texture values!
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-            glBindTexture(GL_TEXTURE_2D, 0);
-
-            // Bind CBO to FBO
-            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, CBO[i], 0);
-        }
+            GPUResourceTracker& tracker = GPUResourceTracker::GetInstance();
+            tracker.GenFramebuffers(1, &FBO, GPUResourceOwner::POSTPROCESS);
+            GLState::BindFramebuffer(GL_FRAMEBUFFER, FBO);
 
-        glGenRenderbuffers(1, &RBO);
-        glBindRenderbuffer(GL_RENDERBUFFER, RBO);
-        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, WINDOW_WIDTH, WINDOW_HEIGHT);
-        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, RBO);
-        // tell OpenGL which color attachments we'll use (of this framebuffer) for rendering 
-        glDrawBuffers(2, attachments);
-        // finally check if framebuffer is complete
+            // Setup CBOs
+            tracker.GenTextures(2, CBO, GPUResourceOwner::POSTPROCESS);
+            for (unsigned int i = 0; i < 2; i++)
+            {
+                GLState::BindTexture(GL_TEXTURE_2D, CBO[i]);
+
+                glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, WINDOW_WIDTH, WINDOW_HEIGHT, 0, GL_RGBA, GL_FLOAT, NULL);
+                tracker.SetTextureSize(CBO[i], GL_RGBA16F, WINDOW_WIDTH, WINDOW_HEIGHT);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);  // we clamp to the edge as the blur filter would otherwise sample repeated texture values!
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+                GLState::BindTexture(GL_TEXTURE_2D, 0);
+
+                // Bind CBO to FBO
+                glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, CBO[i], 0);
+            }
 
-        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-        {
-            fprintf(stderr, "ERROR::FRAMEBUFFER::Framebuffer is not complete!\n");
-        }
-        // Set default frame buffer
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
-    }
+            tracker.GenRenderbuffers(1, &RBO, GPUResourceOwner::POSTPROCESS);
+            glBindRenderbuffer(GL_RENDERBUFFER, RBO);
+            glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, WINDOW_WIDTH, WINDOW_HEIGHT);
+            tracker.SetRenderbufferSize(RBO, GL_DEPTH_COMPONENT, WINDOW_WIDTH, WINDOW_HEIGHT);
+            glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, RBO);
+            // tell OpenGL which color attachments we'll use (of this framebuffer) for rendering 
+            glDrawBuffers(2, attachments);
+            // finally check if framebuffer is complete
 
-    // ping-pong-framebuffer for blurring
-    GLuint pingpongFBO[2], pingpongCBO[2];
-    {
-        glGenFramebuffers(2, pingpongFBO);
-        glGenTextures(2, pingpongCBO);
-        for (unsigned int i = 0; i < 2; i++)
-        {
-            glBindFramebuffer(GL_FRAMEBUFFER, pingpongFBO[i]);
-            glBindTexture(GL_TEXTURE_2D, pingpongCBO[i]);
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, WINDOW_WIDTH, WINDOW_HEIGHT, 0, GL_RGBA, GL_FLOAT, NULL);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE); // we clamp to the edge as the blur filter would otherwise sample repeated texture values!
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, pingpongCBO[i], 0);
-            // also check if framebuffers are complete (no need for depth buffer)
             if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
             {
                 fprintf(stderr, "ERROR::FRAMEBUFFER::Framebuffer is not complete!\n");
             }
+            // Set default frame buffer
+            GLState::BindFramebuffer(GL_FRAMEBUFFER, 0);
         }
-    }
 
-    GLuint UBO;
-    {
-        glGenBuffers(1, &UBO);
-
-        glBindBuffer(GL_UNIFORM_BUFFER, UBO);
-        glBufferData(GL_UNIFORM_BUFFER, 2 * sizeof(glm::mat4), NULL, GL_STATIC_DRAW);
-        glBindBuffer(GL_UNIFORM_BUFFER, 0);
-
-        glBindBufferRange(GL_UNIFORM_BUFFER, 0, UBO, 0, 2 * sizeof(glm::mat4));
-    }
-    stbi_set_flip_vertically_on_load(true);
-
-    glm::mat4 model(1.0f);
-    glm::mat4 view(1.0f);
-    glm::mat4 projection(1.0f);
-
-    bool bIsWireMode = false;
-    float parallax = 0.1f;
-    bool isNormals = false;
-
-    float ZoomOld = Zoom;
-    camera.Position.x = -5.0f;
-    glm::vec3 camRotOld(0.0f);
-    glm::vec3 camPosOld(0.0f);
-
-    float gamma = 2.2f;
-    float exposure = 1.0f;
-    float brightness = 2.0f;
-    float bloomStrength = 0.5f;
-    float filterRadius = 0.005f;
-    int bloomType = 0;
-    int bloomSamples = 5u;
-
-    GLfloat deltaTime = 0.0f;
-    GLfloat lastFrame = 0.0f;
-    GLfloat currentFrame;
-
-    Texture diffuseBox("res/textures/container.png", true);
-    Texture specularBox("res/textures/container_specular.png", false);
-    Texture transparentTex("res/textures/blending_transparent_window.png", false);
-    Texture screenTex("res/textures/container.png", true);
-    Texture particleTex("res/textures/Bolt.png", true);
-    Texture planeTex("res/textures/plane.jpg", true);
-
-    ParticleSystem Particles(particleTex, 500, 5.0f);
-
-    skyBoxShader.Use();
-    Environment.BindCubeMap(0);
-    skyBoxShader.setInt("skybox", 0);
-
-    screenShader.Use();
-    screenShader.setInt("screenTexture", 0);
-    screenShader.setInt("bloomBlur", 1);
-
-    blurShader.Use();
-    blurShader.setInt("image", 0);
-
-    PBRShader.Use();
-    Irradiance.BindCubeMap(6);
-    PBRShader.setInt("irradianceMap", 6);
-    Prefilter.BindCubeMap(7);
-    PBRShader.setInt("prefilterMap", 7);
-    BRDF.BindTexture(8);
-    PBRShader.setInt("brdfLUT", 8);
-    DirLightShadow.BindShadowMap(9);
-    PBRShader.setInt("shadowMap", 9);
-
-    int winWidth = WINDOW_WIDTH, winHeight = WINDOW_HEIGHT;
-
-    glfwSetScrollCallback(window, MouseCallback);
-    glfwSetKeyCallback(window, KeyCallback);
-
-    // Setting shaders uniform block binding
-    lightShader.setBlock("Matrixes", 0);
-    skyBoxShader.setBlock("Matrixes", 0);
-    normalShader.setBlock("Matrixes", 0);
-    particleShader.setBlock("Matrixes", 0);
-    PBRShader.setBlock("Matrixes", 0);
-
-
-    Entity* ring = Root.FindByName("CubeRing");
-    while (!glfwWindowShouldClose(window))
-    {
-        glfwPollEvents();
-        glfwGetWindowSize(window, &winWidth, &winHeight);
-        glViewport(0, 0, winWidth, winHeight);
-        // Start the Dear ImGui frame
-        ImGui_ImplOpenGL3_NewFrame();
-        ImGui_ImplGlfw_NewFrame();
-        ImGui::NewFrame();
-
-        // Global settings menu window
+        // ping-pong-framebuffer for blurring
+        GLuint pingpongFBO[2], pingpongCBO[2];
         {
-            ImGui::Begin("Global options");
-            ImGui::Checkbox("WireFrame Mode", &bIsWireMode);
-            if (bIsWireMode)
-            {
-                glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-            }
-            else
+            GPUResourceTracker& tracker = GPUResourceTracker::GetInstance();
+            tracker.GenFramebuffers(2, pingpongFBO, GPUResourceOwner::POSTPROCESS);
+            tracker.GenTextures(2, pingpongCBO, GPUResourceOwner::POSTPROCESS);
+            for (unsigned int i = 0; i < 2; i++)
             {
-                glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+                GLState::BindFramebuffer(GL_FRAMEBUFFER, pingpongFBO[i]);
+                GLState::BindTexture(GL_TEXTURE_2D, pingpongCBO[i]);
+                glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, WINDOW_WIDTH, WINDOW_HEIGHT, 0, GL_RGBA, GL_FLOAT, NULL);
+                tracker.SetTextureSize(pingpongCBO[i], GL_RGBA16F, WINDOW_WIDTH, WINDOW_HEIGHT);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE); // we clamp to the edge as the blur filter would otherwise sample repeated texture values!
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+                glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, pingpongCBO[i], 0);
+                // also check if framebuffers are complete (no need for depth buffer)
+                if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+                {
+                    fprintf(stderr, "ERROR::FRAMEBUFFER::Framebuffer is not complete!\n");
+                }
             }
-            ImGui::Checkbox("Normals", &isNormals);
-            ImGui::SliderFloat("Gamma", &gamma, 0.0f, 20.0f);
-            ImGui::SliderFloat("Exposure", &exposure, 0.0f, 20.0f);
-            ImGui::SliderFloat("BloomStrength", &bloomStrength, 0.0f, 1.0f);
-            ImGui::SliderFloat("FilterRadius", &filterRadius, 0.0f, 0.01f, "%.5f");
-            ImGui::SliderInt("Bloom Samples", &bloomSamples, 0, 15);
-            ImGui::Checkbox("Light Gizmos", &Light::isGizmosOn);
+        }
 
-            ImGui::RadioButton("Physical based bloom", &bloomType, 0); ImGui::SameLine();
-            ImGui::RadioButton("Gauss blur bloom", &bloomType, 1);
+        // Frame constants (the "Matrixes" block) and per object data, rebound every frame
+        FrameRingBuffer& frameData = FrameRingBuffer::GetInstance();
+        stbi_set_flip_vertically_on_load(true);
+
+        glm::mat4 model(1.0f);
+        glm::mat4 view(1.0f);
+        glm::mat4 projection(1.0f);
+
+        bool bIsWireMode = false;
+        float parallax = 0.1f;
+        bool isNormals = false;
+        bool isCrowd = false;
+        // Loaded the first time the crowd is shown
+        std::unique_ptr<SkinnedModel> crowdCharacter;
+        std::shared_ptr<const Animation> crowdClip;
+        std::unique_ptr<SkinnedCrowd> crowd;
+        bool isPreSkinned = false;
+        AnimationLodSettings crowdLod;
+        PoseCacheSettings crowdPoseCache;
+        bool isCrowdGPUEvaluation = false;
+        // GPU time of the crowd's work, read back FrameRingBuffer::FRAMES frames later
+        GPUTimer crowdSkinningTimer;
+        GPUTimer crowdShadowTimer;
+        GPUTimer crowdColorTimer;
+        // Whole crowd per frame with vertex shader skinning and with pre-skinning
+        double crowdGpuMs[2] = { 0.0, 0.0 };
+        uint32_t crowdModeFrames = 0U;
+        bool isBakedCrowd = false;
+        bool isBakedHalf = false;
+        // Baked from the crowd's character the first time it is shown
+        std::unique_ptr<BakedAnimation> bakedAnimation;
+        std::unique_ptr<BakedCrowd> bakedCrowd;
+        GPUTimer bakedCrowdTimer;
+        // Scene graph pass, which draws the cube ring, and the whole frame for each instance format
+        GPUTimer sceneTimer;
+        double ringSceneMs[3] = { 0.0, 0.0, 0.0 };
+        double ringFrameMs[3] = { 0.0, 0.0, 0.0 };
+        bool isRingCulling = true;
+        InstanceCullingReport ringCullingReport;
+
+        float ZoomOld = Zoom;
+        camera.Position.x = -5.0f;
+        glm::vec3 camRotOld(0.0f);
+        glm::vec3 camPosOld(0.0f);
+
+        float gamma = 2.2f;
+        float exposure = 1.0f;
+        float brightness = 2.0f;
+        float bloomStrength = 0.5f;
+        float filterRadius = 0.005f;
+        int bloomType = 0;
+        int bloomSamples = 5u;
+        HDRBenchmarkResult hdrBenchmark;
+        AnimatorBenchmarkResult animatorBenchmark;
+        KeyframeBenchmarkResult keyframeBenchmark;
+        ClipCompressionReport compressionReport;
+        AnimationSystemBenchmarkResult crowdBenchmarks[3];
+        CharacterMemoryReport characterMemory;
+        PoseBenchmarkResult poseBenchmark;
+        GPUClipBenchmarkResult gpuClipBenchmark;
+        CPUSkinningBenchmarkResult cpuSkinningBenchmark;
+
+        GLfloat deltaTime = 0.0f;
+        GLfloat lastFrame = 0.0f;
+        GLfloat currentFrame;
+
+        Texture diffuseBox("res/textures/container.png", true);
+        Texture specularBox("res/textures/container_specular.png", false);
+        Texture transparentTex("res/textures/blending_transparent_window.png", false);
+        Texture screenTex("res/textures/container.png", true);
+        Texture particleTex("res/textures/Bolt.png", true);
+        Texture planeTex("res/textures/plane.jpg", true);
+
+        ParticleSystem Particles(particleTex, 500, 5.0f);
 
+        skyBoxShader.Use();
+        Environment.BindCubeMap(0);
+        skyBoxShader.setInt("skybox", 0);
 
-            ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
-            ImGui::End();
-        }
+        screenShader.Use();
+        screenShader.setInt("screenTexture", 0);
+        screenShader.setInt("bloomBlur", 1);
+
+        blurShader.Use();
+        blurShader.setInt("image", 0);
 
-        // Camera menu window
+        // Later variants copy these from the variant compiled before them
+        updateLightSlots();
+        Shader& PBRShader = PBRShaders.Get(PBRShaders.GetBase());
+        PBRShader.Use();
+        Irradiance.BindCubeMap(6);
+        PBRShader.setInt("irradianceMap", 6);
+        Prefilter.BindCubeMap(7);
+        PBRShader.setInt("prefilterMap", 7);
+        BRDF.BindTexture(8);
+        PBRShader.setInt("brdfLUT", 8);
+        DirLightShadow.BindShadowMap(9);
+        PBRShader.setInt("shadowMap", 9);
+
+        int winWidth = WINDOW_WIDTH, winHeight = WINDOW_HEIGHT;
+
+        glfwSetScrollCallback(window, MouseCallback);
+        glfwSetKeyCallback(window, KeyCallback);
+
+        // Setting shaders uniform block binding
+        lightShader.setBlock("Matrixes", 0);
+        skyBoxShader.setBlock("Matrixes", 0);
+        normalShader.setBlock("Matrixes", 0);
+        particleShader.setBlock("Matrixes", 0);
+        PBRShader.setBlock("Matrixes", 0);
+
+
+        // Cold cache compiles every program, warm cache only loads binaries
+        const ShaderCacheStats& shaderStats = ShaderCache::GetStats();
+        spdlog::info("Shader programs built in {:.1f} ms ({} from cache, {} compiled, {} rejected)",
+                     shaderStats.BuildMs, shaderStats.Hits, shaderStats.Misses + shaderStats.Rejected, shaderStats.Rejected);
+
+        Entity* ring = Root.FindByName("CubeRing");
+        unsigned int uniformLocationQueries = 0U;
+        unsigned int uniformUploads = 0U;
+        unsigned int filteredUploads = 0U;
+        uint32_t frameObjects = 0U;
+        uint32_t frameBones = 0U;
+        GLStateStats stateStats;
+        while (!glfwWindowShouldClose(window))
         {
-            ImGui::Begin("Camera settings");
+            // Uniform lookups missing the reflected tables during the previous frame
+            uniformLocationQueries = Shader::GetLocationQueryCount();
+            Shader::ResetLocationQueryCount();
+            uniformUploads = Shader::GetUploadCount();
+            filteredUploads = Shader::GetFilteredUploadCount();
+            Shader::ResetUploadCount();
+            frameObjects = frameData.GetObjectCount();
+            frameBones = frameData.GetBoneCount();
+            stateStats = GLState::GetStats();
+            GLState::ResetStats();
+
+            glfwPollEvents();
+            // Programs whose files changed are swapped in once their link finished
+            ShaderWatcher::GetInstance().Update();
+            glfwGetWindowSize(window, &winWidth, &winHeight);
+            GLState::Viewport(0, 0, winWidth, winHeight);
+            // Start the Dear ImGui frame
+            ImGui_ImplOpenGL3_NewFrame();
+            ImGui_ImplGlfw_NewFrame();
+            ImGui::NewFrame();
+
+            // Global settings menu window
+            {
+                ImGui::Begin("Global options");
+                ImGui::Checkbox("WireFrame Mode", &bIsWireMode);
+                if (bIsWireMode)
+                {
+                    GLState::PolygonMode(GL_LINE);
+                }
+                else
+                {
+                    GLState::PolygonMode(GL_FILL);
+                }
+                ImGui::Checkbox("Normals", &isNormals);
+                ImGui::SliderFloat("Gamma", &gamma, 0.0f, 20.0f);
+                ImGui::SliderFloat("Exposure", &exposure, 0.0f, 20.0f);
+                ImGui::SliderFloat("BloomStrength", &bloomStrength, 0.0f, 1.0f);
+                ImGui::SliderFloat("FilterRadius", &filterRadius, 0.0f, 0.01f, "%.5f");
+                ImGui::SliderInt("Bloom Samples", &bloomSamples, 0, 15);
+                ImGui::Checkbox("Light Gizmos", &Light::isGizmosOn);
+                ImGui::Checkbox("Shadows", &isShadows);
+                ImGui::Checkbox("Skinned crowd", &isCrowd);
+                if (isCrowd)
+                {
+                    if (ImGui::Checkbox("Pre-skin in compute", &isPreSkinned))
+                    {
+                        crowdModeFrames = 0U;
+                    }
+                    ImGui::Text("Crowd GPU: skinning %.3f ms, shadow %.3f ms, color %.3f ms", isPreSkinned ? crowdSkinningTimer.GetMs() : 0.0,
+                        isShadows ? crowdShadowTimer.GetMs() : 0.0, crowdColorTimer.GetMs());
+                    ImGui::Text("Crowd GPU total: vertex skinning %.3f ms, pre-skinned %.3f ms", crowdGpuMs[0], crowdGpuMs[1]);
+                    ImGui::Checkbox("GPU clip evaluation", &isCrowdGPUEvaluation);
+                    ImGui::Checkbox("Animation LOD", &crowdLod.IsEnabled);
+                    if (crowd)
+                    {
+                        const AnimationSystemStats& animationStats = crowd->GetAnimationSystem().GetStats();
+                        ImGui::Text("Bones evaluated per frame: %u of %u", animationStats.EvaluatedBones, animationStats.FullRateBones);
+                        ImGui::Text("Characters: %u evaluated, %u interpolated, %u clock only", animationStats.Evaluated,
+                            animationStats.Interpolated, animationStats.ClockOnly);
+                    }
+                    ImGui::Checkbox("Pose cache", &crowdPoseCache.IsEnabled);
+                    if (crowdPoseCache.IsEnabled)
+                    {
+                        ImGui::SliderFloat("Pose time step", &crowdPoseCache.TimeStep, 1.0f / 120.0f, 0.25f, "%.3f s");
+                    }
+                    if (crowd && crowdPoseCache.IsEnabled)
+                    {
+                        const AnimationSystemStats& animationStats = crowd->GetAnimationSystem().GetStats();
+                        const uint32_t lookups = animationStats.CacheHits + animationStats.CacheMisses;
+                        ImGui::Text("Pose cache: %u hits, %u poses evaluated, hit rate %.1f%%", animationStats.CacheHits, animationStats.CacheMisses,
+                            lookups > 0 ? 100.0f * animationStats.CacheHits / lookups : 0.0f);
+                    }
+                }
+                if (crowdCharacter && ImGui::TreeNode("Morph targets"))
+                {
+                    size_t sparseBytes = 0;
+                    size_t denseBytes = 0;
+                    for (uint32_t mesh = 0; mesh < crowdCharacter->GetMeshCount(); ++mesh)
+                    {
+                        SkinnedMesh& skinnedMesh = crowdCharacter->GetMesh(mesh);
+                        sparseBytes += skinnedMesh.GetMorphMemorySize();
+                        denseBytes += skinnedMesh.GetDenseMorphMemorySize();
+                        for (uint32_t target = 0; target < skinnedMesh.GetMorphTargetCount(); ++target)
+                        {
+                            float weight = skinnedMesh.GetMorphTarget(target).Weight;
+                            ImGui::PushID(int(mesh * 1024 + target));
+                            if (ImGui::SliderFloat(skinnedMesh.GetMorphTarget(target).Name.c_str(), &weight, 0.0f, 1.0f))
+                            {
+                                skinnedMesh.SetMorphWeight(target, weight);
+                            }
+                            ImGui::PopID();
+                        }
+                    }
+                    ImGui::Text("Deltas %zu bytes, dense %zu bytes", sparseBytes, denseBytes);
+                    ImGui::TreePop();
+                }
+                ImGui::Checkbox("Baked crowd", &isBakedCrowd);
+                if (isBakedCrowd)
+                {
+                    if (ImGui::Checkbox("Half float bone texture", &isBakedHalf))
+                    {
+                        // Baked again with the other format
+                        bakedCrowd.reset();
+                        bakedAnimation.reset();
+                    }
+                    if (bakedCrowd)
+                    {
+                        ImGui::Text("%u instances in %u draws, GPU %.3f ms", bakedCrowd->GetCount(), bakedCrowd->GetDrawCount(), bakedCrowdTimer.GetMs());
+                        ImGui::Text("Bone texture %.2f MB, %u frames of %u bones, baked in %.1f ms", bakedAnimation->GetMemorySize() / (1024.0 * 1024.0),
+                            bakedAnimation->GetFrameCount(), bakedAnimation->GetPaletteSize(), bakedAnimation->GetBakeMs());
+                    }
+                }
 
-            ImGui::SliderFloat3("Position", &camera.Position[0], -1000.0f, 1000.0f);
-            ImGui::SliderFloat("Yaw", &camera.Rotation.x, -89.0f, 89.0f);
-            ImGui::SliderFloat("Pitch", &camera.Rotation.y, 0.0f, 360.0f);
-            ImGui::SliderFloat("Speed", &camera.Speed, 0.0f, 10.0f);
-            ImGui::SliderFloat("Zoom", &Zoom, 1.0f, 45.0f);
+                ImGui::RadioButton("Physical based bloom", &bloomType, 0); ImGui::SameLine();
+                ImGui::RadioButton("Gauss blur bloom", &bloomType, 1);
 
-            ImGui::End();
-        }
 
-        // Scene graph window
-        {
-            ImGui::Begin("Scene Graph");
+                ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
+                ImGui::Text("glGetUniformLocation calls per frame: %u", uniformLocationQueries);
+                ImGui::Text("Uniform uploads per frame: %u (%u redundant skipped)", uniformUploads, filteredUploads);
+                ImGui::Text("GL state calls per frame: %u issued, %u filtered", stateStats.Issued, stateStats.Filtered);
+                ImGui::Text("Objects per frame: %u, bones %u, ring buffer wait %.3f ms", frameObjects, frameBones, frameData.GetWaitMs());
 
-            Root.DrawGUITree();
+                if (ImGui::CollapsingHeader("Cube ring"))
+                {
+                    const int oldRingFormat = ringFormat;
+                    ImGui::RadioButton("4x4 matrix", &ringFormat, int(InstanceFormat::MATRIX)); ImGui::SameLine();
+                    ImGui::RadioButton("3x4 matrix", &ringFormat, int(InstanceFormat::AFFINE)); ImGui::SameLine();
+                    ImGui::RadioButton("Quaternion + scale", &ringFormat, int(InstanceFormat::QUAT_SCALE));
+                    if (ringFormat != oldRingFormat)
+                    {
+                        const size_t oldBytes = box.GetMemorySize();
+                        box.Upload(buildRing(InstanceFormat(ringFormat)));
+                        spdlog::info("Cube ring instances as {}: {:.1f} MB, was {:.1f} MB", InstanceBuilder::GetFormatName(box.GetFormat()),
+                            box.GetMemorySize() / (1024.0 * 1024.0), oldBytes / (1024.0 * 1024.0));
+                    }
+                    ImGui::Text("%u instances, %u bytes each, %.1f MB of VRAM", box.GetCount(), InstanceBuilder::GetStride(box.GetFormat()),
+                        box.GetMemorySize() / (1024.0 * 1024.0));
+                    ImGui::Checkbox("GPU frustum culling", &isRingCulling);
+                    if (ImGui::Button("Validate culling"))
+                    {
+                        ringCullingReport = box.ValidateCulling(instanceCullingShader, ring->transform.GetModel(), Frustum::FromViewProjection(projection * view));
+                        spdlog::info("Cube ring culling of {} instances: GPU {} visible in {:.3f} ms, CPU {} visible in {:.3f} ms, {} threads {:.3f} ms, {} mismatches",
+                            ringCullingReport.Instances, ringCullingReport.GpuVisible, ringCullingReport.GpuMs, ringCullingReport.CpuVisible,
+                            ringCullingReport.CpuMs, ringCullingReport.Threads, ringCullingReport.ParallelMs, ringCullingReport.Mismatches);
+                    }
+                    if (ringCullingReport.Instances > 0)
+                    {
+                        ImGui::Text("Visible: GPU %u in %.3f ms, CPU %u in %.3f ms (%u threads %.3f ms), %u mismatches", ringCullingReport.GpuVisible,
+                            ringCullingReport.GpuMs, ringCullingReport.CpuVisible, ringCullingReport.CpuMs, ringCullingReport.Threads,
+                            ringCullingReport.ParallelMs, ringCullingReport.Mismatches);
+                    }
+                    // Last measurement while each format was shown
+                    for (int format = 0; format < 3; ++format)
+                    {
+                        ImGui::Text("%s: scene pass GPU %.3f ms, frame %.3f ms", InstanceBuilder::GetFormatName(InstanceFormat(format)),
+                            ringSceneMs[format], ringFrameMs[format]);
+                    }
+                }
 
-            ImGui::Separator();
-            if (Entity::GetSelectedEntity())
-            {
-                Entity::GetSelectedEntity()->DrawGUIEdit();
+                if (ImGui::CollapsingHeader("Shader cache"))
+                {
+                    ImGui::Text("Startup build %.1f ms, %u from cache, %u compiled", shaderStats.BuildMs, shaderStats.Hits, shaderStats.Misses + shaderStats.Rejected);
+                    if (ImGui::Button("Clear shader cache"))
+                    {
+                        ShaderCache::Clear();
+                        spdlog::info("Shader cache cleared, next start will compile every program");
+                    }
+                }
+                if (ImGui::CollapsingHeader("Clip cache"))
+                {
+                    const ClipCacheStats& clipStats = ClipCache::GetStats();
+                    ImGui::Text("%u from cache in %.2f ms, %u imported in %.2f ms", clipStats.Hits, clipStats.LoadMs, clipStats.Misses + clipStats.Rejected, clipStats.ImportMs);
+                    if (ImGui::Button("Clear clip cache"))
+                    {
+                        ClipCache::Clear();
+                        spdlog::info("Clip cache cleared, clips are imported again on their next load");
+                    }
+                }
+                if (ImGui::CollapsingHeader("Shader hot reload"))
+                {
+                    ShaderWatcher& watcher = ShaderWatcher::GetInstance();
+                    const ShaderWatcherStats& reloadStats = watcher.GetStats();
+                    ImGui::Checkbox("Watch shader files", &watcher.IsEnabled);
+                    ImGui::Text("Parallel compile: %s", watcher.HasParallelCompile() ? "yes" : "no");
+                    ImGui::Text("%u reloaded, %u failed, %u linking", reloadStats.Reloads, reloadStats.Failures, reloadStats.Pending);
+                }
+                if (ImGui::CollapsingHeader("Shader variants"))
+                {
+                    PBRShaders.DrawGUI("PBR");
+                }
+                if (ImGui::CollapsingHeader("HDR decode benchmark"))
+                {
+                    if (ImGui::Button("Run on Canyon.hdr"))
+                    {
+                        hdrBenchmark = HDRLoader::Benchmark("res/textures/Canyon/Canyon.hdr");
+                        spdlog::info("HDR decode: stb_image {:.2f} ms, HDRLoader {:.2f} ms", hdrBenchmark.StbMs, hdrBenchmark.DecoderMs);
+                    }
+                    if (hdrBenchmark.Iterations > 0)
+                    {
+                        ImGui::Text("stb_image %.2f ms, HDRLoader %.2f ms (x%.1f)", hdrBenchmark.StbMs, hdrBenchmark.DecoderMs, hdrBenchmark.StbMs / hdrBenchmark.DecoderMs);
+                    }
+                }
+                if (ImGui::CollapsingHeader("Animation benchmark"))
+                {
+                    const char* animatorModel = nullptr;
+                    if (ImGui::Button("Run on CesiumMan"))
+                    {
+                        animatorModel = "res/models/AnimatedFBX/CesiumMan.gltf";
+                    }
+                    ImGui::SameLine();
+                    if (ImGui::Button("Run on agent"))
+                    {
+                        animatorModel = "res/models/AnimatedFBX/agent001/agent001.gltf";
+                    }
+                    if (animatorModel)
+                    {
+                        animatorBenchmark = Animator::Benchmark(animatorModel, animatorModel);
+                        spdlog::info("Animation update on {} ({} joints): node tree {:.4f} ms, flat skeleton {:.4f} ms, max error {}",
+                            animatorModel, animatorBenchmark.Joints, animatorBenchmark.LegacyMs, animatorBenchmark.FlatMs, animatorBenchmark.MaxError);
+                    }
+                    if (animatorBenchmark.Iterations > 0)
+                    {
+                        ImGui::Text("%u joints: node tree %.4f ms, flat %.4f ms (x%.1f)", animatorBenchmark.Joints, animatorBenchmark.LegacyMs,
+                            animatorBenchmark.FlatMs, animatorBenchmark.LegacyMs / animatorBenchmark.FlatMs);
+                        ImGui::Text("Max palette error %g", animatorBenchmark.MaxError);
+                    }
+                    if (ImGui::Button("Run keyframe sampling"))
+                    {
+                        keyframeBenchmark = Bone::Benchmark();
+                        spdlog::info("Keyframe sampling over {} keys: linear {:.4f} us, cursor {:.4f} us, seek {:.4f} us, resampled {:.4f} us, max error cursor {} seek {} resampled {}",
+                            keyframeBenchmark.Keys, keyframeBenchmark.LinearUs, keyframeBenchmark.CursorUs, keyframeBenchmark.SeekUs, keyframeBenchmark.ResampledUs,
+                            keyframeBenchmark.CursorError, keyframeBenchmark.SeekError, keyframeBenchmark.ResampledError);
+                    }
+                    if (keyframeBenchmark.Samples > 0)
+                    {
+                        ImGui::Text("%d keys: linear %.4f us, cursor %.4f us, seek %.4f us, resampled %.4f us", keyframeBenchmark.Keys,
+                            keyframeBenchmark.LinearUs, keyframeBenchmark.CursorUs, keyframeBenchmark.SeekUs, keyframeBenchmark.ResampledUs);
+                        ImGui::Text("Max error: cursor %g, seek %g, resampled %g", keyframeBenchmark.CursorError, keyframeBenchmark.SeekError, keyframeBenchmark.ResampledError);
+                    }
+                    const char* compressedModel = nullptr;
+                    if (ImGui::Button("Compress CesiumMan"))
+                    {
+                        compressedModel = "res/models/AnimatedFBX/CesiumMan.gltf";
+                    }
+                    ImGui::SameLine();
+                    if (ImGui::Button("Compress agent"))
+                    {
+                        compressedModel = "res/models/AnimatedFBX/agent001/agent001.gltf";
+                    }
+                    if (compressedModel)
+                    {
+                        compressionReport = CompressedClip::Benchmark(compressedModel, compressedModel);
+                        spdlog::info("Clip compression of {}: {} keys {} bytes -> {} keys {} bytes, max joint error {}, max rotation error {} deg, sampling {:.4f} ms -> {:.4f} ms",
+                            compressedModel, compressionReport.RawKeys, compressionReport.RawBytes, compressionReport.Keys, compressionReport.CompressedBytes,
+                            compressionReport.MaxJointError, compressionReport.MaxRotationError, compressionReport.RawSampleMs, compressionReport.CompressedSampleMs);
+                    }
+                    if (compressionReport.RawBytes > 0)
+                    {
+                        ImGui::Text("Clip %zu -> %zu bytes (x%.1f), %u -> %u keys", compressionReport.RawBytes, compressionReport.CompressedBytes,
+                            double(compressionReport.RawBytes) / compressionReport.CompressedBytes, compressionReport.RawKeys, compressionReport.Keys);
+                        ImGui::Text("Max joint error %g, max rotation error %g deg", compressionReport.MaxJointError, compressionReport.MaxRotationError);
+                    }
+                    const char* crowdModel = nullptr;
+                    if (ImGui::Button("Crowd of CesiumMan"))
+                    {
+                        crowdModel = "res/models/AnimatedFBX/CesiumMan.gltf";
+                    }
+                    ImGui::SameLine();
+                    if (ImGui::Button("Crowd of agent"))
+                    {
+                        crowdModel = "res/models/AnimatedFBX/agent001/agent001.gltf";
+                    }
+                    const uint32_t crowdSizes[3] = { 100, 1000, 10000 };
+                    for (int i = 0; i < 3; ++i)
+                    {
+                        if (crowdModel)
+                        {
+                            crowdBenchmarks[i] = AnimationSystem::Benchmark(crowdModel, crowdModel, crowdSizes[i]);
+                            spdlog::info("Animation update of {} x {} on {} threads: serial {:.3f} ms, job pool {:.3f} ms", crowdSizes[i], crowdModel,
+                                crowdBenchmarks[i].Threads, crowdBenchmarks[i].SerialMs, crowdBenchmarks[i].ParallelMs);
+                        }
+                        if (crowdBenchmarks[i].Instances > 0)
+                        {
+                            ImGui::Text("%u instances: serial %.3f ms, %u threads %.3f ms", crowdBenchmarks[i].Instances, crowdBenchmarks[i].SerialMs,
+                                crowdBenchmarks[i].Threads, crowdBenchmarks[i].ParallelMs);
+                        }
+                    }
+                    if (ImGui::Button("Run pose kernels"))
+                    {
+                        poseBenchmark = Pose::Benchmark("res/models/AnimatedFBX/CesiumMan.gltf", "res/models/AnimatedFBX/CesiumMan.gltf");
+                        spdlog::info("Pose kernels on {} joints (SIMD / scalar us): sample {:.3f} / {:.3f}, blend {:.3f} / {:.3f}, additive {:.3f} / {:.3f}, model space {:.3f} / {:.3f}, max error {}",
+                            poseBenchmark.Joints, poseBenchmark.SampleUs, poseBenchmark.ScalarSampleUs, poseBenchmark.BlendUs, poseBenchmark.ScalarBlendUs,
+                            poseBenchmark.AdditiveUs, poseBenchmark.ScalarAdditiveUs, poseBenchmark.ModelSpaceUs, poseBenchmark.ScalarModelSpaceUs, poseBenchmark.MaxError);
+                        spdlog::info("Animator update: one clip {:.3f} us, crossfade {:.3f} us", poseBenchmark.AnimatorUs, poseBenchmark.CrossfadeUs);
+                    }
+                    if (poseBenchmark.Iterations > 0)
+                    {
+                        ImGui::Text("%u joints, SIMD / scalar us: sample %.3f / %.3f, blend %.3f / %.3f", poseBenchmark.Joints, poseBenchmark.SampleUs,
+                            poseBenchmark.ScalarSampleUs, poseBenchmark.BlendUs, poseBenchmark.ScalarBlendUs);
+                        ImGui::Text("Additive %.3f / %.3f, model space %.3f / %.3f, max error %g", poseBenchmark.AdditiveUs, poseBenchmark.ScalarAdditiveUs,
+                            poseBenchmark.ModelSpaceUs, poseBenchmark.ScalarModelSpaceUs, poseBenchmark.MaxError);
+                        ImGui::Text("Animator: one clip %.3f us, crossfade %.3f us", poseBenchmark.AnimatorUs, poseBenchmark.CrossfadeUs);
+                    }
+                    if (ImGui::Button("GPU clip evaluation"))
+                    {
+                        gpuClipBenchmark = GPUClipEvaluator::Benchmark("res/models/AnimatedFBX/CesiumMan.gltf", "res/models/AnimatedFBX/CesiumMan.gltf",
+                            clipEvaluationShader, 1000);
+                        spdlog::info("Clip evaluation of {} instances with {} joints: CPU reference {:.3f} ms, GPU {:.3f} ms, max error {}",
+                            gpuClipBenchmark.Instances, gpuClipBenchmark.Joints, gpuClipBenchmark.CpuMs, gpuClipBenchmark.GpuMs, gpuClipBenchmark.MaxError);
+                    }
+                    if (gpuClipBenchmark.Instances > 0)
+                    {
+                        ImGui::Text("%u instances: CPU reference %.3f ms, GPU %.3f ms, max error %g", gpuClipBenchmark.Instances,
+                            gpuClipBenchmark.CpuMs, gpuClipBenchmark.GpuMs, gpuClipBenchmark.MaxError);
+                    }
+                    if (ImGui::Button("CPU skinning"))
+                    {
+                        cpuSkinningBenchmark = CPUSkinning::Benchmark("res/models/AnimatedFBX/CesiumMan.gltf", "res/models/AnimatedFBX/CesiumMan.gltf");
+                        for (uint32_t kernel = 0; kernel < SKINNING_KERNEL_COUNT; ++kernel)
+                        {
+                            const CPUSkinningKernelResult& result = cpuSkinningBenchmark.Kernels[kernel];
+                            if (result.IsSupported)
+                            {
+                                spdlog::info("CPU skinning of {} vertices with {}: {:.3f} ms, max error position {} normal {} bounds {}",
+                                    cpuSkinningBenchmark.Vertices, CPUSkinning::GetKernelName(SkinningKernel(kernel)), result.Ms,
+                                    result.MaxPositionError, result.MaxNormalError, result.MaxBoundsError);
+                            }
+                        }
+                        spdlog::info("CPU skinning on {} threads with {}: {:.3f} ms, max error {}", cpuSkinningBenchmark.Threads,
+                            cpuSkinningBenchmark.ParallelKernel, cpuSkinningBenchmark.ParallelMs, cpuSkinningBenchmark.ParallelMaxError);
+                    }
+                    if (cpuSkinningBenchmark.Iterations > 0)
+                    {
+                        for (uint32_t kernel = 0; kernel < SKINNING_KERNEL_COUNT; ++kernel)
+                        {
+                            const CPUSkinningKernelResult& result = cpuSkinningBenchmark.Kernels[kernel];
+                            if (result.IsSupported)
+                            {
+                                ImGui::Text("%u vertices, %s %.3f ms, max error position %g, normal %g, bounds %g", cpuSkinningBenchmark.Vertices,
+                                    CPUSkinning::GetKernelName(SkinningKernel(kernel)), result.Ms, result.MaxPositionError, result.MaxNormalError,
+                                    result.MaxBoundsError);
+                            }
+                            else
+                            {
+                                ImGui::Text("%s not supported by this CPU", CPUSkinning::GetKernelName(SkinningKernel(kernel)));
+                            }
+                        }
+                        ImGui::Text("%u threads with %s %.3f ms, max error %g", cpuSkinningBenchmark.Threads, cpuSkinningBenchmark.ParallelKernel,
+                            cpuSkinningBenchmark.ParallelMs, cpuSkinningBenchmark.ParallelMaxError);
+                    }
+                    if (ImGui::Button("Memory per character"))
+                    {
+                        characterMemory = AnimationLibrary::ReportCharacterMemory("res/models/AnimatedFBX/CesiumMan.gltf", "res/models/AnimatedFBX/CesiumMan.gltf");
+                    }
+                    if (characterMemory.UnsharedBytes > 0)
+                    {
+                        ImGui::Text("Own clip and skeleton %zu bytes, shared %zu bytes (x%.1f)", characterMemory.UnsharedBytes, characterMemory.SharedBytes,
+                            double(characterMemory.UnsharedBytes) / characterMemory.SharedBytes);
+                        ImGui::Text("Clip %zu, bone map %zu, skeleton %zu, animator %zu bytes", characterMemory.ClipBytes, characterMemory.BoneMapBytes,
+                            characterMemory.SkeletonBytes, characterMemory.InstanceBytes);
+                    }
+                }
+                ImGui::End();
             }
 
-            ImGui::End();
-        }
+            // Camera menu window
+            {
+                ImGui::Begin("Camera settings");
 
-        // Rendering
-        ImGui::Render();
+                ImGui::SliderFloat3("Position", &camera.Position[0], -1000.0f, 1000.0f);
+                ImGui::SliderFloat("Yaw", &camera.Rotation.x, -89.0f, 89.0f);
+                ImGui::SliderFloat("Pitch", &camera.Rotation.y, 0.0f, 360.0f);
+                ImGui::SliderFloat("Speed", &camera.Speed, 0.0f, 10.0f);
+                ImGui::SliderFloat("Zoom", &Zoom, 1.0f, 45.0f);
 
-        glfwMakeContextCurrent(window);
+                ImGui::End();
+            }
 
-        if (camPosOld != camera.Position || camRotOld != camera.Rotation || ZoomOld != Zoom)
-        {
-            view = glm::mat4(1.0f);
-            view = glm::translate(view, camera.Position);
-            camera.UpdateForwardVector();
+            // Scene graph window
+            {
+                ImGui::Begin("Scene Graph");
 
-            view = camera.LookAt(camera.Position, camera.Position + camera.ForwardVector);
-            projection = glm::perspective(glm::radians(Zoom), (float)winWidth / (float)winHeight, 0.1f, 100.0f);
+                Root.DrawGUITree();
 
-            camPosOld = camera.Position;
-            camRotOld = camera.Rotation;
-            ZoomOld = Zoom;
-        }
+                ImGui::Separator();
+                if (Entity::GetSelectedEntity())
+                {
+                    Entity::GetSelectedEntity()->DrawGUIEdit();
+                }
 
+                ImGui::End();
+            }
 
-        Shader::bindUniformData(UBO, 0, sizeof(glm::mat4), glm::value_ptr(view));
-        Shader::bindUniformData(UBO, sizeof(glm::mat4), sizeof(glm::mat4), glm::value_ptr(projection));
+            // GPU resources window
+            GPUResourceTracker::GetInstance().DrawGUI();
 
-        // DRAW SHADOWS
-        DirLightShadow.SetupMap(shadowShader, dirLights[0], *Root.children.front().get());
+            // Rendering
+            ImGui::Render();
 
-        glViewport(0, 0, winWidth, winHeight);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            glfwMakeContextCurrent(window);
 
-        glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+            if (camPosOld != camera.Position || camRotOld != camera.Rotation || ZoomOld != Zoom)
+            {
+                view = glm::mat4(1.0f);
+                view = glm::translate(view, camera.Position);
+                camera.UpdateForwardVector();
 
-        glEnable(GL_CULL_FACE);
-        glEnable(GL_DEPTH_TEST);
+                view = camera.LookAt(camera.Position, camera.Position + camera.ForwardVector);
+                projection = glm::perspective(glm::radians(Zoom), (float)winWidth / (float)winHeight, 0.1f, 100.0f);
 
-        glClearColor(0.01f, 0.1f, 0.1f, 1.00f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                camPosOld = camera.Position;
+                camRotOld = camera.Rotation;
+                ZoomOld = Zoom;
+            }
 
-        // Camera Input
-        {
-            if (glfwGetInputMode(window, GLFW_CURSOR) == GLFW_CURSOR_DISABLED)
+
+            // Waits until the GPU finished the frame that used this region FRAMES frames ago
+            frameData.BeginFrame();
+            FrameConstants& frameConstants = frameData.GetConstants();
+            frameConstants.View = view;
+            frameConstants.Projection = projection;
+            frameConstants.ViewProjection = projection * view;
+
+            if ((isCrowd || isBakedCrowd) && !crowdCharacter)
             {
-                camera.GetMouseInput(window); // Rotate
+                crowdCharacter = std::make_unique<SkinnedModel>("res/models/AnimatedFBX/CesiumMan.gltf");
+                crowdClip = AnimationLibrary::GetInstance().LoadClip("res/models/AnimatedFBX/CesiumMan.gltf", *crowdCharacter);
             }
-            // Camera Movement
-            if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+            if (crowdCharacter)
             {
-                camera.GetKeyboardInput(window, Move::FORWARD, deltaTime);
+                // Both crowds draw the character's vertex buffers
+                crowdCharacter->ApplyMorphs(morphShader);
             }
-            if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+            if (isCrowd && !crowd)
             {
-                camera.GetKeyboardInput(window, Move::BACKWARD, deltaTime);
+                crowd = std::make_unique<SkinnedCrowd>(*crowdCharacter, crowdClip);
+                for (int x = 0; x < 8; ++x)
+                {
+                    for (int z = 0; z < 8; ++z)
+                    {
+                        glm::mat4 transform = glm::translate(glm::mat4(1.0f), glm::vec3(-14.0f + x * 1.5f, 0.0f, -6.0f + z * 1.5f));
+                        crowd->Add(transform, 0.13f * (x * 8 + z));
+                    }
+                }
             }
-            if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+            if (isBakedCrowd && !bakedCrowd)
             {
-                camera.GetKeyboardInput(window, Move::LEFT, deltaTime);
+                bakedAnimation = std::make_unique<BakedAnimation>(*crowdCharacter, std::vector<const Animation*>{ crowdClip.get() }, 30.0f,
+                    isBakedHalf ? BakedFormat::RGBA16F : BakedFormat::RGBA32F);
+                std::vector<BakedInstance> instances;
+                for (int x = 0; x < 100; ++x)
+                {
+                    for (int z = 0; z < 100; ++z)
+                    {
+                        glm::mat4 transform = glm::translate(glm::mat4(1.0f), glm::vec3(-50.0f + x, 0.0f, 8.0f + z));
+                        instances.push_back({ transform, 0U, 0.037f * (x * 100 + z) });
+                    }
+                }
+                bakedCrowd = std::make_unique<BakedCrowd>(*crowdCharacter, *bakedAnimation, instances);
+                spdlog::info("Baked {} frames of {} bones in {:.1f} ms for {} instances", bakedAnimation->GetFrameCount(),
+                    bakedAnimation->GetPaletteSize(), bakedAnimation->GetBakeMs(), bakedCrowd->GetCount());
             }
-            if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+            const bool isCrowdShadowed = isCrowd && isShadows && dirLights[0].GetIsOn();
+            if (isCrowd)
             {
-                camera.GetKeyboardInput(window, Move::RIGHT, deltaTime);
+                // Pre-skinned crowds are skinned here once for the shadow, color and normals passes
+                crowd->SetPreSkinned(isPreSkinned);
+                crowd->SetLodSettings(crowdLod);
+                crowd->GetAnimationSystem().SetPoseCache(crowdPoseCache);
+                crowd->SetGPUEvaluation(isCrowdGPUEvaluation);
+                crowd->SetView(view, projection);
+                crowd->Update(deltaTime);
+                if (isPreSkinned)
+                {
+                    crowdSkinningTimer.Begin();
+                }
+                crowd->Prepare(skinningShader, clipEvaluationShader);
+                if (isPreSkinned)
+                {
+                    crowdSkinningTimer.End();
+                }
+
+                // Timings lag behind the frame, the first frames after a switch still measure the other mode
+                if (++crowdModeFrames > FrameRingBuffer::FRAMES)
+                {
+                    crowdGpuMs[isPreSkinned] = (isPreSkinned ? crowdSkinningTimer.GetMs() : 0.0) +
+                        (isCrowdShadowed ? crowdShadowTimer.GetMs() : 0.0) + crowdColorTimer.GetMs();
+                }
             }
-            if (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS)
+
+            // DRAW SHADOWS
+            if (isShadows && dirLights[0].GetIsOn())
             {
-                camera.GetKeyboardInput(window, Move::UP, deltaTime);
+                DirLightShadow.SetupMap(shadowShader, dirLights[0], *Root.children.front().get());
+                if (isCrowdShadowed)
+                {
+                    DirLightShadow.DrawToMap([&]()
+                    {
+                        Shader& crowdShadowShader = isPreSkinned ? shadowShader : skinnedShadowShader;
+                        crowdShadowShader.Use();
+                        crowdShadowShader.setMat4("lightSpaceMatrix", DirLightShadow.GetLightSpace());
+                        crowdShadowTimer.Begin();
+                        crowd->Draw(crowdShadowShader);
+                        crowdShadowTimer.End();
+                    });
+                }
             }
-            if (glfwGetKey(window, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS)
+
+            GLState::Viewport(0, 0, winWidth, winHeight);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+            GLState::BindFramebuffer(GL_FRAMEBUFFER, FBO);
+
+            GLState::Enable(GL_CULL_FACE);
+            GLState::Enable(GL_DEPTH_TEST);
+
+            glClearColor(0.01f, 0.1f, 0.1f, 1.00f);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+            // Camera Input
             {
-                camera.GetKeyboardInput(window, Move::DOWN, deltaTime);
+                if (glfwGetInputMode(window, GLFW_CURSOR) == GLFW_CURSOR_DISABLED)
+                {
+                    camera.GetMouseInput(window); // Rotate
+                }
+                // Camera Movement
+                if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+                {
+                    camera.GetKeyboardInput(window, Move::FORWARD, deltaTime);
+                }
+                if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+                {
+                    camera.GetKeyboardInput(window, Move::BACKWARD, deltaTime);
+                }
+                if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+                {
+                    camera.GetKeyboardInput(window, Move::LEFT, deltaTime);
+                }
+                if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+                {
+                    camera.GetKeyboardInput(window, Move::RIGHT, deltaTime);
+                }
+                if (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS)
+                {
+                    camera.GetKeyboardInput(window, Move::UP, deltaTime);
+                }
+                if (glfwGetKey(window, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS)
+                {
+                    camera.GetKeyboardInput(window, Move::DOWN, deltaTime);
+                }
             }
-        }
-
 
-        //===============================***PBR***===============================
-        PBRShader.Use();
-        {
-            PBRShader.setMat4("lightSpace", DirLightShadow.GetLightSpace());
 
+            //===============================***PBR***===============================
             spotLights[0].SetIsOn(isSpotlightOn);
             spotLights[0].SetPosition(camera.Position);
             spotLights[0].SetDirection(camera.ForwardVector);
-
-            for (Light* light : lights)
+            updateLightSlots();
+            // Base variant first so object variants compiled while drawing copy complete light state
+            PBRShaders.Get(PBRShaders.GetBase());
+            frameConstants.LightSpace = DirLightShadow.GetLightSpace();
+            frameConstants.CameraPosition = glm::vec4(camera.Position, 1.0f);
+            PBRShaders.ForEachActive([&](Shader& variant)
             {
-                light->SetupShader(PBRShader);
+                variant.Use();
+                for (Light* light : lights)
+                {
+                    if (light->GetIsOn())
+                    {
+                        light->SetupShader(variant);
+                    }
+                }
+            });
+            Particles.Update(computeShader, deltaTime, *Root.FindByName("Generator"));
+            particleShader.Use();
+            particleShader.setMat4("model", Root.FindByName("Generator")->transform.GetModel());
+            Particles.Draw(particleShader);
+            // The ring draws only the instances left by this pass
+            box.SetCulling(isRingCulling);
+            box.Cull(instanceCullingShader, ring->transform.GetModel(), Frustum::FromViewProjection(frameConstants.ViewProjection));
+            sceneTimer.Begin();
+            Root.DrawSelfAndChildren();
+            sceneTimer.End();
+            ringSceneMs[ringFormat] = sceneTimer.GetMs();
+            ringFrameMs[ringFormat] = 1000.0 / ImGui::GetIO().Framerate;
+
+            if (isCrowd)
+            {
+                // One draw per mesh for every character
+                crowdColorTimer.Begin();
+                crowd->Draw(PBRShaders.Get(PBRShaders.GetBase().With(ShaderFeature::SKINNING, !isPreSkinned)));
+                crowdColorTimer.End();
+            }
+            if (isBakedCrowd)
+            {
+                // One instanced draw per mesh, poses come from the baked texture
+                bakedCrowd->Update(deltaTime);
+                bakedCrowdTimer.Begin();
+                bakedCrowd->Draw(PBRShaders.Get(PBRShaders.GetBase().With(ShaderFeature::BAKED_ANIMATION)));
+                bakedCrowdTimer.End();
             }
 
-            PBRShader.setVec3("camPos", camera.Position);
-        }
-        Particles.Update(computeShader, deltaTime, *Root.FindByName("Generator"));
-        particleShader.Use();
-        particleShader.setMat4("model", Root.FindByName("Generator")->transform.GetModel());
-        Particles.Draw(particleShader);
-        Root.DrawSelfAndChildren();
-
-
-        Root.UpdateSelfAndChildren();
-
-        DirLightShadow.BindShadowMap(8U);
-
-        //===============================GEOMETRY SHADER NORMALS===============================
-        if (isNormals)
-        {
-            Root.DrawSelfAndChildren(normalShader);
-        }
-        glm::vec3 rot = ring->transform.GetLocalRotation();
-        rot.x += 0.5f;
-        rot.z += 0.2f;
-        ring->transform.SetLocalRotation(rot);
-        //===============================SKYBOX===============================
-        glDepthFunc(GL_LEQUAL);  // change depth function so depth test passes when values are equal to depth buffer's content
-        skyBoxShader.Use();
-        // skybox cube
-        Environment.BindCubeMap(0);
-        //Irradiance.BindCubeMap(0);
-        //Prefilter.BindCubeMap(0);
-        glCullFace(GL_FRONT);
-        Cube::GetInstance().Draw(skyBoxShader);
-        glCullFace(GL_BACK);
-        glDepthFunc(GL_LESS);
 
+            Root.UpdateSelfAndChildren();
 
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            DirLightShadow.BindShadowMap(8U);
 
-        bool horizontal = true, first_iteration = true;
-        if (bloomType == 0)
-        {
-            bloomRenderer.RenderBloomTexture(CBO[1], filterRadius);
-        }
-        else if (bloomType == 1)
-        {
-            //===============================BLUR===============================
-            blurShader.Use();
-            for (unsigned int i = 0; i < bloomSamples * 2; i++)
+            //===============================GEOMETRY SHADER NORMALS===============================
+            if (isNormals)
             {
-                glBindFramebuffer(GL_FRAMEBUFFER, pingpongFBO[horizontal]);
-                blurShader.setInt("horizontal", horizontal);
-                glBindTexture(GL_TEXTURE_2D, first_iteration ? CBO[1] : pingpongCBO[!horizontal]);  // bind texture of other framebuffer (or scene if first iteration)
-
-                Quad::GetInstance().Draw(blurShader);
-
-                horizontal = !horizontal;
-                if (first_iteration)
+                Root.DrawSelfAndChildren(normalShader);
+                if (isCrowd && isPreSkinned)
                 {
-                    first_iteration = false;
+                    crowd->Draw(normalShader);
                 }
             }
-        }
-
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
-        glEnable(GL_CULL_FACE);
-        glDisable(GL_DEPTH_TEST);
-        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-        glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-        screenShader.Use();
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, CBO[0]);
-        glActiveTexture(GL_TEXTURE1);
-        if (bIsWireMode)
-        {
-            glBindTexture(GL_TEXTURE_2D, 0);
-        }
-        else
-        {
+            glm::vec3 rot = ring->transform.GetLocalRotation();
+            rot.x += 0.5f;
+            rot.z += 0.2f;
+            ring->transform.SetLocalRotation(rot);
+            //===============================SKYBOX===============================
+            GLState::DepthFunc(GL_LEQUAL);  // change depth function so depth test passes when values are equal to depth buffer's content
+            skyBoxShader.Use();
+            // skybox cube
+            Environment.BindCubeMap(0);
+            //Irradiance.BindCubeMap(0);
+            //Prefilter.BindCubeMap(0);
+            GLState::CullFace(GL_FRONT);
+            Cube::GetInstance().Draw(skyBoxShader);
+            GLState::CullFace(GL_BACK);
+            GLState::DepthFunc(GL_LESS);
+
+
+            GLState::BindFramebuffer(GL_FRAMEBUFFER, 0);
+
+            bool horizontal = true, first_iteration = true;
             if (bloomType == 0)
             {
-                glBindTexture(GL_TEXTURE_2D, bloomRenderer.BloomTexture());
+                bloomRenderer.RenderBloomTexture(CBO[1], filterRadius);
             }
             else if (bloomType == 1)
             {
-                glBindTexture(GL_TEXTURE_2D, pingpongCBO[!horizontal]);
+                //===============================BLUR===============================
+                blurShader.Use();
+                for (unsigned int i = 0; i < bloomSamples * 2; i++)
+                {
+                    GLState::BindFramebuffer(GL_FRAMEBUFFER, pingpongFBO[horizontal]);
+                    blurShader.setInt("horizontal", horizontal);
+                    GLState::BindTexture(GL_TEXTURE_2D, first_iteration ? CBO[1] : pingpongCBO[!horizontal]);  // bind texture of other framebuffer (or scene if first iteration)
+
+                    Quad::GetInstance().Draw(blurShader);
+
+                    horizontal = !horizontal;
+                    if (first_iteration)
+                    {
+                        first_iteration = false;
+                    }
+                }
+            }
+
+            GLState::BindFramebuffer(GL_FRAMEBUFFER, 0);
+            GLState::Enable(GL_CULL_FACE);
+            GLState::Disable(GL_DEPTH_TEST);
+            GLState::PolygonMode(GL_FILL);
+            glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+            screenShader.Use();
+            GLState::ActiveTexture(0);
+            GLState::BindTexture(GL_TEXTURE_2D, CBO[0]);
+            GLState::ActiveTexture(1);
+            if (bIsWireMode)
+            {
+                GLState::BindTexture(GL_TEXTURE_2D, 0);
             }
+            else
+            {
+                if (bloomType == 0)
+                {
+                    GLState::BindTexture(GL_TEXTURE_2D, bloomRenderer.BloomTexture());
+                }
+                else if (bloomType == 1)
+                {
+                    GLState::BindTexture(GL_TEXTURE_2D, pingpongCBO[!horizontal]);
+                }
+            }
+            screenShader.setFloat("exposure", exposure);
+            screenShader.setFloat("gamma", gamma);
+            screenShader.setFloat("bloomStrength", bloomStrength);
+
+            Quad::GetInstance().Draw(screenShader);
+
+            ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+            frameData.EndFrame();
+            glfwSwapBuffers(window);
+
+            currentFrame = glfwGetTime();
+            deltaTime = currentFrame - lastFrame;
+            lastFrame = currentFrame;
         }
-        screenShader.setFloat("exposure", exposure);
-        screenShader.setFloat("gamma", gamma);
-        screenShader.setFloat("bloomStrength", bloomStrength);
 
-        Quad::GetInstance().Draw(screenShader);
+        GPUResourceTracker& tracker = GPUResourceTracker::GetInstance();
+        frameData.Release();
 
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
-        glfwSwapBuffers(window);
+        tracker.DeleteFramebuffers(1, &FBO);
+        tracker.DeleteTextures(2, CBO);
+        tracker.DeleteRenderbuffers(1, &RBO);
 
-        currentFrame = glfwGetTime();
-        deltaTime = currentFrame - lastFrame;
-        lastFrame = currentFrame;
+        tracker.DeleteFramebuffers(2, pingpongFBO);
+        tracker.DeleteTextures(2, pingpongCBO);
     }
+    GPUResourceTracker::GetInstance().ReportLeaks();
 
     // Cleanup
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();
 
-    glDeleteBuffers(1, &UBO);
-
-    glDeleteFramebuffers(1, &FBO);
-    glDeleteTextures(2, CBO);
-
-    glDeleteFramebuffers(2, pingpongFBO);
-    glDeleteTextures(2, pingpongCBO);
-
     glfwDestroyWindow(window);
     glfwTerminate();
 